@@ -202,6 +202,42 @@ VLC_API block_t *block_Realloc(block_t *, ssize_t pre, size_t body) VLC_USED;
  */
 VLC_API void block_Release(block_t *block);
 
+/**
+ * Block pool statistics.
+ *
+ * Counters are process-wide and cumulative since the pool was first enabled.
+ */
+struct block_pool_stats
+{
+    uint64_t allocs; /**< Allocations of a pooled size class */
+    uint64_t hits; /**< Allocations served with a recycled block */
+    uint64_t recycled; /**< Released blocks kept for reuse */
+    uint64_t discarded; /**< Released blocks freed as the pool was full */
+    size_t cached_bytes; /**< Memory currently held by the pool */
+};
+
+/**
+ * Enables or disables block recycling.
+ *
+ * When enabled, block_Alloc() rounds small and medium sizes up to a few size
+ * classes (MPEG-TS packets, UDP payloads, typical elementary stream packets),
+ * and block_Release() keeps such blocks in per-thread caches backed by a
+ * process-wide pool, for reuse by later allocations.
+ *
+ * Calls must be paired: the pool is enabled until it is disabled as many
+ * times as it was enabled. The last call to disable it stops recycling,
+ * then frees the blocks held by the process-wide pool and by the calling
+ * thread. Other threads free their caches when they exit.
+ */
+VLC_API void block_PoolEnable(bool enabled);
+
+/**
+ * Gets block pool statistics.
+ *
+ * @param stats structure to fill [OUT]
+ */
+VLC_API void block_PoolGetStats(struct block_pool_stats *stats);
+
 static inline void block_CopyProperties( block_t *dst, const block_t *src )
 {
     dst->i_flags   = src->i_flags;
@@ -231,6 +267,34 @@ static inline block_t *block_Duplicate( const block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Shares a block.
+ *
+ * Creates a duplicate of a block that refers to the same payload, without
+ * copying it. The payload is reference-counted and freed when the last block
+ * referring to it is released.
+ *
+ * After this call, the payload of both the original block and the duplicate
+ * must be considered read-only: block_Realloc() will copy the data rather than
+ * grow either block in place, and block_MakeWritable() must be called before
+ * modifying the payload.
+ *
+ * @param block block to share (it remains owned by the caller)
+ * @return the duplicate on success, NULL on error.
+ */
+VLC_API block_t *block_Share(block_t *block) VLC_USED;
+
+/**
+ * Ensures that a block payload is writable.
+ *
+ * If the payload of the block is shared with other blocks (see
+ * block_Share()), the block is replaced by a writeable duplicate.
+ * Otherwise, the block is returned as is.
+ *
+ * @return a writable block, or NULL on error (the block is released).
+ */
+VLC_API block_t *block_MakeWritable(block_t *block) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
@@ -448,6 +512,17 @@ static inline block_t *block_ChainGather( block_t *p_list )
  */
 VLC_API block_fifo_t *block_FifoNew(void) VLC_USED VLC_MALLOC;
 
+/**
+ * Creates a thread-safe FIFO queue of blocks with a lock-less fast path.
+ *
+ * This is the same as block_FifoNew(), but blocks can also be queued with
+ * vlc_fifo_QueueLockless(), which neither takes the FIFO lock nor wakes up
+ * the consumer unless it is waiting for data.
+ *
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API block_fifo_t *block_FifoNewLockless(void) VLC_USED VLC_MALLOC;
+
 /**
  * Destroys a FIFO created by block_FifoNew().
  *
@@ -544,6 +619,15 @@ VLC_API void vlc_fifo_Signal(vlc_fifo_t *);
  */
 VLC_API void vlc_fifo_Wait(vlc_fifo_t *);
 
+/**
+ * Waits on the FIFO for a signal only.
+ *
+ * This is the same as vlc_fifo_Wait(), but blocks queued with
+ * vlc_fifo_QueueLockless() do not wake the calling thread up, e.g. for a
+ * consumer which is paused and would not dequeue them anyway.
+ */
+VLC_API void vlc_fifo_WaitSignal(vlc_fifo_t *);
+
 VLC_API void vlc_fifo_WaitCond(vlc_fifo_t *, vlc_cond_t *);
 
 /**
@@ -567,6 +651,22 @@ int vlc_fifo_TimedWaitCond(vlc_fifo_t *, vlc_cond_t *, vlc_tick_t);
  */
 VLC_API void vlc_fifo_QueueUnlocked(vlc_fifo_t *, block_t *);
 
+/**
+ * Queues a linked-list of blocks into a FIFO without locking it.
+ *
+ * The blocks are seen by the next thread locking the FIFO. A thread waiting
+ * with vlc_fifo_Wait() is woken up once, however many blocks are queued
+ * before it runs again. If the FIFO was not created with
+ * block_FifoNewLockless(), if another thread is queueing lock-less at the
+ * same time, or if the consumer lags too much behind, this falls back to
+ * block_FifoPut().
+ *
+ * @param block the head of the list of blocks
+ *              (if NULL, this function has no effects)
+ * @note The FIFO must <b>not</b> be locked by the calling thread.
+ */
+VLC_API void vlc_fifo_QueueLockless(vlc_fifo_t *, block_t *);
+
 /**
  * Dequeues the first block from a locked FIFO, if any.
  *
@@ -626,6 +726,17 @@ VLC_API size_t vlc_fifo_GetCount(const vlc_fifo_t *) VLC_USED;
  */
 VLC_API size_t vlc_fifo_GetBytes(const vlc_fifo_t *) VLC_USED;
 
+/**
+ * Checks how many bytes are queued in a FIFO, without locking it.
+ *
+ * This includes the blocks queued with vlc_fifo_QueueLockless() and not
+ * seen by the consumer yet. The value is only indicative, as other threads
+ * may be queueing or dequeueing at the same time.
+ *
+ * @note This function is not cancellation point.
+ */
+VLC_API size_t vlc_fifo_GetBytesLockless(const vlc_fifo_t *) VLC_USED;
+
 VLC_USED static inline bool vlc_fifo_IsEmpty(const vlc_fifo_t *fifo)
 {
     return vlc_fifo_GetCount(fifo) == 0;
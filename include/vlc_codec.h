@@ -134,6 +134,10 @@ struct decoder_t
          * send output frames/blocks via decoder_QueueVideo(), decoder_QueueAudio()
          * or decoder_QueueSub().
          *
+         * The payload of p_block may be shared with other decoders (see
+         * block_Share()): block_MakeWritable() must be called before modifying
+         * it in place.
+         *
          * If p_block is NULL, the decoder asks the module to drain itself. The
          * module should return all available output frames/block via the queue
          * functions.
@@ -161,7 +165,8 @@ struct decoder_t
          * module can also process a part of the block. In that case, it should
          * modify (*pp_block)->p_buffer/i_buffer accordingly and return a valid
          * output block. The module can also set *pp_block to NULL when the input
-         * block is consumed.
+         * block is consumed. As with pf_decode, block_MakeWritable() must be
+         * called before modifying the payload in place.
          *
          * If pp_block is not NULL but *pp_block is NULL, a previous call of the pf
          * function has set the *pp_block to NULL. Here, the module can return new
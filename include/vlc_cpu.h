@@ -65,8 +65,12 @@ VLC_API unsigned vlc_CPU(void);
 
 # ifdef __SSE2__
 #  define vlc_CPU_SSE2() (1)
+#  define VLC_SSE2_TARGET
 # else
 #  define vlc_CPU_SSE2() ((vlc_CPU() & VLC_CPU_SSE2) != 0)
+#  if defined (__GNUC__)
+#   define VLC_SSE2_TARGET __attribute__ ((__target__ ("sse2")))
+#  endif
 # endif
 
 # ifdef __SSE3__
@@ -107,8 +111,12 @@ VLC_API unsigned vlc_CPU(void);
 
 # ifdef __AVX2__
 #  define vlc_CPU_AVX2() (1)
+#  define VLC_AVX2_TARGET
 # else
 #  define vlc_CPU_AVX2() ((vlc_CPU() & VLC_CPU_AVX2) != 0)
+#  if defined (__GNUC__)
+#   define VLC_AVX2_TARGET __attribute__ ((__target__ ("avx2")))
+#  endif
 # endif
 
 # ifdef __3dNOW__
@@ -201,4 +209,13 @@ VLC_API unsigned vlc_CPU(void);
 
 # endif
 
+/* Function attributes enabling an instruction set on x86 with GCC-compatible
+ * compilers; empty elsewhere */
+# ifndef VLC_SSE2_TARGET
+#  define VLC_SSE2_TARGET
+# endif
+# ifndef VLC_AVX2_TARGET
+#  define VLC_AVX2_TARGET
+# endif
+
 #endif /* !VLC_CPU_H */
@@ -419,6 +419,46 @@ VLC_API decoder_t * demux_PacketizerNew( demux_t *p_demux, es_format_t *p_fmt, c
  */
 VLC_API void demux_PacketizerDestroy( decoder_t *p_packetizer );
 
+/**
+ * \defgroup demux_index_cache Seek index cache
+ * Persistent storage of the seek indexes built by demultiplexers
+ *
+ * Demultiplexers that have to scan a file to seek in it (missing or broken
+ * index, no index at all in the format) can store what they found, and
+ * load it back the next time the same file is opened. The data is opaque to
+ * the core, and tied to the path, size, modification time and first and last
+ * bytes of the file. The least recently stored indexes are evicted after 30
+ * days, or when the cache exceeds 64 MiB, by a background thread.
+ *
+ * The cache is disabled by default (see the "demux-index-cache" option).
+ * @{
+ */
+
+/**
+ * Loads a seek index stored by demux_IndexCacheStore() for the same file.
+ *
+ * \param p_demux demultiplexer, reading from a local file
+ * \param psz_name name of the index, unique to the demultiplexer
+ * \return a block holding the index data, or NULL if there is no index
+ * for the current version of the file (or if the cache is disabled)
+ */
+VLC_API block_t *demux_IndexCacheLoad( demux_t *p_demux,
+                                       const char *psz_name ) VLC_USED;
+
+/**
+ * Stores a seek index for the file, replacing any previous one.
+ *
+ * \param p_demux demultiplexer, reading from a local file
+ * \param psz_name name of the index, unique to the demultiplexer
+ * \param p_data index data
+ * \param i_data index data size in bytes
+ * \return VLC_SUCCESS, or an error code if the index was not stored
+ */
+VLC_API int demux_IndexCacheStore( demux_t *p_demux, const char *psz_name,
+                                   const void *p_data, size_t i_data );
+
+/** @} */
+
 /* */
 #define DEMUX_INIT_COMMON() do {            \
     p_demux->pf_control = Control;          \
@@ -48,6 +48,7 @@ enum vlc_module_properties
     VLC_MODULE_DESCRIPTION,
     VLC_MODULE_HELP,
     VLC_MODULE_TEXTDOMAIN,
+    VLC_MODULE_SIGNATURE,
     /* Insert new VLC_MODULE_* here */
 
     /* DO NOT EVER REMOVE, INSERT OR REPLACE ANY ITEM! It would break the ABI!
@@ -290,6 +291,20 @@ VLC_METADATA_EXPORTS
         goto error; \
 }
 
+/**
+ * Declares bytes that a stream must contain at a given offset for the module
+ * to accept it, unless the module is explicitly requested. A module with
+ * several signatures is a candidate if any of them matches. This lets the
+ * core skip the module without running its probe.
+ *
+ * \param offset byte offset from the start of the stream
+ * \param magic string literal of the expected bytes (may contain nul bytes)
+ */
+#define add_signature( offset, magic ) \
+    if (vlc_module_set (VLC_MODULE_SIGNATURE, (unsigned)(offset), \
+                        (const char *)(magic), sizeof (magic) - 1)) \
+        goto error;
+
 #define set_shortname( shortname ) \
     if (vlc_module_set (VLC_MODULE_SHORTNAME, (const char *)(shortname))) \
         goto error;
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * vlc_slices.h: slice-parallel picture processing
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SLICES_H
+#define VLC_SLICES_H 1
+
+#include <vlc_picture.h>
+
+/**
+ * \defgroup slices Slice-parallel processing
+ * \ingroup filter
+ *
+ * Processing of the horizontal slices of a picture on several threads.
+ *
+ * The threads are shared by all the users of the process, and the calling
+ * thread processes slices too. The number of slices is set by the
+ * "video-filter-threads" option (one per CPU by default), whatever the
+ * number of threads actually available: filters keeping state across the
+ * lines of a slice (e.g. recursive filters) can rely on it.
+ * @{
+ * \file
+ */
+
+typedef struct vlc_slices vlc_slices_t;
+
+/**
+ * Callback processing a slice.
+ *
+ * \param opaque data passed to vlc_slices_Run()
+ * \param slice index of the slice, from 0 to count - 1
+ * \param count number of slices
+ */
+typedef void (*vlc_slices_cb)(void *opaque, unsigned slice, unsigned count);
+
+/**
+ * Creates a slicing context.
+ *
+ * \param obj object to read the "video-filter-threads" option from
+ * \return the context, or NULL on error
+ */
+VLC_API vlc_slices_t *vlc_slices_New(vlc_object_t *obj) VLC_USED;
+#define vlc_slices_New(o) vlc_slices_New(VLC_OBJECT(o))
+
+/**
+ * Destroys a slicing context.
+ */
+VLC_API void vlc_slices_Delete(vlc_slices_t *);
+
+/**
+ * Gets the number of slices, e.g. to allocate per-slice state.
+ */
+VLC_API unsigned vlc_slices_Count(const vlc_slices_t *) VLC_USED;
+
+/**
+ * Processes all the slices, and waits for them to be done.
+ *
+ * The callback is invoked once for each slice, possibly concurrently on
+ * different threads.
+ */
+VLC_API void vlc_slices_Run(vlc_slices_t *, vlc_slices_cb cb, void *opaque);
+
+/**
+ * Computes the lines of a slice.
+ *
+ * \param lines total number of lines
+ * \param begin first line of the slice [OUT]
+ * \param end line following the slice [OUT]
+ */
+static inline void vlc_slice_Lines(unsigned slice, unsigned count, int lines,
+                                   int *restrict begin, int *restrict end)
+{
+    *begin = (int64_t)lines * slice / count;
+    *end = (int64_t)lines * (slice + 1) / count;
+}
+
+/**
+ * Restricts a picture to the visible lines of a slice, in each plane.
+ *
+ * The view shares the pixels of the picture, and must not be released or
+ * outlive it.
+ */
+static inline void vlc_slice_Picture(picture_t *restrict view,
+                                     const picture_t *restrict pic,
+                                     unsigned slice, unsigned count)
+{
+    *view = *pic;
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &view->p[i];
+        int begin, end;
+
+        vlc_slice_Lines(slice, count, p->i_visible_lines, &begin, &end);
+        p->p_pixels += begin * p->i_pitch;
+        p->i_lines = p->i_visible_lines = end - begin;
+    }
+}
+
+/** @} */
+
+#endif
@@ -168,6 +168,7 @@ enum stream_query_e
     STREAM_GET_CONTENT_TYPE,    /**< arg1= char **         res=can fail */
     STREAM_GET_SIGNAL,      /**< arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
     STREAM_GET_TAGS,        /**< arg1=const block_t ** res=can fail */
+    STREAM_GET_CACHE_STATS, /**< arg1=stream_cache_stats_t * res=can fail */
 
     STREAM_SET_PAUSE_STATE = 0x200, /**< arg1= bool        res=can fail */
     STREAM_SET_TITLE,       /**< arg1= int          res=can fail */
@@ -181,6 +182,20 @@ enum stream_query_e
     STREAM_GET_PRIVATE_ID_STATE,          /* arg1=int i_private_data arg2=bool *          res=can fail */
 };
 
+/**
+ * Statistics of a caching stream filter, see STREAM_GET_CACHE_STATS
+ */
+typedef struct
+{
+    uint64_t hits;       /**< reads served from the cache */
+    uint64_t misses;     /**< reads that had to fetch from the source */
+    uint64_t read_bytes; /**< bytes fetched from the source */
+    uint64_t seeks;      /**< seeks of the source */
+    uint64_t evictions;  /**< cached data released to stay within budget */
+    size_t   cached;     /**< bytes currently in the cache */
+    size_t   budget;     /**< maximum bytes in the cache */
+} stream_cache_stats_t;
+
 /**
  * Reads data from a byte stream.
  *
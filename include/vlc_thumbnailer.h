@@ -43,6 +43,21 @@ typedef struct vlc_thumbnailer_request_t vlc_thumbnailer_request_t;
  */
 typedef void(*vlc_thumbnailer_cb)( void* data, picture_t* thumbnail );
 
+/**
+ * \brief vlc_thumbnailer_batch_cb defines a callback invoked for each thumbnail
+ * of a batch request
+ *
+ * This callback is called once per requested time, in order, unless the
+ * request is cancelled. The picture follows the same rules as with
+ * \link vlc_thumbnailer_cb \endlink.
+ *
+ * \param data Is the opaque pointer passed as vlc_thumbnailer_RequestBatch last parameter
+ * \param index The index of the thumbnail time in the request
+ * \param thumbnail The generated thumbnail, or NULL in case of failure or timeout
+ */
+typedef void(*vlc_thumbnailer_batch_cb)( void* data, size_t index,
+                                         picture_t* thumbnail );
+
 
 /**
  * \brief vlc_thumbnailer_Create Creates a thumbnailer object
@@ -112,6 +127,40 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                               input_item_t *input_item, vlc_tick_t timeout,
                               vlc_thumbnailer_cb cb, void* user_data );
 
+/**
+ * \brief vlc_thumbnailer_RequestBatch Requests thumbnails at several times
+ * \param thumbnailer A thumbnailer object
+ * \param times The times at which the thumbnails should be taken
+ * \param count The number of times
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param width The width of the thumbnails, or 0
+ * \param height The height of the thumbnails, or 0
+ * \param input_item The input item to generate the thumbnails for
+ * \param timeout A timeout value for the whole batch, or VLC_TICK_INVALID to
+ * disable timeout
+ * \param cb A user callback to be called for each thumbnail (success & error)
+ * \param user_data An opaque value, provided as pf_cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The input is opened once and all the thumbnails are extracted from it,
+ * which is much cheaper than one request per thumbnail.
+ * If both width and height are 0, the thumbnails keep the source size. If
+ * only one of them is 0, it is computed from the source aspect ratio.
+ *
+ * If this function returns a valid request object, the callback is guaranteed
+ * to be called for each time, even in case of later failure.
+ * The returned request object must not be used after the callback has been
+ * invoked for the last time. The times are copied, and the input_item is
+ * held by the thumbnailer: both can be released after calling this function.
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              unsigned width, unsigned height,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data );
+
 /**
  * \brief vlc_thumbnailer_Cancel Cancel a thumbnail request
  * \param thumbnailer A thumbnailer object
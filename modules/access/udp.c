@@ -35,6 +35,8 @@
 # include "config.h"
 #endif
 
+#include <errno.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
@@ -53,12 +55,35 @@
  */
 #define MRU 65507u
 
+/* Initial size of batch receive buffers, large enough for 7 TS packets
+ * with an RTP header, or an Ethernet MTU. */
+#define BATCH_MTU 2048u
+
 typedef struct {
     int fd;
     int timeout;
 
     size_t length;
     char *offset;
+#ifdef HAVE_RECVMMSG
+    /* Batch receive */
+    unsigned batch;
+    size_t mtu;
+    block_t *chain;
+    block_t **chain_last;
+    block_t **slots;
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+# ifdef SO_RXQ_OVFL
+    char (*cmsgs)[CMSG_SPACE(sizeof (uint32_t))];
+    uint32_t drops;
+    vlc_tick_t drops_warned;
+# endif
+    uint64_t datagrams;
+    uint64_t calls;
+    uint64_t full_batches;
+    uint64_t truncated;
+#endif
     char buf[MRU];
 } access_sys_t;
 
@@ -132,6 +157,239 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+#ifdef HAVE_RECVMMSG
+static void BatchUpdateDrops(stream_t *access, const struct msghdr *hdr)
+{
+# ifdef SO_RXQ_OVFL
+    access_sys_t *sys = access->p_sys;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR((struct msghdr *)hdr, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL)
+            continue;
+
+        uint32_t drops;
+
+        memcpy(&drops, CMSG_DATA(cmsg), sizeof (drops));
+        if (drops == sys->drops)
+            continue;
+
+        /* Warn at most once per second */
+        vlc_tick_t now = vlc_tick_now();
+        if (now - sys->drops_warned >= VLC_TICK_FROM_SEC(1))
+        {
+            msg_Warn(access, "%"PRIu32" datagram(s) dropped by the system "
+                     "(%"PRIu32" total)", drops - sys->drops, drops);
+            sys->drops_warned = now;
+        }
+        sys->drops = drops;
+    }
+# else
+    VLC_UNUSED(access); VLC_UNUSED(hdr);
+# endif
+}
+
+/**
+ * Receives as many pending datagrams as fit in the ring of pre-allocated
+ * blocks with a single system call, and appends them to the chain.
+ */
+static int BatchReceive(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < sys->batch; i++)
+    {
+        if (sys->slots[i] == NULL)
+        {
+            sys->slots[i] = block_Alloc(sys->mtu);
+            if (unlikely(sys->slots[i] == NULL))
+                break;
+        }
+
+        struct iovec *iov = &sys->iovs[2 * i];
+
+        iov[0].iov_base = sys->slots[i]->p_buffer;
+        iov[0].iov_len = sys->mtu;
+        /* Tail of datagrams larger than the slot, shared by the batch */
+        iov[1].iov_base = sys->buf;
+        iov[1].iov_len = MRU - __MIN(sys->mtu, MRU);
+
+        struct msghdr *hdr = &sys->msgs[i].msg_hdr;
+
+        hdr->msg_iov = iov;
+        hdr->msg_iovlen = 2;
+        hdr->msg_flags = 0;
+# ifdef SO_RXQ_OVFL
+        hdr->msg_control = sys->cmsgs[i];
+        hdr->msg_controllen = sizeof (sys->cmsgs[i]);
+# endif
+        count++;
+    }
+
+    if (unlikely(count == 0))
+        return -1;
+
+    int val = recvmmsg(sys->fd, sys->msgs, count, MSG_DONTWAIT, NULL);
+    if (val <= 0)
+        return -1;
+
+    sys->calls++;
+    sys->datagrams += val;
+    if ((unsigned)val == count)
+        sys->full_batches++; /* more might be pending */
+
+    size_t largest = 0;
+    int last = -1;
+
+    /* Only the last datagram larger than the slots keeps its tail. The slots
+     * then grow, so that this only happens until the sender's largest size
+     * is known. */
+    for (int i = 0; i < val; i++)
+        if (sys->msgs[i].msg_len > sys->mtu)
+            last = i;
+
+    for (int i = 0; i < val; i++)
+    {
+        block_t *block = sys->slots[i];
+        size_t len = sys->msgs[i].msg_len;
+
+        sys->slots[i] = NULL;
+        BatchUpdateDrops(access, &sys->msgs[i].msg_hdr);
+
+        if (len > sys->mtu)
+        {
+            largest = __MAX(largest, len);
+            if ((sys->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || i != last)
+            {
+                sys->truncated++;
+                block_Release(block);
+                continue;
+            }
+
+            block = block_Realloc(block, 0, len);
+            if (unlikely(block == NULL))
+                continue;
+            memcpy(block->p_buffer + sys->mtu, sys->buf, len - sys->mtu);
+        }
+        else
+            block->i_buffer = len;
+
+        *sys->chain_last = block;
+        sys->chain_last = &block->p_next;
+    }
+
+    /* Move the remaining pre-allocated blocks to the front of the ring */
+    for (unsigned i = val, j = 0; i < count; i++, j++)
+    {
+        sys->slots[j] = sys->slots[i];
+        sys->slots[i] = NULL;
+    }
+
+    if (largest > 0)
+    {   /* Grow the ring for subsequent large datagrams */
+        msg_Dbg(access, "receive buffer size %zu -> %zu bytes", sys->mtu,
+                largest);
+        sys->mtu = largest;
+        for (unsigned i = 0; i < sys->batch; i++)
+            if (sys->slots[i] != NULL)
+            {
+                block_Release(sys->slots[i]);
+                sys->slots[i] = NULL;
+            }
+    }
+    return 0;
+}
+
+static block_t *BlockBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->chain == NULL)
+    {
+        struct pollfd ufd[1];
+
+        ufd[0].fd = sys->fd;
+        ufd[0].events = POLLIN;
+
+        switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+            case 0:
+                msg_Err(access, "receive time-out");
+                *eof = true;
+                return NULL;
+            case -1:
+                return NULL;
+        }
+
+        if (BatchReceive(access) || sys->chain == NULL)
+            return NULL;
+    }
+
+    block_t *block = sys->chain;
+
+    sys->chain = block->p_next;
+    if (sys->chain == NULL)
+        sys->chain_last = &sys->chain;
+    block->p_next = NULL;
+    return block;
+}
+
+static int BatchOpen(stream_t *access, unsigned batch)
+{
+    access_sys_t *sys = access->p_sys;
+
+    sys->batch = batch;
+    sys->mtu = BATCH_MTU;
+    sys->chain = NULL;
+    sys->chain_last = &sys->chain;
+    sys->datagrams = sys->calls = sys->full_batches = sys->truncated = 0;
+    sys->slots = vlc_obj_calloc(VLC_OBJECT(access), batch,
+                                sizeof (*sys->slots));
+    sys->msgs = vlc_obj_calloc(VLC_OBJECT(access), batch,
+                               sizeof (*sys->msgs));
+    sys->iovs = vlc_obj_calloc(VLC_OBJECT(access), 2 * batch,
+                               sizeof (*sys->iovs));
+    if (unlikely(sys->slots == NULL || sys->msgs == NULL || sys->iovs == NULL))
+        return VLC_ENOMEM;
+
+# ifdef SO_RXQ_OVFL
+    sys->cmsgs = vlc_obj_calloc(VLC_OBJECT(access), batch,
+                                sizeof (*sys->cmsgs));
+    if (unlikely(sys->cmsgs == NULL))
+        return VLC_ENOMEM;
+    sys->drops = 0;
+    sys->drops_warned = VLC_TICK_0;
+
+    int on = 1;
+    if (setsockopt(sys->fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof (on)))
+        msg_Dbg(access, "cannot count dropped datagrams: %s",
+                vlc_strerror_c(errno));
+# endif
+    return VLC_SUCCESS;
+}
+
+static void BatchClose(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    msg_Dbg(access, "received %"PRIu64" datagram(s) in %"PRIu64" call(s), "
+            "%"PRIu64" full batch(es), %"PRIu64" truncated", sys->datagrams,
+            sys->calls, sys->full_batches, sys->truncated);
+# ifdef SO_RXQ_OVFL
+    if (sys->drops > 0)
+        msg_Dbg(access, "%"PRIu32" datagram(s) dropped by the system",
+                sys->drops);
+# endif
+
+    block_ChainRelease(sys->chain);
+    for (unsigned i = 0; i < sys->batch; i++)
+        if (sys->slots[i] != NULL)
+            block_Release(sys->slots[i]);
+}
+#endif
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -217,6 +475,22 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    sys->batch = 0;
+
+    int64_t batch = var_InheritInteger( p_access, "udp-batch" );
+    if( batch > 1 )
+    {
+        if( BatchOpen( p_access, __MIN(batch, 1024) ) )
+        {
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+        p_access->pf_read = NULL;
+        p_access->pf_block = BlockBatch;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -228,10 +502,18 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    if( sys->batch > 0 )
+        BatchClose( p_access );
+#endif
     net_Close( sys->fd );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Datagrams per receive call")
+#define BATCH_LONGTEXT N_("Maximum number of datagrams received with a " \
+    "single system call. Receiving many datagrams at once reduces CPU " \
+    "usage at high packet rates. 1 disables batching.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -242,6 +524,10 @@ vlc_module_begin()
     add_obsolete_integer("server-port") /* since 2.0.0 */
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL, true)
+#ifdef HAVE_RECVMMSG
+    add_integer_with_range("udp-batch", 32, 1, 1024, BATCH_TEXT,
+                           BATCH_LONGTEXT, true)
+#endif
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
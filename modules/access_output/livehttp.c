@@ -43,6 +43,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -105,6 +107,15 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define QUEUE_TEXT N_("Segments write queue")
+#define QUEUE_LONGTEXT N_("Number of complete segments waiting to be " \
+                          "written before the muxer is stalled")
+
+#define MEMORY_TEXT N_("Serve segments from memory")
+#define MEMORY_LONGTEXT N_("Keep the segments and the index in memory, and " \
+                           "serve them with the HTTP server at the path of " \
+                           "their URL, instead of writing files")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -135,6 +146,10 @@ vlc_module_begin ()
                  KEYFILE_TEXT, KEYFILE_LONGTEXT)
     add_loadfile(SOUT_CFG_PREFIX "key-loadfile", NULL,
                  KEYLOADFILE_TEXT, KEYLOADFILE_LONGTEXT)
+    add_integer( SOUT_CFG_PREFIX "queue-size", 4, QUEUE_TEXT, QUEUE_LONGTEXT, true )
+        change_integer_range( 1, 1000 )
+    add_bool( SOUT_CFG_PREFIX "memory", false,
+              MEMORY_TEXT, MEMORY_LONGTEXT, true )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -156,6 +171,8 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "queue-size",
+    "memory",
     NULL
 };
 
@@ -171,8 +188,18 @@ typedef struct output_segment
     vlc_tick_t segment_length;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    block_t *p_data; /* segment served from memory */
+    httpd_file_t *p_file;
 } output_segment_t;
 
+/* Complete segment waiting to be written */
+typedef struct output_job
+{
+    struct output_job *p_next;
+    block_t *p_chain;
+    bool b_isend;
+} output_job_t;
+
 typedef struct
 {
     char *psz_cursegPath;
@@ -195,20 +222,55 @@ typedef struct
     bool b_splitanywhere;
     bool b_caching;
     bool b_generate_iv;
-    bool b_segment_has_data;
+    bool b_segment_has_data; /* owned by the muxer thread */
     uint8_t aes_ivs[16];
     gcry_cipher_hd_t aes_ctx;
     char *key_uri;
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+    bool b_open;
+
+    /* In-memory segments and index */
+    bool b_memory;
+    httpd_host_t *p_host;
+    httpd_file_t *p_index_file;
+    block_t *p_memseg;
+    block_t **pp_memseg_end;
+    char *psz_index;
+    size_t i_index;
+
+    /* Segments writer thread */
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    vlc_cond_t space;
+    output_job_t *p_jobs;
+    output_job_t **pp_jobs_end;
+    unsigned i_jobs;
+    unsigned i_max_jobs;
+    bool b_dead;
+    bool b_error;
+    bool b_segment_open; /* owned by the muxer thread */
+
+    /* Statistics */
+    unsigned i_stalls;
+    vlc_tick_t stall_time;
+    unsigned i_writes;
+    vlc_tick_t write_time;
+    vlc_tick_t write_max;
 } sout_access_out_sys_t;
 
 static int LoadCryptFile( sout_access_out_t *p_access);
 static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
-static ssize_t writeSegment( sout_access_out_t *p_access );
+static ssize_t queueSegment( sout_access_out_t *p_access, bool b_isend );
+static ssize_t writeSegment( sout_access_out_t *p_access, block_t *output );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend );
+static int IndexFill( httpd_file_sys_t *, httpd_file_t *, uint8_t *, uint8_t **, int * );
+static char *urlPath( const char *psz_uri );
+static void *WriterThread( void * );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -247,6 +309,23 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
     p_sys->b_segment_has_data = false;
+    p_sys->i_max_jobs = var_GetInteger( p_access, SOUT_CFG_PREFIX "queue-size" );
+    p_sys->b_memory = var_GetBool( p_access, SOUT_CFG_PREFIX "memory" );
+    p_sys->pp_memseg_end = &p_sys->p_memseg;
+
+    if( p_sys->b_memory )
+    {
+        /* Segments in memory are only freed when they leave the index */
+        if( p_sys->i_numsegs == 0 )
+        {
+            msg_Err( p_access, "serving segments from memory needs a "
+                     "limited number of segments (numsegs)" );
+            free( p_sys );
+            return VLC_EGENERIC;
+        }
+        p_sys->b_delsegs = true;
+    }
+    p_sys->pp_jobs_end = &p_sys->p_jobs;
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -265,7 +344,7 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !p_sys->b_memory )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
@@ -296,10 +375,60 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
 
+    vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( &p_sys->wait );
+    vlc_cond_init( &p_sys->space );
+
+    if( p_sys->b_memory )
+    {
+        p_sys->p_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+        if( !p_sys->p_host )
+            goto error;
+
+        if( p_sys->psz_indexPath )
+        {
+            char *psz_url = urlPath( p_sys->psz_indexPath );
+            if( psz_url )
+                p_sys->p_index_file = httpd_FileNew( p_sys->p_host, psz_url,
+                                                     "application/vnd.apple.mpegurl",
+                                                     NULL, NULL, IndexFill,
+                                                     (httpd_file_sys_t *)p_sys );
+            free( psz_url );
+            if( !p_sys->p_index_file )
+                goto error;
+        }
+    }
+
+    /* Files are written and encrypted by a thread, so that slow disks do not
+     * stall the muxer */
+    if( vlc_clone( &p_sys->thread, WriterThread, p_access,
+                   VLC_THREAD_PRIORITY_LOW ) )
+        goto error;
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
     return VLC_SUCCESS;
+
+error:
+    msg_Err( p_access, "cannot start segments writer" );
+    if( p_sys->p_index_file )
+        httpd_FileDelete( p_sys->p_index_file );
+    if( p_sys->p_host )
+        httpd_HostDelete( p_sys->p_host );
+    vlc_cond_destroy( &p_sys->space );
+    vlc_cond_destroy( &p_sys->wait );
+    vlc_mutex_destroy( &p_sys->lock );
+    if( p_sys->key_uri )
+    {
+        gcry_cipher_close( p_sys->aes_ctx );
+        free( p_sys->key_uri );
+    }
+    free( p_sys->psz_keyfile );
+    free( p_sys->psz_indexUrl );
+    free( p_sys->psz_indexPath );
+    free( p_sys );
+    return VLC_EGENERIC;
 }
 
 /************************************************************************
@@ -501,6 +630,10 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
 
 static void destroySegment( output_segment_t *segment )
 {
+    if( segment->p_file )
+        httpd_FileDelete( segment->p_file );
+    if( segment->p_data )
+        block_Release( segment->p_data );
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
@@ -550,6 +683,40 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->segment_length + (p_sys->i_numsegs * p_sys->segment_max_length));
 }
 
+/************************************************************************
+ * writeIndex: Atomically replace the index file
+ ************************************************************************/
+static int writeIndex( sout_access_out_t *p_access, const char *psz_path,
+                       const char *psz_index, size_t i_index )
+{
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", psz_path ) < 0)
+        return -1;
+
+    FILE *fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    bool b_failed = fwrite( psz_index, 1, i_index, fp ) != i_index;
+    b_failed |= fclose( fp ) != 0;
+
+    /* Readers see either the old or the new index, never a partial one */
+    if ( b_failed || vlc_rename( psz_idxTmp, psz_path ) < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    free( psz_idxTmp );
+    return 0;
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -574,33 +741,16 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     // First update index
     if ( p_sys->psz_indexPath )
     {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
-            return -1;
+        struct vlc_memstream ms;
 
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
-            return -1;
-        }
-
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
+        vlc_memstream_open( &ms );
+        vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
                           "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", ceil(secf_from_vlc_tick( p_sys->segment_max_length )) ,
                           p_sys->b_caching ? "YES" : "NO",
                           p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
                           i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
-        {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
-        }
-        char *psz_current_uri=NULL;
-
+                          );
+        const char *psz_current_uri = NULL;
 
         for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
         {
@@ -612,9 +762,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                 ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
               )
             {
-                int ret = 0;
-                free( psz_current_uri );
-                psz_current_uri = strdup( segment->psz_key_uri );
+                psz_current_uri = segment->psz_key_uri;
                 if( p_sys->b_generate_iv )
                 {
                     unsigned long long iv_hi = segment->aes_ivs[0];
@@ -626,55 +774,38 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                         iv_lo <<= 8;
                         iv_lo |= segment->aes_ivs[8+j] & 0xff;
                     }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                          segment->psz_key_uri, iv_hi, iv_lo );
 
                 } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
                 }
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
         }
-        free( psz_current_uri );
 
         if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
-
-        }
-        fclose( fp );
+            vlc_memstream_puts( &ms, STR_ENDLIST );
 
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+        if ( vlc_memstream_close( &ms ) )
+            return -1;
 
-        if ( val < 0 )
+        if ( p_sys->b_memory )
         {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
+            vlc_mutex_lock( &p_sys->lock );
+            free( p_sys->psz_index );
+            p_sys->psz_index = ms.ptr;
+            p_sys->i_index = ms.length;
+            vlc_mutex_unlock( &p_sys->lock );
+            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
         }
         else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
-
-        free( psz_idxTmp );
+        {
+            if ( writeIndex( p_access, p_sys->psz_indexPath, ms.ptr, ms.length ) == 0 )
+                msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+            free( ms.ptr );
+        }
     }
 
     // Then take care of deletion
@@ -687,7 +818,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
          vlc_array_remove( &p_sys->segments_t, 0 );
 
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->b_memory )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -700,12 +831,99 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     return 0;
 }
 
+/*****************************************************************************
+ * urlPath: HTTP server path of an URL
+ *****************************************************************************/
+static char *urlPath( const char *psz_uri )
+{
+    const char *psz_path = strstr( psz_uri, "://" );
+    char *psz_url;
+
+    if( psz_path )
+    {
+        psz_path = strchr( psz_path + 3, '/' );
+        if( !psz_path )
+            psz_path = "/";
+    }
+    else
+        psz_path = psz_uri;
+
+    if( asprintf( &psz_url, "%s%s", *psz_path == '/' ? "" : "/", psz_path ) < 0 )
+        return NULL;
+    return psz_url;
+}
+
+static int SegmentFill( httpd_file_sys_t *opaque, httpd_file_t *file,
+                        uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    const output_segment_t *segment = (const output_segment_t *)opaque;
+    const block_t *p_data = segment->p_data; /* not modified once served */
+
+    VLC_UNUSED(file); VLC_UNUSED(psz_request);
+    *pi_data = 0;
+    *pp_data = p_data ? malloc( p_data->i_buffer ) : NULL;
+    if( *pp_data )
+    {
+        memcpy( *pp_data, p_data->p_buffer, p_data->i_buffer );
+        *pi_data = p_data->i_buffer;
+    }
+    return VLC_SUCCESS;
+}
+
+static int IndexFill( httpd_file_sys_t *opaque, httpd_file_t *file,
+                      uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)opaque;
+
+    VLC_UNUSED(file); VLC_UNUSED(psz_request);
+    vlc_mutex_lock( &p_sys->lock );
+    *pi_data = 0;
+    *pp_data = p_sys->psz_index ? malloc( p_sys->i_index ) : NULL;
+    if( *pp_data )
+    {
+        memcpy( *pp_data, p_sys->psz_index, p_sys->i_index );
+        *pi_data = p_sys->i_index;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * segmentWrite: Write a block of the current segment
+ *****************************************************************************/
+static ssize_t segmentWrite( sout_access_out_sys_t *p_sys, block_t *p_block )
+{
+    size_t i_size = p_block->i_buffer;
+
+    if( p_sys->b_memory )
+    {
+        block_ChainLastAppend( &p_sys->pp_memseg_end, p_block );
+        return i_size;
+    }
+
+    for( size_t i_done = 0; i_done < i_size; )
+    {
+        ssize_t val = vlc_write( p_sys->i_handle, p_block->p_buffer + i_done,
+                                 i_size - i_done );
+        if ( val == -1 )
+        {
+           if ( errno == EINTR )
+              continue;
+           block_Release( p_block );
+           return -1;
+        }
+        i_done += val;
+    }
+    block_Release( p_block );
+    return i_size;
+}
+
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( p_sys->b_open )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -714,21 +932,39 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
             size_t pad = 16 - p_sys->stuffing_size;
             memset(&p_sys->stuffing_bytes[p_sys->stuffing_size], pad, pad);
             gcry_error_t err = gcry_cipher_encrypt( p_sys->aes_ctx, p_sys->stuffing_bytes, 16, NULL, 0 );
+            block_t *p_stuffing;
 
             if( err ) {
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
-            } else {
-
-            int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
-            if( ret != 16 )
-                msg_Err( p_access, "Couldn't write 16 bytes" );
+            } else if( ( p_stuffing = block_Alloc( 16 ) ) != NULL ) {
+                memcpy( p_stuffing->p_buffer, p_sys->stuffing_bytes, 16 );
+                if( segmentWrite( p_sys, p_stuffing ) != 16 )
+                    msg_Err( p_access, "Couldn't write 16 bytes" );
             }
             p_sys->stuffing_size = 0;
         }
 
-
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        p_sys->b_open = false;
+        if( p_sys->b_memory )
+        {
+            segment->p_data = block_ChainGather( p_sys->p_memseg );
+            p_sys->p_memseg = NULL;
+            p_sys->pp_memseg_end = &p_sys->p_memseg;
+
+            char *psz_url = urlPath( segment->psz_uri );
+            if( psz_url )
+                segment->p_file = httpd_FileNew( p_sys->p_host, psz_url, "video/MP2T",
+                                                 NULL, NULL, SegmentFill,
+                                                 (httpd_file_sys_t *)segment );
+            if( !segment->p_file )
+                msg_Err( p_access, "cannot serve segment `%s'", psz_url );
+            free( psz_url );
+        }
+        else
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", secf_from_vlc_tick( p_sys->current_segment_length )) ) )
         {
@@ -781,17 +1017,30 @@ static void Close( vlc_object_t * p_this )
         p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
     }
 
-    ssize_t writevalue = writeSegment( p_access );
-    msg_Dbg( p_access, "Writing.. %zd", writevalue );
-    if( unlikely( writevalue < 0 ) )
+    if( p_sys->b_segment_open || p_sys->full_segments )
     {
-        if( p_sys->full_segments )
+        ssize_t writevalue = queueSegment( p_access, true );
+        msg_Dbg( p_access, "Writing.. %zd", writevalue );
+        if( unlikely( writevalue < 0 ) && p_sys->full_segments )
             block_ChainRelease( p_sys->full_segments );
-        if( p_sys->ongoing_segment )
-            block_ChainRelease( p_sys->ongoing_segment );
     }
 
-    closeCurrentSegment( p_access, p_sys, true );
+    /* Wait for the pending segments to be written */
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_dead = true;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+    vlc_join( p_sys->thread, NULL );
+
+    if( p_sys->i_writes > 0 )
+        msg_Dbg( p_access, "%u segments written in %"PRId64" ms on average, "
+                 "%"PRId64" ms at most", p_sys->i_writes,
+                 MS_FROM_VLC_TICK( p_sys->write_time / p_sys->i_writes ),
+                 MS_FROM_VLC_TICK( p_sys->write_max ) );
+    if( p_sys->i_stalls > 0 )
+        msg_Warn( p_access, "muxer stalled %u times for %"PRId64" ms waiting "
+                  "for the segments to be written", p_sys->i_stalls,
+                  MS_FROM_VLC_TICK( p_sys->stall_time ) );
 
     if( p_sys->key_uri )
     {
@@ -803,7 +1052,8 @@ static void Close( vlc_object_t * p_this )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
         vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename
+         && !p_sys->b_memory )
         {
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
             vlc_unlink( segment->psz_filename );
@@ -812,6 +1062,17 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    if( p_sys->p_index_file )
+        httpd_FileDelete( p_sys->p_index_file );
+    if( p_sys->p_host )
+        httpd_HostDelete( p_sys->p_host );
+    free( p_sys->psz_index );
+    if( p_sys->p_memseg )
+        block_ChainRelease( p_sys->p_memseg );
+    vlc_cond_destroy( &p_sys->space );
+    vlc_cond_destroy( &p_sys->wait );
+    vlc_mutex_destroy( &p_sys->lock );
+
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -865,8 +1126,11 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
+    if ( p_sys->b_memory )
+        fd = 0;
+    else
+        fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                         O_TRUNC, 0666 );
     if ( fd == -1 )
     {
         msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
@@ -892,9 +1156,9 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     msg_Dbg( p_access, "Successfully opened livehttp file: %s (%"PRIu32")" , segment->psz_filename, i_newseg );
 
     p_sys->psz_cursegPath = strdup(segment->psz_filename);
-    p_sys->i_handle = fd;
+    p_sys->i_handle = p_sys->b_memory ? -1 : fd;
+    p_sys->b_open = true;
     p_sys->i_segment = i_newseg;
-    p_sys->b_segment_has_data = false;
     return fd;
 }
 /*****************************************************************************
@@ -911,54 +1175,157 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     block_ChainProperties( p_sys->full_segments, NULL, NULL, &current_length );
     block_ChainProperties( p_sys->ongoing_segment, NULL, NULL, &ongoing_length );
 
-    if( p_sys->i_handle > 0 &&
+    if( p_sys->b_segment_open &&
        (( p_buffer->i_length + current_length + ongoing_length ) >= p_sys->segment_max_length ) )
     {
-        writevalue = writeSegment( p_access );
+        writevalue = queueSegment( p_access, false );
         if( unlikely( writevalue < 0 ) )
         {
             block_ChainRelease ( p_buffer );
             return -1;
         }
-        closeCurrentSegment( p_access, p_sys, false );
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
-    {
-        if ( openNextFile( p_access, p_sys ) < 0 )
-           return -1;
-    }
+    /* The segment file is opened by the writer thread */
+    p_sys->b_segment_open = true;
     return writevalue;
 }
 
-static ssize_t writeSegment( sout_access_out_t *p_access )
+/*****************************************************************************
+ * queueSegment: Pass the full segments to the writer thread
+ *****************************************************************************/
+static ssize_t queueSegment( sout_access_out_t *p_access, bool b_isend )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
-    msg_Dbg( p_access, "Writing all full segments" );
+    output_job_t *job = malloc( sizeof( *job ) );
+    size_t i_size;
+
+    if( unlikely( !job ) )
+        return -1;
+
+    job->p_next = NULL;
+    job->p_chain = p_sys->full_segments;
+    job->b_isend = b_isend;
+    block_ChainProperties( job->p_chain, NULL, &i_size, NULL );
 
-    block_t *output = p_sys->full_segments;
     p_sys->full_segments = NULL;
     p_sys->full_segments_end = &p_sys->full_segments;
+    p_sys->b_segment_open = false;
+    p_sys->b_segment_has_data = false;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->i_jobs >= p_sys->i_max_jobs )
+    {
+        vlc_tick_t start = vlc_tick_now();
+
+        msg_Dbg( p_access, "segments writer is late, stalling" );
+        while( p_sys->i_jobs >= p_sys->i_max_jobs )
+            vlc_cond_wait( &p_sys->space, &p_sys->lock );
+        p_sys->i_stalls++;
+        p_sys->stall_time += vlc_tick_now() - start;
+    }
+
+    *p_sys->pp_jobs_end = job;
+    p_sys->pp_jobs_end = &job->p_next;
+    p_sys->i_jobs++;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+    return i_size;
+}
+
+/*****************************************************************************
+ * WriterThread: Write, encrypt and index the full segments
+ *****************************************************************************/
+static void *WriterThread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        while( !p_sys->p_jobs && !p_sys->b_dead )
+            vlc_cond_wait( &p_sys->wait, &p_sys->lock );
+
+        output_job_t *job = p_sys->p_jobs;
+        if( !job )
+            break; /* all segments were written */
+
+        p_sys->p_jobs = job->p_next;
+        if( !p_sys->p_jobs )
+            p_sys->pp_jobs_end = &p_sys->p_jobs;
+        p_sys->i_jobs--;
+        vlc_cond_signal( &p_sys->space );
+        vlc_mutex_unlock( &p_sys->lock );
+
+        vlc_tick_t start = vlc_tick_now();
+        bool b_error = false;
+
+        if ( !p_sys->b_open && openNextFile( p_access, p_sys ) < 0 )
+        {
+            block_ChainRelease( job->p_chain );
+            b_error = true;
+        }
+        else
+        {
+            b_error = writeSegment( p_access, job->p_chain ) < 0;
+            closeCurrentSegment( p_access, p_sys, job->b_isend );
+        }
+
+        vlc_tick_t duration = vlc_tick_now() - start;
+        free( job );
+
+        vlc_mutex_lock( &p_sys->lock );
+        if( b_error )
+            p_sys->b_error = true;
+        p_sys->i_writes++;
+        p_sys->write_time += duration;
+        if( duration > p_sys->write_max )
+            p_sys->write_max = duration;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
+static ssize_t writeSegment( sout_access_out_t *p_access, block_t *output )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    msg_Dbg( p_access, "Writing all full segments" );
 
     vlc_tick_t current_length = 0;
     block_ChainProperties( output, NULL, NULL, &current_length );
 
     ssize_t i_write=0;
-    bool crypted = false;
     p_sys->current_segment_length = current_length;
     while( output )
     {
-        if( p_sys->key_uri && !crypted )
+        block_t *p_next = output->p_next;
+        output->p_next = NULL;
+
+        if( p_sys->key_uri )
         {
             if( p_sys->stuffing_size )
             {
                 output = block_Realloc( output, p_sys->stuffing_size, output->i_buffer );
                 if( unlikely(!output ) )
+                {
+                    block_ChainRelease( p_next );
                     return VLC_ENOMEM;
+                }
                 memcpy( output->p_buffer, p_sys->stuffing_bytes, p_sys->stuffing_size );
                 p_sys->stuffing_size = 0;
             }
+            else
+            {
+                /* Encrypting in place: the muxer may pass its input through */
+                output = block_MakeWritable( output );
+                if( unlikely(!output) )
+                {
+                    block_ChainRelease( p_next );
+                    return VLC_ENOMEM;
+                }
+            }
             size_t original = output->i_buffer;
             size_t padded = (output->i_buffer + 15 ) & ~15;
             size_t pad = padded - original;
@@ -974,34 +1341,20 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
             if( err )
             {
                 msg_Err( p_access, "Encryption failure: %s ", gpg_strerror(err) );
+                block_Release( output );
+                block_ChainRelease( p_next );
                 return -1;
             }
-            crypted=true;
-
         }
 
-        ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
+        ssize_t val = segmentWrite( p_sys, output );
         if ( val == -1 )
         {
-           if ( errno == EINTR )
-              continue;
-           return -1;
-        }
-
-
-        if ( (size_t)val >= output->i_buffer )
-        {
-           block_t *p_next = output->p_next;
-           block_Release (output);
-           output = p_next;
-           crypted=false;
-        }
-        else
-        {
-           output->p_buffer += val;
-           output->i_buffer -= val;
+            block_ChainRelease( p_next );
+            return -1;
         }
         i_write += val;
+        output = p_next;
     }
     return i_write;
 }
@@ -1013,6 +1366,17 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     size_t i_write = 0;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    bool b_error = p_sys->b_error;
+    vlc_mutex_unlock( &p_sys->lock );
+    if( b_error )
+    {
+        msg_Err( p_access, "Error writing segments" );
+        block_ChainRelease( p_buffer );
+        return -1;
+    }
+
     while( p_buffer )
     {
         /* Check if current block is already past segment-length
@@ -45,6 +45,9 @@
 #elif defined (HAVE_SYS_SOCKET_H)
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#   include <sys/uio.h>
+#endif
 
 #include <vlc_network.h>
 
@@ -70,6 +73,16 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Packets per send call")
+#define BATCH_LONGTEXT N_("Maximum number of packets sent with a single " \
+                          "system call. Packets are only grouped if they " \
+                          "are due within the batch window." )
+
+#define WINDOW_TEXT N_("Batch window (ms)")
+#define WINDOW_LONGTEXT N_("Packets due within this delay are sent along " \
+                           "with the current packet. Packets carrying a " \
+                           "clock reference are never sent early." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -78,6 +91,10 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 32, 1, 1024,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer_with_range( SOUT_CFG_PREFIX "batch-window", 1, 0, 100,
+                            WINDOW_TEXT, WINDOW_LONGTEXT, true )
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -91,6 +108,8 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+    "batch",
+    "batch-window",
     NULL
 };
 
@@ -117,9 +136,35 @@ typedef struct
     block_fifo_t *p_fifo;
     block_t      *p_buffer;
 
+    /* Sender thread state */
+    block_t     **pp_batch;
+    unsigned      i_batch_max;
+    unsigned      i_batch;
+    block_t      *p_pending;
+    vlc_tick_t    i_window;
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr *p_msgs;
+    struct iovec  *p_iovs;
+#endif
+
+    /* Statistics */
+    uint64_t      i_sent_packets;
+    uint64_t      i_sent_bytes;
+    uint64_t      i_send_calls;
+    uint64_t      i_late_packets;
+    vlc_tick_t    i_first_date;
+    vlc_tick_t    i_first_send;
+    vlc_tick_t    i_last_date;
+    vlc_tick_t    i_last_send;
+    vlc_tick_t    i_last_report;
+
     vlc_thread_t  thread;
 } sout_access_out_sys_t;
 
+/* A packet sent later than this after its due date is counted as late */
+#define LATE_THRESHOLD VLC_TICK_FROM_MS(20)
+#define REPORT_INTERVAL VLC_TICK_FROM_SEC(10)
+
 #define DEFAULT_PORT 1234
 
 /*****************************************************************************
@@ -209,20 +254,78 @@ static int Open( vlc_object_t *p_this )
     p_sys->p_fifo = block_FifoNew();
     p_sys->p_buffer = NULL;
 
+    p_sys->i_batch_max = var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" );
+    p_sys->i_window = VLC_TICK_FROM_MS(
+                var_GetInteger( p_access, SOUT_CFG_PREFIX "batch-window" ) );
+    p_sys->i_batch = 0;
+    p_sys->p_pending = NULL;
+    p_sys->pp_batch = vlc_alloc( p_sys->i_batch_max,
+                                 sizeof( *p_sys->pp_batch ) );
+#ifdef HAVE_SENDMMSG
+    p_sys->p_msgs = calloc( p_sys->i_batch_max, sizeof( *p_sys->p_msgs ) );
+    p_sys->p_iovs = calloc( p_sys->i_batch_max, sizeof( *p_sys->p_iovs ) );
+#endif
+
+    p_sys->i_sent_packets = p_sys->i_sent_bytes = 0;
+    p_sys->i_send_calls = p_sys->i_late_packets = 0;
+    p_sys->i_first_date = p_sys->i_first_send = VLC_TICK_INVALID;
+    p_sys->i_last_date = p_sys->i_last_send = VLC_TICK_INVALID;
+    p_sys->i_last_report = VLC_TICK_INVALID;
+
+    if( unlikely(p_sys->p_fifo == NULL || p_sys->pp_batch == NULL) )
+        goto error;
+#ifdef HAVE_SENDMMSG
+    if( unlikely(p_sys->p_msgs == NULL || p_sys->p_iovs == NULL) )
+        goto error;
+#endif
+
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         msg_Err( p_access, "cannot spawn sout access thread" );
-        block_FifoRelease( p_sys->p_fifo );
-        net_Close (i_handle);
-        free (p_sys);
-        return VLC_EGENERIC;
+        goto error;
     }
 
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
     return VLC_SUCCESS;
+
+error:
+    if( p_sys->p_fifo != NULL )
+        block_FifoRelease( p_sys->p_fifo );
+#ifdef HAVE_SENDMMSG
+    free( p_sys->p_msgs );
+    free( p_sys->p_iovs );
+#endif
+    free( p_sys->pp_batch );
+    net_Close (i_handle);
+    free (p_sys);
+    return VLC_EGENERIC;
+}
+
+static void ReportStats( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->i_send_calls == 0 )
+        return;
+
+    vlc_tick_t i_stream = p_sys->i_last_date - p_sys->i_first_date;
+    vlc_tick_t i_wall = p_sys->i_last_send - p_sys->i_first_send;
+
+    msg_Dbg( p_access, "sent %"PRIu64" packets in %"PRIu64" calls, "
+             "%"PRIu64" late", p_sys->i_sent_packets, p_sys->i_send_calls,
+             p_sys->i_late_packets );
+    if( i_stream > 0 && i_wall > 0 )
+    {
+        uint64_t i_expected = p_sys->i_sent_bytes * 8 * CLOCK_FREQ / i_stream;
+        uint64_t i_achieved = p_sys->i_sent_bytes * 8 * CLOCK_FREQ / i_wall;
+
+        msg_Dbg( p_access, "bitrate %"PRIu64" bit/s, stream %"PRIu64" bit/s "
+                 "(%.2f%%)", i_achieved, i_expected,
+                 100. * i_achieved / i_expected );
+    }
 }
 
 /*****************************************************************************
@@ -239,6 +342,17 @@ static void Close( vlc_object_t * p_this )
 
     if( p_sys->p_buffer ) block_Release( p_sys->p_buffer );
 
+    ReportStats( p_access );
+    for( unsigned i = 0; i < p_sys->i_batch; i++ )
+        block_Release( p_sys->pp_batch[i] );
+    if( p_sys->p_pending != NULL )
+        block_Release( p_sys->p_pending );
+    free( p_sys->pp_batch );
+#ifdef HAVE_SENDMMSG
+    free( p_sys->p_msgs );
+    free( p_sys->p_iovs );
+#endif
+
     net_Close( p_sys->i_handle );
     free( p_sys );
 }
@@ -345,6 +459,99 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
     return i_len;
 }
 
+/*****************************************************************************
+ * SendBatch: send the packets of the current batch
+ *****************************************************************************/
+static void SendBatch( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    unsigned i_count = p_sys->i_batch;
+    unsigned i_sent = 0;
+    vlc_tick_t now = vlc_tick_now();
+
+    for( unsigned i = 0; i < i_count; i++ )
+        if( now - (p_sys->i_caching + p_sys->pp_batch[i]->i_dts)
+                > LATE_THRESHOLD )
+            p_sys->i_late_packets++;
+
+#ifdef HAVE_SENDMMSG
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        p_sys->p_iovs[i].iov_base = p_sys->pp_batch[i]->p_buffer;
+        p_sys->p_iovs[i].iov_len = p_sys->pp_batch[i]->i_buffer;
+        p_sys->p_msgs[i].msg_hdr.msg_iov = &p_sys->p_iovs[i];
+        p_sys->p_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while( i_sent < i_count )
+    {
+        int val = sendmmsg( p_sys->i_handle, p_sys->p_msgs + i_sent,
+                            i_count - i_sent, 0 );
+        p_sys->i_send_calls++;
+        if( val == -1 )
+        {   /* Skip the failed packet */
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            val = 1;
+        }
+        else
+        {
+            for( int i = 0; i < val; i++ )
+                p_sys->i_sent_bytes += p_sys->p_msgs[i_sent + i].msg_len;
+            p_sys->i_sent_packets += val;
+        }
+        i_sent += val;
+    }
+#else
+    for( ; i_sent < i_count; i_sent++ )
+    {
+        block_t *p_pk = p_sys->pp_batch[i_sent];
+
+        p_sys->i_send_calls++;
+        if( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+        else
+        {
+            p_sys->i_sent_bytes += p_pk->i_buffer;
+            p_sys->i_sent_packets++;
+        }
+    }
+#endif
+
+    for( unsigned i = 0; i < i_count; i++ )
+        block_Release( p_sys->pp_batch[i] );
+    p_sys->i_batch = 0;
+}
+
+/*****************************************************************************
+ * DropPacket: check the date of a packet against the previous one
+ *****************************************************************************
+ * A packet more than 2 s after the previous one is dropped.
+ *****************************************************************************/
+static bool DropPacket( sout_access_out_t *p_access, vlc_tick_t i_date,
+                        vlc_tick_t *pi_date_last, unsigned i_dropped_packets )
+{
+    vlc_tick_t i_date_last = *pi_date_last;
+
+    *pi_date_last = i_date;
+    if( i_date_last <= 0 )
+        return false;
+
+    if( i_date - i_date_last > VLC_TICK_FROM_SEC(2) )
+    {
+        if( !i_dropped_packets )
+            msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
+                     i_date - i_date_last );
+        return true;
+    }
+    else if( i_date - i_date_last < VLC_TICK_FROM_MS(-1) )
+    {
+        if( !i_dropped_packets )
+            msg_Dbg( p_access, "mmh, packets in the past (%"PRId64")",
+                     i_date_last - i_date );
+    }
+    return false;
+}
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
@@ -360,42 +567,70 @@ static void* ThreadWrite( void *data )
 
     for (;;)
     {
-        block_t *p_pk = block_FifoGet( p_sys->p_fifo );
+        block_t *p_pk = p_sys->p_pending;
         vlc_tick_t    i_date;
 
+        if( p_pk != NULL )
+            p_sys->p_pending = NULL;
+        else
+            p_pk = block_FifoGet( p_sys->p_fifo );
+
         i_date = p_sys->i_caching + p_pk->i_dts;
-        if( i_date_last > 0 )
+        if( DropPacket( p_access, i_date, &i_date_last, i_dropped_packets ) )
         {
-            if( i_date - i_date_last > VLC_TICK_FROM_SEC(2) )
-            {
-                if( !i_dropped_packets )
-                    msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
-                             i_date - i_date_last );
-
-                block_Release( p_pk );
-
-                i_date_last = i_date;
-                i_dropped_packets++;
-                continue;
-            }
-            else if( i_date - i_date_last < VLC_TICK_FROM_MS(-1) )
-            {
-                if( !i_dropped_packets )
-                    msg_Dbg( p_access, "mmh, packets in the past (%"PRId64")",
-                             i_date_last - i_date );
-            }
+            block_Release( p_pk );
+            i_dropped_packets++;
+            continue;
         }
 
-        block_cleanup_push( p_pk );
+        /* Released by Close() if cancelled while waiting or sending */
+        p_sys->pp_batch[p_sys->i_batch++] = p_pk;
         i_to_send--;
         if( !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK) )
         {
             vlc_tick_wait( i_date );
             i_to_send = i_group;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
-            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
-        vlc_cleanup_pop();
+
+        /* Add packets due within the batch window, but never send a clock
+         * reference before its time. */
+        vlc_tick_t now = vlc_tick_now();
+        vlc_tick_t i_date_batch = i_date;
+
+        vlc_fifo_Lock( p_sys->p_fifo );
+        while( p_sys->i_batch < p_sys->i_batch_max
+            && !vlc_fifo_IsEmpty( p_sys->p_fifo ) )
+        {
+            block_t *p_next = vlc_fifo_DequeueUnlocked( p_sys->p_fifo );
+            vlc_tick_t i_date_next = p_sys->i_caching + p_next->i_dts;
+
+            if( i_date_next > now
+             && ( i_date_next > now + p_sys->i_window
+               || (p_next->i_flags & BLOCK_FLAG_CLOCK)
+               || i_to_send == 1 ) )
+            {
+                p_sys->p_pending = p_next;
+                break;
+            }
+
+            /* Batched packets are checked as if sent one by one */
+            if( DropPacket( p_access, i_date_next, &i_date_last,
+                            i_dropped_packets ) )
+            {
+                block_Release( p_next );
+                i_dropped_packets++;
+                continue;
+            }
+
+            p_sys->pp_batch[p_sys->i_batch++] = p_next;
+            if( --i_to_send == 0 )
+                i_to_send = i_group;
+            i_date_batch = i_date_next;
+        }
+        vlc_fifo_Unlock( p_sys->p_fifo );
+
+        SendBatch( p_access );
+        now = vlc_tick_now();
 
         if( i_dropped_packets )
         {
@@ -403,19 +638,27 @@ static void* ThreadWrite( void *data )
             i_dropped_packets = 0;
         }
 
-        i_date_last = i_date;
-
-#if 1
-        i_date = vlc_tick_now() - i_date;
-        if ( i_date > VLC_TICK_FROM_MS(20) )
+        if( now - i_date > LATE_THRESHOLD )
         {
             msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
-                     i_date );
+                     now - i_date );
         }
-#endif
 
-        block_Release( p_pk );
+        /* Statistics */
+        if( p_sys->i_first_send == VLC_TICK_INVALID )
+        {
+            p_sys->i_first_send = now;
+            p_sys->i_first_date = i_date;
+            p_sys->i_last_report = now;
+        }
+        p_sys->i_last_send = now;
+        p_sys->i_last_date = i_date_batch;
 
+        if( now - p_sys->i_last_report >= REPORT_INTERVAL )
+        {
+            ReportStats( p_access );
+            p_sys->i_last_report = now;
+        }
     }
     return NULL;
 }
@@ -37,6 +37,7 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 
 /*****************************************************************************
@@ -58,6 +59,7 @@ vlc_module_end()
 
 typedef block_t *(*cvt_t)(filter_t *, block_t *);
 static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst);
+static const struct cvt_kernel *FindKernel(vlc_fourcc_t src, vlc_fourcc_t dst);
 
 static int Open(vlc_object_t *object)
 {
@@ -75,13 +77,622 @@ static int Open(vlc_object_t *object)
     if (filter->pf_audio_filter == NULL)
         return VLC_EGENERIC;
 
-    msg_Dbg(filter, "%4.4s->%4.4s, bits per sample: %i->%i",
+    filter->p_sys = (void *)FindKernel(src->i_codec, dst->i_codec);
+
+    msg_Dbg(filter, "%4.4s->%4.4s, bits per sample: %i->%i%s",
             (char *)&src->i_codec, (char *)&dst->i_codec,
-            src->audio.i_bitspersample, dst->audio.i_bitspersample);
+            src->audio.i_bitspersample, dst->audio.i_bitspersample,
+            (filter->p_sys != NULL) ? " (vectorized)" : "");
     return VLC_SUCCESS;
 }
 
 
+/*****************************************************************************
+ * Vectorized kernels
+ *****************************************************************************
+ * Each kernel converts the leading samples of a buffer, as many as suit its
+ * vector size, and returns their count; the scalar loops do the rest. The
+ * results are bit-exact with the scalar code, including rounding and
+ * clipping (but for NaN inputs). Kernels may convert in place, as long as
+ * the output samples are not wider than the input ones.
+ *****************************************************************************/
+typedef size_t (*kernel_t)(void *, const void *, size_t);
+
+#if defined(HAVE_SSE2_INTRINSICS) || defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+
+#ifdef HAVE_SSE2_INTRINSICS
+static bool HasSSE2(void)
+{
+    return vlc_CPU_SSE2();
+}
+
+VLC_SSE2_TARGET
+static size_t S16toFl32SSE2(void *restrict p_dst, const void *restrict p_src,
+                            size_t count)
+{
+    const int16_t *src = p_src;
+    float *dst = p_dst;
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+/* Walken's trick, as in the scalar code: the biased float holds the
+ * rounded integer in its mantissa, clipped by the saturating pack. */
+VLC_SSE2_TARGET
+static inline __m128i Fl32toS16BiasedSSE2(__m128 f)
+{
+    const __m128i u = _mm_castps_si128(_mm_add_ps(f, _mm_set1_ps(384.f)));
+    const __m128i neg = _mm_cmplt_epi32(u, _mm_setzero_si128());
+    const __m128i v = _mm_sub_epi32(u, _mm_set1_epi32(0x43c00000));
+
+    return _mm_or_si128(_mm_andnot_si128(neg, v),
+                        _mm_and_si128(neg, _mm_set1_epi32(-32768)));
+}
+
+VLC_SSE2_TARGET
+static size_t Fl32toS16SSE2(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int16_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m128i lo = Fl32toS16BiasedSSE2(_mm_loadu_ps(src + i));
+        __m128i hi = Fl32toS16BiasedSSE2(_mm_loadu_ps(src + i + 4));
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(lo, hi));
+    }
+    return i;
+}
+
+VLC_SSE2_TARGET
+static size_t S32toFl32SSE2(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    float *dst = p_dst;
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    }
+    return i;
+}
+
+VLC_SSE2_TARGET
+static size_t Fl32toS32SSE2(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int32_t *dst = p_dst;
+    const __m128 half = _mm_set1_ps(.5f), neg_half = _mm_set1_ps(-.5f);
+    const __m128 limit = _mm_set1_ps(2147483648.f);
+    const __m128 neg_limit = _mm_set1_ps(-2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        __m128 s = _mm_mul_ps(_mm_loadu_ps(src + i), limit);
+        __m128i v = _mm_cvttps_epi32(s);
+        __m128 frac = _mm_sub_ps(s, _mm_cvtepi32_ps(v));
+
+        /* Round half away from zero, like lroundf() */
+        v = _mm_sub_epi32(v, _mm_castps_si128(_mm_cmpge_ps(frac, half)));
+        v = _mm_add_epi32(v, _mm_castps_si128(_mm_cmple_ps(frac, neg_half)));
+
+        __m128i over = _mm_castps_si128(_mm_cmpge_ps(s, limit));
+        __m128i under = _mm_castps_si128(_mm_cmple_ps(s, neg_limit));
+        v = _mm_or_si128(_mm_andnot_si128(_mm_or_si128(over, under), v),
+                         _mm_or_si128(
+                             _mm_and_si128(over, _mm_set1_epi32(INT32_MAX)),
+                             _mm_and_si128(under, _mm_set1_epi32(INT32_MIN))));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+    return i;
+}
+
+VLC_SSE2_TARGET
+static size_t Fl32toFl64SSE2(void *restrict p_dst, const void *restrict p_src,
+                             size_t count)
+{
+    const float *src = p_src;
+    double *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        __m128 s = _mm_loadu_ps(src + i);
+
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(s));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(s, s)));
+    }
+    return i;
+}
+
+VLC_SSE2_TARGET
+static size_t Fl64toFl32SSE2(void *p_dst, const void *p_src, size_t count)
+{
+    const double *src = p_src;
+    float *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+    return i;
+}
+
+VLC_SSE2_TARGET
+static size_t S16toS32SSE2(void *restrict p_dst, const void *restrict p_src,
+                           size_t count)
+{
+    const int16_t *src = p_src;
+    int32_t *dst = p_dst;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(zero, s));
+        _mm_storeu_si128((__m128i *)(dst + i + 4),
+                         _mm_unpackhi_epi16(zero, s));
+    }
+    return i;
+}
+
+VLC_SSE2_TARGET
+static size_t S32toS16SSE2(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    int16_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packs_epi32(_mm_srai_epi32(lo, 16),
+                                         _mm_srai_epi32(hi, 16)));
+    }
+    return i;
+}
+#endif /* HAVE_SSE2_INTRINSICS */
+
+#ifdef HAVE_AVX2_INTRINSICS
+static bool HasAVX2(void)
+{
+    return vlc_CPU_AVX2();
+}
+
+VLC_AVX2_TARGET
+static size_t S16toFl32AVX2(void *restrict p_dst, const void *restrict p_src,
+                            size_t count)
+{
+    const int16_t *src = p_src;
+    float *dst = p_dst;
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i + 8)));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static inline __m256i Fl32toS16BiasedAVX2(__m256 f)
+{
+    const __m256i u = _mm256_castps_si256(
+                        _mm256_add_ps(f, _mm256_set1_ps(384.f)));
+    const __m256i neg = _mm256_cmpgt_epi32(_mm256_setzero_si256(), u);
+    const __m256i v = _mm256_sub_epi32(u, _mm256_set1_epi32(0x43c00000));
+
+    return _mm256_blendv_epi8(v, _mm256_set1_epi32(-32768), neg);
+}
+
+VLC_AVX2_TARGET
+static size_t Fl32toS16AVX2(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int16_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m256i lo = Fl32toS16BiasedAVX2(_mm256_loadu_ps(src + i));
+        __m256i hi = Fl32toS16BiasedAVX2(_mm256_loadu_ps(src + i + 8));
+        /* The pack works within 128-bits lanes: restore the order */
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+                                             _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static size_t S32toFl32AVX2(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    float *dst = p_dst;
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static size_t Fl32toS32AVX2(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int32_t *dst = p_dst;
+    const __m256 half = _mm256_set1_ps(.5f), neg_half = _mm256_set1_ps(-.5f);
+    const __m256 limit = _mm256_set1_ps(2147483648.f);
+    const __m256 neg_limit = _mm256_set1_ps(-2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256 s = _mm256_mul_ps(_mm256_loadu_ps(src + i), limit);
+        __m256i v = _mm256_cvttps_epi32(s);
+        __m256 frac = _mm256_sub_ps(s, _mm256_cvtepi32_ps(v));
+
+        /* Round half away from zero, like lroundf() */
+        v = _mm256_sub_epi32(v, _mm256_castps_si256(
+                                 _mm256_cmp_ps(frac, half, _CMP_GE_OQ)));
+        v = _mm256_add_epi32(v, _mm256_castps_si256(
+                                 _mm256_cmp_ps(frac, neg_half, _CMP_LE_OQ)));
+
+        __m256 over = _mm256_cmp_ps(s, limit, _CMP_GE_OQ);
+        __m256 under = _mm256_cmp_ps(s, neg_limit, _CMP_LE_OQ);
+        v = _mm256_blendv_epi8(v, _mm256_set1_epi32(INT32_MAX),
+                               _mm256_castps_si256(over));
+        v = _mm256_blendv_epi8(v, _mm256_set1_epi32(INT32_MIN),
+                               _mm256_castps_si256(under));
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static size_t Fl32toFl64AVX2(void *restrict p_dst, const void *restrict p_src,
+                             size_t count)
+{
+    const float *src = p_src;
+    double *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+        _mm256_storeu_pd(dst + i + 4,
+                         _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static size_t Fl64toFl32AVX2(void *p_dst, const void *p_src, size_t count)
+{
+    const double *src = p_src;
+    float *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4));
+
+        _mm256_storeu_ps(dst + i,
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static size_t S16toS32AVX2(void *restrict p_dst, const void *restrict p_src,
+                           size_t count)
+{
+    const int16_t *src = p_src;
+    int32_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i + 8)));
+
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_slli_epi32(lo, 16));
+        _mm256_storeu_si256((__m256i *)(dst + i + 8),
+                            _mm256_slli_epi32(hi, 16));
+    }
+    return i;
+}
+
+VLC_AVX2_TARGET
+static size_t S32toS16AVX2(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    int16_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i v = _mm256_packs_epi32(_mm256_srai_epi32(lo, 16),
+                                       _mm256_srai_epi32(hi, 16));
+
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    return i;
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+
+static bool HasNEON(void)
+{
+    return vlc_CPU_ARM_NEON();
+}
+
+static size_t S16toFl32NEON(void *restrict p_dst, const void *restrict p_src,
+                            size_t count)
+{
+    const int16_t *src = p_src;
+    float *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        int16x8_t s = vld1q_s16(src + i);
+        int32x4_t lo = vmovl_s16(vget_low_s16(s));
+        int32x4_t hi = vmovl_s16(vget_high_s16(s));
+
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(lo), 1.f / 32768.f));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(hi), 1.f / 32768.f));
+    }
+    return i;
+}
+
+static inline int32x4_t Fl32toS16BiasedNEON(float32x4_t f)
+{
+    const int32x4_t u = vreinterpretq_s32_f32(vaddq_f32(f,
+                                                        vdupq_n_f32(384.f)));
+    const uint32x4_t neg = vcltq_s32(u, vdupq_n_s32(0));
+    const int32x4_t v = vsubq_s32(u, vdupq_n_s32(0x43c00000));
+
+    return vbslq_s32(neg, vdupq_n_s32(-32768), v);
+}
+
+static size_t Fl32toS16NEON(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int16_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        int32x4_t lo = Fl32toS16BiasedNEON(vld1q_f32(src + i));
+        int32x4_t hi = Fl32toS16BiasedNEON(vld1q_f32(src + i + 4));
+
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    return i;
+}
+
+static size_t S32toFl32NEON(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    float *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)),
+                                       1.f / 2147483648.f));
+    return i;
+}
+
+static size_t Fl32toS32NEON(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int32_t *dst = p_dst;
+    const float32x4_t limit = vdupq_n_f32(2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        float32x4_t s = vmulq_f32(vld1q_f32(src + i), limit);
+        int32x4_t v = vcvtq_s32_f32(s);
+        float32x4_t frac = vsubq_f32(s, vcvtq_f32_s32(v));
+
+        /* Round half away from zero, like lroundf() */
+        v = vsubq_s32(v, vreinterpretq_s32_u32(
+                             vcgeq_f32(frac, vdupq_n_f32(.5f))));
+        v = vaddq_s32(v, vreinterpretq_s32_u32(
+                             vcleq_f32(frac, vdupq_n_f32(-.5f))));
+
+        v = vbslq_s32(vcgeq_f32(s, limit), vdupq_n_s32(INT32_MAX), v);
+        v = vbslq_s32(vcleq_f32(s, vnegq_f32(limit)),
+                      vdupq_n_s32(INT32_MIN), v);
+        vst1q_s32(dst + i, v);
+    }
+    return i;
+}
+
+# ifdef __aarch64__
+static size_t Fl32toFl64NEON(void *restrict p_dst, const void *restrict p_src,
+                             size_t count)
+{
+    const float *src = p_src;
+    double *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        float32x4_t s = vld1q_f32(src + i);
+
+        vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(s)));
+        vst1q_f64(dst + i + 2, vcvt_high_f64_f32(s));
+    }
+    return i;
+}
+
+static size_t Fl64toFl32NEON(void *p_dst, const void *p_src, size_t count)
+{
+    const double *src = p_src;
+    float *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(src + i));
+        float32x2_t hi = vcvt_f32_f64(vld1q_f64(src + i + 2));
+
+        vst1q_f32(dst + i, vcombine_f32(lo, hi));
+    }
+    return i;
+}
+# endif
+
+static size_t S16toS32NEON(void *restrict p_dst, const void *restrict p_src,
+                           size_t count)
+{
+    const int16_t *src = p_src;
+    int32_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        int16x8_t s = vld1q_s16(src + i);
+
+        vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(s), 16));
+        vst1q_s32(dst + i + 4, vshll_n_s16(vget_high_s16(s), 16));
+    }
+    return i;
+}
+
+static size_t S32toS16NEON(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    int16_t *dst = p_dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        int16x4_t lo = vshrn_n_s32(vld1q_s32(src + i), 16);
+        int16x4_t hi = vshrn_n_s32(vld1q_s32(src + i + 4), 16);
+
+        vst1q_s16(dst + i, vcombine_s16(lo, hi));
+    }
+    return i;
+}
+#endif /* __ARM_NEON */
+
+static const struct cvt_kernel {
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    bool (*available)(void);
+    kernel_t convert;
+} cvt_kernels[] = {
+#ifdef HAVE_AVX2_INTRINSICS
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, HasAVX2, S16toFl32AVX2  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, HasAVX2, S16toS32AVX2   },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, HasAVX2, Fl32toS16AVX2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, HasAVX2, Fl32toS32AVX2  },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, HasAVX2, Fl32toFl64AVX2 },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, HasAVX2, S32toS16AVX2   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, HasAVX2, S32toFl32AVX2  },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, HasAVX2, Fl64toFl32AVX2 },
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, HasSSE2, S16toFl32SSE2  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, HasSSE2, S16toS32SSE2   },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, HasSSE2, Fl32toS16SSE2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, HasSSE2, Fl32toS32SSE2  },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, HasSSE2, Fl32toFl64SSE2 },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, HasSSE2, S32toS16SSE2   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, HasSSE2, S32toFl32SSE2  },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, HasSSE2, Fl64toFl32SSE2 },
+#endif
+#ifdef __ARM_NEON
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, HasNEON, S16toFl32NEON  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, HasNEON, S16toS32NEON   },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, HasNEON, Fl32toS16NEON  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, HasNEON, Fl32toS32NEON  },
+# ifdef __aarch64__
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, HasNEON, Fl32toFl64NEON },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, HasNEON, Fl64toFl32NEON },
+# endif
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, HasNEON, S32toS16NEON   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, HasNEON, S32toFl32NEON  },
+#endif
+    { 0, 0, NULL, NULL }
+};
+
+/* Picks the best kernel supported by the CPU, if any */
+static const struct cvt_kernel *FindKernel(vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    for (int i = 0; cvt_kernels[i].convert; i++) {
+        if (cvt_kernels[i].src == src &&
+            cvt_kernels[i].dst == dst &&
+            cvt_kernels[i].available())
+            return &cvt_kernels[i];
+    }
+    return NULL;
+}
+
+/* Converts the leading samples with the kernel selected at opening, if any */
+static size_t Vectorized(filter_t *filter, void *dst, const void *src,
+                         size_t count)
+{
+    const struct cvt_kernel *kernel = filter->p_sys;
+    return (kernel != NULL) ? kernel->convert(dst, src, count) : 0;
+}
+
+
 /*** from U8 ***/
 static block_t *U8toS16(filter_t *filter, block_t *bsrc)
 {
@@ -174,7 +785,11 @@ static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
     block_CopyProperties(bdst, bsrc);
     int16_t *src = (int16_t *)bsrc->p_buffer;
     float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    size_t count = bsrc->i_buffer / 2;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
 #if 0
         /* Slow version */
         *dst++ = (float)*src++ / 32768.f;
@@ -202,7 +817,11 @@ static block_t *S16toS32(filter_t *filter, block_t *bsrc)
     block_CopyProperties(bdst, bsrc);
     int16_t *src = (int16_t *)bsrc->p_buffer;
     int32_t *dst = (int32_t *)bdst->p_buffer;
-    for (int i = bsrc->i_buffer / 2; i--;)
+    size_t count = bsrc->i_buffer / 2;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
         *dst++ = *src++ << 16;
 out:
     block_Release(bsrc);
@@ -254,7 +873,11 @@ static block_t *Fl32toS16(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     float   *src = (float *)b->p_buffer;
     int16_t *dst = (int16_t *)src;
-    for (int i = b->i_buffer / 4; i--;) {
+    size_t count = b->i_buffer / 4;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;) {
 #if 0
         /* Slow version. */
         if (*src >= 1.0) *dst = 32767;
@@ -281,7 +904,11 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
 {
     float   *src = (float *)b->p_buffer;
     int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    size_t count = b->i_buffer / 4;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
     {
         float s = *(src++) * 2147483648.f;
         if (s >= 2147483647.f)
@@ -305,7 +932,11 @@ static block_t *Fl32toFl64(filter_t *filter, block_t *bsrc)
     block_CopyProperties(bdst, bsrc);
     float  *src = (float *)bsrc->p_buffer;
     double *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 4; i--;)
+    size_t count = bsrc->i_buffer / 4;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
         *(dst++) = *(src++);
 out:
     block_Release(bsrc);
@@ -332,7 +963,11 @@ static block_t *S32toS16(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     int32_t *src = (int32_t *)b->p_buffer;
     int16_t *dst = (int16_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    size_t count = b->i_buffer / 4;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
         *dst++ = (*src++) >> 16;
 
     b->i_buffer /= 2;
@@ -344,7 +979,11 @@ static block_t *S32toFl32(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     int32_t *src = (int32_t*)b->p_buffer;
     float   *dst = (float *)src;
-    for (int i = b->i_buffer / 4; i--;)
+    size_t count = b->i_buffer / 4;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
         *dst++ = (float)(*src++) / 2147483648.f;
     return b;
 }
@@ -411,9 +1050,14 @@ static block_t *Fl64toFl32(filter_t *filter, block_t *b)
 {
     double *src = (double *)b->p_buffer;
     float  *dst = (float *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
+    size_t count = b->i_buffer / 8;
+    size_t done = Vectorized(filter, dst, src, count);
+    src += done;
+    dst += done;
+    for (size_t i = count - done; i--;)
         *(dst++) = *(src++);
 
+    b->i_buffer /= 2;
     VLC_UNUSED(filter);
     return b;
 }
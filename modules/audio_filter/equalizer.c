@@ -28,7 +28,13 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <math.h>
+#if defined(__SSE__)
+# include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -40,9 +46,6 @@
 #include "equalizer_presets.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
- *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
- *    computation (not too hard once the Q is found).
  *  - support for external preset
  *  - callback to handle preset changes on the fly
  *  - ...
@@ -51,6 +54,11 @@
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
+static const int band_count_list[] = { 10, 15, 31 };
+static const char *const band_count_list_text[] = {
+    N_("10 bands"), N_("15 bands"), N_("31 bands"),
+};
+
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
@@ -68,6 +76,19 @@ static void Close( vlc_object_t * );
          "Use the VLC frequency bands. Otherwise, use the ISO Standard " \
          "frequency bands." )
 
+#define BAND_COUNT_TEXT N_( "Number of bands" )
+#define BAND_COUNT_LONGTEXT N_( \
+         "Number of frequency bands: 10 (octaves), 15 (2/3 octaves) or 31 " \
+         "(1/3 octaves). With more than 10 bands, 10 band gains (e.g. from " \
+         "the presets) are interpolated over the bands." )
+
+#define CHANNEL_BANDS_TEXT N_( "Per-channel bands gain" )
+#define CHANNEL_BANDS_LONGTEXT N_( \
+         "Gains in dB added to the bands gain for each channel, in the " \
+         "order of the audio channels. The values of a channel are " \
+         "separated by spaces, and the channels by semicolons, e.g. " \
+         "\"0 0 2;-2 0 0\"." )
+
 #define TWOPASS_TEXT N_( "Two pass" )
 #define TWOPASS_LONGTEXT N_( "Filter the audio twice. This provides a more "  \
          "intense effect.")
@@ -87,6 +108,11 @@ vlc_module_begin ()
         change_string_list( preset_list, preset_list_text )
     add_string( "equalizer-bands", NULL, BANDS_TEXT,
                 BANDS_LONGTEXT, true )
+    add_integer( "equalizer-band-count", 10, BAND_COUNT_TEXT,
+                 BAND_COUNT_LONGTEXT, true )
+        change_integer_list( band_count_list, band_count_list_text )
+    add_string( "equalizer-channel-bands", NULL, CHANNEL_BANDS_TEXT,
+                CHANNEL_BANDS_LONGTEXT, true )
     add_bool( "equalizer-2pass", false, TWOPASS_TEXT,
               TWOPASS_LONGTEXT, true )
     add_bool( "equalizer-vlcfreqs", true, VLC_BANDS_TEXT,
@@ -100,26 +126,43 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* The bands are independent filters of the same input: they are processed
+ * EQZ_LANES at a time, in vector lanes. */
+#define EQZ_LANES 4
+#define EQZ_BANDS_LIMIT 32 /* multiple of EQZ_LANES */
+
+/* Filter state of a channel for one pass */
+typedef struct
+{
+    float x[2];                   /* last two input samples */
+    float y[2][EQZ_BANDS_LIMIT];  /* last two outputs of each band */
+    unsigned i_last;              /* index of the last outputs in y */
+} eqz_state_t;
+
 typedef struct
 {
     /* Filter static config */
     int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
+    int i_band_lanes; /* i_band rounded up to EQZ_LANES */
+    int i_channels;
+    const float *f_freq_10b; /* frequencies of the 10 bands gains */
+    float f_frequency[EQZ_BANDS_LIMIT];
+    /* Coefficients, zero beyond i_band */
+    float f_alpha[EQZ_BANDS_LIMIT];
+    float f_beta[EQZ_BANDS_LIMIT];
+    float f_gamma[EQZ_BANDS_LIMIT];
 
     /* Filter dyn config */
-    float *f_amp;   /* Per band amp */
+    float f_db[EQZ_BANDS_LIMIT];       /* Per band gain */
+    float (*f_channel_db)[EQZ_BANDS_LIMIT]; /* Per channel, per band offset */
+    float (*f_amp)[EQZ_BANDS_LIMIT];   /* Per channel, per band amp */
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
-    /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
-
-    /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    /* Filter state, per channel */
+    eqz_state_t *state;
+    /* Second filter state, per channel */
+    eqz_state_t *state2;
 
     vlc_mutex_t lock;
 } filter_sys_t;
@@ -137,6 +180,8 @@ static int PreampCallback ( vlc_object_t *, char const *, vlc_value_t,
                             vlc_value_t, void * );
 static int BandsCallback  ( vlc_object_t *, char const *, vlc_value_t,
                             vlc_value_t, void * );
+static int ChannelBandsCallback( vlc_object_t *, char const *, vlc_value_t,
+                                 vlc_value_t, void * );
 static int TwoPassCallback( vlc_object_t *, char const *, vlc_value_t,
                             vlc_value_t, void * );
 
@@ -209,29 +254,40 @@ typedef struct
         float f_alpha;
         float f_beta;
         float f_gamma;
-    } band[EQZ_BANDS_MAX];
+    } band[EQZ_BANDS_LIMIT];
 
 } eqz_config_t;
 
+/* ISO 2/3 and 1/3 octave bands */
+static const float f_iso_frequency_table_15b[15] =
+{
+    25, 40, 63, 100, 160, 250, 400, 630, 1000, 1600, 2500, 4000, 6300,
+    10000, 16000,
+};
+
+static const float f_iso_frequency_table_31b[31] =
+{
+    20, 25, 31.5, 40, 50, 63, 80, 100, 125, 160, 200, 250, 315, 400, 500,
+    630, 800, 1000, 1250, 1600, 2000, 2500, 3150, 4000, 5000, 6300, 8000,
+    10000, 12500, 16000, 20000,
+};
+
 /* Equalizer coefficient calculation function based on equ-xmms */
 static void EqzCoeffs( int i_rate, float f_octave_percent,
-                       bool b_use_vlc_freqs,
+                       const float *f_freq_table, int i_band,
                        eqz_config_t *p_eqz_config )
 {
-    const float *f_freq_table_10b = b_use_vlc_freqs
-                                  ? f_vlc_frequency_table_10b
-                                  : f_iso_frequency_table_10b;
     float f_rate = (float) i_rate;
     float f_nyquist_freq = 0.5f * f_rate;
     float f_octave_factor = powf( 2.0f, 0.5f * f_octave_percent );
     float f_octave_factor_1 = 0.5f * ( f_octave_factor + 1.0f );
     float f_octave_factor_2 = 0.5f * ( f_octave_factor - 1.0f );
 
-    p_eqz_config->i_band = EQZ_BANDS_MAX;
+    p_eqz_config->i_band = i_band;
 
-    for( int i = 0; i < EQZ_BANDS_MAX; i++ )
+    for( int i = 0; i < i_band; i++ )
     {
-        float f_freq = f_freq_table_10b[i];
+        float f_freq = f_freq_table[i];
 
         p_eqz_config->band[i].f_frequency = f_freq;
 
@@ -276,63 +332,116 @@ static inline float EqzConvertdB( float db )
     return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
 }
 
+/* Maps a gain given for the 10 bands to the frequency of a band, linearly
+ * in dB over the logarithm of the frequency */
+static float EqzInterpolate( const float *f_freq_10b, const float *f_db_10b,
+                             float f_freq )
+{
+    if( f_freq <= f_freq_10b[0] )
+        return f_db_10b[0];
+
+    for( int i = 1; i < EQZ_BANDS_MAX; i++ )
+        if( f_freq <= f_freq_10b[i] )
+        {
+            float f_pos = log2f( f_freq / f_freq_10b[i - 1] )
+                        / log2f( f_freq_10b[i] / f_freq_10b[i - 1] );
+            return f_db_10b[i - 1]
+                 + f_pos * ( f_db_10b[i] - f_db_10b[i - 1] );
+        }
+    return f_db_10b[EQZ_BANDS_MAX - 1];
+}
+
+/* Updates the amps of the bands from their gains, with the lock held */
+static void EqzUpdateAmps( filter_sys_t *p_sys )
+{
+    for( int ch = 0; ch < p_sys->i_channels; ch++ )
+        for( int i = 0; i < p_sys->i_band; i++ )
+            p_sys->f_amp[ch][i] = EqzConvertdB( p_sys->f_db[i] +
+                                                p_sys->f_channel_db[ch][i] );
+}
+
+/* Parses up to i_max gains in dB separated by spaces, returns their count */
+static int EqzParseGains( const char *p, float *f_db, int i_max )
+{
+    int i = 0;
+
+    while( i < i_max )
+    {
+        char *next;
+        /* Read dB -20/20 */
+        float f = us_strtof( p, &next );
+        if( next == p || isnan( f ) )
+            break; /* no conversion */
+
+        f_db[i++] = f;
+
+        if( *next == '\0' )
+            break; /* end of line */
+        p = &next[1];
+    }
+    return i;
+}
+
 static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
-    vlc_value_t val1, val2, val3;
+    int i;
+    vlc_value_t val1, val2, val3, val4;
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
     int i_ret = VLC_ENOMEM;
 
     bool b_vlcFreqs = var_InheritBool( p_aout, "equalizer-vlcfreqs" );
-    EqzCoeffs( i_rate, 1.0f, b_vlcFreqs, &cfg );
+    p_sys->f_freq_10b = b_vlcFreqs ? f_vlc_frequency_table_10b
+                                   : f_iso_frequency_table_10b;
+
+    switch( var_InheritInteger( p_aout, "equalizer-band-count" ) )
+    {
+        case 15:
+            EqzCoeffs( i_rate, 2.0f / 3.0f, f_iso_frequency_table_15b, 15,
+                       &cfg );
+            break;
+        case 31:
+            EqzCoeffs( i_rate, 1.0f / 3.0f, f_iso_frequency_table_31b, 31,
+                       &cfg );
+            break;
+        default:
+            EqzCoeffs( i_rate, 1.0f, p_sys->f_freq_10b, EQZ_BANDS_MAX, &cfg );
+            break;
+    }
 
     /* Create the static filter config */
     p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_gamma = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
-        goto error;
+    p_sys->i_band_lanes = ( cfg.i_band + EQZ_LANES - 1 ) & ~( EQZ_LANES - 1 );
+    p_sys->i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
 
-    for( i = 0; i < p_sys->i_band; i++ )
+    for( i = 0; i < EQZ_BANDS_LIMIT; i++ )
     {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
+        bool b_band = i < p_sys->i_band;
+
+        p_sys->f_frequency[i] = b_band ? cfg.band[i].f_frequency : 0.0f;
+        p_sys->f_alpha[i] = b_band ? cfg.band[i].f_alpha : 0.0f;
+        p_sys->f_beta[i]  = b_band ? cfg.band[i].f_beta  : 0.0f;
+        p_sys->f_gamma[i] = b_band ? cfg.band[i].f_gamma : 0.0f;
+        p_sys->f_db[i] = 0.0f;
     }
 
     /* Filter dyn config */
     p_sys->b_2eqz = false;
     p_sys->f_gamp = 1.0f;
-    p_sys->f_amp  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_amp )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_amp[i] = 0.0f;
-    }
+    p_sys->f_channel_db = calloc( p_sys->i_channels,
+                                  sizeof( *p_sys->f_channel_db ) );
+    p_sys->f_amp = calloc( p_sys->i_channels, sizeof( *p_sys->f_amp ) );
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    p_sys->state = calloc( 2 * p_sys->i_channels, sizeof( *p_sys->state ) );
+    p_sys->state2 = p_sys->state + p_sys->i_channels;
+    if( !p_sys->f_channel_db || !p_sys->f_amp || !p_sys->state )
+        goto error;
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
+    var_Create( p_aout, "equalizer-channel-bands",
+                VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
     p_sys->b_2eqz = var_CreateGetBool( p_aout, "equalizer-2pass" );
@@ -343,6 +452,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     var_Get( p_aout, "equalizer-preset", &val1 );
     var_Get( p_aout, "equalizer-bands", &val2 );
     var_Get( p_aout, "equalizer-preamp", &val3 );
+    var_Get( p_aout, "equalizer-channel-bands", &val4 );
 
     /* Load the preset only if equalizer-bands is not set. */
     if ( val2.psz_string == NULL || *val2.psz_string == '\0' )
@@ -350,13 +460,14 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     free( val1.psz_string );
     BandsCallback(  VLC_OBJECT( p_aout ), NULL, val2, val2, p_sys );
     PreampCallback( VLC_OBJECT( p_aout ), NULL, val3, val3, p_sys );
+    ChannelBandsCallback( VLC_OBJECT( p_aout ), NULL, val4, val4, p_sys );
+    free( val4.psz_string );
 
     /* Exit if we have no preset and no bands value */
     if (!val2.psz_string || !*val2.psz_string)
     {
         msg_Err(p_filter, "No preset selected");
         free( val2.psz_string );
-        free( p_sys->f_amp );
         i_ret = VLC_EGENERIC;
         goto error;
     }
@@ -365,6 +476,8 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     /* Add our own callbacks */
     var_AddCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_AddCallback( p_aout, "equalizer-bands", BandsCallback, p_sys );
+    var_AddCallback( p_aout, "equalizer-channel-bands", ChannelBandsCallback,
+                     p_sys );
     var_AddCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_AddCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
 
@@ -373,23 +486,93 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     for( i = 0; i < p_sys->i_band; i++ )
     {
         msg_Dbg( p_filter, "   %.2f Hz -> factor:%f alpha:%f beta:%f gamma:%f",
-                 cfg.band[i].f_frequency, p_sys->f_amp[i],
+                 cfg.band[i].f_frequency, p_sys->f_amp[0][i],
                  p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
     }
     return VLC_SUCCESS;
 
 error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
+    free( p_sys->f_channel_db );
+    free( p_sys->f_amp );
+    free( p_sys->state );
     return i_ret;
 }
 
+/* Runs the band filters of a channel on a sample, and returns the sum of
+ * their amplified outputs */
+static inline float EqzBands( const filter_sys_t *p_sys, eqz_state_t *st,
+                              const float *amp, float x )
+{
+    const float dx = x - st->x[1];
+    const float *y1 = st->y[st->i_last];
+    float *y2 = st->y[st->i_last ^ 1]; /* replaced by the new outputs */
+
+    st->x[1] = st->x[0];
+    st->x[0] = x;
+    st->i_last ^= 1;
+
+    /* The lanes are summed in the same order in all the versions, so that
+     * they give the same results */
+#if defined(__SSE__)
+    const __m128 vdx = _mm_set1_ps( dx );
+    __m128 acc = _mm_setzero_ps();
+
+    for( int j = 0; j < p_sys->i_band_lanes; j += EQZ_LANES )
+    {
+        __m128 y = _mm_sub_ps(
+            _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( &p_sys->f_alpha[j] ), vdx ),
+                        _mm_mul_ps( _mm_loadu_ps( &p_sys->f_gamma[j] ),
+                                    _mm_loadu_ps( &y1[j] ) ) ),
+            _mm_mul_ps( _mm_loadu_ps( &p_sys->f_beta[j] ),
+                        _mm_loadu_ps( &y2[j] ) ) );
+
+        _mm_storeu_ps( &y2[j], y );
+        acc = _mm_add_ps( acc, _mm_mul_ps( y, _mm_loadu_ps( &amp[j] ) ) );
+    }
+    acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+    acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+    return _mm_cvtss_f32( acc );
+#elif defined(__ARM_NEON)
+    const float32x4_t vdx = vdupq_n_f32( dx );
+    float32x4_t acc = vdupq_n_f32( 0.0f );
+
+    for( int j = 0; j < p_sys->i_band_lanes; j += EQZ_LANES )
+    {
+        float32x4_t y = vsubq_f32(
+            vaddq_f32( vmulq_f32( vld1q_f32( &p_sys->f_alpha[j] ), vdx ),
+                       vmulq_f32( vld1q_f32( &p_sys->f_gamma[j] ),
+                                  vld1q_f32( &y1[j] ) ) ),
+            vmulq_f32( vld1q_f32( &p_sys->f_beta[j] ), vld1q_f32( &y2[j] ) ) );
+
+        vst1q_f32( &y2[j], y );
+        acc = vaddq_f32( acc, vmulq_f32( y, vld1q_f32( &amp[j] ) ) );
+    }
+    float32x2_t sum = vadd_f32( vget_low_f32( acc ), vget_high_f32( acc ) );
+    return vget_lane_f32( vpadd_f32( sum, sum ), 0 );
+#else
+    float acc[EQZ_LANES] = { 0.0f };
+
+    for( int j = 0; j < p_sys->i_band_lanes; j += EQZ_LANES )
+        for( int k = 0; k < EQZ_LANES; k++ )
+        {
+            float y = p_sys->f_alpha[j + k] * dx +
+                      p_sys->f_gamma[j + k] * y1[j + k] -
+                      p_sys->f_beta[j + k]  * y2[j + k];
+
+            y2[j + k] = y;
+            acc[k] += y * amp[j + k];
+        }
+    return ( acc[0] + acc[2] ) + ( acc[1] + acc[3] );
+#endif
+}
+
 static void EqzFilter( filter_t *p_filter, float *out, float *in,
                        int i_samples, int i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    int i, ch;
+
+    assert( i_channels == p_sys->i_channels );
 
     vlc_mutex_lock( &p_sys->lock );
     for( i = 0; i < i_samples; i++ )
@@ -397,40 +580,14 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
         for( ch = 0; ch < i_channels; ch++ )
         {
             const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
-
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
-
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
+            float o = EqzBands( p_sys, &p_sys->state[ch], p_sys->f_amp[ch], x );
 
             /* Second filter */
             if( p_sys->b_2eqz )
             {
                 const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
 
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
+                o = EqzBands( p_sys, &p_sys->state2[ch], p_sys->f_amp[ch], x2 );
 
                 /* We add source PCM + filtered PCM */
                 out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
@@ -454,15 +611,15 @@ static void EqzClean( filter_t *p_filter )
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
 
     var_DelCallback( p_aout, "equalizer-bands", BandsCallback, p_sys );
+    var_DelCallback( p_aout, "equalizer-channel-bands", ChannelBandsCallback,
+                     p_sys );
     var_DelCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
 
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-
+    free( p_sys->f_channel_db );
     free( p_sys->f_amp );
+    free( p_sys->state );
 }
 
 
@@ -535,33 +692,67 @@ static int PreampCallback( vlc_object_t *p_this, char const *psz_cmd,
 
 static int BandsCallback( vlc_object_t *p_this, char const *psz_cmd,
                          vlc_value_t oldval, vlc_value_t newval, void *p_data )
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval);
+    filter_sys_t *p_sys = p_data;
+    float f_db[EQZ_BANDS_LIMIT];
+    int i_count = 0;
+
+    if( newval.psz_string != NULL )
+        i_count = EqzParseGains( newval.psz_string, f_db, EQZ_BANDS_LIMIT );
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( i_count == EQZ_BANDS_MAX && p_sys->i_band != EQZ_BANDS_MAX )
+    {
+        /* Gains of the 10 bands (e.g. a preset): interpolate them */
+        for( int i = 0; i < p_sys->i_band; i++ )
+            p_sys->f_db[i] = EqzInterpolate( p_sys->f_freq_10b, f_db,
+                                             p_sys->f_frequency[i] );
+    }
+    else
+    {
+        for( int i = 0; i < p_sys->i_band; i++ )
+            p_sys->f_db[i] = ( i < i_count ) ? f_db[i] : 0.f;
+    }
+    EqzUpdateAmps( p_sys );
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int ChannelBandsCallback( vlc_object_t *p_this, char const *psz_cmd,
+                                 vlc_value_t oldval, vlc_value_t newval,
+                                 void *p_data )
 {
     VLC_UNUSED(p_this); VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval);
     filter_sys_t *p_sys = p_data;
     const char *p = newval.psz_string;
-    int i = 0;
 
-    /* Same thing for bands */
     vlc_mutex_lock( &p_sys->lock );
-    while( i < p_sys->i_band )
+    for( int ch = 0; ch < p_sys->i_channels; ch++ )
     {
-        char *next;
-        /* Read dB -20/20 */
-        float f = us_strtof( p, &next );
-        if( next == p || isnan( f ) )
-            break; /* no conversion */
+        float *f_db = p_sys->f_channel_db[ch];
+        int i_count = 0;
 
-        p_sys->f_amp[i++] = EqzConvertdB( f );
+        if( p != NULL )
+        {
+            const char *end = strchr( p, ';' );
+            char *psz_set = end ? strndup( p, end - p ) : strdup( p );
 
-        if( *next == '\0' )
-            break; /* end of line */
-        p = &next[1];
+            if( psz_set != NULL )
+            {
+                i_count = EqzParseGains( psz_set, f_db, p_sys->i_band );
+                free( psz_set );
+            }
+            p = end ? end + 1 : NULL;
+        }
+        for( int i = i_count; i < p_sys->i_band; i++ )
+            f_db[i] = 0.f;
     }
-    while( i < p_sys->i_band )
-        p_sys->f_amp[i++] = EqzConvertdB( 0.f );
+    EqzUpdateAmps( p_sys );
     vlc_mutex_unlock( &p_sys->lock );
     return VLC_SUCCESS;
 }
+
 static int TwoPassCallback( vlc_object_t *p_this, char const *psz_cmd,
                             vlc_value_t oldval, vlc_value_t newval, void *p_data )
 {
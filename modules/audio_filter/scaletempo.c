@@ -31,9 +31,11 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_atomic.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 
+#include <math.h>
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
 
@@ -68,6 +70,9 @@ vlc_module_begin ()
         N_("Overlap Length"), N_("Percentage of stride to overlap"), true )
     add_integer_with_range( "scaletempo-search", 14, 0, 200,
         N_("Search Length"), N_("Length in milliseconds to search for best overlap position"), true )
+    add_bool( "scaletempo-normalize", false,
+        N_("Normalized Search"), N_("Normalize the cross correlation by the energy of each overlap position, "
+           "rather than favouring the loudest. Better quality, but slower"), true )
 #ifdef PITCH_SHIFTER
     add_float_with_range( "pitch-shift", 0, -12, 12,
         N_("Pitch Shift"), N_("Pitch shift in semitones."), false )
@@ -87,7 +92,9 @@ vlc_module_end ()
  *
  * Scaletempo smooths the overlap further by searching within the input buffer
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
- * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
+ * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here,
+ * so the dot-products use SIMD instructions where available.  Optionally, the
+ * correlation is normalized by the energy of the search position (as WSOLA).
  *
  * NOTE:
  * sample: a single audio sample for one channel
@@ -102,6 +109,7 @@ typedef struct
     unsigned  ms_stride;
     double    percent_overlap;
     unsigned  ms_search;
+    bool      normalize;
     /* audio format */
     unsigned  samples_per_frame;  /* AKA number of channels */
     unsigned  bytes_per_sample;
@@ -129,6 +137,7 @@ typedef struct
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*dot_product)( const float *, const float *, unsigned );
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -136,37 +145,167 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/*****************************************************************************
+ * dot_product: sum of the products of two sample arrays
+ *****************************************************************************/
+static float dot_product_float( const float *pa, const float *pb, unsigned n )
+{
+    float sum = 0;
+    for( unsigned i = 0; i < n; i++ ) {
+      sum += pa[i] * pb[i];
+    }
+    return sum;
+}
+
+#if defined(HAVE_SSE2_INTRINSICS) || defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+
+#ifdef HAVE_SSE2_INTRINSICS
+VLC_SSE2_TARGET
+static float dot_product_sse2( const float *pa, const float *pb, unsigned n )
+{
+    __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+    unsigned i;
+
+    for( i = 0; i + 8 <= n; i += 8 ) {
+      sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( pa + i ),
+                                           _mm_loadu_ps( pb + i ) ) );
+      sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( pa + i + 4 ),
+                                           _mm_loadu_ps( pb + i + 4 ) ) );
+    }
+    sum0 = _mm_add_ps( sum0, sum1 );
+    sum0 = _mm_add_ps( sum0, _mm_movehl_ps( sum0, sum0 ) );
+    sum0 = _mm_add_ss( sum0, _mm_shuffle_ps( sum0, sum0, 1 ) );
+    return _mm_cvtss_f32( sum0 ) + dot_product_float( pa + i, pb + i, n - i );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2_TARGET
+static float dot_product_avx2( const float *pa, const float *pb, unsigned n )
+{
+    __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+    unsigned i;
+
+    for( i = 0; i + 16 <= n; i += 16 ) {
+      sum0 = _mm256_add_ps( sum0, _mm256_mul_ps( _mm256_loadu_ps( pa + i ),
+                                                 _mm256_loadu_ps( pb + i ) ) );
+      sum1 = _mm256_add_ps( sum1, _mm256_mul_ps( _mm256_loadu_ps( pa + i + 8 ),
+                                                 _mm256_loadu_ps( pb + i + 8 ) ) );
+    }
+    sum0 = _mm256_add_ps( sum0, sum1 );
+
+    __m128 sum = _mm_add_ps( _mm256_castps256_ps128( sum0 ),
+                             _mm256_extractf128_ps( sum0, 1 ) );
+    sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+    sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+    return _mm_cvtss_f32( sum ) + dot_product_float( pa + i, pb + i, n - i );
+}
+#endif
+
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+
+static float dot_product_neon( const float *pa, const float *pb, unsigned n )
+{
+    float32x4_t sum0 = vdupq_n_f32( 0.f ), sum1 = vdupq_n_f32( 0.f );
+    unsigned i;
+
+    for( i = 0; i + 8 <= n; i += 8 ) {
+      sum0 = vmlaq_f32( sum0, vld1q_f32( pa + i ), vld1q_f32( pb + i ) );
+      sum1 = vmlaq_f32( sum1, vld1q_f32( pa + i + 4 ), vld1q_f32( pb + i + 4 ) );
+    }
+    sum0 = vaddq_f32( sum0, sum1 );
+
+    float32x2_t sum = vadd_f32( vget_low_f32( sum0 ), vget_high_f32( sum0 ) );
+    sum = vpadd_f32( sum, sum );
+    return vget_lane_f32( sum, 0 ) + dot_product_float( pa + i, pb + i, n - i );
+}
+#endif
+
+static float (*select_dot_product( void ))( const float *, const float *, unsigned )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        return dot_product_avx2;
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        return dot_product_sse2;
+#endif
+#ifdef __ARM_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return dot_product_neon;
+#endif
+    return dot_product_float;
+}
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
-static unsigned best_overlap_offset_float( filter_t *p_filter )
+static float *pre_correlate( filter_sys_t *p )
 {
-    filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
-    float best_corr = INT_MIN;
-    unsigned best_off = 0;
-    unsigned i, off;
+    float *pw  = p->table_window;
+    float *po  = p->buf_overlap;
+    float *ppc = p->buf_pre_corr;
+    unsigned i;
 
-    pw  = p->table_window;
-    po  = p->buf_overlap;
     po += p->samples_per_frame;
-    ppc = p->buf_pre_corr;
     for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
       *ppc++ = *pw++ * *po++;
     }
+    return p->buf_pre_corr;
+}
+
+static unsigned best_overlap_offset_float( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    float *ppc, *search_start;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    unsigned off;
+    const unsigned samples = p->samples_overlap - p->samples_per_frame;
 
+    ppc = pre_correlate( p );
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
+      float corr = p->dot_product( ppc, search_start, samples );
+      if( corr > best_corr ) {
+        best_corr = corr;
+        best_off  = off;
       }
+      search_start += p->samples_per_frame;
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
+static unsigned best_overlap_offset_float_normalized( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    float *ppc, *search_start;
+    float best_corr = -INFINITY;
+    unsigned best_off = 0;
+    unsigned off;
+    const unsigned samples = p->samples_overlap - p->samples_per_frame;
+
+    ppc = pre_correlate( p );
+    search_start = (float *)p->buf_queue + p->samples_per_frame;
+
+    /* energy of the search position, slid along with it */
+    double energy = p->dot_product( search_start, search_start, samples );
+    for( off = 0; off < p->frames_search; off++ ) {
+      float corr = p->dot_product( ppc, search_start, samples )
+                 / sqrtf( __MAX( energy, 0 ) + 1e-9f );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
       }
+      for( unsigned i = 0; i < p->samples_per_frame; i++ ) {
+        energy += search_start[samples + i] * search_start[samples + i]
+                - search_start[i] * search_start[i];
+      }
       search_start += p->samples_per_frame;
     }
 
@@ -351,7 +490,9 @@ static int reinit_buffers( filter_t *p_filter )
             for( j = 0; j < p->samples_per_frame; j++ )
                 *pw++ = v;
         }
-        p->best_overlap_offset = best_overlap_offset_float;
+        p->best_overlap_offset = p->normalize
+                               ? best_overlap_offset_float_normalized
+                               : best_overlap_offset_float;
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -421,9 +562,12 @@ static int Open( vlc_object_t *p_this )
     p_sys->ms_stride       = var_InheritInteger( p_this, "scaletempo-stride" );
     p_sys->percent_overlap = var_InheritFloat( p_this, "scaletempo-overlap" );
     p_sys->ms_search       = var_InheritInteger( p_this, "scaletempo-search" );
+    p_sys->normalize       = var_InheritBool( p_this, "scaletempo-normalize" );
+    p_sys->dot_product     = select_dot_product();
 
-    msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search",
-             p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search );
+    msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search%s",
+             p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search,
+             p_sys->normalize ? ", normalized" : "" );
 
     p_sys->buf_queue      = NULL;
     p_sys->buf_overlap    = NULL;
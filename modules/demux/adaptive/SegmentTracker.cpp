@@ -89,6 +89,11 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNKNOWN;
+    prefetchRepresentation = NULL;
+    prefetchCount = 0;
+    if(adaptSet)
+        prefetchCount = var_InheritInteger(adaptSet->getPlaylist()->getVLCObject(),
+                                           "adaptive-prefetch");
 }
 
 SegmentTracker::~SegmentTracker()
@@ -96,6 +101,68 @@ SegmentTracker::~SegmentTracker()
     reset();
 }
 
+void SegmentTracker::flushPrefetched()
+{
+    while(!prefetched.empty())
+    {
+        delete prefetched.front().second;
+        prefetched.pop_front();
+    }
+    prefetchRepresentation = NULL;
+}
+
+SegmentChunk * SegmentTracker::getPrefetchedChunk(BaseRepresentation *rep, uint64_t number)
+{
+    if(rep != prefetchRepresentation)
+    {
+        flushPrefetched();
+        return NULL;
+    }
+
+    while(!prefetched.empty() && prefetched.front().first < number)
+    {
+        delete prefetched.front().second;
+        prefetched.pop_front();
+    }
+
+    if(prefetched.empty() || prefetched.front().first != number)
+    {
+        flushPrefetched();
+        return NULL;
+    }
+
+    SegmentChunk *chunk = prefetched.front().second;
+    prefetched.pop_front();
+    return chunk;
+}
+
+void SegmentTracker::prefetchChunks(BaseRepresentation *rep,
+                                    AbstractConnectionManager *connManager)
+{
+    /* Live segments might not be available yet */
+    if(!prefetchCount || rep->getPlaylist()->isLive())
+        return;
+
+    if(rep != prefetchRepresentation)
+        flushPrefetched();
+    prefetchRepresentation = rep;
+
+    uint64_t number = prefetched.empty() ? next : prefetched.back().first + 1;
+    while(prefetched.size() < prefetchCount)
+    {
+        bool b_gap = false;
+        ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                                number, &number, &b_gap);
+        if(!segment || b_gap)
+            break;
+        SegmentChunk *chunk = segment->toChunk(resources, connManager, number, rep);
+        if(!chunk)
+            break;
+        prefetched.push_back(std::pair<uint64_t, SegmentChunk *>(number, chunk));
+        number++;
+    }
+}
+
 void SegmentTracker::setAdaptationLogic(AbstractAdaptationLogic *logic_)
 {
     logic = logic_;
@@ -154,6 +221,7 @@ bool SegmentTracker::segmentsListReady() const
 
 void SegmentTracker::reset()
 {
+    flushPrefetched();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -269,7 +337,9 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+    SegmentChunk *chunk = getPrefetchedChunk(rep, next);
+    if(!chunk)
+        chunk = segment->toChunk(resources, connManager, next, rep);
 
     /* Notify new segment length for stats / logic */
     if(chunk)
@@ -296,6 +366,7 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     {
         curNumber = next;
         next++;
+        prefetchChunks(rep, connManager);
     }
 
     return chunk;
@@ -335,6 +406,7 @@ void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
         index_sent = false;
         init_sent = false;
     }
+    flushPrefetched();
     curNumber = next = segnumber;
 }
 
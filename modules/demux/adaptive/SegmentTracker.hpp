@@ -140,6 +140,9 @@ namespace adaptive
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            SegmentChunk * getPrefetchedChunk(BaseRepresentation *, uint64_t);
+            void prefetchChunks(BaseRepresentation *, AbstractConnectionManager *);
+            void flushPrefetched();
             bool first;
             bool initializing;
             bool index_sent;
@@ -152,6 +155,10 @@ namespace adaptive
             BaseAdaptationSet *adaptationSet;
             BaseRepresentation *curRepresentation;
             std::list<SegmentTrackerListenerInterface *> listeners;
+            /* media chunks already scheduled for download, by number */
+            unsigned prefetchCount;
+            BaseRepresentation *prefetchRepresentation;
+            std::list<std::pair<uint64_t, SegmentChunk *> > prefetched;
     };
 }
 
@@ -24,6 +24,7 @@
 #include "SharedResources.hpp"
 #include "http/AuthStorage.hpp"
 #include "http/HTTPConnectionManager.h"
+#include "http/SegmentCache.hpp"
 #include "encryption/Keyring.hpp"
 
 #include <vlc_common.h>
@@ -38,11 +39,17 @@ SharedResources::SharedResources(vlc_object_t *obj, bool local)
     if(m && local)
         m->setLocalConnectionsAllowed();
     connManager = m;
+    segmentCache = NULL;
+    /* local segments are read from the access directly */
+    size_t cachesize = var_InheritInteger(obj, "adaptive-cache-size");
+    if(!local && cachesize)
+        segmentCache = new (std::nothrow) SegmentCache(obj, cachesize * 1024 * 1024);
 }
 
 SharedResources::~SharedResources()
 {
     delete connManager;
+    delete segmentCache;
     delete encryptionKeyring;
     delete authStorage;
 }
@@ -61,3 +68,8 @@ AbstractConnectionManager * SharedResources::getConnManager()
 {
     return connManager;
 }
+
+SegmentCache * SharedResources::getSegmentCache()
+{
+    return segmentCache;
+}
@@ -666,6 +666,13 @@ void AbstractStream::trackerEvent(const SegmentTrackerEvent &event)
             }
             break;
 
+        case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+            /* Let the downloader serve the least buffered stream first */
+            if(connManager)
+                connManager->updateBufferingLevel(*event.u.buffering_level.id,
+                                                  event.u.buffering_level.current);
+            break;
+
         default:
             break;
     }
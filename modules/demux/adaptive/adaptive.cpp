@@ -73,6 +73,19 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
+#define ADAPT_DOWNLOADERS_TEXT N_("Download workers")
+#define ADAPT_DOWNLOADERS_LONGTEXT N_("Number of segments downloaded in parallel " \
+                                      "across all the streams")
+
+#define ADAPT_CACHESIZE_TEXT N_("Segment cache size (MiB)")
+#define ADAPT_CACHESIZE_LONGTEXT N_("Memory used for keeping downloaded segments " \
+                                    "for seeking back or switching representations " \
+                                    "(0 to disable)")
+
+#define ADAPT_PREFETCH_TEXT N_("Prefetched segments")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of segments requested ahead of the " \
+                                   "current one, per stream (on-demand content only)")
+
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
@@ -122,6 +135,12 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_integer_with_range( "adaptive-downloaders", 2, 1, 8,
+                     ADAPT_DOWNLOADERS_TEXT, ADAPT_DOWNLOADERS_LONGTEXT, true )
+        add_integer_with_range( "adaptive-prefetch", 1, 0, 8,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT, true )
+        add_integer_with_range( "adaptive-cache-size", 32, 0, 1024,
+                     ADAPT_CACHESIZE_TEXT, ADAPT_CACHESIZE_LONGTEXT, true )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -116,7 +117,8 @@ block_t * AbstractChunk::doRead(size_t size, bool b_block)
             block->i_flags |= BLOCK_FLAG_HEADER;
         bytesRead += block->i_buffer;
         onDownload(&block);
-        block->i_flags &= ~BLOCK_FLAG_HEADER;
+        if(block)
+            block->i_flags &= ~BLOCK_FLAG_HEADER;
     }
 
     return block;
@@ -156,7 +158,7 @@ HTTPChunkSource::HTTPChunkSource(const std::string& url, AbstractConnectionManag
 HTTPChunkSource::~HTTPChunkSource()
 {
     if(connection)
-        connection->setUsed(false);
+        connManager->releaseConnection(connection);
     vlc_mutex_destroy(&lock);
 }
 
@@ -269,7 +271,7 @@ bool HTTPChunkSource::prepare()
                 HTTPConnection *httpconn = dynamic_cast<HTTPConnection *>(connection);
                 if(httpconn)
                     connparams = httpconn->getRedirection();
-                connection->setUsed(false);
+                connManager->releaseConnection(connection);
                 connection = NULL;
                 if(httpconn)
                     continue;
@@ -303,7 +305,11 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     done = false;
     eof = false;
     held = false;
-    downloadstart = 0;
+    downloadtime = 0;
+    cache = NULL;
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    cachesize = 0;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -323,11 +329,47 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+    block_ChainRelease(p_cachehead);
     vlc_mutex_unlock(&lock);
 
     vlc_cond_destroy(&avail);
 }
 
+void HTTPChunkBufferedSource::setCache(SegmentCache *cache_, const std::string &key)
+{
+    vlc_mutex_locker locker( &lock );
+    cache = cache_;
+    cachekey = key;
+}
+
+void HTTPChunkBufferedSource::cacheBlock(block_t *p_block)
+{
+    /* The reader gets the original blocks, sharing the payload */
+    block_t *p_view = NULL;
+    if(cache->fits(cachesize + p_block->i_buffer))
+        p_view = block_Share(p_block);
+    if(!p_view)
+    {
+        storeCache(false); /* too large, won't be cached */
+        return;
+    }
+    block_ChainLastAppend(&pp_cachetail, p_view);
+    cachesize += p_view->i_buffer;
+}
+
+void HTTPChunkBufferedSource::storeCache(bool complete)
+{
+    if(complete && requeststatus == RequestStatus::Success &&
+       (!contentLength || contentLength == buffered + consumed))
+    {
+        cache->put(cachekey, p_cachehead, connection->getContentType());
+    }
+    else block_ChainRelease(p_cachehead);
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    cache = NULL;
+}
+
 bool HTTPChunkBufferedSource::isDone() const
 {
     vlc_mutex_locker locker( &lock );
@@ -347,8 +389,12 @@ void HTTPChunkBufferedSource::release()
     vlc_cond_signal(&avail);
 }
 
-void HTTPChunkBufferedSource::bufferize(size_t readsize)
+size_t HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
+    /* Only account for the time we're actually downloading, as the
+     * source can wait in the queue while workers serve other streams */
+    const vlc_tick_t start = vlc_tick_now();
+
     vlc_mutex_lock(&lock);
     if(!prepare())
     {
@@ -356,7 +402,7 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         eof = true;
         vlc_cond_signal(&avail);
         vlc_mutex_unlock(&lock);
-        return;
+        return 0;
     }
 
     if(readsize < HTTPChunkSource::CHUNK_SIZE)
@@ -371,7 +417,7 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     if(!p_block)
     {
         eof = true;
-        return;
+        return 0;
     }
 
     struct
@@ -387,22 +433,28 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         p_block = NULL;
         vlc_mutex_locker locker( &lock );
         done = true;
+        downloadtime += vlc_tick_now() - start;
         rate.size = buffered + consumed;
-        rate.time = vlc_tick_now() - downloadstart;
-        downloadstart = 0;
+        rate.time = downloadtime;
+        if(cache)
+            storeCache(ret == 0);
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
         vlc_mutex_locker locker( &lock );
+        if(cache)
+            cacheBlock(p_block);
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
+        downloadtime += vlc_tick_now() - start;
         if((size_t) ret < readsize)
         {
             done = true;
             rate.size = buffered + consumed;
-            rate.time = vlc_tick_now() - downloadstart;
-            downloadstart = 0;
+            rate.time = downloadtime;
+            if(cache)
+                storeCache(true);
         }
     }
 
@@ -412,16 +464,8 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     }
 
     vlc_cond_signal(&avail);
-}
 
-bool HTTPChunkBufferedSource::prepare()
-{
-    if(!prepared)
-    {
-        downloadstart = vlc_tick_now();
-        return HTTPChunkSource::prepare();
-    }
-    return true;
+    return ret > 0 ? ret : 0;
 }
 
 bool HTTPChunkBufferedSource::hasMoreData() const
@@ -508,6 +552,85 @@ block_t * HTTPChunkBufferedSource::read(size_t readsize)
     return p_block;
 }
 
+CachedChunkSource::CachedChunkSource(block_t *p_chain, const std::string &type) :
+    AbstractChunkSource(),
+    p_head     (p_chain),
+    contentType(type)
+{
+    block_ChainProperties(p_chain, NULL, &contentLength, NULL);
+}
+
+CachedChunkSource::~CachedChunkSource()
+{
+    block_ChainRelease(p_head);
+}
+
+bool CachedChunkSource::hasMoreData() const
+{
+    return p_head != NULL;
+}
+
+std::string CachedChunkSource::getContentType() const
+{
+    return contentType;
+}
+
+block_t * CachedChunkSource::readBlock()
+{
+    block_t *p_block = p_head;
+    if(p_block)
+    {
+        p_head = p_block->p_next;
+        p_block->p_next = NULL;
+    }
+    return p_block;
+}
+
+block_t * CachedChunkSource::read(size_t readsize)
+{
+    if(!readsize || !p_head)
+        return NULL;
+
+    /* Whole or partial blocks are handed out without copying */
+    if(p_head->i_buffer == readsize || (p_head->i_buffer < readsize && !p_head->p_next))
+        return readBlock();
+
+    if(p_head->i_buffer > readsize)
+    {
+        block_t *p_block = block_Share(p_head);
+        if(!p_block)
+            return NULL;
+        p_block->i_buffer = readsize;
+        p_head->p_buffer += readsize;
+        p_head->i_buffer -= readsize;
+        return p_block;
+    }
+
+    block_t *p_block = block_Alloc(readsize);
+    if(!p_block)
+        return NULL;
+
+    size_t copied = 0;
+    while(p_head && copied < readsize)
+    {
+        const size_t toconsume = std::min(p_head->i_buffer, readsize - copied);
+        memcpy(&p_block->p_buffer[copied], p_head->p_buffer, toconsume);
+        copied += toconsume;
+        p_head->i_buffer -= toconsume;
+        p_head->p_buffer += toconsume;
+        if(p_head->i_buffer == 0)
+        {
+            block_t *next = p_head->p_next;
+            p_head->p_next = NULL;
+            block_Release(p_head);
+            p_head = next;
+        }
+    }
+    p_block->i_buffer = copied;
+
+    return p_block;
+}
+
 HTTPChunk::HTTPChunk(const std::string &url, AbstractConnectionManager *manager,
                      const adaptive::ID &id, bool access):
     AbstractChunk(new HTTPChunkSource(url, manager, id, access))
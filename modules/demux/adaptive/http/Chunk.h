@@ -41,6 +41,7 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class SegmentCache;
 
         class AbstractChunkSource
         {
@@ -128,21 +129,44 @@ namespace adaptive
                 virtual bool       hasMoreData     () const; /* impl */
                 void               hold();
                 void               release();
+                void               setCache(SegmentCache *, const std::string &);
 
             protected:
-                virtual bool       prepare(); /* reimpl */
-                void               bufferize(size_t);
+                size_t             bufferize(size_t);
                 bool               isDone() const;
 
             private:
+                void               cacheBlock(block_t *);
+                void               storeCache(bool);
                 block_t            *p_head; /* read cache buffer */
                 block_t           **pp_tail;
                 size_t              buffered; /* read cache size */
                 bool                done;
                 bool                eof;
-                vlc_tick_t          downloadstart;
+                vlc_tick_t          downloadtime; /* time spent requesting/reading */
                 vlc_cond_t          avail;
                 bool                held;
+                SegmentCache       *cache;
+                std::string         cachekey;
+                block_t            *p_cachehead; /* whole segment, shared with the reader */
+                block_t           **pp_cachetail;
+                size_t              cachesize;
+        };
+
+        /* Segment served from the SegmentCache */
+        class CachedChunkSource : public AbstractChunkSource
+        {
+            public:
+                CachedChunkSource(block_t *, const std::string &);
+                virtual ~CachedChunkSource();
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual std::string getContentType  () const; /* reimpl */
+
+            private:
+                block_t            *p_head;
+                std::string         contentType;
         };
 
         class HTTPChunk : public AbstractChunk
@@ -1,5 +1,5 @@
 /*
- * Downloader.hpp
+ * Downloader.cpp
  *****************************************************************************
  * Copyright (C) 2015 - VideoLAN Authors
  *
@@ -25,47 +25,84 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
-
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Worker::Worker(Downloader *d, unsigned i)
+{
+    downloader = d;
+    index = i;
+    current = NULL;
+    bytes = 0;
+    time = 0;
+}
+
+Downloader::StreamQueue::StreamQueue(const ID &id_) : id(id_)
+{
+}
+
+Downloader::Downloader(vlc_object_t *obj, unsigned count)
 {
+    p_obj = obj;
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
+    vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
+    workers_count = VLC_CLIP(count, 1, MAX_WORKERS);
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(workers.size() < workers_count)
     {
-        return false;
+        Worker *worker = new (std::nothrow) Worker(this, workers.size());
+        if(!worker)
+            break;
+        if(vlc_clone(&worker->handle, downloaderThread,
+                     static_cast<void *>(worker), VLC_THREAD_PRIORITY_INPUT))
+        {
+            delete worker;
+            break;
+        }
+        workers.push_back(worker);
     }
-    thread_handle_valid = true;
-    return true;
+    return !workers.empty();
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    std::vector<Worker *>::const_iterator it;
+    for(it = workers.begin(); it != workers.end(); ++it)
+    {
+        Worker *worker = *it;
+        vlc_join(worker->handle, NULL);
+        if(worker->time)
+            msg_Dbg(p_obj, "download worker %u: %zu bytes in %" PRId64 " ms, "
+                           "%" PRIu64 " KiB/s", worker->index, worker->bytes,
+                    MS_FROM_VLC_TICK(worker->time),
+                    (uint64_t) worker->bytes * CLOCK_FREQ / worker->time / 1024);
+        delete worker;
+    }
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
+    vlc_cond_destroy(&updatedcond);
 }
+
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
     source->hold();
-    chunks.push_back(source);
+    std::list<StreamQueue>::iterator it;
+    for(it = queues.begin(); it != queues.end(); ++it)
+        if((*it).id == source->sourceid)
+            break;
+    if(it == queues.end())
+        it = queues.insert(queues.end(), StreamQueue(source->sourceid));
+    (*it).sources.push_back(source);
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
 }
@@ -73,47 +110,136 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
+    /* a worker can't be interrupted in the middle of a read */
+    while(isDownloading(source))
+        vlc_cond_wait(&updatedcond, &lock);
     source->release();
-    chunks.remove(source);
+    removeSource(source);
+    vlc_mutex_unlock(&lock);
+}
+
+void Downloader::updateBufferingLevel(const ID &id, vlc_tick_t level)
+{
+    vlc_mutex_lock(&lock);
+    levels[id] = level;
     vlc_mutex_unlock(&lock);
 }
 
 void * Downloader::downloaderThread(void *opaque)
 {
-    Downloader *instance = static_cast<Downloader *>(opaque);
+    Worker *worker = static_cast<Worker *>(opaque);
     int canc = vlc_savecancel();
-    instance->Run();
+    worker->downloader->Run(worker);
     vlc_restorecancel( canc );
     return NULL;
 }
 
-void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
+void Downloader::DownloadSource(Worker *worker, HTTPChunkBufferedSource *source)
 {
     if(!source->isDone())
-        source->bufferize(HTTPChunkSource::CHUNK_SIZE);
+    {
+        vlc_tick_t time = vlc_tick_now();
+        size_t size = source->bufferize(HTTPChunkSource::CHUNK_SIZE);
+        worker->time += vlc_tick_now() - time;
+        worker->bytes += size;
+    }
+}
+
+bool Downloader::isDownloading(const HTTPChunkBufferedSource *source) const
+{
+    std::vector<Worker *>::const_iterator it;
+    for(it = workers.begin(); it != workers.end(); ++it)
+        if((*it)->current == source)
+            return true;
+    return false;
+}
+
+void Downloader::removeSource(HTTPChunkBufferedSource *source)
+{
+    std::list<StreamQueue>::iterator it;
+    for(it = queues.begin(); it != queues.end(); ++it)
+    {
+        (*it).sources.remove(source);
+        if((*it).sources.empty())
+        {
+            queues.erase(it);
+            break;
+        }
+    }
+}
+
+HTTPChunkBufferedSource * Downloader::getNextSource()
+{
+    std::list<StreamQueue>::iterator it;
+    /* The source each stream is waiting for first, starting with the
+     * least buffered stream, round robin on equal levels */
+    std::list<StreamQueue>::iterator lowest = queues.end();
+    vlc_tick_t lowestlevel = 0;
+    for(it = queues.begin(); it != queues.end(); ++it)
+    {
+        if(isDownloading((*it).sources.front()))
+            continue;
+        std::map<ID, vlc_tick_t>::const_iterator level = levels.find((*it).id);
+        vlc_tick_t i_level = (level != levels.end()) ? (*level).second : 0;
+        if(lowest == queues.end() || i_level < lowestlevel)
+        {
+            lowest = it;
+            lowestlevel = i_level;
+        }
+    }
+    if(lowest != queues.end())
+    {
+        HTTPChunkBufferedSource *source = (*lowest).sources.front();
+        queues.splice(queues.end(), queues, lowest);
+        return source;
+    }
+    /* Then use idle workers for prefetched sources */
+    for(it = queues.begin(); it != queues.end(); ++it)
+    {
+        std::list<HTTPChunkBufferedSource *>::const_iterator it2;
+        for(it2 = ++(*it).sources.begin(); it2 != (*it).sources.end(); ++it2)
+        {
+            if(!isDownloading(*it2))
+            {
+                HTTPChunkBufferedSource *source = *it2;
+                queues.splice(queues.end(), queues, it);
+                return source;
+            }
+        }
+    }
+    return NULL;
 }
 
-void Downloader::Run()
+void Downloader::Run(Worker *worker)
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source = NULL;
+        while(!killed && !(source = getNextSource()))
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        worker->current = source;
+        vlc_mutex_unlock(&lock);
+
+        DownloadSource(worker, source);
+
+        vlc_mutex_lock(&lock);
+        worker->current = NULL;
+        if(source->isDone())
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
-            if(source->isDone())
-            {
-                chunks.pop_front();
-                source->release();
-            }
+            removeSource(source);
+            source->release();
+        }
+        else
+        {
+            /* let another worker pick it up if we're needed elsewhere */
+            vlc_cond_signal(&waitcond);
         }
+        vlc_cond_broadcast(&updatedcond);
     }
     vlc_mutex_unlock(&lock);
 }
@@ -24,6 +24,8 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace adaptive
 {
@@ -31,25 +33,60 @@ namespace adaptive
     namespace http
     {
 
+        /* Pool of download threads shared by all the streams.
+         * Sources are queued per stream (source ID). Workers serve the
+         * stream with the lowest buffering level first, one CHUNK_SIZE
+         * at a time, in turn on equal levels, and the oldest source of
+         * each stream (the one the demuxer reads next) is always served
+         * before its prefetched successors. */
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(vlc_object_t *, unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
+                void updateBufferingLevel(const ID &, vlc_tick_t);
+
+                static const unsigned MAX_WORKERS = 8;
 
             private:
+                class Worker
+                {
+                    public:
+                        Worker(Downloader *, unsigned);
+                        Downloader *downloader;
+                        unsigned index;
+                        vlc_thread_t handle;
+                        HTTPChunkBufferedSource *current;
+                        size_t bytes;
+                        vlc_tick_t time;
+                };
+
+                class StreamQueue
+                {
+                    public:
+                        StreamQueue(const ID &);
+                        ID id;
+                        std::list<HTTPChunkBufferedSource *> sources;
+                };
+
                 static void * downloaderThread(void *);
-                void Run();
-                void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                void Run(Worker *);
+                void DownloadSource(Worker *, HTTPChunkBufferedSource *);
+                HTTPChunkBufferedSource * getNextSource();
+                bool isDownloading(const HTTPChunkBufferedSource *) const;
+                void removeSource(HTTPChunkBufferedSource *);
+                vlc_object_t *p_obj;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                vlc_cond_t   updatedcond;
                 bool         killed;
-                std::list<HTTPChunkBufferedSource *> chunks;
+                unsigned     workers_count;
+                std::vector<Worker *> workers;
+                std::list<StreamQueue> queues;
+                std::map<ID, vlc_tick_t> levels;
         };
 
     }
@@ -64,8 +64,10 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    downloader = new (std::nothrow) Downloader(p_object,
+                                var_InheritInteger(p_object, "adaptive-downloaders"));
+    if(downloader)
+        downloader->start();
     factory = new ConnectionFactory(storage);
 }
 
@@ -142,6 +144,14 @@ AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &para
     return conn;
 }
 
+void HTTPConnectionManager::releaseConnection(AbstractConnection *conn)
+{
+    /* Other sources look for available connections from other threads */
+    vlc_mutex_lock(&lock);
+    conn->setUsed(false);
+    vlc_mutex_unlock(&lock);
+}
+
 void HTTPConnectionManager::start(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
@@ -156,6 +166,11 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         downloader->cancel(src);
 }
 
+void HTTPConnectionManager::updateBufferingLevel(const adaptive::ID &sourceid, vlc_tick_t level)
+{
+    downloader->updateBufferingLevel(sourceid, level);
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
@@ -0,0 +1,145 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+#include "BytesRange.hpp"
+
+#include <vlc_block.h>
+
+#include <sstream>
+
+using namespace adaptive::http;
+
+SegmentCache::SegmentCache(vlc_object_t *obj, size_t maxsize)
+{
+    p_obj = obj;
+    maxSize = maxsize;
+    size = 0;
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.stored = 0;
+    stats.evicted = 0;
+    stats.hitbytes = 0;
+    vlc_mutex_init(&lock);
+}
+
+SegmentCache::~SegmentCache()
+{
+    if(stats.hits || stats.misses)
+        msg_Dbg(p_obj, "segment cache: %u hits (%" PRIu64 " KiB), %u misses, "
+                       "%u stored, %u evicted, %zu KiB in use",
+                stats.hits, stats.hitbytes / 1024, stats.misses,
+                stats.stored, stats.evicted, size / 1024);
+
+    std::list<Entry>::iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+        block_ChainRelease((*it).p_chain);
+    vlc_mutex_destroy(&lock);
+}
+
+std::string SegmentCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    if(!range.isValid())
+        return url;
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url << "@" << range.getStartByte() << "-" << range.getEndByte();
+    return ss.str();
+}
+
+bool SegmentCache::fits(size_t datasize) const
+{
+    return datasize <= maxSize;
+}
+
+block_t * SegmentCache::get(const std::string &key, std::string *contentType)
+{
+    vlc_mutex_locker locker(&lock);
+
+    std::map<std::string, std::list<Entry>::iterator>::iterator it = index.find(key);
+    if(it == index.end())
+    {
+        stats.misses++;
+        return NULL;
+    }
+
+    /* Readers make the data writable before modifying it (decryption) */
+    block_t *p_chain = NULL;
+    block_t **pp_tail = &p_chain;
+    for(block_t *p = (*it->second).p_chain; p; p = p->p_next)
+    {
+        block_t *p_dup = block_Share(p);
+        if(!p_dup)
+        {
+            block_ChainRelease(p_chain);
+            return NULL;
+        }
+        block_ChainLastAppend(&pp_tail, p_dup);
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    *contentType = (*it->second).contentType;
+    stats.hits++;
+    stats.hitbytes += (*it->second).size;
+    return p_chain;
+}
+
+void SegmentCache::evict(size_t needed)
+{
+    while(!entries.empty() && size + needed > maxSize)
+    {
+        Entry &entry = entries.back();
+        size -= entry.size;
+        block_ChainRelease(entry.p_chain);
+        index.erase(entry.key);
+        entries.pop_back();
+        stats.evicted++;
+    }
+}
+
+void SegmentCache::put(const std::string &key, block_t *p_chain,
+                       const std::string &contentType)
+{
+    size_t datasize;
+    block_ChainProperties(p_chain, NULL, &datasize, NULL);
+
+    vlc_mutex_locker locker(&lock);
+
+    if(!datasize || !fits(datasize) || index.find(key) != index.end())
+    {
+        block_ChainRelease(p_chain);
+        return;
+    }
+
+    evict(datasize);
+
+    Entry entry;
+    entry.key = key;
+    entry.contentType = contentType;
+    entry.p_chain = p_chain;
+    entry.size = datasize;
+    entries.push_front(entry);
+    index[key] = entries.begin();
+    size += datasize;
+    stats.stored++;
+}
@@ -0,0 +1,77 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include <vlc_common.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class BytesRange;
+
+        /* Memory bounded LRU of completely downloaded segments, shared
+         * by all the representations so that back seeks and identical
+         * init segments don't go through the network again. */
+        class SegmentCache
+        {
+            public:
+                SegmentCache(vlc_object_t *, size_t);
+                ~SegmentCache();
+                bool fits(size_t) const;
+                block_t * get(const std::string &, std::string *);
+                void put(const std::string &, block_t *, const std::string &);
+
+                static std::string makeKey(const std::string &, const BytesRange &);
+
+            private:
+                class Entry
+                {
+                    public:
+                        std::string key;
+                        std::string contentType;
+                        block_t *p_chain;
+                        size_t size;
+                };
+                void evict(size_t);
+                vlc_object_t *p_obj;
+                vlc_mutex_t lock;
+                size_t maxSize;
+                size_t size;
+                std::list<Entry> entries; /* most recently used first */
+                std::map<std::string, std::list<Entry>::iterator> index;
+                struct
+                {
+                    unsigned hits;
+                    unsigned misses;
+                    unsigned stored;
+                    unsigned evicted;
+                    uint64_t hitbytes;
+                } stats;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -43,6 +43,7 @@ RateBasedAdaptationLogic::RateBasedAdaptationLogic  (vlc_object_t *obj) :
 {
     usedBps = 0;
     dllength = 0;
+    dlend = 0;
     dlsize = 0;
     vlc_mutex_init(&lock);
 }
@@ -81,16 +82,31 @@ void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size, vlc_t
 {
     if(unlikely(time == 0))
         return;
-    /* Accumulate up to observation window */
-    dllength += time;
+
+    /* Transfers are reported when they end. Concurrent transfers share
+     * the link, so only the wall clock time not already covered by a
+     * previous transfer is accounted. */
+    const vlc_tick_t end = vlc_tick_now();
+    const vlc_tick_t start = end - time;
+
+    vlc_mutex_lock(&lock);
+    if(start >= dlend)
+        dllength += time;
+    else if(end > dlend)
+        dllength += end - dlend;
+    if(end > dlend)
+        dlend = end;
     dlsize += size;
 
+    /* Accumulate up to observation window */
     if(dllength < VLC_TICK_FROM_MS(250))
+    {
+        vlc_mutex_unlock(&lock);
         return;
+    }
 
     const size_t bps = CLOCK_FREQ * dlsize * 8 / dllength;
 
-    vlc_mutex_lock(&lock);
     bpsAvg = average.push(bps);
 
 //    BwDebug(msg_Dbg(p_obj, "alpha1 %lf alpha0 %lf dmax %ld ds %ld", alpha,
@@ -51,7 +51,8 @@ namespace adaptive
                 MovingAverage<size_t>   average;
 
                 size_t                  dlsize;
-                vlc_tick_t              dllength;
+                vlc_tick_t              dllength; /* wall clock time with transfers */
+                vlc_tick_t              dlend; /* end of the latest transfer */
 
                 mutable vlc_mutex_t     lock;
         };
@@ -34,6 +34,9 @@
 #include "../http/BytesRange.hpp"
 #include "../http/HTTPConnectionManager.h"
 #include "../http/Downloader.hpp"
+#include "../http/SegmentCache.hpp"
+#include "../SharedResources.hpp"
+#include <vlc_block.h>
 #include <cassert>
 
 using namespace adaptive::http;
@@ -82,12 +85,44 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                                 size_t index, BaseRepresentation *rep)
 {
     const std::string url = getUrlSegment().toString(index, rep);
-    HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
-                                                                                 rep->getAdaptationSet()->getID());
+    BytesRange range;
+    if(startByte != endByte)
+        range = BytesRange(startByte, endByte);
+
+    AbstractChunkSource *source = NULL;
+    HTTPChunkBufferedSource *httpsource = NULL;
+    SegmentCache *cache = res ? res->getSegmentCache() : NULL;
+    /* live media segments can be updated under the same URL,
+     * only the init segments are safe to reuse */
+    if(cache && classId != InitSegment::CLASSID_INITSEGMENT &&
+       rep->getPlaylist()->isLive())
+        cache = NULL;
+    std::string cachekey;
+    if(cache)
+    {
+        std::string contentType;
+        cachekey = SegmentCache::makeKey(url, range);
+        block_t *p_data = cache->get(cachekey, &contentType);
+        if(p_data)
+        {
+            source = new (std::nothrow) CachedChunkSource(p_data, contentType);
+            if(!source)
+                block_ChainRelease(p_data);
+        }
+    }
+
+    if(!source)
+    {
+        source = httpsource = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
+                                                          rep->getAdaptationSet()->getID());
+        if(httpsource && cache)
+            httpsource->setCache(cache, cachekey);
+    }
+
     if( source )
     {
-        if(startByte != endByte)
-            source->setBytesRange(BytesRange(startByte, endByte));
+        if(range.isValid())
+            source->setBytesRange(range);
 
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
@@ -98,7 +133,8 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                 delete chunk;
                 return NULL;
             }
-            connManager->start(source);
+            if(httpsource)
+                connManager->start(httpsource);
             return chunk;
         }
         else
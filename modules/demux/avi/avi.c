@@ -219,6 +219,8 @@ static int AVI_PacketSearch   ( demux_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static bool AVI_IndexCacheLoad ( demux_t *, bool );
+static void AVI_IndexCacheStore( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -686,7 +688,11 @@ static int Open( vlc_object_t * p_this )
     }
 
     i_do_index = var_InheritInteger( p_demux, "avi-index" );
-    if( i_do_index == 1 ) /* Always fix */
+    if( p_sys->b_seekable && AVI_IndexCacheLoad( p_demux, i_do_index == 1 ) )
+    {
+        p_sys->b_indexloaded = true;
+    }
+    else if( i_do_index == 1 ) /* Always fix */
     {
 aviindex:
         if( p_sys->b_fastseekable )
@@ -2593,6 +2599,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
     vlc_tick_t i_dialog_update;
     vlc_dialog_id *p_dialog_id = NULL;
+    bool b_cancelled = false;
 
     p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
     p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
@@ -2604,7 +2611,10 @@ static void AVI_IndexCreate( demux_t *p_demux )
     }
 
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_index_Clean( &p_sys->track[i_stream]->idx );
         avi_index_Init( &p_sys->track[i_stream]->idx );
+    }
 
     i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
                         stream_Size( p_demux->s ) );
@@ -2631,7 +2641,10 @@ static void AVI_IndexCreate( demux_t *p_demux )
         if( p_dialog_id != NULL && vlc_tick_now() - i_dialog_update > VLC_TICK_FROM_MS(100) )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
+            {
+                b_cancelled = true;
                 break;
+            }
 
             double f_current = vlc_stream_Tell( p_demux->s );
             double f_size    = stream_Size( p_demux->s );
@@ -2710,6 +2723,156 @@ print_stat:
         msg_Dbg( p_demux, "stream[%d] creating %d index entries",
                 i_stream, p_sys->track[i_stream]->idx.i_size );
     }
+
+    /* a partial index would be reused as is */
+    if( !b_cancelled )
+        AVI_IndexCacheStore( p_demux );
+}
+
+/*
+ * Index cache: the indexes of all the tracks built by scanning the file, so
+ * that they are not rebuilt again for the same file. The indexes read from
+ * the file itself load as fast as a cached copy, and are not stored.
+ *
+ * version, flags, track count, last chunk position, then for each track the
+ * entry count and the entries (fourcc, flags, position, length)
+ */
+#define AVI_INDEX_CACHE_VERSION 1
+#define AVI_INDEX_CACHE_CREATED 0x01 /* built by scanning the whole file */
+#define AVI_INDEX_CACHE_HEADER  16
+#define AVI_INDEX_CACHE_ENTRY   20
+
+static void AVI_IndexCacheStore( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    size_t i_size = AVI_INDEX_CACHE_HEADER;
+    bool b_empty = true;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i]->idx;
+        i_size += 4 + (size_t)p_index->i_size * AVI_INDEX_CACHE_ENTRY;
+        if( p_index->i_size > 0 )
+            b_empty = false;
+    }
+    if( b_empty )
+        return;
+
+    uint8_t *p_data = malloc( i_size );
+    if( unlikely(p_data == NULL) )
+        return;
+
+    uint8_t *p = p_data;
+    p[0] = AVI_INDEX_CACHE_VERSION;
+    p[1] = AVI_INDEX_CACHE_CREATED;
+    SetWLE( &p[2], 0 );
+    SetDWLE( &p[4], p_sys->i_track );
+    SetQWLE( &p[8], p_sys->i_movi_lastchunk_pos );
+    p += AVI_INDEX_CACHE_HEADER;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        SetDWLE( p, p_index->i_size );
+        p += 4;
+        for( uint32_t j = 0; j < p_index->i_size; j++ )
+        {
+            const avi_entry_t *p_entry = &p_index->p_entry[j];
+
+            SetDWLE( &p[0], p_entry->i_id );
+            SetDWLE( &p[4], p_entry->i_flags );
+            SetQWLE( &p[8], p_entry->i_pos );
+            SetDWLE( &p[16], p_entry->i_length );
+            p += AVI_INDEX_CACHE_ENTRY;
+        }
+    }
+
+    demux_IndexCacheStore( p_demux, "avi", p_data, i_size );
+    free( p_data );
+}
+
+static bool AVI_IndexCacheLoad( demux_t *p_demux, bool b_created )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    block_t *p_block = demux_IndexCacheLoad( p_demux, "avi" );
+    if( p_block == NULL )
+        return false;
+
+    const uint8_t *p = p_block->p_buffer;
+    size_t i_left = p_block->i_buffer;
+
+    if( i_left < AVI_INDEX_CACHE_HEADER || p[0] != AVI_INDEX_CACHE_VERSION ||
+        ( b_created && !(p[1] & AVI_INDEX_CACHE_CREATED) ) ||
+        GetDWLE( &p[4] ) != p_sys->i_track )
+    {
+        block_Release( p_block );
+        return false;
+    }
+    uint64_t i_lastchunk_pos = GetQWLE( &p[8] );
+    p += AVI_INDEX_CACHE_HEADER;
+    i_left -= AVI_INDEX_CACHE_HEADER;
+
+    unsigned i;
+    for( i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        avi_index_Clean( p_index );
+        avi_index_Init( p_index );
+        if( i_left < 4 )
+            break;
+
+        uint32_t i_count = GetDWLE( p );
+        p += 4;
+        i_left -= 4;
+        if( i_count > i_left / AVI_INDEX_CACHE_ENTRY )
+            break;
+
+        if( i_count > 0 )
+        {
+            p_index->p_entry = vlc_alloc( i_count, sizeof( *p_index->p_entry ) );
+            if( unlikely(p_index->p_entry == NULL) )
+                break;
+            p_index->i_max = i_count;
+        }
+
+        uint64_t i_lengthtotal = 0;
+        for( uint32_t j = 0; j < i_count; j++ )
+        {
+            avi_entry_t *p_entry = &p_index->p_entry[j];
+
+            p_entry->i_id          = GetDWLE( &p[0] );
+            p_entry->i_flags       = GetDWLE( &p[4] );
+            p_entry->i_pos         = GetQWLE( &p[8] );
+            p_entry->i_length      = GetDWLE( &p[16] );
+            p_entry->i_lengthtotal = i_lengthtotal;
+            i_lengthtotal += p_entry->i_length;
+            p += AVI_INDEX_CACHE_ENTRY;
+        }
+        p_index->i_size = i_count;
+        i_left -= (size_t)i_count * AVI_INDEX_CACHE_ENTRY;
+    }
+    block_Release( p_block );
+
+    if( i < p_sys->i_track || i_left > 0 )
+    {
+        msg_Warn( p_demux, "invalid index cache" );
+        for( unsigned j = 0; j < p_sys->i_track; j++ )
+        {
+            avi_index_Clean( &p_sys->track[j]->idx );
+            avi_index_Init( &p_sys->track[j]->idx );
+        }
+        return false;
+    }
+
+    if( p_sys->i_movi_lastchunk_pos < i_lastchunk_pos )
+        p_sys->i_movi_lastchunk_pos = i_lastchunk_pos;
+
+    for( i = 0; i < p_sys->i_track; i++ )
+        msg_Dbg( p_demux, "stream[%u] loaded %u index entries from cache",
+                 i, p_sys->track[i]->idx.i_size );
+    return true;
 }
 
 /* */
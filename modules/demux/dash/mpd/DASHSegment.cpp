@@ -48,9 +48,7 @@ DashIndexChunk::~DashIndexChunk()
 
 void DashIndexChunk::onDownload(block_t **pp_block)
 {
-    decrypt(pp_block);
-
-    if(!rep || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 )
+    if(!decrypt(pp_block) || !rep || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 )
         return;
 
     IndexReader br(rep->getPlaylist()->getVLCObject());
@@ -31,6 +31,7 @@
 #include <vlc_picture.h>
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_interrupt.h>
 #include <vlc_vector.h>
 
 
@@ -124,6 +125,7 @@ struct demux_sys
 
     int current_title;
     vlc_tick_t chapter_gap;
+    vlc_tick_t live_date;
 
     unsigned int updates;
 
@@ -671,6 +673,17 @@ Demux(demux_t *demux)
 
     const vlc_tick_t step_length = __MAX(audio_step_length, video_step_length);
 
+    /* A source that cannot control the pace is live: deliver in real time */
+    if (!sys->can_control_pace)
+    {
+        if (sys->live_date == VLC_TICK_INVALID)
+            sys->live_date = vlc_tick_now();
+        else if (vlc_mwait_i11e(sys->live_date))
+            return VLC_DEMUXER_SUCCESS;
+        sys->live_date += step_length > 0 ? step_length
+                                          : sys->input_sample_length;
+    }
+
     int ret = VLC_SUCCESS;
     bool audio_eof = true, video_eof = true, input_eof = true;
     if (sys->audio_track_count > 0)
@@ -840,6 +853,7 @@ Open(vlc_object_t *obj)
     sys->current_title = 0;
     sys->chapter_gap = sys->chapter_count > 0 ?
                        (sys->length / sys->chapter_count) : VLC_TICK_INVALID;
+    sys->live_date = VLC_TICK_INVALID;
     sys->updates = 0;
 
     demux->pf_control = Control;
@@ -47,17 +47,12 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    int32_t      *p_sample_offset_pts;  /* pts-dts */
-
-    uint32_t     *p_sample_size;
-    /* TODO if needed add pts
-        but quickly *add* support for edts and seeking */
+    /* position of the first sample in the track stts and ctts tables,
+     * which are decoded on demand */
+    uint32_t     i_index_dts;   /* stts entry of the first sample */
+    uint32_t     i_skip_dts;    /* samples of that entry in previous chunks */
+    uint32_t     i_index_pts;   /* ctts entry of the first sample */
+    uint32_t     i_skip_pts;    /* samples of that entry in previous chunks */
 
 } mp4_chunk_t;
 
@@ -129,8 +124,12 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* stsz table */
+
+    /* sample timing tables, shared by all chunks (ctts may be NULL) */
+    const MP4_Box_data_stts_t *p_stts;
+    const MP4_Box_data_ctts_t *p_ctts;
+    int64_t          i_cts_shift;    /* composition to decoding time shift */
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
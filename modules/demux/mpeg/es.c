@@ -76,6 +76,8 @@ vlc_module_begin ()
 
     add_shortcut( "m4v" )
     add_shortcut( "mp4v" )
+    add_signature( 0, "\x00\x00\x01" )
+    add_signature( 220, "\x00\x00\x01" ) /* .re4 */
 vlc_module_end ()
 
 /*****************************************************************************
@@ -75,6 +75,9 @@ vlc_module_begin ()
     set_capability( "demux", 8 )
     set_callbacks( Open, Close )
     add_shortcut( "ps" )
+    add_signature( 0, "\x00\x00\x01" )
+    add_signature( 0, "PSMF" )
+    add_signature( 8, "CDXA" )
 vlc_module_end ()
 
 /*****************************************************************************
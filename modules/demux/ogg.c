@@ -64,6 +64,7 @@ vlc_module_begin ()
     set_capability( "demux", 50 )
     set_callbacks( Open, Close )
     add_shortcut( "ogg" )
+    add_signature( 0, "OggS" )
 vlc_module_end ()
 
 
@@ -733,5 +733,7 @@ vlc_module_begin ()
     set_category (CAT_INPUT)
     set_subcategory (SUBCAT_INPUT_DEMUX)
     set_capability ("demux", 20)
+    add_signature (0, "MThd")
+    add_signature (0, "RIFF")
     set_callbacks (Open, Close)
 vlc_module_end ()
@@ -52,6 +52,8 @@ vlc_module_begin ()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_DEMUX )
     set_capability( "demux", 142 )
+    add_signature( 0, "RIFF" )
+    add_signature( 0, "RF64" )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -150,6 +150,13 @@ block_t *hxxx_AnnexB_to_xVC( block_t *p_block, uint8_t i_nal_length_size )
     }
     else
     {
+        /* Rewriting in place: do not touch a payload shared with others */
+        p_block = block_MakeWritable( p_block );
+        if( unlikely(!p_block) )
+        {
+            free( p_list );
+            return NULL;
+        }
         p_source = p_dest = p_block->p_buffer;
         p_sourceend = &p_block->p_buffer[p_block->i_buffer];
     }
@@ -0,0 +1,405 @@
+/*****************************************************************************
+ * cache_range.c: sparse byte range cache for random access streams
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+#include <vlc_list.h>
+
+/*
+ * The stream is split in fixed size blocks, aligned on their size. Any set
+ * of blocks can be cached, so that going back and forth between distant
+ * parts of the stream (e.g. MP4 with the moov at the end, or MKV cues) does
+ * not fetch the same data again. The least recently used blocks are
+ * released once the memory budget is reached.
+ *
+ * Fetching a missing block reads ahead more and more blocks as long as the
+ * stream is read sequentially, so that network accesses issue few, large
+ * requests. A seek to a missing block starts over with a single block.
+ */
+#define RANGE_BLOCK_SIZE (64 * 1024)
+
+typedef struct range_block range_block_t;
+struct range_block
+{
+    range_block_t   *next;   /* next block of the hash bucket */
+    struct vlc_list  node;   /* position in the LRU list */
+    uint64_t         index;  /* offset of the block / RANGE_BLOCK_SIZE */
+    size_t           length; /* RANGE_BLOCK_SIZE, except at the end */
+    uint8_t          data[RANGE_BLOCK_SIZE];
+};
+
+typedef struct
+{
+    uint64_t        offset;        /* reading offset */
+    uint64_t        source_offset; /* offset of the source stream */
+    uint64_t        size;          /* UINT64_MAX if unknown */
+
+    range_block_t **buckets;
+    size_t          bucket_mask;
+    struct vlc_list lru;           /* most recently used first */
+    size_t          count;
+    size_t          max_count;
+
+    uint64_t        last_index;    /* block of the previous read */
+    unsigned        readahead;     /* blocks to fetch on the next miss */
+    unsigned        max_readahead;
+
+    stream_cache_stats_t stats;
+} stream_sys_t;
+
+static range_block_t **Find(stream_sys_t *sys, uint64_t index)
+{
+    range_block_t **pp = &sys->buckets[index & sys->bucket_mask];
+
+    while (*pp != NULL && (*pp)->index != index)
+        pp = &(*pp)->next;
+    return pp;
+}
+
+static void Insert(stream_sys_t *sys, range_block_t *block)
+{
+    range_block_t **pp = &sys->buckets[block->index & sys->bucket_mask];
+
+    block->next = *pp;
+    *pp = block;
+    vlc_list_prepend(&block->node, &sys->lru);
+}
+
+static void Remove(stream_sys_t *sys, range_block_t *block)
+{
+    range_block_t **pp = Find(sys, block->index);
+
+    assert(*pp == block);
+    *pp = block->next;
+    vlc_list_remove(&block->node);
+}
+
+/**
+ * Gets a block to fill, reusing the least recently used one if the cache is
+ * full.
+ */
+static range_block_t *Alloc(stream_sys_t *sys)
+{
+    if (sys->count < sys->max_count)
+    {
+        range_block_t *block = malloc(sizeof (*block));
+        if (likely(block != NULL))
+        {
+            sys->count++;
+            return block;
+        }
+    }
+
+    range_block_t *block = vlc_list_last_entry_or_null(&sys->lru,
+                                                       range_block_t, node);
+    if (block != NULL)
+    {
+        Remove(sys, block);
+        sys->stats.evictions++;
+    }
+    return block;
+}
+
+static void Release(stream_sys_t *sys, range_block_t *block)
+{
+    Remove(sys, block);
+    sys->count--;
+    free(block);
+}
+
+static void Flush(stream_sys_t *sys)
+{
+    range_block_t *block;
+
+    vlc_list_foreach(block, &sys->lru, node)
+        Release(sys, block);
+    assert(sys->count == 0);
+}
+
+/**
+ * Fetches a missing block, and the following ones if reading sequentially.
+ *
+ * \return the requested block, or NULL on error or at the end of the stream
+ */
+static range_block_t *Fetch(stream_t *s, uint64_t index, bool sequential)
+{
+    stream_sys_t *sys = s->p_sys;
+    uint64_t offset = index * RANGE_BLOCK_SIZE;
+
+    if (sequential)
+        sys->readahead = __MIN(sys->readahead * 2, sys->max_readahead);
+    else
+        sys->readahead = 1;
+
+    if (sys->source_offset != offset)
+    {
+        if (vlc_stream_Seek(s->s, offset))
+        {
+            msg_Err(s, "cannot seek (to offset %"PRIu64")", offset);
+            return NULL;
+        }
+        sys->source_offset = offset;
+        sys->stats.seeks++;
+    }
+
+    range_block_t *first = NULL;
+
+    for (unsigned i = 0; i < sys->readahead; i++)
+    {
+        if (offset >= sys->size)
+            break;
+        if (i > 0 && *Find(sys, index + i) != NULL)
+            break; /* the rest may be cached too, fetch it later if not */
+
+        range_block_t *block = Alloc(sys);
+        if (unlikely(block == NULL))
+            break;
+
+        ssize_t val = vlc_stream_Read(s->s, block->data, RANGE_BLOCK_SIZE);
+        if (val <= 0)
+        {
+            sys->count--;
+            free(block);
+            break;
+        }
+
+        block->index = index + i;
+        block->length = val;
+        Insert(sys, block);
+        sys->source_offset += val;
+        sys->stats.read_bytes += val;
+        offset += val;
+
+        if (first == NULL)
+            first = block;
+        if ((size_t)val < RANGE_BLOCK_SIZE)
+            break; /* end of stream or error */
+    }
+
+    if (first != NULL)
+    {   /* the requested block is the most recently used */
+        vlc_list_remove(&first->node);
+        vlc_list_prepend(&first->node, &sys->lru);
+    }
+    return first;
+}
+
+static ssize_t Read(stream_t *s, void *buf, size_t len)
+{
+    stream_sys_t *sys = s->p_sys;
+    uint64_t index = sys->offset / RANGE_BLOCK_SIZE;
+    size_t skip = sys->offset % RANGE_BLOCK_SIZE;
+    range_block_t *block = *Find(sys, index);
+    bool sequential = index == sys->last_index + 1;
+
+    sys->last_index = index;
+    if (block != NULL && skip >= block->length && sys->offset < sys->size)
+    {   /* truncated by a read error, try again */
+        Release(sys, block);
+        block = NULL;
+    }
+
+    if (block != NULL)
+    {
+        sys->stats.hits++;
+        vlc_list_remove(&block->node);
+        vlc_list_prepend(&block->node, &sys->lru);
+    }
+    else
+    {
+        sys->stats.misses++;
+        block = Fetch(s, index, sequential);
+        if (block == NULL)
+            return 0;
+    }
+
+    if (skip >= block->length)
+        return 0;
+
+    size_t copy = __MIN(len, block->length - skip);
+
+    memcpy(buf, block->data + skip, copy);
+    sys->offset += copy;
+    return copy;
+}
+
+static int Seek(stream_t *s, uint64_t offset)
+{
+    stream_sys_t *sys = s->p_sys;
+
+    sys->offset = offset;
+    return VLC_SUCCESS;
+}
+
+static int Control(stream_t *s, int query, va_list args)
+{
+    stream_sys_t *sys = s->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+        case STREAM_GET_SIZE:
+        case STREAM_GET_PTS_DELAY:
+        case STREAM_GET_TITLE_INFO:
+        case STREAM_GET_TITLE:
+        case STREAM_GET_SEEKPOINT:
+        case STREAM_GET_META:
+        case STREAM_GET_CONTENT_TYPE:
+        case STREAM_GET_SIGNAL:
+        case STREAM_GET_TAGS:
+        case STREAM_SET_PAUSE_STATE:
+        case STREAM_SET_PRIVATE_ID_STATE:
+        case STREAM_SET_PRIVATE_ID_CA:
+        case STREAM_GET_PRIVATE_ID_STATE:
+            return vlc_stream_vaControl(s->s, query, args);
+
+        case STREAM_SET_TITLE:
+        case STREAM_SET_SEEKPOINT:
+        {
+            int ret = vlc_stream_vaControl(s->s, query, args);
+            if (ret == VLC_SUCCESS)
+            {   /* the offsets now refer to another title */
+                Flush(sys);
+                sys->offset = sys->source_offset = vlc_stream_Tell(s->s);
+                if (vlc_stream_GetSize(s->s, &sys->size))
+                    sys->size = UINT64_MAX;
+            }
+            return ret;
+        }
+
+        case STREAM_GET_CACHE_STATS:
+        {
+            stream_cache_stats_t *stats = va_arg(args, stream_cache_stats_t *);
+
+            *stats = sys->stats;
+            stats->cached = sys->count * RANGE_BLOCK_SIZE;
+            stats->budget = sys->max_count * RANGE_BLOCK_SIZE;
+            return VLC_SUCCESS;
+        }
+
+        case STREAM_SET_RECORD_STATE:
+        default:
+            msg_Err(s, "invalid vlc_stream_vaControl query=0x%x", query);
+            return VLC_EGENERIC;
+    }
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *s = (stream_t *)obj;
+    bool can_seek;
+
+    /* Without seeking, only the latest data is ever read again: the other
+     * stream caches are better at this. */
+    if (vlc_stream_Control(s->s, STREAM_CAN_SEEK, &can_seek) || !can_seek)
+        return VLC_EGENERIC;
+
+    stream_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    if (vlc_stream_GetSize(s->s, &sys->size))
+        sys->size = UINT64_MAX;
+
+    uint64_t budget = var_InheritInteger(s, "cache-range-size") << 10;
+    if (budget > sys->size) /* no point caching more than the whole stream */
+        budget = sys->size + RANGE_BLOCK_SIZE - 1;
+    sys->max_count = __MAX(budget / RANGE_BLOCK_SIZE, 2);
+
+    size_t buckets = 1;
+    while (buckets < sys->max_count)
+        buckets <<= 1;
+
+    sys->buckets = calloc(buckets, sizeof (*sys->buckets));
+    if (unlikely(sys->buckets == NULL))
+    {
+        free(sys);
+        return VLC_ENOMEM;
+    }
+    sys->bucket_mask = buckets - 1;
+    vlc_list_init(&sys->lru);
+    sys->count = 0;
+
+    /* Keep at least half of the cache for the data read earlier */
+    sys->max_readahead = (var_InheritInteger(s, "cache-range-readahead") << 10)
+                         / RANGE_BLOCK_SIZE;
+    sys->max_readahead = VLC_CLIP(sys->max_readahead, 1, sys->max_count / 2);
+    sys->readahead = 1;
+
+    sys->offset = sys->source_offset = vlc_stream_Tell(s->s);
+    sys->last_index = sys->offset / RANGE_BLOCK_SIZE - 1;
+    memset(&sys->stats, 0, sizeof (sys->stats));
+
+    msg_Dbg(s, "using %zu bytes cache, %u bytes readahead",
+            sys->max_count * RANGE_BLOCK_SIZE,
+            sys->max_readahead * RANGE_BLOCK_SIZE);
+
+    s->p_sys = sys;
+    s->pf_read = Read;
+    s->pf_seek = Seek;
+    s->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *s = (stream_t *)obj;
+    stream_sys_t *sys = s->p_sys;
+    uint64_t lookups = sys->stats.hits + sys->stats.misses;
+
+    msg_Dbg(s, "%"PRIu64" reads, %.1f%% hits, %"PRIu64" bytes fetched "
+            "with %"PRIu64" seeks, %"PRIu64" evictions", lookups,
+            lookups ? 100. * sys->stats.hits / lookups : 0.,
+            sys->stats.read_bytes, sys->stats.seeks, sys->stats.evictions);
+
+    Flush(sys);
+    free(sys->buckets);
+    free(sys);
+}
+
+vlc_module_begin()
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
+    set_capability("stream_filter", 0)
+
+    set_description(N_("Byte range cache"))
+    set_callbacks(Open, Close)
+
+    add_integer("cache-range-size", 1 << 15, N_("Cache size"),
+                N_("Memory used to cache the data read from the stream "
+                   "(KiB)"), false)
+        change_integer_range(128, 1 << 22)
+    add_integer("cache-range-readahead", 1 << 10, N_("Readahead"),
+                N_("Maximum data fetched ahead of a sequential read (KiB)"),
+                true)
+        change_integer_range(64, 1 << 20)
+vlc_module_end()
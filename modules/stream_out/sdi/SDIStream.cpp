@@ -368,6 +368,13 @@ void AbstractDecodedStream::decoderThread()
 int AbstractDecodedStream::Send(block_t *p_block)
 {
     assert(p_decoder);
+    /* Decoders modify their input in place (see duplicate) */
+    if(p_block)
+    {
+        p_block = block_MakeWritable(p_block);
+        if(!p_block)
+            return VLC_ENOMEM;
+    }
     vlc_mutex_lock(&inputLock);
     inputQueue.push(p_block);
     if(p_block)
@@ -739,6 +739,11 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
             goto error;
     }
 
+    /* Decoders modify their input in place (see duplicate) */
+    p_buffer = block_MakeWritable( p_buffer );
+    if( unlikely(p_buffer == NULL) )
+        return VLC_ENOMEM;
+
     int i_ret;
     switch( id->p_decoder->fmt_in.i_cat )
     {
@@ -110,6 +110,10 @@ static void Destroy( vlc_object_t * );
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
 
 
+#define CACHE_SIZE_TEXT N_("Glyph cache size (kB)")
+#define CACHE_SIZE_LONGTEXT N_("Memory shared by the caches of loaded " \
+  "glyphs and of rendered glyphs. 0 disables the caches." )
+
 #define YUVP_TEXT N_("Use YUVP renderer")
 #define YUVP_LONGTEXT N_("This renders the font using \"paletized YUV\". " \
   "This option is only needed if you want to encode into DVB subtitles" )
@@ -211,6 +215,9 @@ vlc_module_begin ()
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
 
+    add_integer_with_range( "freetype-cache-size", 1024, 0, 65536,
+                            CACHE_SIZE_TEXT, CACHE_SIZE_LONGTEXT, true )
+
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
                             TEXT_DIRECTION_LONGTEXT, false )
@@ -1428,6 +1435,14 @@ static int Create( vlc_object_t *p_this )
         p_sys->p_stroker = NULL;
     }
 
+    /* The caches are optional */
+    size_t i_cache_size = var_InheritInteger( p_filter, "freetype-cache-size" ) * 1024;
+    if( i_cache_size > 0 )
+    {
+        p_sys->p_glyph_cache = LRUCache_New( i_cache_size / 2, FreeCachedGlyph );
+        p_sys->p_bitmap_cache = LRUCache_New( i_cache_size / 2, FreeCachedBitmap );
+    }
+
     /* Dictionnaries for fonts and families */
     vlc_dictionary_init( &p_sys->face_map, 50 );
     vlc_dictionary_init( &p_sys->family_map, 50 );
@@ -1553,6 +1568,18 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    /* Caches, holding glyphs of the faces */
+    if( p_sys->p_glyph_cache )
+    {
+        LRUCache_LogStats( p_this, "glyph", p_sys->p_glyph_cache );
+        LRUCache_Delete( p_sys->p_glyph_cache );
+    }
+    if( p_sys->p_bitmap_cache )
+    {
+        LRUCache_LogStats( p_this, "glyph bitmap", p_sys->p_bitmap_cache );
+        LRUCache_Delete( p_sys->p_bitmap_cache );
+    }
+
     /* Text styles */
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
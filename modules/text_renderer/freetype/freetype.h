@@ -46,6 +46,8 @@
 #include FT_GLYPH_H
 #include FT_STROKER_H
 
+#include "lru_cache.h"
+
 /* Consistency between Freetype versions and platforms */
 #define FT_FLOOR(X)     ((X & -64) >> 6)
 #define FT_CEIL(X)      (((X + 63) & -64) >> 6)
@@ -78,6 +80,10 @@ typedef struct
     FT_Face        p_face;          /* handle to face object */
     FT_Stroker     p_stroker;       /* handle to path stroker object */
 
+    /* Loaded glyphs and rendered glyph bitmaps (may be NULL) */
+    lru_cache_t   *p_glyph_cache;
+    lru_cache_t   *p_bitmap_cache;
+
     text_style_t  *p_default_style;
     text_style_t  *p_forced_style;  /* Renderer overridings */
 
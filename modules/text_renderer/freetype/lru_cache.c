@@ -0,0 +1,233 @@
+/*****************************************************************************
+ * lru_cache.c : Least recently used cache for glyphs
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Least recently used cache
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lru_cache.h"
+
+typedef struct lru_entry_t lru_entry_t;
+struct lru_entry_t
+{
+    lru_entry_t     *p_next;    /**< next entry of the hash bucket */
+    struct vlc_list  node;      /**< position in the LRU list */
+    void            *p_value;
+    size_t           i_cost;
+    uint32_t         i_hash;
+    size_t           i_key;
+    unsigned char    key[];
+};
+
+struct lru_cache_t
+{
+    lru_entry_t    **pp_buckets;
+    size_t           i_buckets; /**< power of two */
+    size_t           i_count;
+    size_t           i_cost;
+    size_t           i_max_cost;
+    struct vlc_list  lru;       /**< most recently used first */
+    void           (*pf_free)( void * );
+
+    unsigned         i_hits;
+    unsigned         i_misses;
+    unsigned         i_evictions;
+};
+
+static uint32_t Hash( const unsigned char *p_key, size_t i_key )
+{
+    uint32_t i_hash = 2166136261u; /* FNV-1a */
+
+    for( size_t i = 0; i < i_key; i++ )
+        i_hash = ( i_hash ^ p_key[i] ) * 16777619u;
+    return i_hash;
+}
+
+lru_cache_t *LRUCache_New( size_t i_max_cost, void (*pf_free)( void * ) )
+{
+    lru_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    p_cache->i_buckets = 256;
+    p_cache->pp_buckets = calloc( p_cache->i_buckets, sizeof( lru_entry_t * ) );
+    if( !p_cache->pp_buckets )
+    {
+        free( p_cache );
+        return NULL;
+    }
+
+    p_cache->i_max_cost = i_max_cost;
+    p_cache->pf_free = pf_free;
+    vlc_list_init( &p_cache->lru );
+    return p_cache;
+}
+
+void LRUCache_Delete( lru_cache_t *p_cache )
+{
+    lru_entry_t *p_entry;
+
+    vlc_list_foreach( p_entry, &p_cache->lru, node )
+    {
+        p_cache->pf_free( p_entry->p_value );
+        free( p_entry );
+    }
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+static lru_entry_t **Find( lru_cache_t *p_cache, const void *p_key,
+                           size_t i_key, uint32_t i_hash )
+{
+    lru_entry_t **pp_entry =
+        &p_cache->pp_buckets[i_hash & ( p_cache->i_buckets - 1 )];
+
+    for( ; *pp_entry; pp_entry = &(*pp_entry)->p_next )
+    {
+        const lru_entry_t *p_entry = *pp_entry;
+        if( p_entry->i_hash == i_hash && p_entry->i_key == i_key
+         && !memcmp( p_entry->key, p_key, i_key ) )
+            break;
+    }
+    return pp_entry;
+}
+
+static void Remove( lru_cache_t *p_cache, lru_entry_t *p_entry )
+{
+    lru_entry_t **pp_entry = Find( p_cache, p_entry->key, p_entry->i_key,
+                                   p_entry->i_hash );
+    assert( *pp_entry == p_entry );
+    *pp_entry = p_entry->p_next;
+
+    vlc_list_remove( &p_entry->node );
+    p_cache->i_count--;
+    p_cache->i_cost -= p_entry->i_cost;
+    p_cache->pf_free( p_entry->p_value );
+    free( p_entry );
+}
+
+static void Grow( lru_cache_t *p_cache )
+{
+    size_t i_buckets = p_cache->i_buckets * 2;
+    lru_entry_t **pp_buckets = calloc( i_buckets, sizeof( lru_entry_t * ) );
+    if( !pp_buckets )
+        return; /* keep the longer chains */
+
+    for( size_t i = 0; i < p_cache->i_buckets; i++ )
+    {
+        for( lru_entry_t *p_entry = p_cache->pp_buckets[i]; p_entry; )
+        {
+            lru_entry_t *p_next = p_entry->p_next;
+            lru_entry_t **pp_bucket = &pp_buckets[p_entry->i_hash & ( i_buckets - 1 )];
+
+            p_entry->p_next = *pp_bucket;
+            *pp_bucket = p_entry;
+            p_entry = p_next;
+        }
+    }
+
+    free( p_cache->pp_buckets );
+    p_cache->pp_buckets = pp_buckets;
+    p_cache->i_buckets = i_buckets;
+}
+
+void *LRUCache_Get( lru_cache_t *p_cache, const void *p_key, size_t i_key )
+{
+    lru_entry_t *p_entry = *Find( p_cache, p_key, i_key, Hash( p_key, i_key ) );
+
+    if( !p_entry )
+    {
+        p_cache->i_misses++;
+        return NULL;
+    }
+
+    p_cache->i_hits++;
+    vlc_list_remove( &p_entry->node );
+    vlc_list_prepend( &p_entry->node, &p_cache->lru );
+    return p_entry->p_value;
+}
+
+void LRUCache_Put( lru_cache_t *p_cache, const void *p_key, size_t i_key,
+                   void *p_value, size_t i_cost )
+{
+    uint32_t i_hash = Hash( p_key, i_key );
+
+    if( i_cost > p_cache->i_max_cost || *Find( p_cache, p_key, i_key, i_hash ) )
+    {
+        p_cache->pf_free( p_value );
+        return;
+    }
+
+    lru_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key );
+    if( !p_entry )
+    {
+        p_cache->pf_free( p_value );
+        return;
+    }
+
+    while( p_cache->i_cost + i_cost > p_cache->i_max_cost )
+    {
+        lru_entry_t *p_last = vlc_list_last_entry_or_null( &p_cache->lru,
+                                                           lru_entry_t, node );
+        Remove( p_cache, p_last );
+        p_cache->i_evictions++;
+    }
+
+    if( p_cache->i_count >= p_cache->i_buckets )
+        Grow( p_cache );
+
+    p_entry->p_value = p_value;
+    p_entry->i_cost = i_cost;
+    p_entry->i_hash = i_hash;
+    p_entry->i_key = i_key;
+    memcpy( p_entry->key, p_key, i_key );
+
+    lru_entry_t **pp_bucket = &p_cache->pp_buckets[i_hash & ( p_cache->i_buckets - 1 )];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    vlc_list_prepend( &p_entry->node, &p_cache->lru );
+    p_cache->i_count++;
+    p_cache->i_cost += i_cost;
+}
+
+void LRUCache_LogStats( vlc_object_t *p_obj, const char *psz_name,
+                        const lru_cache_t *p_cache )
+{
+    unsigned i_lookups = p_cache->i_hits + p_cache->i_misses;
+
+    msg_Dbg( p_obj, "%s cache: %u lookups, %.1f%% hits, %u evictions, "
+             "%zu entries, %zu/%zu bytes", psz_name, i_lookups,
+             i_lookups ? 100. * p_cache->i_hits / i_lookups : 0.,
+             p_cache->i_evictions, p_cache->i_count,
+             p_cache->i_cost, p_cache->i_max_cost );
+}
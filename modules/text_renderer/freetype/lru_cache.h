@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * lru_cache.h : Least recently used cache for glyphs
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Least recently used cache
+ *
+ * Values are looked up by the bytes of their key, and the least recently
+ * used ones are released when the cost of all the values exceeds the budget
+ * of the cache.
+ */
+
+typedef struct lru_cache_t lru_cache_t;
+
+/**
+ * Creates a cache.
+ *
+ * \param i_max_cost memory budget of the cache, in bytes
+ * \param pf_free called to release a value
+ */
+lru_cache_t *LRUCache_New( size_t i_max_cost, void (*pf_free)( void * ) );
+
+/**
+ * Releases a cache and all its values.
+ */
+void LRUCache_Delete( lru_cache_t *p_cache );
+
+/**
+ * Looks up a value.
+ *
+ * The value belongs to the cache, and may be released by the next
+ * LRUCache_Put() call.
+ *
+ * \return the value, or NULL if it is not cached
+ */
+void *LRUCache_Get( lru_cache_t *p_cache, const void *p_key, size_t i_key );
+
+/**
+ * Adds a value to the cache, which then owns it.
+ *
+ * \param i_cost memory size of the value, in bytes
+ *
+ * The value is released immediately if it cannot be stored.
+ */
+void LRUCache_Put( lru_cache_t *p_cache, const void *p_key, size_t i_key,
+                   void *p_value, size_t i_cost );
+
+/**
+ * Logs the hit rate of the cache.
+ */
+void LRUCache_LogStats( vlc_object_t *p_obj, const char *psz_name,
+                        const lru_cache_t *p_cache );
+
+#endif
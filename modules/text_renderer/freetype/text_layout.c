@@ -116,11 +116,47 @@ typedef struct run_desc_t
 
 } run_desc_t;
 
+/**
+ * Key of the glyph caches: a glyph as loaded and styled by LoadGlyphs().
+ * Faces are loaded for a given size, so they identify the size too.
+ */
+typedef struct glyph_key_t
+{
+    FT_Face     p_face;
+    FT_UInt     i_index;
+    int         i_style_flags;  /* synthetic bold and italic */
+    FT_Fixed    i_radius;       /* outline radius, -1 without outline */
+} glyph_key_t;
+
+/**
+ * Entry of the glyph cache
+ */
+typedef struct cached_glyph_t
+{
+    FT_Glyph    p_glyph;
+    FT_Glyph    p_outline;
+    FT_Pos      i_x_advance;
+    FT_Pos      i_y_advance;
+} cached_glyph_t;
+
+/**
+ * Key of the glyph bitmap cache. Bitmaps are rendered at the subpixel
+ * position of the pen and moved by whole pixels.
+ */
+typedef struct bitmap_key_t
+{
+    glyph_key_t glyph;
+    bool        b_outline;
+    FT_Pos      i_x;            /* 26.6 fractional part of the origin */
+    FT_Pos      i_y;
+} bitmap_key_t;
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
 typedef struct glyph_bitmaps_t
 {
+    glyph_key_t key;            /* p_face is NULL if the glyph is not cached */
     FT_Glyph p_glyph;
     FT_Glyph p_outline;
     FT_Glyph p_shadow;
@@ -997,6 +1033,127 @@ static int ZeroNsmAdvance( paragraph_t *p_paragraph )
 #endif
 #endif
 
+static size_t GlyphCost( FT_Glyph glyph )
+{
+    if( glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph)glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    if( glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * abs( p_bitmap->pitch );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+void FreeCachedGlyph( void *p_value )
+{
+    cached_glyph_t *p_cached = p_value;
+
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+void FreeCachedBitmap( void *p_value )
+{
+    FT_Done_Glyph( (FT_Glyph)p_value );
+}
+
+/**
+ * Stores copies of the glyphs just loaded into the glyph cache
+ */
+static void CacheGlyph( filter_sys_t *p_sys, const glyph_bitmaps_t *p_bitmaps,
+                        const FT_Vector *p_advance )
+{
+    cached_glyph_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    p_cached->p_outline = NULL;
+    p_cached->i_x_advance = p_advance->x;
+    p_cached->i_y_advance = p_advance->y;
+
+    if( FT_Glyph_Copy( p_bitmaps->p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return;
+    }
+    if( p_bitmaps->p_outline &&
+        FT_Glyph_Copy( p_bitmaps->p_outline, &p_cached->p_outline ) )
+    {
+        FT_Done_Glyph( p_cached->p_glyph );
+        free( p_cached );
+        return;
+    }
+
+    size_t i_cost = sizeof( *p_cached ) + GlyphCost( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        i_cost += GlyphCost( p_cached->p_outline );
+    LRUCache_Put( p_sys->p_glyph_cache, &p_bitmaps->key, sizeof( p_bitmaps->key ),
+                  p_cached, i_cost );
+}
+
+/**
+ * Renders a glyph or outline of LoadGlyphs() to a bitmap at the given origin,
+ * like FT_Glyph_To_Bitmap(), through the glyph bitmap cache.
+ */
+static FT_Error RenderGlyph( filter_sys_t *p_sys, const glyph_key_t *p_key,
+                             bool b_outline, FT_Glyph *p_glyph,
+                             const FT_Vector *p_origin, bool b_destroy )
+{
+    if( !p_sys->p_bitmap_cache || !p_key->p_face ||
+        (*p_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( p_glyph, FT_RENDER_MODE_NORMAL,
+                                   (FT_Vector *)p_origin, b_destroy );
+
+    bitmap_key_t key;
+    memset( &key, 0, sizeof( key ) );
+    key.glyph = *p_key;
+    key.b_outline = b_outline;
+    key.i_x = p_origin->x & 63;
+    key.i_y = p_origin->y & 63;
+
+    FT_Glyph bitmap;
+    FT_Glyph cached = LRUCache_Get( p_sys->p_bitmap_cache, &key, sizeof( key ) );
+    if( cached )
+    {
+        if( FT_Glyph_Copy( cached, &bitmap ) )
+            return FT_Err_Out_Of_Memory;
+    }
+    else
+    {
+        FT_Vector subpixel = { .x = key.i_x, .y = key.i_y };
+        FT_Error error;
+
+        cached = *p_glyph;
+        error = FT_Glyph_To_Bitmap( &cached, FT_RENDER_MODE_NORMAL, &subpixel, 0 );
+        if( error )
+            return error;
+        error = FT_Glyph_Copy( cached, &bitmap );
+        LRUCache_Put( p_sys->p_bitmap_cache, &key, sizeof( key ),
+                      cached, GlyphCost( cached ) );
+        if( error )
+            return error;
+    }
+
+    /* Move the bitmap by the whole pixels of the origin */
+    FT_BitmapGlyph bitmap_glyph = (FT_BitmapGlyph)bitmap;
+    bitmap_glyph->left += ( p_origin->x - key.i_x ) / 64;
+    bitmap_glyph->top += ( p_origin->y - key.i_y ) / 64;
+
+    if( b_destroy )
+        FT_Done_Glyph( *p_glyph );
+    *p_glyph = bitmap;
+    return 0;
+}
+
 /**
  * Load the glyphs of a paragraph. When shaping with HarfBuzz the glyph indices
  * have already been determined at this point, as well as the advance values.
@@ -1039,18 +1196,27 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_radius = -1;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        int i_synthetic_styles = 0;
+        if( ( p_style->i_style_flags & STYLE_BOLD )
+              && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+            i_synthetic_styles |= STYLE_BOLD;
+        if( ( p_style->i_style_flags & STYLE_ITALIC )
+              && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+            i_synthetic_styles |= STYLE_ITALIC;
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1101,30 +1267,59 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
-
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
-
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+            memset( &p_bitmaps->key, 0, sizeof( p_bitmaps->key ) );
+            if( p_sys->p_glyph_cache )
+            {
+                p_bitmaps->key.p_face = p_face;
+                p_bitmaps->key.i_index = i_glyph_index;
+                p_bitmaps->key.i_style_flags = i_synthetic_styles;
+                p_bitmaps->key.i_radius = i_radius;
+            }
 
-#undef SKIP_GLYPH
+            const cached_glyph_t *p_cached = !p_sys->p_glyph_cache ? NULL :
+                LRUCache_Get( p_sys->p_glyph_cache, &p_bitmaps->key,
+                              sizeof( p_bitmaps->key ) );
+            FT_Vector advance;
 
-            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
+            if( p_cached )
             {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_sys->p_stroker, 0, 0 ) )
+                if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+                if( p_cached->p_outline &&
+                    FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
                     p_bitmaps->p_outline = 0;
+                advance.x = p_cached->i_x_advance;
+                advance.y = p_cached->i_y_advance;
             }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                if( i_synthetic_styles & STYLE_BOLD )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( i_synthetic_styles & STYLE_ITALIC )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
+
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                if( i_radius >= 0 )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
+
+                advance = p_face->glyph->advance;
+                if( p_sys->p_glyph_cache )
+                    CacheGlyph( p_sys, p_bitmaps, &advance );
+            }
+
+#undef SKIP_GLYPH
 
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
@@ -1132,8 +1327,8 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
@@ -1240,8 +1435,9 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            if( RenderGlyph( p_sys, &p_bitmaps->key,
+                             p_bitmaps->p_shadow == p_bitmaps->p_outline,
+                             &p_bitmaps->p_shadow, &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1249,8 +1445,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys, &p_bitmaps->key, false,
+                             &p_bitmaps->p_glyph, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1265,8 +1461,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys, &p_bitmaps->key, true,
+                             &p_bitmaps->p_outline, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
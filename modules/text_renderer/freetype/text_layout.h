@@ -63,6 +63,12 @@ struct line_desc_t
 void FreeLines( line_desc_t *p_lines );
 line_desc_t *NewLine( int i_count );
 
+/**
+ * Releases the values of the glyph and glyph bitmap caches
+ */
+void FreeCachedGlyph( void *p_value );
+void FreeCachedBitmap( void *p_value );
+
 /**
  * \struct layout_ruby_t
  * \brief LayoutText parameters
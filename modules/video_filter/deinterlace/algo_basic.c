@@ -184,38 +184,55 @@ int RenderLinear( filter_t *p_filter,
     return VLC_SUCCESS;
 }
 
+/* Pictures being blended, shared by all the slices */
+struct blend_slice
+{
+    filter_sys_t *p_sys;
+    picture_t *p_outpic;
+    picture_t *p_pic;
+};
+
 /*****************************************************************************
  * RenderMean: Half-resolution blender
  *****************************************************************************/
 
-int RenderMean( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+static void RenderMeanSlice( void *opaque, unsigned i_slice, unsigned i_count )
 {
-    int i_plane;
-
-    filter_sys_t *p_sys = p_filter->p_sys;
+    const struct blend_slice *ctx = opaque;
+    filter_sys_t *p_sys = ctx->p_sys;
 
-    /* Copy image and skip lines */
-    for( i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
+    for( int i_plane = 0 ; i_plane < ctx->p_pic->i_planes ; i_plane++ )
     {
-        uint8_t *p_in, *p_out_end, *p_out;
+        const plane_t *p_inp = &ctx->p_pic->p[i_plane];
+        const plane_t *p_outp = &ctx->p_outpic->p[i_plane];
+        int i_begin, i_end;
 
-        p_in = p_pic->p[i_plane].p_pixels;
+        vlc_slice_Lines( i_slice, i_count, p_outp->i_visible_lines,
+                         &i_begin, &i_end );
 
-        p_out = p_outpic->p[i_plane].p_pixels;
-        p_out_end = p_out + p_outpic->p[i_plane].i_pitch
-                             * p_outpic->p[i_plane].i_visible_lines;
+        uint8_t *p_in = p_inp->p_pixels + 2 * i_begin * p_inp->i_pitch;
+        uint8_t *p_out = p_outp->p_pixels + i_begin * p_outp->i_pitch;
 
         /* All lines: mean value */
-        for( ; p_out < p_out_end ; )
+        for( int y = i_begin; y < i_end; y++ )
         {
-            Merge( p_out, p_in, p_in + p_pic->p[i_plane].i_pitch,
-                   p_pic->p[i_plane].i_pitch );
+            Merge( p_out, p_in, p_in + p_inp->i_pitch, p_inp->i_pitch );
 
-            p_out += p_outpic->p[i_plane].i_pitch;
-            p_in += 2 * p_pic->p[i_plane].i_pitch;
+            p_out += p_outp->i_pitch;
+            p_in += 2 * p_inp->i_pitch;
         }
     }
     EndMerge();
+}
+
+int RenderMean( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct blend_slice ctx = {
+        .p_sys = p_sys, .p_outpic = p_outpic, .p_pic = p_pic,
+    };
+
+    vlc_slices_Run( p_sys->slices, RenderMeanSlice, &ctx );
     return VLC_SUCCESS;
 }
 
@@ -223,37 +240,50 @@ int RenderMean( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
  * RenderBlend: Full-resolution blender
  *****************************************************************************/
 
-int RenderBlend( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+static void RenderBlendSlice( void *opaque, unsigned i_slice, unsigned i_count )
 {
-    int i_plane;
-
-    filter_sys_t *p_sys = p_filter->p_sys;
+    const struct blend_slice *ctx = opaque;
+    filter_sys_t *p_sys = ctx->p_sys;
 
-    /* Copy image and skip lines */
-    for( i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
+    for( int i_plane = 0 ; i_plane < ctx->p_pic->i_planes ; i_plane++ )
     {
-        uint8_t *p_in, *p_out_end, *p_out;
+        const plane_t *p_inp = &ctx->p_pic->p[i_plane];
+        const plane_t *p_outp = &ctx->p_outpic->p[i_plane];
+        int i_begin, i_end;
 
-        p_in = p_pic->p[i_plane].p_pixels;
+        vlc_slice_Lines( i_slice, i_count, p_outp->i_visible_lines,
+                         &i_begin, &i_end );
 
-        p_out = p_outpic->p[i_plane].p_pixels;
-        p_out_end = p_out + p_outpic->p[i_plane].i_pitch
-                             * p_outpic->p[i_plane].i_visible_lines;
+        uint8_t *p_out = p_outp->p_pixels + i_begin * p_outp->i_pitch;
+        int y = i_begin;
 
         /* First line: simple copy */
-        memcpy( p_out, p_in, p_pic->p[i_plane].i_pitch );
-        p_out += p_outpic->p[i_plane].i_pitch;
+        if( y == 0 && y < i_end )
+        {
+            memcpy( p_out, p_inp->p_pixels, p_inp->i_pitch );
+            p_out += p_outp->i_pitch;
+            y++;
+        }
 
         /* Remaining lines: mean value */
-        for( ; p_out < p_out_end ; )
+        for( ; y < i_end; y++ )
         {
-            Merge( p_out, p_in, p_in + p_pic->p[i_plane].i_pitch,
-                   p_pic->p[i_plane].i_pitch );
+            const uint8_t *p_in = p_inp->p_pixels + (y - 1) * p_inp->i_pitch;
 
-            p_out += p_outpic->p[i_plane].i_pitch;
-            p_in  += p_pic->p[i_plane].i_pitch;
+            Merge( p_out, p_in, p_in + p_inp->i_pitch, p_inp->i_pitch );
+            p_out += p_outp->i_pitch;
         }
     }
     EndMerge();
+}
+
+int RenderBlend( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct blend_slice ctx = {
+        .p_sys = p_sys, .p_outpic = p_outpic, .p_pic = p_pic,
+    };
+
+    vlc_slices_Run( p_sys->slices, RenderBlendSlice, &ctx );
     return VLC_SUCCESS;
 }
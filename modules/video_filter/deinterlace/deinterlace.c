@@ -528,6 +528,13 @@ notsupp:
 
     p_sys->chroma = chroma;
 
+    p_sys->slices = vlc_slices_New( p_filter );
+    if( !p_sys->slices )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     InitDeinterlacingContext( &p_sys->context );
 
     config_ChainParse( p_filter, FILTER_CFG_PREFIX, ppsz_filter_options,
@@ -662,6 +669,9 @@ void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t*)p_this;
 
+    filter_sys_t *p_sys = p_filter->p_sys;
+
     Flush( p_filter );
-    free( p_filter->p_sys );
+    vlc_slices_Delete( p_sys->slices );
+    free( p_sys );
 }
@@ -34,6 +34,7 @@ struct vlc_object_t;
 
 #include <vlc_common.h>
 #include <vlc_mouse.h>
+#include <vlc_slices.h>
 
 /* Local algorithm headers */
 #include "algo_basic.h"
@@ -77,6 +78,9 @@ typedef struct
 
     struct deinterlace_ctx   context;
 
+    /** Slices of the pictures, for the algorithms rendering in parallel */
+    vlc_slices_t *slices;
+
     /* Algorithm-specific substructures */
     union {
         phosphor_sys_t phosphor; /**< Phosphor algorithm state. */
@@ -32,6 +32,7 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
 #include "filter_picture.h"
 
 #include <math.h>                                          /* exp(), sqrt() */
@@ -99,8 +100,20 @@ typedef struct
     type_t *pt_distribution;
     type_t *pt_buffer;
     type_t *pt_scale;
+
+    vlc_slices_t *slices;
 } filter_sys_t;
 
+/* Plane being blurred, shared by all its slices */
+typedef struct
+{
+    const filter_sys_t *p_sys;
+    const plane_t *p_in;
+    plane_t *p_out;
+    int x_factor;
+    int y_factor;
+} gaussianblur_slice_t;
+
 static void gaussianblur_InitDistribution( filter_sys_t *p_sys )
 {
     double f_sigma = p_sys->f_sigma;
@@ -171,6 +184,14 @@ static int Create( vlc_object_t *p_this )
     p_sys->pt_buffer = NULL;
     p_sys->pt_scale = NULL;
 
+    p_sys->slices = vlc_slices_New( p_filter );
+    if( p_sys->slices == NULL )
+    {
+        free( p_sys->pt_distribution );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     return VLC_SUCCESS;
 }
 
@@ -182,16 +203,90 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys->pt_distribution );
     free( p_sys->pt_buffer );
     free( p_sys->pt_scale );
+    vlc_slices_Delete( p_sys->slices );
 
     free( p_sys );
 }
 
+/* Horizontal pass, from the input plane to the buffer */
+static void HorizontalSlice( void *opaque, unsigned i_slice, unsigned i_count )
+{
+    const gaussianblur_slice_t *ctx = opaque;
+    const int i_dim = ctx->p_sys->i_dim;
+    const type_t *pt_distribution = ctx->p_sys->pt_distribution;
+    type_t *pt_buffer = ctx->p_sys->pt_buffer;
+    const uint8_t *p_in = ctx->p_in->p_pixels;
+
+    const int i_visible_pitch = ctx->p_in->i_visible_pitch;
+    const int i_in_pitch = ctx->p_in->i_pitch;
+    const int x_factor = ctx->x_factor;
+    int i_begin, i_end;
+
+    vlc_slice_Lines( i_slice, i_count, ctx->p_in->i_visible_lines,
+                     &i_begin, &i_end );
+
+    for( int i_line = i_begin; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+            const int c = i_line*i_in_pitch+i_col;
+            for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
+                 x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
+                 x++ )
+            {
+                t_value += pt_distribution[x+i_dim] *
+                           p_in[c+(x>>x_factor)];
+            }
+            pt_buffer[c] = t_value;
+        }
+    }
+}
+
+/* Vertical pass, from the buffer to the output plane */
+static void VerticalSlice( void *opaque, unsigned i_slice, unsigned i_count )
+{
+    const gaussianblur_slice_t *ctx = opaque;
+    const int i_dim = ctx->p_sys->i_dim;
+    const type_t *pt_distribution = ctx->p_sys->pt_distribution;
+    const type_t *pt_buffer = ctx->p_sys->pt_buffer;
+    const type_t *pt_scale = ctx->p_sys->pt_scale;
+    uint8_t *p_out = ctx->p_out->p_pixels;
+
+    const int i_visible_lines = ctx->p_in->i_visible_lines;
+    const int i_visible_pitch = ctx->p_in->i_visible_pitch;
+    const int i_in_pitch = ctx->p_in->i_pitch;
+    const int x_factor = ctx->x_factor;
+    const int y_factor = ctx->y_factor;
+    int i_begin, i_end;
+
+    vlc_slice_Lines( i_slice, i_count, i_visible_lines, &i_begin, &i_end );
+
+    for( int i_line = i_begin; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+            const int c = i_line*i_in_pitch+i_col;
+            for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
+                 y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
+                 y++ )
+            {
+                t_value += pt_distribution[y+i_dim] *
+                           pt_buffer[c+(y>>y_factor)*i_in_pitch];
+            }
+
+            const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
+            p_out[i_line * ctx->p_out->i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
+        }
+    }
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
     const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
     type_t *pt_scale;
     const type_t *pt_distribution = p_sys->pt_distribution;
 
@@ -210,7 +305,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                                p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
     }
 
-    pt_buffer = p_sys->pt_buffer;
     if( !p_sys->pt_scale )
     {
         const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
@@ -243,54 +337,21 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         }
     }
 
-    pt_scale = p_sys->pt_scale;
     for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
-
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
-
         const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
         const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
-
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
-
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
+        gaussianblur_slice_t ctx = {
+            .p_sys = p_sys,
+            .p_in = &p_pic->p[i_plane],
+            .p_out = &p_outpic->p[i_plane],
+            .x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1,
+            .y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1,
+        };
+
+        /* The vertical pass reads lines of the neighbouring slices */
+        vlc_slices_Run( p_sys->slices, HorizontalSlice, &ctx );
+        vlc_slices_Run( p_sys->slices, VerticalSlice, &ctx );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
@@ -32,6 +32,7 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
 #include "filter_picture.h"
 
 
@@ -92,11 +93,20 @@ typedef struct
     int w[3], h[3];
 
     struct vf_priv_s cfg;
+    vlc_slices_t *slices;
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
 } filter_sys_t;
 
+/* Pictures being denoised, shared by all the slices */
+typedef struct
+{
+    filter_sys_t *sys;
+    picture_t *src;
+    picture_t *dst;
+} hqdn3d_slice_t;
+
 /*****************************************************************************
  * Open
  *****************************************************************************/
@@ -109,7 +119,6 @@ static int Open(vlc_object_t *this)
     const video_format_t *fmt_out = &filter->fmt_out.video;
     const vlc_fourcc_t fourcc_in  = fmt_in->i_chroma;
     const vlc_fourcc_t fourcc_out = fmt_out->i_chroma;
-    int wmax = 0;
 
     const vlc_chroma_description_t *chroma =
             vlc_fourcc_GetChromaDescription(fourcc_in);
@@ -132,15 +141,31 @@ static int Open(vlc_object_t *this)
 
     sys->chroma = chroma;
 
+    sys->slices = vlc_slices_New(filter);
+    if (!sys->slices) {
+        free(sys);
+        return VLC_ENOMEM;
+    }
+    const unsigned count = vlc_slices_Count(sys->slices);
+
     for (int i = 0; i < 3; ++i) {
         sys->w[i] = fmt_in->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-    }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
-    if (!cfg->Line) {
-        free(sys);
-        return VLC_ENOMEM;
+
+        /* The spatial filter saves the horizontal recursion state at the
+         * start of each slice of columns, then each slice runs the vertical
+         * recursion over its own columns of a line */
+        cfg->LineAnt[i] = vlc_alloc(sys->h[i] * count, sizeof(unsigned int));
+        cfg->Line[i] = vlc_alloc(sys->w[i], sizeof(unsigned int));
+        if (!cfg->LineAnt[i] || !cfg->Line[i]) {
+            for (int j = 0; j <= i; ++j) {
+                free(cfg->LineAnt[j]);
+                free(cfg->Line[j]);
+            }
+            vlc_slices_Delete(sys->slices);
+            free(sys);
+            return VLC_ENOMEM;
+        }
     }
 
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
@@ -183,14 +208,72 @@ static void Close(vlc_object_t *this)
 
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
+        free(cfg->LineAnt[i]);
+        free(cfg->Line[i]);
     }
-    free(cfg->Line);
+    vlc_slices_Delete(sys->slices);
     free(sys);
 }
 
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+/* Horizontal spatial state (or temporal only pass) on slices of lines */
+static void FilterLines(void *opaque, unsigned slice, unsigned count)
+{
+    const hqdn3d_slice_t *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (int i = 0; i < 3; ++i) {
+        const plane_t *src = &ctx->src->p[i];
+        plane_t *dst = &ctx->dst->p[i];
+        int *spat = cfg->Coefs[i ? 2 : 0];
+        int *temp = cfg->Coefs[i ? 3 : 1];
+        int begin, end;
+
+        vlc_slice_Lines(slice, count, sys->h[i], &begin, &end);
+        if (begin == end)
+            continue;
+
+        if (!spat[0])
+            deNoiseTemporal(src->p_pixels + begin * src->i_pitch,
+                            dst->p_pixels + begin * dst->i_pitch,
+                            cfg->Frame[i] + begin * sys->w[i],
+                            sys->w[i], end - begin,
+                            src->i_pitch, dst->i_pitch, temp);
+        else
+            deNoiseHorizontal(src->p_pixels, cfg->LineAnt[i], sys->w[i],
+                              begin, end, src->i_pitch, count, spat, temp);
+    }
+}
+
+/* Spatial and temporal passes on slices of columns, so that the vertical
+ * recursion runs over whole columns */
+static void FilterColumns(void *opaque, unsigned slice, unsigned count)
+{
+    const hqdn3d_slice_t *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (int i = 0; i < 3; ++i) {
+        const plane_t *src = &ctx->src->p[i];
+        plane_t *dst = &ctx->dst->p[i];
+        int *spat = cfg->Coefs[i ? 2 : 0];
+        int *temp = cfg->Coefs[i ? 3 : 1];
+        int begin, end;
+
+        vlc_slice_Lines(slice, count, sys->w[i], &begin, &end);
+        if (begin == end || !spat[0])
+            continue;
+
+        deNoiseSpatial(src->p_pixels, dst->p_pixels, cfg->LineAnt[i],
+                       cfg->Line[i] + begin, cfg->Frame[i],
+                       sys->w[i], sys->h[i], begin, end, slice, count,
+                       src->i_pitch, dst->i_pitch, spat, spat, temp);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -220,32 +303,31 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-
-    if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
-    {
-        picture_Release( src );
-        picture_Release( dst );
-        return NULL;
+    for (int i = 0; i < 3; ++i) {
+        if (cfg->Frame[i])
+            continue;
+
+        /* The previous frame of the first one is itself */
+        const int w = sys->w[i], h = sys->h[i];
+        unsigned short *ant = vlc_alloc(w * h, sizeof(unsigned short));
+        if (unlikely(!ant)) {
+            picture_Release( src );
+            picture_Release( dst );
+            return NULL;
+        }
+        for (int y = 0; y < h; y++) {
+            const uint8_t *line = src->p[i].p_pixels + y * src->p[i].i_pitch;
+            for (int x = 0; x < w; x++)
+                ant[y * w + x] = line[x] << 8;
+        }
+        cfg->Frame[i] = ant;
     }
 
+    hqdn3d_slice_t ctx = { .sys = sys, .src = src, .dst = dst };
+
+    vlc_slices_Run(sys->slices, FilterLines, &ctx);
+    vlc_slices_Run(sys->slices, FilterColumns, &ctx);
+
     return CopyInfoAndRelease(dst, src);
 }
 
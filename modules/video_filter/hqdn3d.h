@@ -32,7 +32,8 @@
 
 struct vf_priv_s {
         int Coefs[4][512*16];
-        unsigned int *Line;
+        unsigned int *Line[3];
+        unsigned int *LineAnt[3];
         unsigned short *Frame[3];
 };
 
@@ -67,110 +68,87 @@ static void deNoiseTemporal(
     }
 }
 
-static void deNoiseSpacial(
+/* Horizontal pass of the spatial filter on lines [Y0, Y1), only keeping its
+ * state where each of the Count slices of columns starts: LineAnt[Y*Count+k]
+ * is the recursion value before the first column of the slice k. */
+static void deNoiseHorizontal(
                     unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,       // vf->priv->Line (width bytes)
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical)
+                    unsigned int *LineAnt,       // H*Count
+                    int W, int Y0, int Y1, int sStride, unsigned Count,
+                    int *Horizontal, int *Temporal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
     unsigned int PixelAnt;
-    unsigned int PixelDst;
 
-    /* First pixel has no left nor top neighbor. */
-    PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+    Frame += Y0 * (long)sStride;
+    LineAnt += Y0 * (long)Count;
 
-    /* First line has no top neighbor, only left. */
-    for (long X = 1; X < W; X++){
-        PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (long Y = 1; Y < H; Y++){
-        sLineOffs += sStride, dLineOffs += dStride;
+    for (long Y = Y0; Y < Y1; Y++){
         /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            PixelDst = LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+        PixelAnt = Frame[0]<<16;
+
+        long X = 1;
+        for (unsigned k = 0; k < Count; k++){
+            int X0, X1;
+
+            vlc_slice_Lines(k, Count, W, &X0, &X1);
+            /* Without temporal filtering, the first line is filtered
+             * against its first pixel only, as it always was */
+            if (Y != 0 || Temporal[0])
+                for (; X < X0; X++)
+                    PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
+            LineAnt[k] = PixelAnt;
         }
+        Frame += sStride;
+        LineAnt += Count;
     }
 }
 
-static void deNoise(unsigned char *Frame,        // mpi->planes[x]
+/* Spatial and temporal passes on the columns [X0, X1) of the slice Slice,
+ * from the top line to the bottom one. The horizontal recursion resumes
+ * from the state saved by deNoiseHorizontal(), and LineV holds the previous
+ * line of the vertical recursion, for the columns of the slice only. */
+static void deNoiseSpatial(
+                    unsigned char *Frame,        // mpi->planes[x]
                     unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
-                    unsigned short **FrameAntPtr,
-                    int W, int H, int sStride, int dStride,
+                    const unsigned int *LineAnt, // from deNoiseHorizontal()
+                    unsigned int *LineV,         // X1-X0
+                    unsigned short *FrameAnt,    // vf->priv->Frame[x]
+                    int W, int H, int X0, int X1, unsigned Slice, unsigned Count,
+                    int sStride, int dStride,
                     int *Horizontal, int *Vertical, int *Temporal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
-    unsigned short* FrameAnt=(*FrameAntPtr);
-
-    if(!FrameAnt){
-        (*FrameAntPtr)=FrameAnt=malloc(W*H*sizeof(unsigned short));
-        if(!FrameAnt)
-            return;
-        for (long Y = 0; Y < H; Y++){
-            unsigned short* dst=&FrameAnt[Y*W];
-            unsigned char* src=Frame+Y*sStride;
-            for (long X = 0; X < W; X++) dst[X]=src[X]<<8;
-        }
-    }
+    unsigned int PixelAnt, PixelDst;
 
-    if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
-        return;
-    }
-    if(!Temporal[0]){
-        deNoiseSpacial(Frame, FrameDest, LineAnt,
-                       W, H, sStride, dStride, Horizontal, Vertical);
-        return;
-    }
-
-    /* First pixel has no left nor top neighbor. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)>>8);
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor. Only left one for each pixel and
-     * last frame */
-    for (long X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-        FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (long Y = 1; Y < H; Y++){
-        unsigned short* LinePrev=&FrameAnt[Y*W];
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-        LinePrev[0] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+    for (long Y = 0; Y < H; Y++){
+        PixelAnt = LineAnt[Y * Count + Slice];
+
+        for (long X = X0; X < X1; X++){
+            unsigned int Pixel;
+
+            /* First pixel on each line doesn't have previous pixel */
+            if (X == 0)
+                Pixel = PixelAnt = Frame[0]<<16;
+            else {
+                Pixel = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
+                if (Y != 0 || Temporal[0])
+                    PixelAnt = Pixel;
+            }
+
+            /* First line has no top neighbor */
+            if (Y > 0)
+                Pixel = LowPassMul(LineV[X - X0], Pixel, Vertical);
+            LineV[X - X0] = Pixel;
+
+            if (Temporal[0]){
+                PixelDst = LowPassMul(FrameAnt[X]<<8, Pixel, Temporal);
+                FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
+            } else
+                PixelDst = Pixel;
+            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
         }
+        Frame += sStride;
+        FrameDest += dStride;
+        FrameAnt += W;
     }
 }
 
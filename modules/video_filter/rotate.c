@@ -36,6 +36,7 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
 #include "filter_picture.h"
 #include "../control/motionlib.h"
 
@@ -89,8 +90,21 @@ typedef struct
 {
     atomic_uint_fast32_t sincos;
     motion_sensors_t *p_motion;
+    vlc_slices_t *slices;
 } filter_sys_t;
 
+/* Parameters of a picture, shared by all its slices */
+typedef struct
+{
+    const picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_sin;
+    int i_cos;
+    int i_y_offset;
+    int i_u_offset;
+    int i_v_offset;
+} rotate_slice_t;
+
 typedef union {
     uint32_t u;
     struct {
@@ -154,6 +168,13 @@ static int Create( vlc_object_t *p_this )
         return VLC_ENOMEM;
     p_sys = p_filter->p_sys;
 
+    p_sys->slices = vlc_slices_New( p_filter );
+    if( p_sys->slices == NULL )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
                        p_filter->p_cfg );
 
@@ -162,6 +183,7 @@ static int Create( vlc_object_t *p_this )
         p_sys->p_motion = motion_create( VLC_OBJECT( p_filter ) );
         if( p_sys->p_motion == NULL )
         {
+            vlc_slices_Delete( p_sys->slices );
             free( p_sys );
             return VLC_EGENERIC;
         }
@@ -194,38 +216,21 @@ static void Destroy( vlc_object_t *p_this )
         var_DelCallback( p_filter, FILTER_PREFIX "angle",
                          RotateCallback, p_sys );
     }
+    vlc_slices_Delete( p_sys->slices );
     free( p_sys );
 }
 
-/*****************************************************************************
- *
- *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *opaque, unsigned i_slice, unsigned i_count )
 {
-    picture_t *p_outpic;
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    if( p_sys->p_motion != NULL )
-    {
-        int i_angle = motion_get_angle( p_sys->p_motion );
-        store_trigo( p_sys, i_angle / 20.f );
-    }
-
-    int i_sin, i_cos;
-    fetch_trigo( p_sys, &i_sin, &i_cos );
+    const rotate_slice_t *ctx = opaque;
+    const picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int i_sin = ctx->i_sin;
+    const int i_cos = ctx->i_cos;
 
     for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
-        plane_t *p_srcp = &p_pic->p[i_plane];
+        const plane_t *p_srcp = &p_pic->p[i_plane];
         plane_t *p_dstp = &p_outpic->p[i_plane];
 
         const int i_visible_lines = p_srcp->i_visible_lines;
@@ -241,11 +246,18 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
         const int i_line_next =  i_cos / i_aspect -i_sin*i_visible_pitch;
         const int i_col_next  = -i_sin / i_aspect -i_cos*i_visible_pitch;
+        int i_begin, i_end;
+
+        vlc_slice_Lines( i_slice, i_count, i_visible_lines, &i_begin, &i_end );
+
+        /* Each line moves the origin by (i_cos, -i_sin) / i_aspect */
         int i_line_orig0 = ( - i_cos * i_line_center / i_aspect
-                             - i_sin * i_col_center + (1<<11) );
+                             - i_sin * i_col_center + (1<<11) )
+                           + i_begin * ( i_cos / i_aspect );
         int i_col_orig0 =    i_sin * i_line_center / i_aspect
-                           - i_cos * i_col_center + (1<<11);
-        for( int y = 0; y < i_visible_lines; y++)
+                           - i_cos * i_col_center + (1<<11)
+                           + i_begin * ( -i_sin / i_aspect );
+        for( int y = i_begin; y < i_end; y++)
         {
             uint8_t *p_out = &p_dstp->p_pixels[y * p_dstp->i_pitch];
 
@@ -321,64 +333,76 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             i_col_orig0 += i_col_next;
         }
     }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
 /*****************************************************************************
  *
  *****************************************************************************/
-static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_pic ) return NULL;
 
-    int i_u_offset, i_v_offset, i_y_offset;
-
-    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
-                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
     {
-        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                  (char*)&(p_pic->format.i_chroma) );
         picture_Release( p_pic );
         return NULL;
     }
 
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
+    if( p_sys->p_motion != NULL )
     {
-        picture_Release( p_pic );
-        return NULL;
+        int i_angle = motion_get_angle( p_sys->p_motion );
+        store_trigo( p_sys, i_angle / 20.f );
     }
 
+    int i_sin, i_cos;
+    fetch_trigo( p_sys, &i_sin, &i_cos );
+
+    rotate_slice_t ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .i_sin = i_sin,
+        .i_cos = i_cos,
+    };
+
+    vlc_slices_Run( p_sys->slices, FilterSlice, &ctx );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+static void FilterPackedSlice( void *opaque, unsigned i_slice,
+                               unsigned i_count )
+{
+    const rotate_slice_t *ctx = opaque;
+    const picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int i_sin = ctx->i_sin;
+    const int i_cos = ctx->i_cos;
+
     const int i_visible_pitch = p_pic->p->i_visible_pitch>>1; /* In fact it's i_visible_pixels */
     const int i_visible_lines = p_pic->p->i_visible_lines;
 
-    const uint8_t *p_in   = p_pic->p->p_pixels+i_y_offset;
-    const uint8_t *p_in_u = p_pic->p->p_pixels+i_u_offset;
-    const uint8_t *p_in_v = p_pic->p->p_pixels+i_v_offset;
+    const uint8_t *p_in   = p_pic->p->p_pixels+ctx->i_y_offset;
+    const uint8_t *p_in_u = p_pic->p->p_pixels+ctx->i_u_offset;
+    const uint8_t *p_in_v = p_pic->p->p_pixels+ctx->i_v_offset;
     const int i_in_pitch  = p_pic->p->i_pitch;
 
-    uint8_t *p_out   = p_outpic->p->p_pixels+i_y_offset;
-    uint8_t *p_out_u = p_outpic->p->p_pixels+i_u_offset;
-    uint8_t *p_out_v = p_outpic->p->p_pixels+i_v_offset;
+    uint8_t *p_out   = p_outpic->p->p_pixels+ctx->i_y_offset;
+    uint8_t *p_out_u = p_outpic->p->p_pixels+ctx->i_u_offset;
+    uint8_t *p_out_v = p_outpic->p->p_pixels+ctx->i_v_offset;
     const int i_out_pitch = p_outpic->p->i_pitch;
 
     const int i_line_center = i_visible_lines>>1;
     const int i_col_center  = i_visible_pitch>>1;
 
-    if( p_sys->p_motion != NULL )
-    {
-        int i_angle = motion_get_angle( p_sys->p_motion );
-        store_trigo( p_sys, i_angle / 20.f );
-    }
+    int i_begin, i_end;
 
-    int i_sin, i_cos;
-    fetch_trigo( p_sys, &i_sin, &i_cos );
+    vlc_slice_Lines( i_slice, i_count, i_visible_lines, &i_begin, &i_end );
 
-    for( int i_line = 0; i_line < i_visible_lines; i_line++ )
+    for( int i_line = i_begin; i_line < i_end; i_line++ )
     {
         for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
         {
@@ -428,6 +452,56 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
+}
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_pic ) return NULL;
+
+    int i_u_offset, i_v_offset, i_y_offset;
+
+    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
+                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    {
+        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    if( p_sys->p_motion != NULL )
+    {
+        int i_angle = motion_get_angle( p_sys->p_motion );
+        store_trigo( p_sys, i_angle / 20.f );
+    }
+
+    int i_sin, i_cos;
+    fetch_trigo( p_sys, &i_sin, &i_cos );
+
+    rotate_slice_t ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .i_sin = i_sin,
+        .i_cos = i_cos,
+        .i_y_offset = i_y_offset,
+        .i_u_offset = i_u_offset,
+        .i_v_offset = i_v_offset,
+    };
+
+    vlc_slices_Run( p_sys->slices, FilterPackedSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -42,6 +42,7 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
 #include "filter_picture.h"
 
 #define SIG_TEXT N_("Sharpen strength (0-2)")
@@ -91,8 +92,17 @@ static const char *const ppsz_filter_options[] = {
 typedef struct
 {
     atomic_int sigma;
+    vlc_slices_t *slices;
 } filter_sys_t;
 
+/* Parameters of a picture, shared by all its slices */
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int sigma;
+} sharpen_slice_t;
+
 /*****************************************************************************
  * Create: allocates Sharpen video thread output method
  *****************************************************************************
@@ -118,6 +128,13 @@ static int Create( vlc_object_t *p_this )
         return VLC_ENOMEM;
     p_filter->p_sys = p_sys;
 
+    p_sys->slices = vlc_slices_New( p_filter );
+    if( p_sys->slices == NULL )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     p_filter->pf_video_filter = Filter;
 
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
@@ -145,6 +162,7 @@ static void Destroy( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     var_DelCallback( p_filter, FILTER_PREFIX "sigma", SharpenCallback, p_sys );
+    vlc_slices_Delete( p_sys->slices );
     free( p_sys );
 }
 
@@ -159,7 +177,7 @@ static void Destroy( vlc_object_t *p_this )
 #define IS_YUV_420_10BITS(fmt) (fmt == VLC_CODEC_I420_10L ||    \
                                 fmt == VLC_CODEC_I420_10B)
 
-#define SHARPEN_FRAME(maxval, data_t)                                   \
+#define SHARPEN_LINES(maxval, data_t)                                   \
     do                                                                  \
     {                                                                   \
         assert((maxval) >= 0);                                          \
@@ -168,12 +186,16 @@ static void Destroy( vlc_object_t *p_this )
         const unsigned data_sz = sizeof(data_t);                        \
         const int i_src_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
         const int i_out_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_sys->sigma);         \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
-                                                                        \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = i_begin; i < i_end; i++ )                     \
         {                                                               \
+            if( i == 0 || i == i_visible_lines - 1 )                    \
+            {                                                           \
+                memcpy(&p_out[i * i_out_line_len],                      \
+                       &p_src[i * i_src_line_len], i_visible_pitch);    \
+                continue;                                               \
+            }                                                           \
+                                                                        \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
             for( unsigned j = data_sz; j < i_visible_pitch - 1; j++ )   \
@@ -199,18 +221,40 @@ static void Destroy( vlc_object_t *p_this )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *opaque, unsigned i_slice, unsigned i_count )
 {
-    picture_t *p_outpic;
+    const sharpen_slice_t *ctx = opaque;
+    picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
+    const int sigma = ctx->sigma;
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
+    int i_first, i_last;
+
+    vlc_slice_Lines( i_slice, i_count, i_visible_lines, &i_first, &i_last );
+
+    const unsigned i_begin = i_first, i_end = i_last;
+
+    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
+        SHARPEN_LINES(255, uint8_t);
+    else
+        SHARPEN_LINES(1023, uint16_t);
+
+    picture_t pic, outpic;
+
+    vlc_slice_Picture( &pic, p_pic, i_slice, i_count );
+    vlc_slice_Picture( &outpic, p_outpic, i_slice, i_count );
+    plane_CopyPixels( &outpic.p[U_PLANE], &pic.p[U_PLANE] );
+    plane_CopyPixels( &outpic.p[V_PLANE], &pic.p[V_PLANE] );
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
 
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
@@ -220,14 +264,13 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
 
     filter_sys_t *p_sys = p_filter->p_sys;
+    sharpen_slice_t ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .sigma = atomic_load(&p_sys->sigma),
+    };
 
-    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
-    else
-        SHARPEN_FRAME(1023, uint16_t);
-
-    plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
-    plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
+    vlc_slices_Run( p_sys->slices, FilterSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
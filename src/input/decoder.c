@@ -179,6 +179,9 @@ struct decoder_owner
  * a bogus PTS and won't be displayed */
 #define DECODER_BOGUS_VIDEO_DELAY                ((vlc_tick_t)(DEFAULT_PTS_DELAY * 30))
 
+/* 400 MiB, i.e. ~ 50mb/s for 60s */
+#define DECODER_FIFO_MAX_SIZE (400*1024*1024)
+
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION   VLC_TICK_FROM_MS(200)
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
@@ -1002,7 +1005,9 @@ static void DecoderPlayCc( struct decoder_owner *p_owner, block_t *p_cc,
 
         if( i_bitmap > 1 )
         {
-            block_FifoPut( p_ccowner->p_fifo, block_Duplicate(p_cc) );
+            block_t *p_dup = block_Share( p_cc );
+            if( p_dup )
+                block_FifoPut( p_ccowner->p_fifo, p_dup );
         }
         else
         {
@@ -1716,7 +1721,8 @@ static void *DecoderThread( void *p_data )
         {   /* Wait for resumption from pause */
             p_owner->b_idle = true;
             vlc_cond_signal( &p_owner->wait_acknowledge );
-            vlc_fifo_Wait( p_owner->p_fifo );
+            /* The queued blocks need not wake up the paused thread */
+            vlc_fifo_WaitSignal( p_owner->p_fifo );
             p_owner->b_idle = false;
             continue;
         }
@@ -1873,8 +1879,8 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
 
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
-    /* decoder fifo */
-    p_owner->p_fifo = block_FifoNew();
+    /* decoder fifo: the input thread queues without locking it */
+    p_owner->p_fifo = block_FifoNewLockless();
     if( unlikely(p_owner->p_fifo == NULL) )
     {
         vlc_object_delete(p_dec);
@@ -2232,21 +2238,22 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
-    vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
         /* FIXME: ideally we would check the time amount of data
          * in the FIFO instead of its size. */
-        /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        if( vlc_fifo_GetBytesLockless( p_owner->p_fifo ) > DECODER_FIFO_MAX_SIZE )
         {
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
-            block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            block_FifoEmpty( p_owner->p_fifo );
             p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
+        vlc_fifo_QueueLockless( p_owner->p_fifo, p_block );
+        return;
     }
-    else
+
+    vlc_fifo_Lock( p_owner->p_fifo );
     if( !p_owner->b_waiting )
     {   /* The FIFO is not consumed when waiting, so pacing would deadlock VLC.
          * Locking is not necessary as b_waiting is only read, not written by
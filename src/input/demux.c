@@ -35,6 +35,7 @@
 #include <vlc_modules.h>
 #include <vlc_strings.h>
 #include "input_internal.h"
+#include "../modules/modules.h"
 
 typedef const struct
 {
@@ -61,6 +62,7 @@ static const char *demux_NameFromMimeType(const char *mime)
     {   /* Must be sorted in ascending ASCII order */
         { "audio/aac",           "m4a"     },
         { "audio/aacp",          "m4a"     },
+        { "audio/flac",          "flac"    }, /* not always fLaC at 0 */
         { "audio/mpeg",          "mp3"     },
         //{ "video/MP1S",          "es,mpgv" }, !b_force
         { "video/dv",            "rawdv"   },
@@ -245,8 +247,28 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_input,
     if( psz_module == NULL )
         psz_module = p_demux->psz_name;
 
-    priv->module = vlc_module_load(p_demux, "demux", psz_module,
-        !strcmp(psz_module, p_demux->psz_name), demux_Probe, p_demux);
+    bool strict = !strcmp(psz_module, p_demux->psz_name);
+    const uint8_t *p_peek;
+    ssize_t i_peek = -1;
+
+    /* Peek once so that modules with signatures that cannot match are not
+     * even probed. The buffer is copied as probes invalidate the peek. */
+    if( vlc_stream_Tell( s ) == 0 )
+        i_peek = vlc_stream_Peek( s, &p_peek, MODULE_SIGNATURE_SPAN );
+
+    if( i_peek >= 0 )
+    {
+        uint8_t peek[MODULE_SIGNATURE_SPAN];
+
+        if( i_peek > 0 )
+            memcpy( peek, p_peek, i_peek );
+        priv->module = vlc_module_load_peek(vlc_object_logger(p_demux),
+                                            "demux", psz_module, strict,
+                                            peek, i_peek, demux_Probe, p_demux);
+    }
+    else
+        priv->module = vlc_module_load(p_demux, "demux", psz_module, strict,
+                                       demux_Probe, p_demux);
 
     if (priv->module == NULL)
     {
@@ -0,0 +1,417 @@
+/*****************************************************************************
+ * demux_index.c: persistent seek index cache
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_block.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+
+#include "config/configuration.h"
+#include "../libvlc.h"
+
+/*
+ * Each index is a file of the "index" cache subdirectory, named after the
+ * MD5 of the media file path and of the index name. The header ties it to
+ * the size, the modification date and the MD5 of the first and last bytes
+ * of the media file, and checks the integrity of the index data.
+ */
+#define INDEX_MAGIC   "VLCindex"
+#define INDEX_VERSION 2
+#define INDEX_HEADER  (8 + 4 + 8 + 8 + 4 + 16 + 8 + 16)
+
+/* Bytes of the media file hashed at each end */
+#define INDEX_PROBE_SIZE 65536
+
+/* The least recently stored indexes are removed beyond these limits */
+#define INDEX_CACHE_MAX_AGE  (30 * 24 * 3600) /* seconds */
+#define INDEX_CACHE_MAX_SIZE (64 << 20)
+
+struct index_key
+{
+    uint64_t size;
+    int64_t mtime;
+    uint32_t mtime_ns;
+    uint8_t digest[16];
+};
+
+static void IndexKeyWrite(uint8_t *hdr, const struct index_key *key)
+{
+    SetQWLE(&hdr[12], key->size);
+    SetQWLE(&hdr[20], key->mtime);
+    SetDWLE(&hdr[28], key->mtime_ns);
+    memcpy(&hdr[32], key->digest, 16);
+}
+
+static bool IndexKeyMatches(const uint8_t *hdr, const struct index_key *key)
+{
+    uint8_t ref[INDEX_HEADER];
+
+    IndexKeyWrite(ref, key);
+    return !memcmp(&hdr[12], &ref[12], 8 + 8 + 4 + 16);
+}
+
+/* Identifies the content of the media file: the date of a file rewritten
+ * within the same second, or restored with its old date, is not enough */
+static int IndexCacheKey(const char *filepath, struct index_key *key)
+{
+    FILE *file = vlc_fopen(filepath, "rb");
+    if (file == NULL)
+        return -1;
+
+    struct stat st;
+    uint8_t *buf = NULL;
+
+    if (fstat(fileno(file), &st) || !S_ISREG(st.st_mode))
+        goto error;
+
+    key->size = st.st_size;
+    key->mtime = st.st_mtime;
+#if defined (HAVE_STRUCT_STAT_ST_MTIM)
+    key->mtime_ns = st.st_mtim.tv_nsec;
+#elif defined (HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    key->mtime_ns = st.st_mtimespec.tv_nsec;
+#else
+    key->mtime_ns = 0;
+#endif
+
+    buf = malloc(INDEX_PROBE_SIZE);
+    if (unlikely(buf == NULL))
+        goto error;
+
+    struct md5_s md5;
+    InitMD5(&md5);
+    AddMD5(&md5, buf, fread(buf, 1, INDEX_PROBE_SIZE, file));
+    if (key->size > INDEX_PROBE_SIZE)
+    {
+        size_t tail = __MIN(key->size - INDEX_PROBE_SIZE, INDEX_PROBE_SIZE);
+
+        if (fseek(file, -(long)tail, SEEK_END))
+            goto error;
+        AddMD5(&md5, buf, fread(buf, 1, tail, file));
+    }
+    EndMD5(&md5);
+    memcpy(key->digest, md5.buf, 16);
+
+    free(buf);
+    fclose(file);
+    return 0;
+error:
+    free(buf);
+    fclose(file);
+    return -1;
+}
+
+static char *IndexCacheDir(void)
+{
+    char *cachedir = config_GetUserDir(VLC_CACHE_DIR);
+    char *dir;
+
+    if (cachedir == NULL
+     || asprintf(&dir, "%s" DIR_SEP "index", cachedir) == -1)
+        dir = NULL;
+    free(cachedir);
+    return dir;
+}
+
+static char *IndexCachePath(demux_t *demux, const char *name,
+                            struct index_key *key, bool create)
+{
+    if (demux->psz_filepath == NULL
+     || !var_InheritBool(demux, "demux-index-cache"))
+        return NULL;
+
+    if (IndexCacheKey(demux->psz_filepath, key))
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5(&md5);
+    AddMD5(&md5, demux->psz_filepath, strlen(demux->psz_filepath) + 1);
+    AddMD5(&md5, name, strlen(name));
+    EndMD5(&md5);
+
+    char *hash = psz_md5_hash(&md5);
+    char *dir = IndexCacheDir();
+    char *path = NULL;
+
+    if (hash != NULL && dir != NULL)
+    {
+        if (create)
+            config_CreateDir(VLC_OBJECT(demux), dir);
+        if (asprintf(&path, "%s" DIR_SEP "%s", dir, hash) == -1)
+            path = NULL;
+    }
+
+    free(dir);
+    free(hash);
+    return path;
+}
+
+struct index_entry
+{
+    char *path;
+    time_t mtime;
+    uint64_t size;
+};
+
+static int IndexEntryCmp(const void *a, const void *b)
+{
+    const struct index_entry *ea = a, *eb = b;
+
+    return (ea->mtime > eb->mtime) - (ea->mtime < eb->mtime);
+}
+
+/* Removes the indexes older than the maximum age, then the oldest ones
+ * until the cache fits in its maximum size */
+static void IndexCachePrune(void)
+{
+    char *dirpath = IndexCacheDir();
+    if (dirpath == NULL)
+        return;
+
+    DIR *dir = vlc_opendir(dirpath);
+    if (dir == NULL)
+    {
+        free(dirpath);
+        return;
+    }
+
+    struct index_entry *entries = NULL;
+    size_t count = 0;
+    uint64_t total = 0;
+    time_t now = time(NULL);
+    const char *name;
+
+    while ((name = vlc_readdir(dir)) != NULL)
+    {
+        struct stat st;
+        char *path;
+
+        if (name[0] == '.'
+         || asprintf(&path, "%s" DIR_SEP "%s", dirpath, name) == -1)
+            continue;
+
+        if (vlc_stat(path, &st) || !S_ISREG(st.st_mode))
+        {
+            free(path);
+            continue;
+        }
+
+        if (now - st.st_mtime > INDEX_CACHE_MAX_AGE)
+        {
+            vlc_unlink(path);
+            free(path);
+            continue;
+        }
+
+        struct index_entry *tab = realloc(entries,
+                                          (count + 1) * sizeof (*entries));
+        if (unlikely(tab == NULL))
+        {
+            free(path);
+            break;
+        }
+        entries = tab;
+        entries[count].path = path;
+        entries[count].mtime = st.st_mtime;
+        entries[count].size = st.st_size;
+        count++;
+        total += st.st_size;
+    }
+    closedir(dir);
+    free(dirpath);
+
+    qsort(entries, count, sizeof (*entries), IndexEntryCmp);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (total > INDEX_CACHE_MAX_SIZE)
+        {
+            vlc_unlink(entries[i].path);
+            total -= entries[i].size;
+        }
+        free(entries[i].path);
+    }
+    free(entries);
+}
+
+/* Pruning scans the whole cache directory: it runs on a background thread,
+ * which scans again as long as indexes were stored meanwhile */
+static atomic_uint prune_requests = ATOMIC_VAR_INIT(0);
+
+static void *IndexCachePruneThread(void *data)
+{
+    unsigned requests = atomic_load(&prune_requests);
+
+    (void) data;
+    do
+        IndexCachePrune();
+    while (!atomic_compare_exchange_strong(&prune_requests, &requests, 0));
+    return NULL;
+}
+
+static void IndexCachePruneAsync(void)
+{
+    if (atomic_fetch_add(&prune_requests, 1) == 0
+     && vlc_clone_detach(NULL, IndexCachePruneThread, NULL,
+                         VLC_THREAD_PRIORITY_LOW))
+        atomic_store(&prune_requests, 0);
+}
+
+static void IndexCacheDigest(const void *data, size_t size, uint8_t *digest)
+{
+    struct md5_s md5;
+
+    InitMD5(&md5);
+    AddMD5(&md5, data, size);
+    EndMD5(&md5);
+    memcpy(digest, md5.buf, 16);
+}
+
+block_t *demux_IndexCacheLoad(demux_t *demux, const char *name)
+{
+    struct index_key key;
+    char *path = IndexCachePath(demux, name, &key, false);
+    if (path == NULL)
+        return NULL;
+
+    block_t *block = block_FilePath(path, false);
+    free(path);
+    if (block == NULL)
+        return NULL;
+
+    const uint8_t *hdr = block->p_buffer;
+    uint8_t digest[16];
+
+    if (block->i_buffer < INDEX_HEADER
+     || memcmp(hdr, INDEX_MAGIC, 8) || GetDWLE(&hdr[8]) != INDEX_VERSION
+     || !IndexKeyMatches(hdr, &key)
+     || GetQWLE(&hdr[48]) != block->i_buffer - INDEX_HEADER)
+    {
+        msg_Dbg(demux, "%s index cache is stale", name);
+        block_Release(block);
+        return NULL;
+    }
+
+    IndexCacheDigest(&hdr[INDEX_HEADER], block->i_buffer - INDEX_HEADER,
+                     digest);
+    if (memcmp(&hdr[56], digest, 16))
+    {
+        msg_Warn(demux, "%s index cache is corrupted", name);
+        block_Release(block);
+        return NULL;
+    }
+
+    block->p_buffer += INDEX_HEADER;
+    block->i_buffer -= INDEX_HEADER;
+    msg_Dbg(demux, "%s index loaded from cache (%zu bytes)", name,
+            block->i_buffer);
+    return block;
+}
+
+int demux_IndexCacheStore(demux_t *demux, const char *name,
+                          const void *data, size_t size)
+{
+    struct index_key key;
+    char *tmpname = NULL;
+    char *path = IndexCachePath(demux, name, &key, true);
+    int ret = VLC_EGENERIC;
+
+    if (path == NULL)
+        goto out;
+
+    /* Several instances can store the same index at the same time */
+    if (asprintf(&tmpname, "%s.XXXXXX", path) == -1)
+    {
+        tmpname = NULL;
+        goto out;
+    }
+
+    int fd = vlc_mkstemp(tmpname);
+    if (fd == -1)
+    {
+        msg_Warn(demux, "cannot create %s: %s", tmpname,
+                 vlc_strerror_c(errno));
+        goto out;
+    }
+
+    FILE *file = fdopen(fd, "wb");
+    if (file == NULL)
+    {
+        vlc_close(fd);
+        vlc_unlink(tmpname);
+        goto out;
+    }
+
+    uint8_t hdr[INDEX_HEADER];
+    memcpy(hdr, INDEX_MAGIC, 8);
+    SetDWLE(&hdr[8], INDEX_VERSION);
+    IndexKeyWrite(hdr, &key);
+    SetQWLE(&hdr[48], size);
+    IndexCacheDigest(data, size, &hdr[56]);
+
+    if (fwrite(hdr, sizeof (hdr), 1, file) != 1
+     || (size > 0 && fwrite(data, size, 1, file) != 1)
+     || fflush(file))
+    {
+        msg_Warn(demux, "cannot write %s: %s", tmpname,
+                 vlc_strerror_c(errno));
+        fclose(file);
+        vlc_unlink(tmpname);
+        goto out;
+    }
+
+#if !defined( _WIN32 ) && !defined( __OS2__ )
+    int val = vlc_rename(tmpname, path); /* atomically replace the old index */
+    fclose(file);
+#else
+    vlc_unlink(path);
+    fclose(file);
+    int val = vlc_rename(tmpname, path);
+#endif
+    if (val)
+    {
+        msg_Warn(demux, "cannot rename %s: %s", tmpname,
+                 vlc_strerror_c(errno));
+        vlc_unlink(tmpname);
+        goto out;
+    }
+
+    msg_Dbg(demux, "%s index stored in cache (%zu bytes)", name, size);
+    IndexCachePruneAsync();
+    ret = VLC_SUCCESS;
+out:
+    free(tmpname);
+    free(path);
+    return ret;
+}
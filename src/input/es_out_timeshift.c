@@ -161,19 +161,34 @@ typedef struct attribute_packed
 } ts_cmd_t;
 
 typedef struct ts_storage_t ts_storage_t;
+
+/* Backend storing the data of C_SEND commands */
+typedef struct
+{
+    /* Takes ownership of the block, sets up the command to retrieve it */
+    int      (*pf_write)( ts_storage_t *, ts_cmd_t *, block_t *, bool b_flush );
+    block_t *(*pf_read) ( ts_storage_t *, ts_cmd_t *, bool b_flush );
+    void     (*pf_close)( ts_storage_t * );
+} ts_storage_ops_t;
+
 struct ts_storage_t
 {
     ts_storage_t *p_next;
+    const ts_storage_ops_t *ops;
 
-    /* */
+    size_t  i_file_max; /* Max size in bytes */
+    int64_t i_file_size;/* Current size in bytes */
+
+    /* File backend */
 #ifdef _WIN32
     char    *psz_file;  /* Filename */
 #endif
-    size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
 
+    /* Memory backend */
+    int64_t *pi_ram_size; /* Memory used by all the memory storages */
+
     /* */
     int      i_cmd_r;
     int      i_cmd_w;
@@ -188,11 +203,17 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    bool           b_tmp_files;
+    int64_t        i_ram_size_max;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
     vlc_cond_t     wait;
 
+    /* */
+    int64_t        i_ram_size;
+    bool           b_ram_warned;
+
     /* */
     bool           b_paused;
     vlc_tick_t     i_pause_date;
@@ -227,6 +248,8 @@ typedef struct
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    bool           b_tmp_files;       /* Temporary files are allowed */
+    int64_t        i_ram_size_max;    /* Maximal memory used before files */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -264,6 +287,9 @@ static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
 static void         *TsRun( void * );
 
 static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNewMemory( int64_t i_size_max, int64_t *pi_ram_size );
+static bool         TsStorageIsMemory( const ts_storage_t * );
+static vlc_tick_t   TsStorageEvict( ts_storage_t *, int64_t i_size );
 static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
@@ -330,6 +356,12 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    p_sys->i_ram_size_max = var_InheritInteger( p_input, "input-timeshift-ram" ) * 1024 * 1024;
+    if( p_sys->i_ram_size_max > 0 )
+        msg_Dbg( p_input, "using up to %"PRId64" MiB of memory for timeshift",
+                 p_sys->i_ram_size_max / (1024*1024) );
+
+    p_sys->b_tmp_files = var_InheritBool( p_input, "input-timeshift-files" );
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -800,6 +832,10 @@ static int TsStart( es_out_t *p_out )
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->b_tmp_files = p_sys->b_tmp_files;
+    p_ts->i_ram_size_max = p_sys->i_ram_size_max;
+    p_ts->i_ram_size = 0;
+    p_ts->b_ram_warned = false;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -853,7 +889,12 @@ static void TsStop( ts_thread_t *p_ts )
         if( TsPopCmdLocked( p_ts, &cmd, true ) )
             break;
 
-        CmdClean( &cmd );
+        /* Pending deletions still have to reach the next es_out, or the
+         * ES they refer to would never be removed */
+        if( cmd.i_type == C_DEL )
+            CmdExecuteDel( p_ts->p_out, &cmd );
+        else
+            CmdClean( &cmd );
     }
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
     if( p_ts->p_storage_r )
@@ -862,13 +903,97 @@ static void TsStop( ts_thread_t *p_ts )
 
     TsDestroy( p_ts );
 }
+static size_t TsCmdSize( const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->i_type != C_SEND )
+        return 0;
+    return sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+}
+static bool TsRamFits( ts_thread_t *p_ts, const ts_cmd_t *p_cmd )
+{
+    return p_ts->i_ram_size + (int64_t)TsCmdSize( p_cmd ) <= p_ts->i_ram_size_max;
+}
+static void TsRamEvictLocked( ts_thread_t *p_ts, const ts_cmd_t *p_cmd )
+{
+    if( !p_ts->b_ram_warned )
+    {
+        msg_Warn( p_ts->p_input, "timeshift memory full, dropping oldest data" );
+        p_ts->b_ram_warned = true;
+    }
+
+    ts_storage_t *p_storage_r = p_ts->p_storage_r;
+    if( !p_storage_r || !TsStorageIsMemory( p_storage_r ) )
+        return;
+
+    /* Date of the next command to execute */
+    const vlc_tick_t i_start = TsStorageIsEmpty( p_storage_r ) ? VLC_TICK_INVALID
+                             : p_storage_r->p_cmd[p_storage_r->i_cmd_r].i_date;
+    vlc_tick_t i_end = VLC_TICK_INVALID;
+
+    for( ts_storage_t *p_storage = p_storage_r;
+         p_storage && !TsRamFits( p_ts, p_cmd ); p_storage = p_storage->p_next )
+    {
+        i_end = TsStorageEvict( p_storage, p_ts->i_ram_size + TsCmdSize( p_cmd )
+                                           - p_ts->i_ram_size_max );
+    }
+
+    /* Everything was dropped: the command being pushed comes next */
+    if( i_end == VLC_TICK_INVALID )
+        i_end = p_cmd->i_date;
+
+    /* The commands kept from the dropped span go with the first one left */
+    for( ts_storage_t *p_storage = p_ts->p_storage_r; p_storage;
+         p_storage = p_storage->p_next )
+    {
+        int i_cmd = p_storage->i_cmd_r;
+        for( ; i_cmd < p_storage->i_cmd_w &&
+               p_storage->p_cmd[i_cmd].i_date < i_end; i_cmd++ )
+            p_storage->p_cmd[i_cmd].i_date = i_end;
+        if( i_cmd < p_storage->i_cmd_w )
+            break;
+    }
+
+    /* Do not keep the storages emptied before the written one */
+    while( TsStorageIsEmpty( p_ts->p_storage_r ) && p_ts->p_storage_r->p_next )
+    {
+        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
+        TsStorageDelete( p_ts->p_storage_r );
+        p_ts->p_storage_r = p_next;
+    }
+
+    /* Execute the first command left when the dropped data would have been,
+     * rather than waiting for the whole dropped span */
+    if( i_start != VLC_TICK_INVALID && i_end > i_start )
+        p_ts->i_cmd_delay -= i_end - i_start;
+}
 static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    ts_storage_t *p_storage_w = p_ts->p_storage_w;
+    const bool b_ram_full = p_storage_w && TsStorageIsMemory( p_storage_w ) &&
+                            !TsRamFits( p_ts, p_cmd );
+
+    if( !p_storage_w || b_ram_full || TsStorageIsFull( p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = NULL;
+
+        /* Keep the data in memory while the budget allows it, then
+         * overflow to temporary files */
+        if( p_ts->i_ram_size_max > 0 && TsRamFits( p_ts, p_cmd ) )
+            p_storage = TsStorageNewMemory( p_ts->i_tmp_size_max, &p_ts->i_ram_size );
+        if( !p_storage && p_ts->b_tmp_files )
+            p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+
+        if( !p_storage && p_ts->i_ram_size_max > 0 )
+        {
+            /* No temporary file: use the memory as a ring buffer */
+            TsRamEvictLocked( p_ts, p_cmd );
+            if( !b_ram_full || TsStorageIsFull( p_storage_w, p_cmd ) )
+                p_storage = TsStorageNewMemory( p_ts->i_tmp_size_max, &p_ts->i_ram_size );
+            else
+                p_storage = p_storage_w;
+        }
 
         if( !p_storage )
         {
@@ -878,14 +1003,18 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
             return;
         }
 
-        if( !p_ts->p_storage_w )
+        if( p_storage != p_storage_w )
+            msg_Dbg( p_ts->p_input, "timeshift: storing in %s",
+                     TsStorageIsMemory( p_storage ) ? "memory" : "a temporary file" );
+
+        if( !p_storage_w )
         {
             p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
         }
-        else
+        else if( p_storage != p_storage_w )
         {
-            TsStoragePack( p_ts->p_storage_w );
-            p_ts->p_storage_w->p_next = p_storage;
+            TsStoragePack( p_storage_w );
+            p_storage_w->p_next = p_storage;
             p_ts->p_storage_w = p_storage;
         }
     }
@@ -1112,35 +1241,174 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static int TsStorageFileWrite( ts_storage_t *p_storage, ts_cmd_t *p_cmd,
+                               block_t *p_block, bool b_flush )
+{
+    p_cmd->u.send.p_block = NULL;
+    p_cmd->u.send.i_offset = ftell( p_storage->p_filew );
+
+    if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+    {
+        block_Release( p_block );
+        return VLC_EGENERIC;
+    }
+    p_storage->i_file_size += sizeof(*p_block);
+    if( p_block->i_buffer > 0 )
+    {
+        if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
+        {
+            block_Release( p_block );
+            return VLC_EGENERIC;
+        }
+    }
+    p_storage->i_file_size += p_block->i_buffer;
+    block_Release( p_block );
+
+    if( b_flush )
+        fflush( p_storage->p_filew );
+    return VLC_SUCCESS;
+}
+static block_t *TsStorageFileRead( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+{
+    block_t block;
+
+    if( !b_flush &&
+        !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
+        fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+    {
+        block_t *p_block = block_Alloc( block.i_buffer );
+        if( p_block )
+        {
+            p_block->i_dts      = block.i_dts;
+            p_block->i_pts      = block.i_pts;
+            p_block->i_flags    = block.i_flags;
+            p_block->i_length   = block.i_length;
+            p_block->i_nb_samples = block.i_nb_samples;
+            p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+        }
+        return p_block;
+    }
+    //perror( "TsStoragePopCmd" );
+    return block_Alloc( 1 );
+}
+static void TsStorageFileClose( ts_storage_t *p_storage )
+{
+    fclose( p_storage->p_filer );
+    fclose( p_storage->p_filew );
+#ifdef _WIN32
+    vlc_unlink( p_storage->psz_file );
+    free( p_storage->psz_file );
+#endif
+}
+
+static const ts_storage_ops_t ts_storage_file_ops =
+{
+    .pf_write = TsStorageFileWrite,
+    .pf_read = TsStorageFileRead,
+    .pf_close = TsStorageFileClose,
+};
+
+static int TsStorageMemoryWrite( ts_storage_t *p_storage, ts_cmd_t *p_cmd,
+                                 block_t *p_block, bool b_flush )
+{
+    VLC_UNUSED( b_flush );
+    const int64_t i_size = sizeof(*p_block) + p_block->i_buffer;
+
+    p_cmd->u.send.p_block = p_block;
+    p_storage->i_file_size += i_size;
+    *p_storage->pi_ram_size += i_size;
+    return VLC_SUCCESS;
+}
+static block_t *TsStorageMemoryRead( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+{
+    VLC_UNUSED( b_flush );
+    block_t *p_block = p_cmd->u.send.p_block;
+
+    *p_storage->pi_ram_size -= sizeof(*p_block) + p_block->i_buffer;
+    return p_block;
+}
+static void TsStorageMemoryClose( ts_storage_t *p_storage )
+{
+    VLC_UNUSED( p_storage );
+}
+
+static const ts_storage_ops_t ts_storage_memory_ops =
+{
+    .pf_write = TsStorageMemoryWrite,
+    .pf_read = TsStorageMemoryRead,
+    .pf_close = TsStorageMemoryClose,
+};
+
+static ts_storage_t *TsStorageAlloc( const ts_storage_ops_t *ops, int64_t i_size_max )
 {
     ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
     if( unlikely(p_storage == NULL) )
         return NULL;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
+    p_storage->p_next = NULL;
+    p_storage->ops = ops;
+
+    /* */
+    p_storage->i_file_max = i_size_max;
+    p_storage->i_file_size = 0;
+
+    /* */
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_max = 30000;
+    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
+
+    if( !p_storage->p_cmd )
     {
         free( p_storage );
         return NULL;
     }
+    return p_storage;
+}
+
+static ts_storage_t *TsStorageNewMemory( int64_t i_size_max, int64_t *pi_ram_size )
+{
+    ts_storage_t *p_storage = TsStorageAlloc( &ts_storage_memory_ops, i_size_max );
+    if( !p_storage )
+        return NULL;
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+    p_storage->pi_ram_size = pi_ram_size;
+    return p_storage;
+}
+
+static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+{
+    char *psz_file;
+    int fd = GetTmpFile( &psz_file, psz_tmp_path );
+    if( fd == -1 )
+        return NULL;
+
+    FILE *p_filew = fdopen( fd, "w+b" );
+    if( p_filew == NULL )
     {
         vlc_close( fd );
         vlc_unlink( psz_file );
         goto error;
     }
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
+    FILE *p_filer = vlc_fopen( psz_file, "rb" );
+    if( p_filer == NULL )
+    {
+        fclose( p_filew );
+        vlc_unlink( psz_file );
+        goto error;
+    }
+
+    ts_storage_t *p_storage = TsStorageAlloc( &ts_storage_file_ops, i_tmp_size_max );
+    if( !p_storage )
     {
-        fclose( p_storage->p_filew );
+        fclose( p_filer );
+        fclose( p_filew );
         vlc_unlink( psz_file );
         goto error;
     }
+    p_storage->p_filew = p_filew;
+    p_storage->p_filer = p_filer;
 
 #ifndef _WIN32
     vlc_unlink( psz_file );
@@ -1148,28 +1416,9 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
 #else
     p_storage->psz_file = psz_file;
 #endif
-    p_storage->p_next = NULL;
-
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
-
-    /* */
-    p_storage->i_cmd_w = 0;
-    p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
-    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
-
-    if( !p_storage->p_cmd )
-    {
-        TsStorageDelete( p_storage );
-        return NULL;
-    }
     return p_storage;
 error:
     free( psz_file );
-    free( p_storage );
     return NULL;
 }
 
@@ -1185,15 +1434,91 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
-#ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
-#endif
+    p_storage->ops->pf_close( p_storage );
     free( p_storage );
 }
 
+static bool TsStorageIsMemory( const ts_storage_t *p_storage )
+{
+    return p_storage->ops == &ts_storage_memory_ops;
+}
+
+static bool TsCmdIsPcr( const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->i_type != C_CONTROL )
+        return false;
+    return p_cmd->u.control.i_query == ES_OUT_SET_PCR ||
+           p_cmd->u.control.i_query == ES_OUT_SET_GROUP_PCR ||
+           p_cmd->u.control.i_query == ES_OUT_RESET_PCR;
+}
+
+/* Drops the oldest data of a memory storage, and returns the date of the
+ * first command left after it (VLC_TICK_INVALID if none).
+ * The other commands are kept, in order, just before that command. */
+static vlc_tick_t TsStorageEvict( ts_storage_t *p_storage, int64_t i_size )
+{
+    if( !TsStorageIsMemory( p_storage ) )
+        return VLC_TICK_INVALID;
+
+    int i_cmd = p_storage->i_cmd_r;
+    int i_kept = 0;
+    for( ; i_cmd < p_storage->i_cmd_w && i_size > 0; i_cmd++ )
+    {
+        ts_cmd_t *p_cmd = &p_storage->p_cmd[i_cmd];
+        if( p_cmd->i_type == C_SEND )
+        {
+            block_t *p_block = p_cmd->u.send.p_block;
+            const int64_t i_block_size = sizeof(*p_block) + p_block->i_buffer;
+            i_size -= i_block_size;
+            p_storage->i_file_size -= i_block_size;
+            *p_storage->pi_ram_size -= i_block_size;
+            block_Release( p_block );
+        }
+        else if( TsCmdIsPcr( p_cmd ) )
+        {
+            /* The clock references of the dropped data go with it */
+            CmdClean( p_cmd );
+        }
+        else
+        {
+            p_storage->p_cmd[p_storage->i_cmd_r + i_kept++] = *p_cmd;
+        }
+    }
+
+    const bool b_dropped = i_cmd - i_kept > p_storage->i_cmd_r;
+    if( b_dropped )
+    {
+        memmove( &p_storage->p_cmd[i_cmd - i_kept],
+                 &p_storage->p_cmd[p_storage->i_cmd_r],
+                 i_kept * sizeof(*p_storage->p_cmd) );
+        p_storage->i_cmd_r = i_cmd - i_kept;
+    }
+    if( i_cmd >= p_storage->i_cmd_w )
+        return VLC_TICK_INVALID;
+
+    /* The data left is not continuous with what was played before: restart
+     * the clock on it, in the slot freed by the dropped commands */
+    if( b_dropped )
+    {
+        ts_cmd_t *p_reset = &p_storage->p_cmd[--p_storage->i_cmd_r];
+        p_reset->i_type = C_CONTROL;
+        p_reset->i_date = p_storage->p_cmd[i_cmd].i_date;
+        p_reset->u.control.i_query = ES_OUT_RESET_PCR;
+    }
+
+    /* Let the decoders know about the gap */
+    for( int i = i_cmd; i < p_storage->i_cmd_w; i++ )
+    {
+        ts_cmd_t *p_cmd = &p_storage->p_cmd[i];
+        if( p_cmd->i_type == C_SEND )
+        {
+            p_cmd->u.send.p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+            break;
+        }
+    }
+    return p_storage->p_cmd[i_cmd].i_date;
+}
+
 static void TsStoragePack( ts_storage_t *p_storage )
 {
     /* Try to release a bit of memory */
@@ -1210,7 +1535,7 @@ static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
     {
-        size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+        size_t i_size = TsCmdSize( p_cmd );
 
         if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
             return true;
@@ -1227,33 +1552,10 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
 
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
 
-    if( cmd.i_type == C_SEND )
-    {
-        block_t *p_block = cmd.u.send.p_block;
-
-        cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
-
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
-        {
-            block_Release( p_block );
-            return;
-        }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
-        }
-        p_storage->i_file_size += p_block->i_buffer;
-        block_Release( p_block );
+    if( cmd.i_type == C_SEND &&
+        p_storage->ops->pf_write( p_storage, &cmd, cmd.u.send.p_block, b_flush ) )
+        return;
 
-        if( b_flush )
-            fflush( p_storage->p_filew );
-    }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
@@ -1262,31 +1564,7 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
     if( p_cmd->i_type == C_SEND )
-    {
-        block_t block;
-
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
-        {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->u.send.p_block = p_block;
-        }
-        else
-        {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
-        }
-    }
+        p_cmd->u.send.p_block = p_storage->ops->pf_read( p_storage, p_cmd, b_flush );
 }
 
 /*****************************************************************************
@@ -25,7 +25,15 @@
 #endif
 
 #include <vlc_thumbnailer.h>
+#include <vlc_codec.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_image.h>
+#include <vlc_interrupt.h>
+#include <vlc_modules.h>
 #include "input_internal.h"
+#include "demux.h"
+#include "stream.h"
 #include "misc/background_worker.h"
 
 struct vlc_thumbnailer_t
@@ -53,56 +61,550 @@ typedef struct vlc_thumbnailer_params_t
      * VLC_TICK_INVALID means no timeout
      */
     vlc_tick_t timeout;
+    /** Times of a batch request (owned), or NULL for a single thumbnail */
+    vlc_tick_t* times;
+    size_t count;
+    /** Size of the thumbnails, or 0 to keep the source size/aspect ratio */
+    unsigned width;
+    unsigned height;
     vlc_thumbnailer_cb cb;
+    vlc_thumbnailer_batch_cb batch_cb;
     void* user_data;
 } vlc_thumbnailer_params_t;
 
 struct vlc_thumbnailer_request_t
 {
     vlc_thumbnailer_t *thumbnailer;
-    input_thread_t *input_thread;
+    vlc_thread_t thread;
+    vlc_interrupt_t *interrupt;
 
     vlc_thumbnailer_params_t params;
 
     vlc_mutex_t lock;
+    size_t reported;
     bool done;
 };
 
-static void
-on_thumbnailer_input_event( input_thread_t *input,
-                            const struct vlc_input_event *event, void *userdata )
+/*
+ * Thumbnails are extracted by a bare demux -> packetizer -> decoder chain
+ * running on the request thread, without any input thread, clock or video
+ * output. The file is opened once per request, and reused for all the
+ * thumbnails of a batch.
+ */
+struct es_out_id_t
 {
-    VLC_UNUSED(input);
-    if ( event->type != INPUT_EVENT_THUMBNAIL_READY &&
-         ( event->type != INPUT_EVENT_STATE || ( event->state.value != ERROR_S &&
-                                                 event->state.value != END_S ) ) )
-         return;
+    enum es_format_category_e cat;
+};
+
+struct thumbnailer_extractor
+{
+    es_out_t out;
+    vlc_object_t *obj;
+    demux_t *demux;
+    image_handler_t *image;
 
-    vlc_thumbnailer_request_t* request = userdata;
-    picture_t *pic = NULL;
+    es_out_id_t *es; /* video ES being decoded, or NULL */
+    decoder_t *packetizer;
+    decoder_t *decoder;
 
-    if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
+    vlc_mutex_t lock;
+    vlc_tick_t target; /* earliest acceptable date, or VLC_TICK_INVALID */
+    picture_t *pic; /* accepted picture */
+    picture_t *last; /* last decoded picture, for the end of stream */
+};
+
+struct thumbnailer_decoder
+{
+    decoder_t dec;
+    struct thumbnailer_extractor *ex;
+};
+
+static vlc_decoder_device *
+extractor_GetDevice( decoder_t *dec )
+{
+    VLC_UNUSED(dec);
+    /* Software decoding only: the pictures are converted on the CPU */
+    return NULL;
+}
+
+static void extractor_QueueVideo( decoder_t *dec, picture_t *pic )
+{
+    struct thumbnailer_extractor *ex =
+        container_of( dec, struct thumbnailer_decoder, dec )->ex;
+
+    vlc_mutex_lock( &ex->lock );
+    if ( ex->pic == NULL && ( ex->target == VLC_TICK_INVALID ||
+         pic->date == VLC_TICK_INVALID || pic->date >= ex->target ) )
+        ex->pic = pic;
+    else
     {
-        /*
-         * Stop the input thread ASAP, delegate its release to
-         * thumbnailer_request_Release
-         */
-        input_Stop( request->input_thread );
-        pic = event->thumbnail;
+        if ( ex->last != NULL )
+            picture_Release( ex->last );
+        ex->last = pic;
     }
-    vlc_mutex_lock( &request->lock );
-    request->done = true;
-    /*
-     * If the request has not been cancelled, we can invoke the completion
-     * callback.
-     */
-    if ( request->params.cb )
+    vlc_mutex_unlock( &ex->lock );
+}
+
+static void extractor_QueueCc( decoder_t *dec, block_t *cc,
+                               const decoder_cc_desc_t *desc )
+{
+    VLC_UNUSED(dec); VLC_UNUSED(desc);
+    block_Release( cc );
+}
+
+static const struct decoder_owner_callbacks extractor_decoder_cbs =
+{
+    .video = {
+        .get_device = extractor_GetDevice,
+        .queue = extractor_QueueVideo,
+        .queue_cc = extractor_QueueCc,
+    },
+};
+
+static decoder_t *extractor_LoadDecoder( struct thumbnailer_extractor *ex,
+                                         const es_format_t *fmt,
+                                         bool packetizer )
+{
+    struct thumbnailer_decoder *owner =
+        vlc_object_create( ex->obj, sizeof( *owner ) );
+    if ( unlikely( owner == NULL ) )
+        return NULL;
+
+    decoder_t *dec = &owner->dec;
+    owner->ex = ex;
+    decoder_Init( dec, fmt );
+    dec->b_frame_drop_allowed = false;
+    dec->cbs = &extractor_decoder_cbs;
+    if ( packetizer )
+        dec->p_module = module_need( dec, "packetizer", "$packetizer", false );
+    else
+        dec->p_module = module_need( dec, "video decoder", "$codec", false );
+
+    if ( dec->p_module == NULL )
+    {
+        decoder_Destroy( dec );
+        return NULL;
+    }
+    return dec;
+}
+
+static void extractor_CloseDecoder( struct thumbnailer_extractor *ex )
+{
+    if ( ex->decoder != NULL )
+        decoder_Destroy( ex->decoder );
+    if ( ex->packetizer != NULL )
+        decoder_Destroy( ex->packetizer );
+    ex->decoder = ex->packetizer = NULL;
+}
+
+static int extractor_OpenDecoder( struct thumbnailer_extractor *ex,
+                                  const es_format_t *fmt )
+{
+    ex->decoder = extractor_LoadDecoder( ex, fmt, false );
+    if ( ex->decoder == NULL )
+        return VLC_EGENERIC;
+
+    if ( !fmt->b_packetized )
+    {
+        ex->packetizer = extractor_LoadDecoder( ex, fmt, true );
+        if ( ex->packetizer == NULL )
+        {
+            extractor_CloseDecoder( ex );
+            return VLC_EGENERIC;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static bool extractor_HasPicture( struct thumbnailer_extractor *ex )
+{
+    vlc_mutex_lock( &ex->lock );
+    bool ret = ex->pic != NULL;
+    vlc_mutex_unlock( &ex->lock );
+    return ret;
+}
+
+/* Decodes a packetized block, or drains the decoder if NULL */
+static void extractor_DecodeBlock( struct thumbnailer_extractor *ex,
+                                   block_t *block )
+{
+    if ( ex->decoder == NULL )
     {
+        if ( block != NULL )
+            block_Release( block );
+        return;
+    }
+    ex->decoder->pf_decode( ex->decoder, block );
+}
+
+/* Decodes a block from the demux, or drains the chain if NULL */
+static void extractor_Decode( struct thumbnailer_extractor *ex,
+                              block_t *block )
+{
+    if ( ex->packetizer == NULL )
+    {
+        extractor_DecodeBlock( ex, block );
+        return;
+    }
+
+    block_t **pp_block = block != NULL ? &block : NULL;
+    block_t *packet;
+
+    while ( ( packet = ex->packetizer->pf_packetize( ex->packetizer,
+                                                     pp_block ) ) != NULL )
+    {
+        if ( ex->decoder != NULL &&
+             !es_format_IsSimilar( &ex->decoder->fmt_in,
+                                   &ex->packetizer->fmt_out ) )
+        {
+            /* Restart the decoder on the new format */
+            decoder_Destroy( ex->decoder );
+            ex->decoder = extractor_LoadDecoder( ex, &ex->packetizer->fmt_out,
+                                                 false );
+        }
+
+        while ( packet != NULL )
+        {
+            block_t *next = packet->p_next;
+
+            packet->p_next = NULL;
+            extractor_DecodeBlock( ex, packet );
+            packet = next;
+        }
+    }
+
+    if ( block == NULL )
+        extractor_DecodeBlock( ex, NULL );
+}
+
+static void extractor_Flush( struct thumbnailer_extractor *ex )
+{
+    if ( ex->packetizer != NULL && ex->packetizer->pf_flush != NULL )
+        ex->packetizer->pf_flush( ex->packetizer );
+    if ( ex->decoder != NULL && ex->decoder->pf_flush != NULL )
+        ex->decoder->pf_flush( ex->decoder );
+
+    vlc_mutex_lock( &ex->lock );
+    if ( ex->pic != NULL )
+        picture_Release( ex->pic );
+    if ( ex->last != NULL )
+        picture_Release( ex->last );
+    ex->pic = ex->last = NULL;
+    vlc_mutex_unlock( &ex->lock );
+}
+
+static es_out_id_t *extractor_EsAdd( es_out_t *out, const es_format_t *fmt )
+{
+    struct thumbnailer_extractor *ex =
+        container_of( out, struct thumbnailer_extractor, out );
+    es_out_id_t *es = malloc( sizeof( *es ) );
+    if ( unlikely( es == NULL ) )
+        return NULL;
+
+    es->cat = fmt->i_cat;
+    /* Only the first decodable video track is used */
+    if ( ex->es == NULL && fmt->i_cat == VIDEO_ES &&
+         extractor_OpenDecoder( ex, fmt ) == VLC_SUCCESS )
+        ex->es = es;
+    return es;
+}
+
+static int extractor_EsSend( es_out_t *out, es_out_id_t *es, block_t *block )
+{
+    struct thumbnailer_extractor *ex =
+        container_of( out, struct thumbnailer_extractor, out );
+
+    if ( es != ex->es || extractor_HasPicture( ex ) )
+        block_Release( block );
+    else
+        extractor_Decode( ex, block );
+    return VLC_SUCCESS;
+}
+
+static void extractor_EsDel( es_out_t *out, es_out_id_t *es )
+{
+    struct thumbnailer_extractor *ex =
+        container_of( out, struct thumbnailer_extractor, out );
+
+    if ( es == ex->es )
+    {
+        extractor_Decode( ex, NULL );
+        extractor_CloseDecoder( ex );
+        ex->es = NULL;
+    }
+    free( es );
+}
+
+static int extractor_EsControl( es_out_t *out, int query, va_list args )
+{
+    struct thumbnailer_extractor *ex =
+        container_of( out, struct thumbnailer_extractor, out );
+
+    switch ( query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *es = va_arg( args, es_out_id_t * );
+            *va_arg( args, bool * ) = es == ex->es;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_ES:
+        case ES_OUT_UNSET_ES:
+        case ES_OUT_RESTART_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_CAT_POLICY:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_SET_GROUP_EPG_EVENT:
+        case ES_OUT_SET_EPG_TIME:
+        case ES_OUT_DEL_GROUP:
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+        case ES_OUT_SET_META:
+            /* Nothing to do without playback */
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static const struct es_out_callbacks extractor_es_out_cbs =
+{
+    .add = extractor_EsAdd,
+    .send = extractor_EsSend,
+    .del = extractor_EsDel,
+    .control = extractor_EsControl,
+};
+
+static int extractor_Open( struct thumbnailer_extractor *ex,
+                           vlc_object_t *obj, input_item_t *item )
+{
+    ex->out.cbs = &extractor_es_out_cbs;
+    ex->obj = obj;
+    ex->demux = NULL;
+    ex->image = NULL;
+    ex->es = NULL;
+    ex->packetizer = ex->decoder = NULL;
+    vlc_mutex_init( &ex->lock );
+    ex->target = VLC_TICK_INVALID;
+    ex->pic = ex->last = NULL;
+
+    char *url = input_item_GetURI( item );
+    if ( url == NULL )
+        goto error;
+
+    stream_t *s = stream_AccessNew( obj, NULL, &ex->out, false, url );
+    if ( s != NULL )
+    {
+        s = stream_FilterAutoNew( s );
+        if ( s->pf_read == NULL && s->pf_block == NULL &&
+             s->pf_readdir == NULL )
+            ex->demux = s; /* access_demux */
+        else
+        {
+            ex->demux = demux_NewAdvanced( obj, NULL, "any", url, s,
+                                           &ex->out, false );
+            if ( ex->demux == NULL )
+                vlc_stream_Delete( s );
+        }
+    }
+    free( url );
+
+    if ( ex->demux == NULL )
+        goto error;
+    return VLC_SUCCESS;
+
+error:
+    vlc_mutex_destroy( &ex->lock );
+    return VLC_EGENERIC;
+}
+
+static void extractor_Close( struct thumbnailer_extractor *ex )
+{
+    demux_Delete( ex->demux );
+    /* The demux deletes its ES, but not necessarily on all paths */
+    extractor_CloseDecoder( ex );
+    extractor_Flush( ex );
+    if ( ex->image != NULL )
+        image_HandlerDelete( ex->image );
+    vlc_mutex_destroy( &ex->lock );
+}
+
+/**
+ * Seeks to the given time (or position if time is VLC_TICK_INVALID), and
+ * decodes up to the first suitable picture.
+ */
+static picture_t *extractor_Extract( struct thumbnailer_extractor *ex,
+                                     vlc_tick_t time, double pos, bool fast )
+{
+    vlc_tick_t target = VLC_TICK_INVALID;
+
+    if ( time != VLC_TICK_INVALID )
+    {
+        target = __MAX( time, VLC_TICK_0 );
+        /* If seeking fails, demux from the current point onward */
+        demux_Control( ex->demux, DEMUX_SET_TIME, target, !fast );
+    }
+    else
+    {
+        vlc_tick_t length;
+
+        if ( demux_Control( ex->demux, DEMUX_GET_LENGTH,
+                            &length ) == VLC_SUCCESS && length > 0 )
+            target = VLC_TICK_0 + pos * length;
+        demux_Control( ex->demux, DEMUX_SET_POSITION, pos, !fast );
+    }
+
+    extractor_Flush( ex );
+    vlc_mutex_lock( &ex->lock );
+    /* Fast seeks take the first picture, whatever its date */
+    ex->target = fast ? VLC_TICK_INVALID : target;
+    vlc_mutex_unlock( &ex->lock );
+
+    while ( !extractor_HasPicture( ex ) )
+    {
+        if ( vlc_killed() )
+            return NULL;
+        if ( demux_Demux( ex->demux ) != VLC_DEMUXER_SUCCESS )
+        {
+            extractor_Decode( ex, NULL );
+            break;
+        }
+    }
+
+    vlc_mutex_lock( &ex->lock );
+    picture_t *pic = ex->pic;
+    if ( pic == NULL )
+    {
+        /* End of stream before the target: use the last picture, if any */
+        pic = ex->last;
+        ex->last = NULL;
+    }
+    ex->pic = NULL;
+    vlc_mutex_unlock( &ex->lock );
+    return pic;
+}
+
+static picture_t *extractor_Scale( struct thumbnailer_extractor *ex,
+                                   picture_t *pic,
+                                   unsigned width, unsigned height )
+{
+    if ( width == 0 && height == 0 )
+        return pic;
+
+    const video_format_t *fmt_in = &pic->format;
+    uint64_t src_width = fmt_in->i_visible_width;
+    uint64_t src_height = fmt_in->i_visible_height;
+
+    if ( fmt_in->i_sar_num != 0 && fmt_in->i_sar_den != 0 )
+        src_width = src_width * fmt_in->i_sar_num / fmt_in->i_sar_den;
+    if ( src_width == 0 || src_height == 0 )
+        goto error;
+    if ( width == 0 )
+        width = __MAX( 1, height * src_width / src_height );
+    else if ( height == 0 )
+        height = __MAX( 1, width * src_height / src_width );
+
+    if ( ex->image == NULL )
+    {
+        ex->image = image_HandlerCreate( ex->obj );
+        if ( unlikely( ex->image == NULL ) )
+            goto error;
+    }
+
+    video_format_t fmt_out;
+    video_format_Init( &fmt_out, fmt_in->i_chroma );
+    video_format_Setup( &fmt_out, fmt_in->i_chroma, width, height,
+                        width, height, 1, 1 );
+
+    picture_t *scaled = image_Convert( ex->image, pic, fmt_in, &fmt_out );
+    if ( scaled != NULL )
+        scaled->date = pic->date;
+    picture_Release( pic );
+    return scaled;
+
+error:
+    picture_Release( pic );
+    return NULL;
+}
+
+/* Reports the next thumbnail of the request, unless it was cancelled */
+static void thumbnailer_request_Report( vlc_thumbnailer_request_t *request,
+                                        picture_t *pic )
+{
+    vlc_mutex_lock( &request->lock );
+    size_t index = request->reported++;
+    if ( request->params.batch_cb != NULL )
+        request->params.batch_cb( request->params.user_data, index, pic );
+    else if ( request->params.cb != NULL )
         request->params.cb( request->params.user_data, pic );
+    if ( request->reported == request->params.count )
+    {
         request->params.cb = NULL;
+        request->params.batch_cb = NULL;
     }
     vlc_mutex_unlock( &request->lock );
+}
+
+static void *thumbnailer_request_Run( void *data )
+{
+    vlc_thumbnailer_request_t *request = data;
+    const vlc_thumbnailer_params_t *params = &request->params;
+    struct thumbnailer_extractor ex;
+
+    vlc_interrupt_set( request->interrupt );
+
+    bool opened = extractor_Open( &ex, request->thumbnailer->parent,
+                                  params->input_item ) == VLC_SUCCESS;
+
+    for ( size_t i = 0; i < params->count && !vlc_killed(); i++ )
+    {
+        picture_t *pic = NULL;
+
+        if ( opened )
+        {
+            if ( params->times != NULL )
+                pic = extractor_Extract( &ex, params->times[i], 0.,
+                                         params->fast_seek );
+            else if ( params->type == VLC_THUMBNAILER_SEEK_TIME )
+                pic = extractor_Extract( &ex, params->time, 0.,
+                                         params->fast_seek );
+            else
+                pic = extractor_Extract( &ex, VLC_TICK_INVALID, params->pos,
+                                         params->fast_seek );
+            if ( pic != NULL )
+                pic = extractor_Scale( &ex, pic, params->width,
+                                       params->height );
+        }
+        if ( vlc_killed() )
+        {
+            /* Timed out: reported by thumbnailer_request_Stop */
+            if ( pic != NULL )
+                picture_Release( pic );
+            break;
+        }
+
+        thumbnailer_request_Report( request, pic );
+        if ( pic != NULL )
+            picture_Release( pic );
+    }
+
+    if ( opened )
+        extractor_Close( &ex );
+
+    vlc_mutex_lock( &request->lock );
+    request->done = true;
+    vlc_mutex_unlock( &request->lock );
     background_worker_RequestProbe( request->thumbnailer->worker );
+    return NULL;
 }
 
 static void thumbnailer_request_Hold( void* data )
@@ -113,45 +615,34 @@ static void thumbnailer_request_Hold( void* data )
 static void thumbnailer_request_Release( void* data )
 {
     vlc_thumbnailer_request_t* request = data;
-    if ( request->input_thread )
-        input_Close( request->input_thread );
 
+    if ( request->interrupt != NULL )
+        vlc_interrupt_destroy( request->interrupt );
     input_item_Release( request->params.input_item );
+    free( request->params.times );
     vlc_mutex_destroy( &request->lock );
     free( request );
 }
 
 static int thumbnailer_request_Start( void* owner, void* entity, void** out )
 {
-    vlc_thumbnailer_t* thumbnailer = owner;
+    VLC_UNUSED(owner);
     vlc_thumbnailer_request_t* request = entity;
-    input_thread_t* input = request->input_thread =
-            input_CreateThumbnailer( thumbnailer->parent,
-                                     on_thumbnailer_input_event, request,
-                                     request->params.input_item );
-    if ( unlikely( input == NULL ) )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
-    }
-    if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
-    {
-        input_SetTime( input, request->params.time,
-                       request->params.fast_seek );
-    }
-    else
-    {
-        assert( request->params.type == VLC_THUMBNAILER_SEEK_POS );
-        input_SetPosition( input, request->params.pos,
-                       request->params.fast_seek );
-    }
-    if ( input_Start( input ) != VLC_SUCCESS )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
-    }
+
+    request->interrupt = vlc_interrupt_create();
+    if ( unlikely( request->interrupt == NULL ) )
+        goto error;
+    if ( vlc_clone( &request->thread, thumbnailer_request_Run, request,
+                    VLC_THREAD_PRIORITY_LOW ) )
+        goto error;
+
     *out = request;
     return VLC_SUCCESS;
+
+error:
+    while ( request->reported < request->params.count )
+        thumbnailer_request_Report( request, NULL );
+    return VLC_EGENERIC;
 }
 
 static void thumbnailer_request_Stop( void* owner, void* handle )
@@ -159,19 +650,14 @@ static void thumbnailer_request_Stop( void* owner, void* handle )
     VLC_UNUSED(owner);
 
     vlc_thumbnailer_request_t *request = handle;
-    vlc_mutex_lock( &request->lock );
+    vlc_interrupt_kill( request->interrupt );
+    vlc_join( request->thread, NULL );
     /*
-     * If the callback hasn't been invoked yet, we assume a timeout and
-     * signal it back to the user
+     * If the callback hasn't been invoked for every thumbnail yet, we assume
+     * a timeout and signal it back to the user
      */
-    if ( request->params.cb != NULL )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        request->params.cb = NULL;
-    }
-    vlc_mutex_unlock( &request->lock );
-    assert( request->input_thread != NULL );
-    input_Stop( request->input_thread );
+    while ( request->reported < request->params.count )
+        thumbnailer_request_Report( request, NULL );
 }
 
 static int thumbnailer_request_Probe( void* owner, void* handle )
@@ -190,10 +676,14 @@ thumbnailer_RequestCommon( vlc_thumbnailer_t* thumbnailer,
 {
     vlc_thumbnailer_request_t *request = malloc( sizeof( *request ) );
     if ( unlikely( request == NULL ) )
+    {
+        free( params->times );
         return NULL;
+    }
     request->thumbnailer = thumbnailer;
-    request->input_thread = NULL;
+    request->interrupt = NULL;
     request->params = *(vlc_thumbnailer_params_t*)params;
+    request->reported = 0;
     request->done = false;
     input_item_Hold( request->params.input_item );
     vlc_mutex_init( &request->lock );
@@ -223,6 +713,7 @@ vlc_thumbnailer_RequestByTime( vlc_thumbnailer_t *thumbnailer,
                 .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
                 .input_item = input_item,
                 .timeout = timeout,
+                .count = 1,
                 .cb = cb,
                 .user_data = user_data,
         });
@@ -241,17 +732,51 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                 .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
                 .input_item = input_item,
                 .timeout = timeout,
+                .count = 1,
                 .cb = cb,
                 .user_data = user_data,
         });
 }
 
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              unsigned width, unsigned height,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data )
+{
+    if ( count == 0 )
+        return NULL;
+
+    vlc_tick_t *copy = vlc_alloc( count, sizeof( *copy ) );
+    if ( unlikely( copy == NULL ) )
+        return NULL;
+    memcpy( copy, times, count * sizeof( *copy ) );
+
+    /* The times are owned by the request, even on failure */
+    return thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .type = VLC_THUMBNAILER_SEEK_TIME,
+                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .input_item = input_item,
+                .timeout = timeout,
+                .times = copy,
+                .count = count,
+                .width = width,
+                .height = height,
+                .batch_cb = cb,
+                .user_data = user_data,
+        });
+}
+
 void vlc_thumbnailer_Cancel( vlc_thumbnailer_t* thumbnailer,
                              vlc_thumbnailer_request_t* req )
 {
     vlc_mutex_lock( &req->lock );
-    /* Ensure we won't invoke the callback if the input was running. */
+    /* Ensure we won't invoke the callback if the request was running. */
     req->params.cb = NULL;
+    req->params.batch_cb = NULL;
     vlc_mutex_unlock( &req->lock );
     background_worker_Cancel( thumbnailer->worker, req );
 }
@@ -88,6 +88,17 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Format the log messages in the calling thread, but write them from a " \
+    "dedicated thread, so that slow log outputs do not delay the playback. " \
+    "Messages are dropped if the log output cannot keep up.")
+
+#define LOG_RATE_TEXT N_("Debug messages rate limit")
+#define LOG_RATE_LONGTEXT N_( \
+    "Maximum number of debug messages per second and per module " \
+    "with asynchronous logging (0=unlimited).")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -400,6 +411,11 @@ static const char *const screensaver_texts[] = {
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define VIDEO_FILTER_THREADS_TEXT N_("Video filter threads")
+#define VIDEO_FILTER_THREADS_LONGTEXT N_( \
+    "Number of slices that the video filters supporting it process in " \
+    "parallel. 0 means one per CPU.")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -725,6 +741,18 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_RAM_TEXT N_("Timeshift memory (MiB)")
+#define INPUT_TIMESHIFT_RAM_LONGTEXT N_( \
+    "Amount of memory used to store the timeshifted streams before " \
+    "overflowing to temporary files. If no temporary file can be created, " \
+    "the oldest data is dropped. 0 disables in-memory timeshift." )
+
+#define INPUT_TIMESHIFT_FILES_TEXT N_("Timeshift to temporary files")
+#define INPUT_TIMESHIFT_FILES_LONGTEXT N_( \
+    "Store the timeshifted streams in temporary files. If disabled, only " \
+    "the timeshift memory is used, and the oldest data is dropped when it " \
+    "is full." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -884,6 +912,11 @@ static const char *const ppsz_prefres[] = {
     "However allocation of port numbers below 1025 is usually restricted " \
     "by the operating system." )
 
+#define HTTP_WORKERS_TEXT N_( "HTTP streaming threads" )
+#define HTTP_WORKERS_LONGTEXT N_( \
+    "Number of threads sending live streams to the HTTP clients. " \
+    "0 uses one thread per CPU core." )
+
 #define RTSP_PORT_TEXT N_( "RTSP server port" )
 #define RTSP_PORT_LONGTEXT N_( \
     "The RTSP server will listen on this TCP port. " \
@@ -1071,6 +1104,12 @@ static const char *const ppsz_prefres[] = {
 #define DEMUX_FILTER_LONGTEXT N_( \
     "Demux filters are used to modify/control the stream that is being read." )
 
+#define DEMUX_INDEX_CACHE_TEXT N_("Cache seek indexes")
+#define DEMUX_INDEX_CACHE_LONGTEXT N_( \
+    "Keep the seek indexes that demultiplexers build by scanning files " \
+    "in the cache directory, and reuse them when the same unmodified " \
+    "file is opened again." )
+
 #define DEMUX_TEXT N_("Demux module")
 #define DEMUX_LONGTEXT N_( \
     "Demultiplexers are used to separate the \"elementary\" streams " \
@@ -1097,6 +1136,13 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define BLOCK_POOL_TEXT N_("Recycle data blocks")
+#define BLOCK_POOL_LONGTEXT N_( \
+    "Keep released data blocks of common sizes (such as TS packets and UDP " \
+    "payloads) in per-thread pools, and reuse them for later allocations. " \
+    "This reduces memory allocator load and fragmentation with high " \
+    "packet rates, at the expense of some memory.")
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1753,6 +1799,9 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list("video-filter", "video filter", NULL,
                     VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT)
+    add_integer( "video-filter-threads", 0, VIDEO_FILTER_THREADS_TEXT,
+                 VIDEO_FILTER_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 16 )
 
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -1905,6 +1954,8 @@ vlc_module_begin ()
         change_integer_range( 1, 65535 )
     add_integer( "https-port", 8443, HTTPS_PORT_TEXT, HTTPS_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
+    add_integer_with_range( "http-workers", 0, 0, 64, HTTP_WORKERS_TEXT,
+                            HTTP_WORKERS_LONGTEXT, true )
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT, true )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
@@ -2034,6 +2085,10 @@ vlc_module_begin ()
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer_with_range( "input-timeshift-ram", 0, 0, 4096,
+                 INPUT_TIMESHIFT_RAM_TEXT, INPUT_TIMESHIFT_RAM_LONGTEXT, true )
+    add_bool( "input-timeshift-files", true, INPUT_TIMESHIFT_FILES_TEXT,
+              INPUT_TIMESHIFT_FILES_LONGTEXT, true )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2054,6 +2109,8 @@ vlc_module_begin ()
 
     set_subcategory( SUBCAT_INPUT_DEMUX )
     add_module("demux", "demux", "any", DEMUX_TEXT, DEMUX_LONGTEXT)
+    add_bool( "demux-index-cache", false, DEMUX_INDEX_CACHE_TEXT,
+              DEMUX_INDEX_CACHE_LONGTEXT, true )
     set_subcategory( SUBCAT_INPUT_ACODEC )
     set_subcategory( SUBCAT_INPUT_SCODEC )
     add_obsolete_bool( "prefer-system-codecs" )
@@ -2157,6 +2214,9 @@ vlc_module_begin ()
                  RT_OFFSET_LONGTEXT, true )
 #endif
 
+    add_bool( "block-pool", false, BLOCK_POOL_TEXT,
+              BLOCK_POOL_LONGTEXT, true )
+
 #if defined(HAVE_DBUS)
     add_obsolete_bool( "inhibit" ) /* since 3.0.0 */
 #endif
@@ -2254,6 +2314,9 @@ vlc_module_begin ()
         change_short('v')
         change_volatile ()
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
+    add_integer( "log-rate-limit", 0, LOG_RATE_TEXT, LOG_RATE_LONGTEXT, true )
+        change_integer_range( 0, INT_MAX )
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
         change_short('d')
@@ -58,6 +58,7 @@
 #include <vlc_dialog.h>
 #include <vlc_keystore.h>
 #include <vlc_fs.h>
+#include <vlc_block.h>
 #include <vlc_cpu.h>
 #include <vlc_url.h>
 #include <vlc_modules.h>
@@ -95,6 +96,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->main_playlist = NULL;
     priv->p_vlm = NULL;
     priv->media_source_provider = NULL;
+    priv->block_pool = false;
 
     vlc_ExitInit( &priv->exit );
 
@@ -220,6 +222,12 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     vlc_CPU_dump( VLC_OBJECT(p_libvlc) );
 
+    if( var_InheritBool( p_libvlc, "block-pool" ) )
+    {
+        block_PoolEnable( true );
+        priv->block_pool = true;
+    }
+
     if( var_InheritBool( p_libvlc, "media-library") )
     {
         priv->p_media_library = libvlc_MlCreate( p_libvlc );
@@ -435,6 +443,18 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
 
     libvlc_InternalActionsClean( p_libvlc );
 
+    if( priv->block_pool )
+    {
+        struct block_pool_stats st;
+
+        block_PoolGetStats( &st );
+        msg_Dbg( p_libvlc, "block pool: %"PRIu64" allocations, %"PRIu64
+                 " recycled, %"PRIu64" released to the pool, %"PRIu64
+                 " freed, %zu bytes cached", st.allocs, st.hits, st.recycled,
+                 st.discarded, st.cached_bytes );
+        block_PoolEnable( false );
+    }
+
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
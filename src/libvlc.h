@@ -210,6 +210,7 @@ typedef struct libvlc_priv_t
     vlc_actions_t *actions; ///< Hotkeys handler
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
     struct vlc_thumbnailer_t *p_thumbnailer; ///< Lazily instantiated media thumbnailer
+    bool block_pool; ///< Whether this instance enabled the block pool
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -32,6 +32,7 @@
 #include <fcntl.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
 
@@ -105,6 +106,346 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/* 2 * BLOCK_PADDING: pre + post padding */
+#define BLOCK_ALLOC_SIZE(size) \
+    (sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING) + (size))
+
+/*** Block pool ***/
+
+/** Payload size classes of recycled blocks */
+static const size_t block_pool_sizes[] =
+{
+    188, /* MPEG-TS packet */
+    1316, /* 7 MPEG-TS packets, as in UDP or RTP datagrams */
+    4096, /* compressed audio and subtitles, small PES */
+    32768, /* PES and compressed video frames */
+};
+
+#define BLOCK_POOL_CLASSES ARRAY_SIZE(block_pool_sizes)
+
+/** Maximum blocks per class in a thread cache */
+#define BLOCK_POOL_THREAD_MAX 32
+/** Maximum bytes per class in the process-wide pool */
+#define BLOCK_POOL_GLOBAL_BYTES (4 << 20)
+
+struct block_pool_list
+{
+    block_t *head;
+    size_t count;
+};
+
+struct block_pool_depot
+{
+    vlc_mutex_t lock;
+    struct block_pool_list list;
+};
+
+struct block_pool_cache
+{
+    struct block_pool_list lists[BLOCK_POOL_CLASSES];
+};
+
+static struct block_pool_depot block_pool_depots[BLOCK_POOL_CLASSES] =
+{
+    { VLC_STATIC_MUTEX, { NULL, 0 } },
+    { VLC_STATIC_MUTEX, { NULL, 0 } },
+    { VLC_STATIC_MUTEX, { NULL, 0 } },
+    { VLC_STATIC_MUTEX, { NULL, 0 } },
+};
+static_assert (ARRAY_SIZE(block_pool_depots) == BLOCK_POOL_CLASSES,
+               "Block pool depots must match size classes");
+
+static atomic_bool block_pool_enabled = ATOMIC_VAR_INIT(false);
+static vlc_mutex_t block_pool_lock = VLC_STATIC_MUTEX;
+static unsigned block_pool_users; /* protected by block_pool_lock */
+static vlc_threadvar_t block_pool_key; /* never deleted, see block_pool_Init */
+static bool block_pool_key_valid;
+
+static struct
+{
+    atomic_uint_fast64_t allocs;
+    atomic_uint_fast64_t hits;
+    atomic_uint_fast64_t recycled;
+    atomic_uint_fast64_t discarded;
+    atomic_size_t cached_bytes;
+} block_pool_stats;
+
+static void block_pool_Push(struct block_pool_list *list, block_t *b)
+{
+    b->p_next = list->head;
+    list->head = b;
+    list->count++;
+}
+
+static block_t *block_pool_Pop(struct block_pool_list *list)
+{
+    block_t *b = list->head;
+
+    if (b != NULL)
+    {
+        list->head = b->p_next;
+        list->count--;
+    }
+    return b;
+}
+
+static void block_pool_Free(block_t *b, size_t n)
+{
+    while (b != NULL)
+    {
+        block_t *next = b->p_next;
+
+        free(b);
+        b = next;
+    }
+    atomic_fetch_add_explicit(&block_pool_stats.discarded, n,
+                              memory_order_relaxed);
+}
+
+/**
+ * Moves up to count blocks from a thread cache to the process-wide pool.
+ * Blocks that do not fit within the pool memory limit are freed.
+ */
+static void block_pool_Drain(struct block_pool_list *list, unsigned i,
+                             size_t count)
+{
+    struct block_pool_depot *depot = &block_pool_depots[i];
+    const size_t size = BLOCK_ALLOC_SIZE(block_pool_sizes[i]);
+    const size_t max = BLOCK_POOL_GLOBAL_BYTES / size;
+    block_t *dropped = NULL;
+    size_t n = 0;
+
+    vlc_mutex_lock(&depot->lock);
+    /* Checked with the lock held, so that blocks cannot be added to the pool
+     * after the pool was disabled and emptied. */
+    const bool enabled = atomic_load_explicit(&block_pool_enabled,
+                                              memory_order_relaxed);
+    while (count-- > 0 && list->head != NULL)
+    {
+        block_t *b = block_pool_Pop(list);
+
+        if (enabled && depot->list.count < max)
+            block_pool_Push(&depot->list, b);
+        else
+        {
+            b->p_next = dropped;
+            dropped = b;
+            n++;
+        }
+    }
+    vlc_mutex_unlock(&depot->lock);
+
+    if (n > 0)
+    {
+        atomic_fetch_sub_explicit(&block_pool_stats.cached_bytes, n * size,
+                                  memory_order_relaxed);
+        block_pool_Free(dropped, n);
+    }
+}
+
+static void block_pool_CacheRelease(void *data)
+{
+    struct block_pool_cache *cache = data;
+
+    for (unsigned i = 0; i < BLOCK_POOL_CLASSES; i++)
+        block_pool_Drain(&cache->lists[i], i, SIZE_MAX);
+    free(cache);
+}
+
+static struct block_pool_cache *block_pool_GetCache(void)
+{
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool_key);
+    if (cache == NULL)
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (unlikely(cache == NULL))
+            return NULL;
+        if (unlikely(vlc_threadvar_set(block_pool_key, cache)))
+        {
+            free(cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+static void block_pool_Release(block_t *b)
+{
+    assert(b->p_start == (unsigned char *)(b + 1));
+
+    unsigned i = 0;
+    while (BLOCK_ALLOC_SIZE(block_pool_sizes[i]) != sizeof (*b) + b->i_size)
+    {
+        i++;
+        assert(i < BLOCK_POOL_CLASSES);
+    }
+
+    struct block_pool_cache *cache = NULL;
+
+    if (atomic_load_explicit(&block_pool_enabled, memory_order_relaxed))
+        cache = block_pool_GetCache();
+    if (cache == NULL)
+    {
+        b->p_next = NULL;
+        block_pool_Free(b, 1);
+        return;
+    }
+
+    struct block_pool_list *list = &cache->lists[i];
+
+    block_pool_Push(list, b);
+    atomic_fetch_add_explicit(&block_pool_stats.recycled, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&block_pool_stats.cached_bytes,
+                              BLOCK_ALLOC_SIZE(block_pool_sizes[i]),
+                              memory_order_relaxed);
+
+    /* Blocks are typically allocated and released by different threads
+     * (e.g. demux and decoder): hand half of the cache over. */
+    if (list->count > BLOCK_POOL_THREAD_MAX)
+        block_pool_Drain(list, i, BLOCK_POOL_THREAD_MAX / 2);
+}
+
+static const struct vlc_block_callbacks block_pool_cbs =
+{
+    block_pool_Release,
+};
+
+static block_t *block_pool_Alloc(unsigned i)
+{
+    const size_t alloc = BLOCK_ALLOC_SIZE(block_pool_sizes[i]);
+    struct block_pool_cache *cache = block_pool_GetCache();
+    block_t *b = NULL;
+
+    atomic_fetch_add_explicit(&block_pool_stats.allocs, 1,
+                              memory_order_relaxed);
+
+    if (likely(cache != NULL))
+    {
+        struct block_pool_list *list = &cache->lists[i];
+
+        if (list->head == NULL)
+        {   /* Refill half of the thread cache from the process-wide pool */
+            struct block_pool_depot *depot = &block_pool_depots[i];
+
+            vlc_mutex_lock(&depot->lock);
+            for (size_t n = 0; n < BLOCK_POOL_THREAD_MAX / 2; n++)
+            {
+                block_t *r = block_pool_Pop(&depot->list);
+                if (r == NULL)
+                    break;
+                block_pool_Push(list, r);
+            }
+            vlc_mutex_unlock(&depot->lock);
+        }
+
+        b = block_pool_Pop(list);
+    }
+
+    if (b != NULL)
+    {
+        atomic_fetch_add_explicit(&block_pool_stats.hits, 1,
+                                  memory_order_relaxed);
+        atomic_fetch_sub_explicit(&block_pool_stats.cached_bytes, alloc,
+                                  memory_order_relaxed);
+    }
+    else
+    {
+        b = malloc(alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+    }
+
+    return block_Init(b, &block_pool_cbs, b + 1, alloc - sizeof (*b));
+}
+
+/**
+ * Creates the thread cache key.
+ *
+ * The key is never deleted: threads may still own a cache when the pool is
+ * disabled, and each cache is released by the key destructor when its thread
+ * exits.
+ */
+static void block_pool_Init(void)
+{
+    block_pool_key_valid = !vlc_threadvar_create(&block_pool_key,
+                                                 block_pool_CacheRelease);
+}
+
+/**
+ * Frees the blocks of the process-wide pool, and those cached by the calling
+ * thread. The pool must have been disabled already.
+ */
+static void block_pool_Flush(void)
+{
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool_key);
+
+    for (unsigned i = 0; i < BLOCK_POOL_CLASSES; i++)
+    {
+        struct block_pool_depot *depot = &block_pool_depots[i];
+        struct block_pool_list list;
+
+        if (cache != NULL)
+            block_pool_Drain(&cache->lists[i], i, SIZE_MAX);
+
+        vlc_mutex_lock(&depot->lock);
+        list = depot->list;
+        depot->list.head = NULL;
+        depot->list.count = 0;
+        vlc_mutex_unlock(&depot->lock);
+
+        if (list.count > 0)
+        {
+            atomic_fetch_sub_explicit(&block_pool_stats.cached_bytes,
+                list.count * BLOCK_ALLOC_SIZE(block_pool_sizes[i]),
+                memory_order_relaxed);
+            block_pool_Free(list.head, list.count);
+        }
+    }
+}
+
+void block_PoolEnable(bool enabled)
+{
+    static vlc_once_t once = VLC_STATIC_ONCE;
+
+    vlc_once(&once, block_pool_Init);
+
+    vlc_mutex_lock(&block_pool_lock);
+    if (enabled)
+    {
+        /* Users are counted even if the key could not be created, so that
+         * enabling and disabling calls remain paired. */
+        if (block_pool_users++ == 0 && block_pool_key_valid)
+            atomic_store_explicit(&block_pool_enabled, true,
+                                  memory_order_relaxed);
+    }
+    else
+    {
+        assert(block_pool_users > 0);
+        if (--block_pool_users == 0 && block_pool_key_valid)
+        {
+            atomic_store_explicit(&block_pool_enabled, false,
+                                  memory_order_relaxed);
+            block_pool_Flush();
+        }
+    }
+    vlc_mutex_unlock(&block_pool_lock);
+}
+
+void block_PoolGetStats(struct block_pool_stats *st)
+{
+    st->allocs = atomic_load_explicit(&block_pool_stats.allocs,
+                                      memory_order_relaxed);
+    st->hits = atomic_load_explicit(&block_pool_stats.hits,
+                                    memory_order_relaxed);
+    st->recycled = atomic_load_explicit(&block_pool_stats.recycled,
+                                        memory_order_relaxed);
+    st->discarded = atomic_load_explicit(&block_pool_stats.discarded,
+                                         memory_order_relaxed);
+    st->cached_bytes = atomic_load_explicit(&block_pool_stats.cached_bytes,
+                                            memory_order_relaxed);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -113,17 +454,33 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
-    /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
-    if (unlikely(alloc <= size))
-        return NULL;
+    block_t *b = NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    if (atomic_load_explicit(&block_pool_enabled, memory_order_relaxed))
+    {
+        for (unsigned i = 0; i < BLOCK_POOL_CLASSES; i++)
+            if (size <= block_pool_sizes[i])
+            {
+                b = block_pool_Alloc(i);
+                if (unlikely(b == NULL))
+                    return NULL;
+                break;
+            }
+    }
+
+    if (b == NULL)
+    {
+        const size_t alloc = BLOCK_ALLOC_SIZE(size);
+        if (unlikely(alloc <= size))
+            return NULL;
+
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    }
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
@@ -141,6 +498,102 @@ void block_Release(block_t *block)
     block->cbs->free(block);
 }
 
+/**
+ * Shared block payload.
+ *
+ * The first block passed to block_Share() (the origin) keeps owning the
+ * memory. Every view of the payload, including the origin itself, points to
+ * the embedded callbacks, so that the payload owner can be found back from
+ * any view with container_of().
+ */
+struct block_shared
+{
+    struct vlc_block_callbacks cbs;
+    vlc_atomic_rc_t rc;
+    block_t *origin;
+    const struct vlc_block_callbacks *origin_cbs;
+    uint8_t *origin_start;
+    size_t origin_size;
+};
+
+static void block_shared_Release(block_t *block)
+{
+    struct block_shared *sh = container_of(block->cbs, struct block_shared,
+                                           cbs);
+
+    if (block != sh->origin)
+        free(block);
+
+    if (!vlc_atomic_rc_dec(&sh->rc))
+        return;
+
+    block_t *origin = sh->origin;
+
+    origin->p_start = sh->origin_start;
+    origin->i_size = sh->origin_size;
+    origin->cbs = sh->origin_cbs;
+    free(sh);
+    origin->cbs->free(origin);
+}
+
+static bool block_IsShared(const block_t *block)
+{
+    if (block->cbs->free != block_shared_Release)
+        return false;
+
+    struct block_shared *sh = container_of(block->cbs, struct block_shared,
+                                           cbs);
+    return atomic_load_explicit(&sh->rc.refs, memory_order_acquire) > 1;
+}
+
+block_t *block_Share(block_t *block)
+{
+    struct block_shared *sh;
+
+    block_Check(block);
+
+    if (block->cbs->free == block_shared_Release)
+        sh = container_of(block->cbs, struct block_shared, cbs);
+    else
+    {
+        sh = malloc(sizeof (*sh));
+        if (unlikely(sh == NULL))
+            return NULL;
+
+        sh->cbs.free = block_shared_Release;
+        vlc_atomic_rc_init(&sh->rc);
+        sh->origin = block;
+        sh->origin_cbs = block->cbs;
+        sh->origin_start = block->p_start;
+        sh->origin_size = block->i_size;
+
+        /* Views must not write past their payload: the spare space around it
+         * is shared as well. Strip it so that block_Realloc() copies. */
+        block->p_start = block->p_buffer;
+        block->i_size = block->i_buffer;
+        block->cbs = &sh->cbs;
+    }
+
+    block_t *view = malloc(sizeof (*view));
+    if (unlikely(view == NULL))
+        return NULL;
+
+    block_Init(view, &sh->cbs, block->p_buffer, block->i_buffer);
+    block_CopyProperties(view, block);
+    vlc_atomic_rc_inc(&sh->rc);
+    return view;
+}
+
+block_t *block_MakeWritable(block_t *block)
+{
+    if (!block_IsShared(block))
+        return block;
+
+    block_t *dup = block_Duplicate(block);
+    block_Release(block);
+    return dup;
+}
+
 block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 {
     block_Check( p_block );
@@ -177,7 +630,7 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !block_IsShared( p_block ) )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -199,10 +652,13 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     uint8_t *p_start = p_block->p_start;
     uint8_t *p_end = p_start + p_block->i_size;
 
-    /* Second, reallocate the buffer if we lack space. */
+    /* Second, reallocate the buffer if we lack space, or if the spare space
+     * belongs to a payload shared with other blocks (copy-on-write). */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || ((i_prebody > 0 || i_body > p_block->i_buffer)
+         && block_IsShared( p_block )) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
@@ -26,6 +26,7 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -44,11 +45,64 @@ struct block_fifo_t
     block_t             **pp_last;
     size_t              i_depth;
     size_t              i_size;
+
+    /* Lock-less single producer ring (NULL if not enabled). Blocks are
+     * moved from the ring to the list by whoever holds the lock. */
+    block_t             **ring;
+    atomic_uint         ring_head; /**< next slot to collect */
+    atomic_uint         ring_tail; /**< next slot to fill */
+    atomic_flag         producing; /**< a producer is filling the ring */
+    atomic_bool         waiting;   /**< a thread waits for data */
+    atomic_size_t       bytes;     /**< i_size plus the bytes in the ring */
 };
 
+#define FIFO_RING_SIZE 256
+
+/* Returns the number of bytes appended */
+static size_t vlc_fifo_AppendUnlocked(vlc_fifo_t *fifo, block_t *block)
+{
+    size_t size = fifo->i_size;
+
+    assert(*(fifo->pp_last) == NULL);
+
+    *(fifo->pp_last) = block;
+
+    while (block != NULL)
+    {
+        fifo->pp_last = &block->p_next;
+        fifo->i_depth++;
+        fifo->i_size += block->i_buffer;
+
+        block = block->p_next;
+    }
+    return fifo->i_size - size;
+}
+
+/* Moves the blocks queued without the lock at the end of the list */
+static void vlc_fifo_Collect(vlc_fifo_t *fifo)
+{
+    vlc_mutex_assert(&fifo->lock);
+
+    if (fifo->ring == NULL)
+        return;
+
+    unsigned head = atomic_load_explicit(&fifo->ring_head,
+                                         memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&fifo->ring_tail,
+                                         memory_order_acquire);
+    if (head == tail)
+        return;
+
+    for (; head != tail; head++)
+        vlc_fifo_AppendUnlocked(fifo, fifo->ring[head % FIFO_RING_SIZE]);
+
+    atomic_store_explicit(&fifo->ring_head, head, memory_order_release);
+}
+
 void vlc_fifo_Lock(vlc_fifo_t *fifo)
 {
     vlc_mutex_lock(&fifo->lock);
+    vlc_fifo_Collect(fifo);
 }
 
 void vlc_fifo_Unlock(vlc_fifo_t *fifo)
@@ -62,6 +116,26 @@ void vlc_fifo_Signal(vlc_fifo_t *fifo)
 }
 
 void vlc_fifo_Wait(vlc_fifo_t *fifo)
+{
+    if (fifo->ring != NULL)
+    {
+        /* Pairs with the lock-less producer: either it sees the flag and
+         * signals, or the block it queued is seen here. */
+        atomic_store(&fifo->waiting, true);
+        if (atomic_load(&fifo->ring_tail) != atomic_load(&fifo->ring_head))
+        {
+            atomic_store_explicit(&fifo->waiting, false, memory_order_relaxed);
+            vlc_fifo_Collect(fifo);
+            return; /* spurious wakeup */
+        }
+        vlc_fifo_WaitCond(fifo, &fifo->wait);
+        atomic_store_explicit(&fifo->waiting, false, memory_order_relaxed);
+        return;
+    }
+    vlc_fifo_WaitCond(fifo, &fifo->wait);
+}
+
+void vlc_fifo_WaitSignal(vlc_fifo_t *fifo)
 {
     vlc_fifo_WaitCond(fifo, &fifo->wait);
 }
@@ -69,11 +143,14 @@ void vlc_fifo_Wait(vlc_fifo_t *fifo)
 void vlc_fifo_WaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar)
 {
     vlc_cond_wait(condvar, &fifo->lock);
+    vlc_fifo_Collect(fifo);
 }
 
 int vlc_fifo_TimedWaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar, vlc_tick_t deadline)
 {
-    return vlc_cond_timedwait(condvar, &fifo->lock, deadline);
+    int ret = vlc_cond_timedwait(condvar, &fifo->lock, deadline);
+    vlc_fifo_Collect(fifo);
+    return ret;
 }
 
 size_t vlc_fifo_GetCount(const vlc_fifo_t *fifo)
@@ -88,23 +165,76 @@ size_t vlc_fifo_GetBytes(const vlc_fifo_t *fifo)
     return fifo->i_size;
 }
 
+size_t vlc_fifo_GetBytesLockless(const vlc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->bytes, memory_order_relaxed);
+}
+
 void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
 {
     vlc_mutex_assert(&fifo->lock);
-    assert(*(fifo->pp_last) == NULL);
 
-    *(fifo->pp_last) = block;
+    atomic_fetch_add_explicit(&fifo->bytes,
+                              vlc_fifo_AppendUnlocked(fifo, block),
+                              memory_order_relaxed);
+    vlc_fifo_Signal(fifo);
+}
 
-    while (block != NULL)
+/* Wakes the consumer up only if it waits for data, and only once for all
+ * the blocks queued until it runs again */
+static void vlc_fifo_WakeLockless(vlc_fifo_t *fifo)
+{
+    if (atomic_load(&fifo->waiting)
+     && atomic_exchange(&fifo->waiting, false))
     {
-        fifo->pp_last = &block->p_next;
-        fifo->i_depth++;
-        fifo->i_size += block->i_buffer;
+        vlc_mutex_lock(&fifo->lock);
+        vlc_fifo_Signal(fifo);
+        vlc_mutex_unlock(&fifo->lock);
+    }
+}
 
-        block = block->p_next;
+void vlc_fifo_QueueLockless(vlc_fifo_t *fifo, block_t *block)
+{
+    /* Only one producer may use the ring at a time, others take the lock */
+    if (fifo->ring == NULL
+     || atomic_flag_test_and_set_explicit(&fifo->producing,
+                                          memory_order_acquire))
+    {
+        block_FifoPut(fifo, block);
+        return;
     }
 
-    vlc_fifo_Signal(fifo);
+    unsigned tail = atomic_load_explicit(&fifo->ring_tail,
+                                         memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&fifo->ring_head,
+                                         memory_order_acquire);
+
+    size_t size = 0;
+
+    while (block != NULL && tail - head < FIFO_RING_SIZE)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        size += block->i_buffer;
+        fifo->ring[tail++ % FIFO_RING_SIZE] = block;
+        block = next;
+    }
+    atomic_fetch_add_explicit(&fifo->bytes, size, memory_order_relaxed);
+    atomic_store(&fifo->ring_tail, tail);
+    atomic_flag_clear_explicit(&fifo->producing, memory_order_release);
+
+    if (block != NULL)
+    {   /* Ring full: the consumer is late (or paused), queue the rest with
+         * the lock, still without waking it up needlessly */
+        vlc_fifo_Lock(fifo);
+        atomic_fetch_add_explicit(&fifo->bytes,
+                                  vlc_fifo_AppendUnlocked(fifo, block),
+                                  memory_order_relaxed);
+        vlc_fifo_Unlock(fifo);
+    }
+
+    vlc_fifo_WakeLockless(fifo);
 }
 
 block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
@@ -125,6 +255,8 @@ block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
     fifo->i_depth--;
     assert(fifo->i_size >= block->i_buffer);
     fifo->i_size -= block->i_buffer;
+    atomic_fetch_sub_explicit(&fifo->bytes, block->i_buffer,
+                              memory_order_relaxed);
 
     return block;
 }
@@ -135,6 +267,8 @@ block_t *vlc_fifo_DequeueAllUnlocked(block_fifo_t *fifo)
 
     block_t *block = fifo->p_first;
 
+    atomic_fetch_sub_explicit(&fifo->bytes, fifo->i_size,
+                              memory_order_relaxed);
     fifo->p_first = NULL;
     fifo->pp_last = &fifo->p_first;
     fifo->i_depth = 0;
@@ -155,11 +289,38 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->pp_last = &p_fifo->p_first;
     p_fifo->i_depth = p_fifo->i_size = 0;
 
+    p_fifo->ring = NULL;
+    atomic_init( &p_fifo->ring_head, 0 );
+    atomic_init( &p_fifo->ring_tail, 0 );
+    atomic_flag_clear( &p_fifo->producing );
+    atomic_init( &p_fifo->waiting, false );
+    atomic_init( &p_fifo->bytes, 0 );
+
+    return p_fifo;
+}
+
+block_fifo_t *block_FifoNewLockless( void )
+{
+    block_fifo_t *p_fifo = block_FifoNew();
+    if( !p_fifo )
+        return NULL;
+
+    p_fifo->ring = vlc_alloc( FIFO_RING_SIZE, sizeof( *p_fifo->ring ) );
+    if( !p_fifo->ring )
+    {
+        block_FifoRelease( p_fifo );
+        return NULL;
+    }
     return p_fifo;
 }
 
 void block_FifoRelease( block_fifo_t *p_fifo )
 {
+    vlc_mutex_lock( &p_fifo->lock );
+    vlc_fifo_Collect( p_fifo );
+    vlc_mutex_unlock( &p_fifo->lock );
+    free( p_fifo->ring );
+
     block_ChainRelease( p_fifo->p_first );
     vlc_cond_destroy( &p_fifo->wait );
     vlc_mutex_destroy( &p_fifo->lock );
@@ -206,10 +367,10 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 {
     block_t *b;
 
-    vlc_mutex_lock( &p_fifo->lock );
+    vlc_fifo_Lock( p_fifo );
     assert(p_fifo->p_first != NULL);
     b = p_fifo->p_first;
-    vlc_mutex_unlock( &p_fifo->lock );
+    vlc_fifo_Unlock( p_fifo );
 
     return b;
 }
@@ -219,9 +380,9 @@ size_t block_FifoSize (block_fifo_t *fifo)
 {
     size_t size;
 
-    vlc_mutex_lock (&fifo->lock);
+    vlc_fifo_Lock (fifo);
     size = fifo->i_size;
-    vlc_mutex_unlock (&fifo->lock);
+    vlc_fifo_Unlock (fifo);
     return size;
 }
 
@@ -230,8 +391,8 @@ size_t block_FifoCount (block_fifo_t *fifo)
 {
     size_t depth;
 
-    vlc_mutex_lock (&fifo->lock);
+    vlc_fifo_Lock (fifo);
     depth = fifo->i_depth;
-    vlc_mutex_unlock (&fifo->lock);
+    vlc_fifo_Unlock (fifo);
     return depth;
 }
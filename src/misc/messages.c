@@ -37,6 +37,7 @@
 #include <assert.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
@@ -440,6 +441,300 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * A message log that formats the messages in the calling thread, queues them
+ * in a bounded lock-free ring, and passes them to another log from a
+ * dedicated thread. The other log filters the messages on that thread, as
+ * the verbosity of each log module is its own. Messages are dropped rather
+ * than waited for when the ring is full, and debug messages can be rate
+ * limited per module.
+ */
+#define LOG_ASYNC_SLOTS     1024 /* power of two */
+#define LOG_ASYNC_DBG_SLOTS (LOG_ASYNC_SLOTS * 3 / 4) /* room for the others */
+#define LOG_ASYNC_TEXT_SIZE 232
+#define LOG_ASYNC_MODULES   64   /* rate limiting buckets */
+
+typedef struct vlc_log_async_t
+{
+    atomic_size_t seq;
+    int type;
+    vlc_log_t meta;
+    char *msg; /**< heap copy of long messages, or NULL */
+    char module[32];
+    char text[LOG_ASYNC_TEXT_SIZE];
+} vlc_log_async_t;
+
+struct vlc_logger_async {
+    struct vlc_logger logger;
+    struct vlc_logger *sink;
+    unsigned rate_limit;
+
+    atomic_size_t tail; /**< next slot to write */
+    atomic_size_t head; /**< next slot to read, written by the thread only */
+
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    atomic_bool sleeping;
+    bool dead;
+
+    atomic_uint dropped;
+    atomic_uint limited;
+    struct vlc_log_async_bucket {
+        atomic_uint second;
+        atomic_uint count;
+    } modules[LOG_ASYNC_MODULES];
+
+    vlc_log_async_t slots[LOG_ASYNC_SLOTS];
+};
+
+static bool vlc_LogAsyncRateLimited(struct vlc_logger_async *async,
+                                    const char *module)
+{
+    unsigned hash = 0;
+
+    while (*module != '\0')
+        hash = hash * 31 + (unsigned char)*(module++);
+
+    /* Modules colliding in a bucket share the same budget */
+    struct vlc_log_async_bucket *bucket =
+        &async->modules[hash % LOG_ASYNC_MODULES];
+    unsigned now = SEC_FROM_VLC_TICK(vlc_tick_now());
+    unsigned second = atomic_load_explicit(&bucket->second,
+                                           memory_order_relaxed);
+
+    if (second != now
+     && atomic_compare_exchange_strong_explicit(&bucket->second, &second, now,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        atomic_store_explicit(&bucket->count, 0, memory_order_relaxed);
+
+    return atomic_fetch_add_explicit(&bucket->count, 1, memory_order_relaxed)
+           >= async->rate_limit;
+}
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+
+    if (type == VLC_MSG_DBG && async->rate_limit > 0
+     && vlc_LogAsyncRateLimited(async, item->psz_module)) {
+        atomic_fetch_add_explicit(&async->limited, 1, memory_order_relaxed);
+        return;
+    }
+
+    /* Reserve a slot (bounded multiple producers queue) */
+    size_t pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    vlc_log_async_t *log;
+
+    for (;;) {
+        log = &async->slots[pos % LOG_ASYNC_SLOTS];
+
+        size_t seq = atomic_load_explicit(&log->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0) {
+            /* Debug messages cannot fill the ring up, so that errors,
+             * warnings and information messages are dropped last */
+            if (type == VLC_MSG_DBG
+             && pos - atomic_load_explicit(&async->head, memory_order_relaxed)
+                >= LOG_ASYNC_DBG_SLOTS) {
+                atomic_fetch_add_explicit(&async->dropped, 1,
+                                          memory_order_relaxed);
+                return;
+            }
+            if (atomic_compare_exchange_weak_explicit(&async->tail, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* The ring is full */
+            atomic_fetch_add_explicit(&async->dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        } else
+            pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    }
+
+    /* Format the message now, as its arguments do not outlive the call */
+    va_list aq;
+    va_copy(aq, ap);
+    int len = vsnprintf(log->text, sizeof (log->text), format, aq);
+    va_end(aq);
+
+    log->msg = NULL;
+    if (len < 0)
+        strcpy(log->text, "message lost");
+    else if ((size_t)len >= sizeof (log->text)) {
+        log->msg = malloc(len + 1);
+        if (likely(log->msg != NULL))
+            vsnprintf(log->msg, len + 1, format, ap);
+    }
+
+    log->type = type;
+    log->meta = *item;
+    /* NOTE: Object types, file and function names are static constants, but
+     * the module name can be on the stack of the caller. */
+    strlcpy(log->module, item->psz_module, sizeof (log->module));
+    log->meta.psz_module = log->module;
+    log->meta.psz_header = item->psz_header ? strdup(item->psz_header) : NULL;
+
+    atomic_store_explicit(&log->seq, pos + 1, memory_order_release);
+
+    /* Wake the thread up only if it went to sleep */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&async->sleeping, memory_order_relaxed)) {
+        vlc_mutex_lock(&async->lock);
+        vlc_cond_signal(&async->wait);
+        vlc_mutex_unlock(&async->lock);
+    }
+}
+
+static bool vlc_LogAsyncPending(struct vlc_logger_async *async)
+{
+    size_t head = atomic_load_explicit(&async->head, memory_order_relaxed);
+    const vlc_log_async_t *log = &async->slots[head % LOG_ASYNC_SLOTS];
+
+    /* False if empty, or if the message is still being formatted */
+    return atomic_load_explicit(&log->seq, memory_order_acquire) == head + 1;
+}
+
+static bool vlc_LogAsyncDequeue(struct vlc_logger_async *async)
+{
+    size_t head = atomic_load_explicit(&async->head, memory_order_relaxed);
+    vlc_log_async_t *log = &async->slots[head % LOG_ASYNC_SLOTS];
+
+    if (!vlc_LogAsyncPending(async))
+        return false;
+
+    vlc_LogCallback(async->sink, log->type, &log->meta, "%s",
+                    (log->msg != NULL) ? log->msg : log->text);
+    free(log->msg);
+    free((char *)log->meta.psz_header);
+
+    atomic_store_explicit(&log->seq, head + LOG_ASYNC_SLOTS,
+                          memory_order_release);
+    atomic_store_explicit(&async->head, head + 1, memory_order_relaxed);
+    return true;
+}
+
+static void vlc_LogAsyncReportDrops(struct vlc_logger_async *async)
+{
+    static const vlc_log_t meta = {
+        .psz_object_type = "logger",
+        .psz_module = "main",
+        .file = __FILE__,
+        .line = __LINE__,
+        .func = __func__,
+    };
+    unsigned dropped = atomic_exchange(&async->dropped, 0);
+    unsigned limited = atomic_exchange(&async->limited, 0);
+
+    if (dropped > 0)
+        vlc_LogCallback(async->sink, VLC_MSG_WARN, &meta,
+                        "%u log messages dropped", dropped);
+    if (limited > 0)
+        vlc_LogCallback(async->sink, VLC_MSG_DBG, &meta,
+                        "%u debug messages rate limited", limited);
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+    bool dead;
+
+    do {
+        while (vlc_LogAsyncDequeue(async));
+        vlc_LogAsyncReportDrops(async);
+
+        vlc_mutex_lock(&async->lock);
+        atomic_store_explicit(&async->sleeping, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        /* Check again, a message may have been queued before the flag was
+         * visible to its writer. */
+        dead = async->dead;
+        if (!dead && !vlc_LogAsyncPending(async))
+            vlc_cond_timedwait(&async->wait, &async->lock,
+                               vlc_tick_now() + VLC_TICK_FROM_MS(100));
+        atomic_store_explicit(&async->sleeping, false, memory_order_relaxed);
+        vlc_mutex_unlock(&async->lock);
+    } while (!dead);
+
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+    struct vlc_logger *sink = async->sink;
+
+    vlc_mutex_lock(&async->lock);
+    async->dead = true;
+    vlc_cond_signal(&async->wait);
+    vlc_mutex_unlock(&async->lock);
+    vlc_join(async->thread, NULL);
+
+    /* Drain the remaining messages, if any */
+    while (vlc_LogAsyncDequeue(async));
+    vlc_LogAsyncReportDrops(async);
+
+    vlc_cond_destroy(&async->wait);
+    vlc_mutex_destroy(&async->lock);
+    free(async);
+    sink->ops->destroy(sink);
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+};
+
+static struct vlc_logger *vlc_LogAsyncCreate(vlc_object_t *obj,
+                                             struct vlc_logger *sink)
+{
+    if (sink == &discard_log || !var_InheritBool(obj, "log-async"))
+        return sink;
+
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return sink;
+
+    async->logger.ops = &async_ops;
+    async->sink = sink;
+    async->rate_limit = var_InheritInteger(obj, "log-rate-limit");
+    atomic_init(&async->tail, 0);
+    atomic_init(&async->head, 0);
+    vlc_mutex_init(&async->lock);
+    vlc_cond_init(&async->wait);
+    atomic_init(&async->sleeping, false);
+    async->dead = false;
+    atomic_init(&async->dropped, 0);
+    atomic_init(&async->limited, 0);
+    for (size_t i = 0; i < LOG_ASYNC_MODULES; i++) {
+        atomic_init(&async->modules[i].second, 0);
+        atomic_init(&async->modules[i].count, 0);
+    }
+    for (size_t i = 0; i < LOG_ASYNC_SLOTS; i++)
+        atomic_init(&async->slots[i].seq, i);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW)) {
+        vlc_cond_destroy(&async->wait);
+        vlc_mutex_destroy(&async->lock);
+        free(async);
+        return sink;
+    }
+    return &async->logger;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -449,6 +744,7 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    logger = vlc_LogAsyncCreate(VLC_OBJECT(vlc), logger);
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
@@ -579,6 +875,7 @@ void vlc_LogSet(libvlc_int_t *vlc, const struct vlc_logger_operations *ops,
 
     if (logger == NULL)
         logger = &discard_log;
+    logger = vlc_LogAsyncCreate(VLC_OBJECT(vlc), logger);
 
     vlc_LogSwitch(vlc->obj.logger, logger);
     vlc_LogSpam(VLC_OBJECT(vlc));
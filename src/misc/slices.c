@@ -0,0 +1,233 @@
+/*****************************************************************************
+ * slices.c: slice-parallel picture processing
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+#include <vlc_slices.h>
+
+#define SLICES_MAX 16
+
+/* A run of vlc_slices_Run(), queued until all its slices are handed out */
+struct vlc_slices_job
+{
+    struct vlc_list node;
+    vlc_slices_cb   cb;
+    void           *opaque;
+    unsigned        count;
+    unsigned        next;    /* next slice to hand out */
+    unsigned        pending; /* slices not processed yet */
+    vlc_cond_t      done;
+};
+
+/* Worker threads, shared by all the slicing contexts */
+struct vlc_slices_pool
+{
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;
+    struct vlc_list jobs;
+    bool            quit;
+    unsigned        refs;
+    unsigned        threads;
+    vlc_thread_t    thread[SLICES_MAX - 1];
+};
+
+struct vlc_slices
+{
+    struct vlc_slices_pool *pool; /* NULL if single-threaded */
+    unsigned count;
+};
+
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+static struct vlc_slices_pool *pool_instance = NULL;
+
+/* Processes the next slice of a job, with the pool lock held */
+static void ProcessSlice(struct vlc_slices_pool *pool,
+                         struct vlc_slices_job *job)
+{
+    unsigned slice = job->next++;
+
+    assert(slice < job->count);
+    if (job->next == job->count)
+        vlc_list_remove(&job->node);
+
+    vlc_mutex_unlock(&pool->lock);
+    job->cb(job->opaque, slice, job->count);
+    vlc_mutex_lock(&pool->lock);
+
+    if (--job->pending == 0)
+        vlc_cond_signal(&job->done);
+}
+
+static void *Thread(void *data)
+{
+    struct vlc_slices_pool *pool = data;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        struct vlc_slices_job *job;
+
+        while ((job = vlc_list_first_entry_or_null(&pool->jobs,
+                                struct vlc_slices_job, node)) == NULL)
+        {
+            if (pool->quit)
+                goto out;
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        }
+        ProcessSlice(pool, job);
+    }
+out:
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static struct vlc_slices_pool *PoolHold(void)
+{
+    struct vlc_slices_pool *pool;
+
+    vlc_mutex_lock(&pool_lock);
+    pool = pool_instance;
+    if (pool == NULL)
+    {
+        pool = malloc(sizeof (*pool));
+        if (unlikely(pool == NULL))
+            goto out;
+
+        vlc_mutex_init(&pool->lock);
+        vlc_cond_init(&pool->wait);
+        vlc_list_init(&pool->jobs);
+        pool->quit = false;
+        pool->refs = 0;
+        pool->threads = 0;
+
+        /* The threads running vlc_slices_Run() process slices too */
+        unsigned threads = VLC_CLIP(vlc_GetCPUCount(), 2, SLICES_MAX) - 1;
+
+        while (pool->threads < threads
+            && vlc_clone(&pool->thread[pool->threads], Thread, pool,
+                         VLC_THREAD_PRIORITY_VIDEO) == 0)
+            pool->threads++;
+
+        if (pool->threads == 0)
+        {
+            vlc_cond_destroy(&pool->wait);
+            vlc_mutex_destroy(&pool->lock);
+            free(pool);
+            pool = NULL;
+            goto out;
+        }
+        pool_instance = pool;
+    }
+    pool->refs++;
+out:
+    vlc_mutex_unlock(&pool_lock);
+    return pool;
+}
+
+static void PoolRelease(struct vlc_slices_pool *pool)
+{
+    vlc_mutex_lock(&pool_lock);
+    assert(pool == pool_instance);
+    if (--pool->refs == 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        assert(vlc_list_is_empty(&pool->jobs));
+        pool->quit = true;
+        vlc_cond_broadcast(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+
+        for (unsigned i = 0; i < pool->threads; i++)
+            vlc_join(pool->thread[i], NULL);
+
+        vlc_cond_destroy(&pool->wait);
+        vlc_mutex_destroy(&pool->lock);
+        free(pool);
+        pool_instance = NULL;
+    }
+    vlc_mutex_unlock(&pool_lock);
+}
+
+#undef vlc_slices_New
+vlc_slices_t *vlc_slices_New(vlc_object_t *obj)
+{
+    vlc_slices_t *slices = malloc(sizeof (*slices));
+    if (unlikely(slices == NULL))
+        return NULL;
+
+    int64_t count = var_InheritInteger(obj, "video-filter-threads");
+    if (count <= 0)
+        count = vlc_GetCPUCount();
+
+    slices->count = VLC_CLIP(count, 1, SLICES_MAX);
+    slices->pool = (slices->count > 1) ? PoolHold() : NULL;
+    return slices;
+}
+
+void vlc_slices_Delete(vlc_slices_t *slices)
+{
+    if (slices->pool != NULL)
+        PoolRelease(slices->pool);
+    free(slices);
+}
+
+unsigned vlc_slices_Count(const vlc_slices_t *slices)
+{
+    return slices->count;
+}
+
+void vlc_slices_Run(vlc_slices_t *slices, vlc_slices_cb cb, void *opaque)
+{
+    struct vlc_slices_pool *pool = slices->pool;
+
+    if (pool == NULL)
+    {
+        for (unsigned i = 0; i < slices->count; i++)
+            cb(opaque, i, slices->count);
+        return;
+    }
+
+    struct vlc_slices_job job = {
+        .cb = cb,
+        .opaque = opaque,
+        .count = slices->count,
+        .next = 0,
+        .pending = slices->count,
+    };
+
+    vlc_cond_init(&job.done);
+    vlc_mutex_lock(&pool->lock);
+    vlc_list_append(&job.node, &pool->jobs);
+    vlc_cond_broadcast(&pool->wait);
+
+    while (job.next < job.count)
+        ProcessSlice(pool, &job);
+    while (job.pending > 0)
+        vlc_cond_wait(&job.done, &pool->lock);
+
+    vlc_mutex_unlock(&pool->lock);
+    vlc_cond_destroy(&job.done);
+}
@@ -23,6 +23,10 @@
 struct subpicture_region_private_t {
     video_format_t fmt;
     picture_t      *p_picture;
+
+    /* What the picture was converted from, to detect content changes */
+    video_format_t source_fmt;
+    picture_t      *p_source;
 };
 
 subpicture_region_t * subpicture_region_NewInternal( const video_format_t *p_fmt );
@@ -27,9 +27,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -67,7 +64,9 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     i_hash;   /**< Hash of the name */
+    variable_t  *p_next;   /**< Next variable in the same hash bucket */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -136,23 +135,116 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+#define VAR_FILTER_BITS (4 * 64)
+
+static uint32_t VarHash( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    for( const unsigned char *p = (const unsigned char *)psz_name; *p; p++ )
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
+}
+
+static void FilterAdd( vlc_object_internals_t *priv, uint32_t hash )
+{
+    unsigned bit = hash % VAR_FILTER_BITS;
+
+    atomic_fetch_or_explicit( &priv->var_filter[bit / 64],
+                              UINT64_C(1) << (bit % 64),
+                              memory_order_release );
+}
+
+/**
+ * Checks if an object may have a variable, without locking it.
+ * This never fails for a variable that was created before the call.
+ */
+static bool FilterMayContain( vlc_object_internals_t *priv, uint32_t hash )
+{
+    unsigned bit = hash % VAR_FILTER_BITS;
+    uint_least64_t word = atomic_load_explicit( &priv->var_filter[bit / 64],
+                                                memory_order_acquire );
+    return (word >> (bit % 64)) & 1;
+}
+
+static variable_t *LookupLocked( vlc_object_internals_t *priv,
+                                 const char *psz_name, uint32_t hash )
+{
+    vlc_mutex_assert( &priv->var_lock );
+
+    if( priv->var_count == 0 )
+        return NULL;
+
+    variable_t *var = priv->var_table[hash & (priv->var_buckets - 1)];
+    while( var != NULL
+        && (var->i_hash != hash || strcmp( var->psz_name, psz_name )) )
+        var = var->p_next;
+    return var;
 }
 
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    void **pp_var;
+    uint32_t hash = VarHash( psz_name );
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    return LookupLocked( priv, psz_name, hash );
+}
+
+static int Insert( vlc_object_internals_t *priv, variable_t *var )
+{
+    vlc_mutex_assert( &priv->var_lock );
+
+    if( priv->var_count >= priv->var_buckets )
+    {   /* Keep less than one variable per bucket on average */
+        size_t buckets = priv->var_buckets ? 2 * priv->var_buckets : 16;
+        variable_t **table = calloc( buckets, sizeof (*table) );
+        if( unlikely(table == NULL) )
+            return VLC_ENOMEM;
+
+        for( size_t i = 0; i < priv->var_buckets; i++ )
+            for( variable_t *v = priv->var_table[i], *next; v != NULL; v = next )
+            {
+                next = v->p_next;
+                v->p_next = table[v->i_hash & (buckets - 1)];
+                table[v->i_hash & (buckets - 1)] = v;
+            }
+
+        free( priv->var_table );
+        priv->var_table = table;
+        priv->var_buckets = buckets;
+    }
+
+    variable_t **pp = &priv->var_table[var->i_hash & (priv->var_buckets - 1)];
+    var->p_next = *pp;
+    *pp = var;
+    priv->var_count++;
+    FilterAdd( priv, var->i_hash );
+    return VLC_SUCCESS;
+}
+
+static void Remove( vlc_object_internals_t *priv, variable_t *var )
+{
+    vlc_mutex_assert( &priv->var_lock );
+
+    variable_t **pp = &priv->var_table[var->i_hash & (priv->var_buckets - 1)];
+    while( *pp != var )
+        pp = &(*pp)->p_next;
+    *pp = var->p_next;
+    priv->var_count--;
+
+    /* Rebuild the filter, without the removed name */
+    uint_least64_t filter[4] = { 0, 0, 0, 0 };
+    for( size_t i = 0; i < priv->var_buckets; i++ )
+        for( variable_t *v = priv->var_table[i]; v != NULL; v = v->p_next )
+        {
+            unsigned bit = v->i_hash % VAR_FILTER_BITS;
+            filter[bit / 64] |= UINT64_C(1) << (bit % 64);
+        }
+    for( size_t i = 0; i < ARRAY_SIZE(filter); i++ )
+        atomic_store_explicit( &priv->var_filter[i], filter[i],
+                               memory_order_relaxed );
 }
 
 static void Destroy( variable_t *p_var )
@@ -295,6 +387,7 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -352,17 +445,18 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    void **pp_var;
     variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = LookupLocked( p_priv, psz_name, p_var->i_hash );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = Insert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -392,7 +486,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        Remove( p_priv, p_var );
     }
     else
     {
@@ -405,17 +499,27 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
+void var_Init( vlc_object_internals_t *priv )
 {
-    Destroy( var );
+    priv->var_table = NULL;
+    priv->var_buckets = 0;
+    priv->var_count = 0;
+    for( size_t i = 0; i < ARRAY_SIZE(priv->var_filter); i++ )
+        atomic_init( &priv->var_filter[i], 0 );
 }
 
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( size_t i = 0; i < priv->var_buckets; i++ )
+        for( variable_t *var = priv->var_table[i], *next; var != NULL; var = next )
+        {
+            next = var->p_next;
+            Destroy( var );
+        }
+    free( priv->var_table );
+    var_Init( priv );
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -729,8 +833,14 @@ int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
     variable_t *p_var;
     int err = VLC_SUCCESS;
+    uint32_t hash = VarHash( psz_name );
 
-    p_var = Lookup( p_this, psz_name );
+    /* Most objects walked by var_Inherit() do not have the variable */
+    if( !FilterMayContain( p_priv, hash ) )
+        return VLC_ENOVAR;
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    p_var = LookupLocked( p_priv, psz_name, hash );
     if( p_var != NULL )
     {
         assert( expected_type == 0 ||
@@ -1135,21 +1245,6 @@ error:
     return VLC_EGENERIC;
 }
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
-}
-
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
@@ -1157,9 +1252,14 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (size_t i = 0; i < priv->var_buckets; i++)
+        for (variable_t *var = priv->var_table[i]; var != NULL; var = var->p_next)
+        {
+            char *dup = strdup(var->psz_name);
+            if (dup != NULL)
+                ARRAY_APPEND(names, dup);
+        }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
@@ -23,6 +23,7 @@
 #ifndef LIBVLC_VARIABLES_H
 # define LIBVLC_VARIABLES_H 1
 
+# include <stdatomic.h>
 # include <vlc_list.h>
 
 struct vlc_res;
@@ -38,7 +39,11 @@ struct vlc_object_internals
     const char *typename; /**< Object type human-readable name */
 
     /* Object variables */
-    void           *var_root;
+    struct variable_t **var_table; /**< Hash table of variables */
+    size_t          var_buckets; /**< Number of hash buckets (power of 2) */
+    size_t          var_count;
+    /** Bloom filter of the variable names, readable without the lock */
+    atomic_uint_least64_t var_filter[4];
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
@@ -49,6 +54,7 @@ struct vlc_object_internals
 # define vlc_internals(o) ((o)->priv)
 # define vlc_externals(priv) (abort(), (void *)(priv))
 
+extern void var_Init( vlc_object_internals_t * );
 extern void var_DestroyAll( vlc_object_t * );
 
 /**
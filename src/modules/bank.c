@@ -54,6 +54,7 @@ typedef struct vlc_modcap
     char *name;
     module_t **modv;
     size_t modc;
+    bool sorted; /**< modv is already in decreasing score order */
 } vlc_modcap_t;
 
 static int vlc_modcap_cmp(const void *a, const void *b)
@@ -86,6 +87,8 @@ static void vlc_modcap_sort(const void *node, const VISIT which,
 
     if (which != postorder && which != leaf)
         return;
+    if (cap->sorted)
+        return;
 
     qsort(cap->modv, cap->modc, sizeof (*cap->modv), vlc_module_cmp);
     (void) depth;
@@ -102,54 +105,73 @@ static struct
 vlc_plugin_t *vlc_plugins = NULL;
 
 /**
- * Adds a module to the bank
+ * Looks up a capability of the bank, adding it if needed
  */
-static int vlc_module_store(module_t *mod)
+static vlc_modcap_t *vlc_modcap_get(const char *name)
 {
-    const char *name = module_get_capability(mod);
+    /* Most modules share their capability with an already stored one */
+    const void **cp = tfind(&name, &modules.caps_tree, vlc_modcap_cmp);
+    if (cp != NULL)
+        return (vlc_modcap_t *)*cp;
+
     vlc_modcap_t *cap = malloc(sizeof (*cap));
     if (unlikely(cap == NULL))
-        return -1;
+        return NULL;
 
     cap->name = strdup(name);
     cap->modv = NULL;
     cap->modc = 0;
+    cap->sorted = true;
 
     if (unlikely(cap->name == NULL))
         goto error;
 
-    void **cp = tsearch(cap, &modules.caps_tree, vlc_modcap_cmp);
-    if (unlikely(cp == NULL))
+    if (unlikely(tsearch(cap, &modules.caps_tree, vlc_modcap_cmp) == NULL))
         goto error;
+    return cap;
+error:
+    vlc_modcap_free(cap);
+    return NULL;
+}
 
-    if (*cp != cap)
-    {
-        vlc_modcap_free(cap);
-        cap = *cp;
-    }
+/**
+ * Adds a module to the bank
+ */
+static int vlc_module_store(module_t *mod)
+{
+    vlc_modcap_t *cap = vlc_modcap_get(module_get_capability(mod));
+    if (unlikely(cap == NULL))
+        return -1;
 
     module_t **modv = realloc(cap->modv, sizeof (*modv) * (cap->modc + 1));
     if (unlikely(modv == NULL))
         return -1;
 
+    /* A single module is in order */
+    cap->sorted = cap->modc == 0;
     cap->modv = modv;
     cap->modv[cap->modc] = mod;
     cap->modc++;
     return 0;
-error:
-    vlc_modcap_free(cap);
-    return -1;
 }
 
 /**
- * Adds a plugin (and all its modules) to the bank
+ * Adds the plugin to the list of plugins, but not its modules
  */
-static void vlc_plugin_store(vlc_plugin_t *lib)
+static void vlc_plugin_link(vlc_plugin_t *lib)
 {
     vlc_mutex_assert(&modules.lock);
 
     lib->next = vlc_plugins;
     vlc_plugins = lib;
+}
+
+/**
+ * Adds a plugin (and all its modules) to the bank
+ */
+static void vlc_plugin_store(vlc_plugin_t *lib)
+{
+    vlc_plugin_link(lib);
 
     for (module_t *m = lib->module; m != NULL; m = m->next)
         vlc_module_store(m);
@@ -292,7 +314,9 @@ typedef struct module_bank
 
     size_t        size;
     vlc_plugin_t **plugins;
+    size_t        cached; /**< plugins taken from the cache */
     vlc_plugin_t *cache;
+    vlc_cache_index_t index;
 } module_bank_t;
 
 /**
@@ -317,6 +341,8 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
             vlc_plugin_destroy(plugin);
             plugin = NULL;
         }
+        else if (plugin != NULL)
+            bank->cached++;
     }
 
     if (plugin == NULL)
@@ -339,15 +365,11 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
     if (plugin == NULL)
         return -1;
 
-    vlc_plugin_store(plugin);
-
-    if (bank->mode & CACHE_WRITE_FILE) /* Add entry to to-be-saved cache */
-    {
-        bank->plugins = xrealloc(bank->plugins,
-                                 (bank->size + 1) * sizeof (vlc_plugin_t *));
-        bank->plugins[bank->size] = plugin;
-        bank->size++;
-    }
+    /* Stored once the whole directory is scanned */
+    bank->plugins = xrealloc(bank->plugins,
+                             (bank->size + 1) * sizeof (vlc_plugin_t *));
+    bank->plugins[bank->size] = plugin;
+    bank->size++;
 
     /* TODO: deal with errors */
     return  0;
@@ -444,8 +466,14 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
         .mode = mode,
     };
 
+    vlc_tick_t start = vlc_tick_now();
+
     if (mode & CACHE_READ_FILE)
-        bank.cache = vlc_cache_load(obj, path, &modules.caches);
+    {
+        bank.cache = vlc_cache_load(obj, path, &modules.caches, &bank.index);
+        msg_Dbg(obj, "plugins cache loaded in %"PRId64" us",
+                US_FROM_VLC_TICK(vlc_tick_now() - start));
+    }
     else
         msg_Dbg(bank.obj, "ignoring plugins cache file");
 
@@ -454,7 +482,10 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
         msg_Dbg(obj, "recursively browsing `%s'", bank.base);
 
         /* Don't go deeper than 5 subdirectories */
+        vlc_tick_t scan = vlc_tick_now();
         AllocatePluginDir(&bank, 5, path, NULL);
+        msg_Dbg(obj, "plugins directory scanned in %"PRId64" us",
+                US_FROM_VLC_TICK(vlc_tick_now() - scan));
     }
 
     /* Deal with unmatched cache entries from cache file */
@@ -466,9 +497,52 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
         if (mode & CACHE_SCAN_DIR)
             vlc_plugin_destroy(plugin);
         else
-            vlc_plugin_store(plugin);
+        {   /* not saved: the cache is only written after a scan */
+            assert(!(mode & CACHE_WRITE_FILE));
+            plugin->next = NULL;
+            bank.plugins = xrealloc(bank.plugins,
+                                    (bank.size + 1) * sizeof (vlc_plugin_t *));
+            bank.plugins[bank.size++] = plugin;
+            bank.cached++;
+        }
+    }
+
+    /* If the plugins are exactly the cached ones, their modules are stored
+     * in the order of the cache capability index, and need no sorting. */
+    bool indexed = bank.index.plugc > 0 && bank.cached == bank.index.plugc
+                && bank.size == bank.cached;
+
+    for (size_t i = 0; i < bank.size; i++)
+    {
+        if (indexed)
+            vlc_plugin_link(bank.plugins[i]);
+        else
+            vlc_plugin_store(bank.plugins[i]);
     }
 
+    if (indexed)
+    {
+        for (size_t i = 0; i < bank.index.capc; i++)
+        {
+            const struct vlc_cache_cap *entry = &bank.index.capv[i];
+            vlc_modcap_t *cap = vlc_modcap_get(entry->name);
+            if (unlikely(cap == NULL))
+                continue;
+
+            module_t **modv = realloc(cap->modv, sizeof (*modv)
+                                      * (cap->modc + entry->count));
+            if (unlikely(modv == NULL))
+                continue;
+
+            cap->sorted = cap->modc == 0;
+            cap->modv = modv;
+            for (uint32_t j = 0; j < entry->count; j++)
+                cap->modv[cap->modc++] = bank.index.modv[entry->order[j]];
+        }
+        msg_Dbg(obj, "plugins cache capability index used");
+    }
+    vlc_cache_index_clean(&bank.index);
+
     if (mode & CACHE_WRITE_FILE)
         CacheSave(obj, path, bank.plugins, bank.size);
 
@@ -720,6 +794,8 @@ void module_LoadPlugins(vlc_object_t *obj)
 {
     /*vlc_mutex_assert (&modules.lock); not for static mutexes :( */
 
+    vlc_tick_t start = vlc_tick_now();
+
     if (modules.usage == 1)
     {
         module_InitStaticModules ();
@@ -727,17 +803,21 @@ void module_LoadPlugins(vlc_object_t *obj)
         msg_Dbg (obj, "searching plug-in modules");
         AllocateAllPlugins (obj);
 #endif
+        vlc_tick_t sort = vlc_tick_now();
         config_UnsortConfig ();
         config_SortConfig ();
 
         twalk(modules.caps_tree, vlc_modcap_sort);
+        msg_Dbg(obj, "plug-ins sorted in %"PRId64" us",
+                US_FROM_VLC_TICK(vlc_tick_now() - sort));
     }
     vlc_mutex_unlock (&modules.lock);
 
     size_t count;
     module_t **list = module_list_get (&count);
     module_list_free (list);
-    msg_Dbg (obj, "plug-ins loaded: %zu modules", count);
+    msg_Dbg (obj, "plug-ins loaded: %zu modules in %"PRId64" us", count,
+             US_FROM_VLC_TICK(vlc_tick_now() - start));
 }
 
 /**
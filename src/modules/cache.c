@@ -56,7 +56,7 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 36
+#define CACHE_SUBVERSION_NUM 38
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
@@ -282,11 +282,11 @@ error:
     return -1; /* FIXME: leaks */
 }
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
+static module_t *vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
 {
     module_t *module = vlc_module_create(plugin);
     if (unlikely(module == NULL))
-        return -1;
+        return NULL;
 
     LOAD_STRING(module->psz_shortname);
     LOAD_STRING(module->psz_longname);
@@ -303,16 +303,37 @@ static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
             LOAD_STRING(module->pp_shortcuts[j]);
     }
 
+    LOAD_IMMEDIATE(module->i_signatures);
+    if (module->i_signatures > MODULE_SIGNATURE_MAX)
+        goto error;
+    else if (module->i_signatures > 0)
+    {
+        module->p_signatures =
+            xmalloc (sizeof (*module->p_signatures) * module->i_signatures);
+        for (unsigned j = 0; j < module->i_signatures; j++)
+        {
+            struct vlc_module_signature *sig = &module->p_signatures[j];
+
+            LOAD_IMMEDIATE(sig->offset);
+            LOAD_IMMEDIATE(sig->length);
+            if (sig->length == 0
+             || sig->offset + sig->length > MODULE_SIGNATURE_SPAN)
+                goto error;
+            LOAD_ARRAY(sig->magic, sig->length);
+        }
+    }
+
     LOAD_STRING(module->activate_name);
     LOAD_STRING(module->deactivate_name);
     LOAD_STRING(module->psz_capability);
     LOAD_IMMEDIATE(module->i_score);
-    return 0;
+    return module;
 error:
-    return -1;
+    return NULL;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(block_t *file,
+                                           vlc_cache_index_t *index)
 {
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
@@ -322,9 +343,23 @@ static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
     LOAD_IMMEDIATE(modules);
 
     for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
+    {
+        module_t *module = vlc_cache_load_module(plugin, file);
+        if (module == NULL)
             goto error;
 
+        /* Keep the file order, which the capability index refers to */
+        if ((index->modc & 63) == 0)
+        {
+            module_t **modv = realloc(index->modv,
+                                      (index->modc + 64) * sizeof (*modv));
+            if (unlikely(modv == NULL))
+                goto error;
+            index->modv = modv;
+        }
+        index->modv[index->modc++] = module;
+    }
+
     if (vlc_cache_load_plugin_config(plugin, file))
         goto error;
 
@@ -353,6 +388,67 @@ error:
     return NULL;
 }
 
+/**
+ * Loads the capability index, in place.
+ *
+ * Every cached module must be listed exactly once, under its capability.
+ */
+static int vlc_cache_load_index(vlc_cache_index_t *index, block_t *file)
+{
+    bool *seen = NULL;
+    size_t total = 0;
+    uint32_t capc;
+
+    LOAD_IMMEDIATE(capc);
+    if (capc > index->modc)
+        goto error;
+
+    index->capv = vlc_alloc(capc, sizeof (*index->capv));
+    seen = calloc(index->modc, sizeof (*seen));
+    if (unlikely((capc > 0 && index->capv == NULL)
+              || (index->modc > 0 && seen == NULL)))
+        goto error;
+
+    for (index->capc = 0; index->capc < capc; index->capc++)
+    {
+        struct vlc_cache_cap *cap = &index->capv[index->capc];
+
+        LOAD_STRING(cap->name);
+        LOAD_IMMEDIATE(cap->count);
+        LOAD_ALIGNOF(*cap->order);
+        LOAD_ARRAY(cap->order, cap->count);
+
+        if (cap->name == NULL || cap->count == 0)
+            goto error;
+
+        for (uint32_t i = 0; i < cap->count; i++)
+        {
+            uint32_t m = cap->order[i];
+
+            if (m >= index->modc || seen[m]
+             || strcmp(module_get_capability(index->modv[m]), cap->name))
+                goto error;
+            seen[m] = true;
+        }
+        total += cap->count;
+    }
+
+    if (total != index->modc)
+        goto error;
+    free(seen);
+    return 0;
+error:
+    free(seen);
+    return -1;
+}
+
+void vlc_cache_index_clean(vlc_cache_index_t *index)
+{
+    free(index->modv);
+    free(index->capv);
+    memset(index, 0, sizeof (*index));
+}
+
 /**
  * Loads a plugins cache file.
  *
@@ -360,9 +456,11 @@ error:
  * will in turn be queried by AllocateAllPlugins() to see if it needs to
  * actually load the dynamically loadable module.
  * This allows us to only fully load plugins when they are actually used.
+ *
+ * \param index capability index of the cached modules [OUT]
  */
 vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
-                             block_t **backingp)
+                             block_t **backingp, vlc_cache_index_t *index)
 {
     char *psz_filename;
 
@@ -432,11 +530,19 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
         return NULL;
     }
 
-    vlc_plugin_t *cache = NULL;
+    /* Keep the file order: the directory scan looks the plugins up in the
+     * same order as they were saved, so each lookup hits the list head. */
+    vlc_plugin_t *cache = NULL, **tailp = &cache;
+    uint32_t plugc;
+
+    memset(index, 0, sizeof (*index));
 
-    while (file->i_buffer > 0)
+    if (vlc_cache_load_immediate(&plugc, file, sizeof (plugc)))
+        goto error;
+
+    for (index->plugc = 0; index->plugc < plugc; index->plugc++)
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(file, index);
         if (plugin == NULL)
             goto error;
 
@@ -448,10 +554,13 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
             goto error;
         }
 
-        plugin->next = cache;
-        cache = plugin;
+        *tailp = plugin;
+        tailp = &plugin->next;
     }
 
+    if (vlc_cache_load_index(index, file) || file->i_buffer > 0)
+        goto error;
+
     file->p_next = *backingp;
     *backingp = file;
     return cache;
@@ -460,6 +569,7 @@ error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
     /* TODO: cleanup */
+    vlc_cache_index_clean(index);
     block_Release(file);
     return NULL;
 }
@@ -574,6 +684,18 @@ static int CacheSaveModule(FILE *file, const module_t *module)
     for (size_t j = 0; j < module->i_shortcuts; j++)
          SAVE_STRING(module->pp_shortcuts[j]);
 
+    SAVE_IMMEDIATE(module->i_signatures);
+
+    for (size_t j = 0; j < module->i_signatures; j++)
+    {
+        const struct vlc_module_signature *sig = &module->p_signatures[j];
+
+        SAVE_IMMEDIATE(sig->offset);
+        SAVE_IMMEDIATE(sig->length);
+        if (fwrite(sig->magic, 1, sig->length, file) != sig->length)
+            goto error;
+    }
+
     SAVE_STRING(module->activate_name);
     SAVE_STRING(module->deactivate_name);
     SAVE_STRING(module->psz_capability);
@@ -583,6 +705,81 @@ error:
     return -1;
 }
 
+struct cache_entry
+{
+    const module_t *module;
+    uint32_t index; /* in the file order */
+};
+
+/* Same order as the bank: by capability, then by decreasing score */
+static int CacheEntryCmp(const void *a, const void *b)
+{
+    const struct cache_entry *ea = a, *eb = b;
+    int ret = strcmp(module_get_capability(ea->module),
+                     module_get_capability(eb->module));
+
+    if (ret == 0)
+        ret = eb->module->i_score - ea->module->i_score;
+    if (ret == 0)
+        ret = (ea->index > eb->index) - (ea->index < eb->index);
+    return ret;
+}
+
+static int CacheSaveIndex(FILE *file, vlc_plugin_t *const *cache, size_t n)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++)
+        count += cache[i]->modules_count;
+
+    struct cache_entry *tab = vlc_alloc(count, sizeof (*tab));
+    if (unlikely(count > 0 && tab == NULL))
+        return -1;
+
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+        for (const module_t *module = cache[i]->module;
+             module != NULL;
+             module = module->next, m++)
+        {
+            tab[m].module = module;
+            tab[m].index = m;
+        }
+    assert(m == count);
+
+    qsort(tab, count, sizeof (*tab), CacheEntryCmp);
+
+    uint32_t capc = 0;
+    for (size_t i = 0; i < count; i++)
+        if (i == 0 || strcmp(module_get_capability(tab[i - 1].module),
+                             module_get_capability(tab[i].module)))
+            capc++;
+    SAVE_IMMEDIATE(capc);
+
+    for (size_t i = 0; i < count;)
+    {
+        const char *name = module_get_capability(tab[i].module);
+        size_t end = i + 1;
+
+        while (end < count && !strcmp(module_get_capability(tab[end].module),
+                                         name))
+            end++;
+
+        uint32_t modc = end - i;
+        SAVE_STRING(name);
+        SAVE_IMMEDIATE(modc);
+        SAVE_ALIGNOF(uint32_t);
+        for (; i < end; i++)
+            SAVE_IMMEDIATE(tab[i].index);
+    }
+
+    free(tab);
+    return 0;
+error:
+    free(tab);
+    return -1;
+}
+
 static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
 {
     uint32_t i_file_size = 0;
@@ -606,6 +803,9 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
+    uint32_t plugc = n;
+    SAVE_IMMEDIATE(plugc);
+
     for (size_t i = 0; i < n; i++)
     {
         const vlc_plugin_t *plugin = cache[i];
@@ -631,6 +831,10 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
         SAVE_IMMEDIATE(plugin->size);
     }
 
+    /* Capability index */
+    if (CacheSaveIndex(file, cache, n))
+        goto error;
+
     if (fflush (file)) /* flush libc buffers */
         goto error;
     return 0; /* success! */
@@ -67,6 +67,8 @@ module_t *vlc_module_create(vlc_plugin_t *plugin)
     module->psz_help = NULL;
     module->pp_shortcuts = NULL;
     module->i_shortcuts = 0;
+    module->p_signatures = NULL;
+    module->i_signatures = 0;
     module->psz_capability = NULL;
     module->i_score = (parent != NULL) ? parent->i_score : 1;
     module->activate_name = NULL;
@@ -86,6 +88,7 @@ void vlc_module_destroy (module_t *module)
         module_t *next = module->next;
 
         free(module->pp_shortcuts);
+        free(module->p_signatures);
         free(module);
         module = next;
     }
@@ -97,6 +100,7 @@ vlc_plugin_t *vlc_plugin_create(void)
     if (unlikely(plugin == NULL))
         return NULL;
 
+    plugin->next = NULL;
     plugin->modules_count = 0;
     plugin->textdomain = NULL;
     plugin->conf.items = NULL;
@@ -259,6 +263,31 @@ static int vlc_plugin_desc_cb(void *ctx, void *tgt, int propid, ...)
             break;
         }
 
+        case VLC_MODULE_SIGNATURE:
+        {
+            unsigned offset = va_arg (ap, unsigned);
+            const char *magic = va_arg (ap, const char *);
+            size_t length = va_arg (ap, size_t);
+            unsigned index = module->i_signatures;
+            /* The core matches signatures against a bounded peek */
+            assert(index < MODULE_SIGNATURE_MAX);
+            assert(length > 0 && offset + length <= MODULE_SIGNATURE_SPAN);
+
+            struct vlc_module_signature *tab =
+                realloc (module->p_signatures, sizeof (*tab) * (index + 1));
+            if (unlikely(tab == NULL))
+            {
+                ret = -1;
+                break;
+            }
+            module->p_signatures = tab;
+            module->i_signatures = index + 1;
+            tab[index].offset = offset;
+            tab[index].length = length;
+            tab[index].magic = (const unsigned char *)magic;
+            break;
+        }
+
         case VLC_MODULE_CAPABILITY:
             module->psz_capability = va_arg (ap, const char *);
             break;
@@ -126,29 +126,44 @@ static int module_load(vlc_logger_t *log, module_t *m,
     return ret;
 }
 
-/**
- * Finds and instantiates the best module of a certain type.
- * All candidates modules having the specified capability and name will be
- * sorted in decreasing order of priority. Then the probe callback will be
- * invoked for each module, until it succeeds (returns 0), or all candidate
- * module failed to initialize.
- *
- * The probe callback first parameter is the address of the module entry point.
- * Further parameters are passed as an argument list; it corresponds to the
- * variable arguments passed to this function. This scheme is meant to
- * support arbitrary prototypes for the module entry point.
- *
- * \param log logger (or NULL to ignore)
- * \param capability capability, i.e. class of module
- * \param name name of the module asked, if any
- * \param strict if true, do not fallback to plugin with a different name
- *                 but the same capability
- * \param probe module probe callback
- * \return the module or NULL in case of a failure
- */
-module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
-                            const char *name, bool strict,
-                            vlc_activate_t probe, ...)
+static bool module_match_signature(const module_t *m,
+                                   const unsigned char *peek, size_t size)
+{
+    if (m->i_signatures == 0)
+        return true;
+
+    for (unsigned i = 0; i < m->i_signatures; i++)
+    {
+        const struct vlc_module_signature *sig = &m->p_signatures[i];
+
+        if (sig->offset + sig->length <= size
+         && memcmp(peek + sig->offset, sig->magic, sig->length) == 0)
+            return true;
+    }
+    return false;
+}
+
+static int module_probe(vlc_logger_t *log, module_t *m, vlc_activate_t init,
+                        bool forced, bool timed, va_list args)
+{
+    if (!timed)
+        return module_load(log, m, init, forced, args);
+
+    vlc_tick_t start = vlc_tick_now();
+    int ret = module_load(log, m, init, forced, args);
+
+    vlc_debug(log, "%s module \"%s\" probe %s in %"PRId64" us",
+              m->psz_capability, module_get_object(m),
+              (ret == VLC_SUCCESS) ? "succeeded" : "failed",
+              US_FROM_VLC_TICK(vlc_tick_now() - start));
+    return ret;
+}
+
+static module_t *vlc_module_load_va(struct vlc_logger *log,
+                                    const char *capability,
+                                    const char *name, bool strict,
+                                    const unsigned char *peek, size_t size,
+                                    vlc_activate_t probe, va_list args)
 {
     if (name == NULL || name[0] == '\0')
         name = "any";
@@ -166,10 +181,22 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
         return NULL;
     }
 
+    /* Modules whose signatures are not found in the peeked data would reject
+     * the stream anyway, unless they are requested by name. */
+    if (peek != NULL)
+    {
+        size_t skipped = 0;
+
+        for (ssize_t i = 0; i < total; i++)
+            if (!module_match_signature(mods[i], peek, size))
+                skipped++;
+
+        vlc_debug(log, "%zu %s candidates excluded by signature", skipped,
+                  capability);
+    }
+
     module_t *module = NULL;
-    va_list args;
 
-    va_start(args, probe);
     while (*name)
     {
         const char *shortcut = name;
@@ -181,6 +208,7 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
         if (!strcasecmp ("none", shortcut))
             goto done;
 
+        bool any = slen == 3 && !strncasecmp ("any", shortcut, slen);
         bool force = strict && strcasecmp ("any", shortcut);
         for (ssize_t i = 0; i < total; i++)
         {
@@ -189,9 +217,13 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
                 continue; // module failed in previous iteration
             if (!module_match_name(cand, shortcut, slen))
                 continue;
+            if (any && peek != NULL
+             && !module_match_signature(cand, peek, size))
+                continue;
             mods[i] = NULL; // only try each module once at most...
 
-            int ret = module_load(log, cand, probe, force, args);
+            int ret = module_probe(log, cand, probe, force, peek != NULL,
+                                   args);
             switch (ret)
             {
                 case VLC_SUCCESS:
@@ -211,8 +243,11 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
             module_t *cand = mods[i];
             if (cand == NULL || module_get_score (cand) <= 0)
                 continue;
+            if (peek != NULL && !module_match_signature(cand, peek, size))
+                continue;
 
-            int ret = module_load(log, cand, probe, false, args);
+            int ret = module_probe(log, cand, probe, false, peek != NULL,
+                                   args);
             switch (ret)
             {
                 case VLC_SUCCESS:
@@ -224,7 +259,6 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
         }
     }
 done:
-    va_end (args);
     module_list_free (mods);
 
     if (module != NULL)
@@ -235,6 +269,65 @@ done:
     return module;
 }
 
+/**
+ * Finds and instantiates the best module of a certain type.
+ * All candidates modules having the specified capability and name will be
+ * sorted in decreasing order of priority. Then the probe callback will be
+ * invoked for each module, until it succeeds (returns 0), or all candidate
+ * module failed to initialize.
+ *
+ * The probe callback first parameter is the address of the module entry point.
+ * Further parameters are passed as an argument list; it corresponds to the
+ * variable arguments passed to this function. This scheme is meant to
+ * support arbitrary prototypes for the module entry point.
+ *
+ * \param log logger (or NULL to ignore)
+ * \param capability capability, i.e. class of module
+ * \param name name of the module asked, if any
+ * \param strict if true, do not fallback to plugin with a different name
+ *                 but the same capability
+ * \param probe module probe callback
+ * \return the module or NULL in case of a failure
+ */
+module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
+                            const char *name, bool strict,
+                            vlc_activate_t probe, ...)
+{
+    va_list args;
+
+    va_start(args, probe);
+    module_t *module = vlc_module_load_va(log, capability, name, strict,
+                                          NULL, 0, probe, args);
+    va_end(args);
+    return module;
+}
+
+/**
+ * Finds and instantiates the best module of a certain type for a stream.
+ *
+ * This works like vlc_module_load(), but the modules that are not explicitly
+ * named and whose signatures do not match the first bytes of the stream are
+ * skipped without being probed. The probe time of each module is logged.
+ *
+ * \param peek first bytes of the stream
+ * \param peek_size number of bytes in peek (data past the end of the stream
+ *                  or past MODULE_SIGNATURE_SPAN are not needed)
+ */
+module_t *vlc_module_load_peek(struct vlc_logger *log, const char *capability,
+                               const char *name, bool strict,
+                               const void *peek, size_t peek_size,
+                               vlc_activate_t probe, ...)
+{
+    va_list args;
+
+    assert(peek != NULL);
+    va_start(args, probe);
+    module_t *module = vlc_module_load_va(log, capability, name, strict,
+                                          peek, peek_size, probe, args);
+    va_end(args);
+    return module;
+}
+
 static int generic_start(void *func, bool forced, va_list ap)
 {
     vlc_object_t *obj = va_arg(ap, vlc_object_t *);
@@ -24,6 +24,7 @@
 # define LIBVLC_MODULES_H 1
 
 # include <stdatomic.h>
+# include <vlc_modules.h>
 
 /** VLC plugin */
 typedef struct vlc_plugin_t
@@ -62,6 +63,17 @@ typedef struct vlc_plugin_t
 extern struct vlc_plugin_t *vlc_plugins;
 
 #define MODULE_SHORTCUT_MAX 20
+#define MODULE_SIGNATURE_MAX 16
+/** Signatures must lie within the first bytes of the stream */
+#define MODULE_SIGNATURE_SPAN 256
+
+/** Module signature, i.e. magic bytes at a fixed offset */
+struct vlc_module_signature
+{
+    uint16_t offset;
+    uint16_t length;
+    const unsigned char *magic;
+};
 
 /** Plugin entry point prototype */
 typedef int (*vlc_plugin_cb) (int (*)(void *, void *, int, ...), void *);
@@ -81,6 +93,10 @@ struct module_t
     unsigned    i_shortcuts;
     const char **pp_shortcuts;
 
+    /** Signatures of the accepted streams (if none, accepts any) */
+    unsigned    i_signatures;
+    struct vlc_module_signature *p_signatures;
+
     /*
      * Variables set by the module to identify itself
      */
@@ -115,6 +131,11 @@ void *module_Symbol(struct vlc_logger *, vlc_plugin_t *, const char *name);
 
 ssize_t module_list_cap (module_t ***, const char *);
 
+module_t *vlc_module_load_peek(struct vlc_logger *, const char *cap,
+                               const char *name, bool strict,
+                               const void *peek, size_t peek_size,
+                               vlc_activate_t probe, ...) VLC_USED;
+
 int vlc_bindtextdomain (const char *);
 
 /* Low-level OS-dependent handler */
@@ -162,7 +183,30 @@ void *vlc_dlsym(void *handle, const char *) VLC_USED;
 char *vlc_dlerror(void) VLC_USED;
 
 /* Plugins cache */
-vlc_plugin_t *vlc_cache_load(vlc_object_t *, const char *, block_t **);
+
+/**
+ * Capability index of a plugins cache.
+ *
+ * The modules of each capability are listed in the bank order, that is by
+ * decreasing score, so that the bank need not sort them again.
+ */
+typedef struct vlc_cache_index
+{
+    size_t plugc; /**< number of cached plugins */
+    size_t modc; /**< number of cached modules */
+    module_t **modv; /**< cached modules, in file order */
+    size_t capc;
+    struct vlc_cache_cap
+    {
+        const char *name;
+        uint32_t count;
+        const uint32_t *order; /**< indices in modv */
+    } *capv;
+} vlc_cache_index_t;
+
+vlc_plugin_t *vlc_cache_load(vlc_object_t *, const char *, block_t **,
+                             vlc_cache_index_t *);
+void vlc_cache_index_clean(vlc_cache_index_t *);
 vlc_plugin_t *vlc_cache_lookup(vlc_plugin_t **, const char *relpath);
 
 void CacheSave(vlc_object_t *, const char *, vlc_plugin_t *const *, size_t);
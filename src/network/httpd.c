@@ -61,6 +61,13 @@
 #   include <sys/socket.h>
 #endif
 
+#ifdef __linux__
+/* live streams are sent by a pool of epoll threads */
+# define HTTPD_WORKERS 1
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+#endif
+
 #if defined(_WIN32)
 /* We need HUGE buffer otherwise TCP throughput is very limited */
 #define HTTPD_CL_BUFSIZE 1000000
@@ -68,9 +75,31 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* the streaming threads send the new data at most this often */
+#define HTTPD_WORKER_PERIOD VLC_TICK_FROM_MS(20)
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
 static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
 
+#ifdef HTTPD_WORKERS
+/* streaming thread, owns the clients of the live streams once the answer
+ * header is sent */
+struct httpd_worker
+{
+    httpd_host_t *host;
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+
+    struct vlc_list clients;
+    size_t client_count;
+
+    int epfd;
+    int wakefd;
+    atomic_bool woken;
+    bool failed; /* cannot poll, does not take clients anymore */
+};
+#endif
+
 /* each host run in his own thread */
 struct httpd_host_t
 {
@@ -100,6 +129,11 @@ struct httpd_host_t
 
     /* TLS data */
     vlc_tls_server_t *p_tls;
+
+#ifdef HTTPD_WORKERS
+    struct httpd_worker *workers;
+    unsigned worker_count;
+#endif
 };
 
 
@@ -162,6 +196,9 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* live stream sent from its buffer by a worker, if any */
+    httpd_stream_t *stream;
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -607,7 +644,8 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
+    /* circular buffer, and the keyframe position above */
+    vlc_rwlock_t buffer_lock;
     int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
     uint8_t     *p_buffer;          /* buffer */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
@@ -616,8 +654,338 @@ struct httpd_stream_t
     /* custom headers */
     size_t        i_http_headers;
     httpd_header * p_http_headers;
+
+#ifdef HTTPD_WORKERS
+    /* number of clients of the stream owned by each worker of the host */
+    atomic_uint *worker_clients;
+#endif
 };
 
+#ifdef HTTPD_WORKERS
+/*
+ * Sends the pending data of a live stream to a client, straight from the
+ * circular buffer of the stream (no copy per client).
+ * Returns the number of bytes sent, 0 if there is nothing to send yet,
+ * or -1 on error (including EAGAIN).
+ */
+static ssize_t httpd_StreamSendClient(httpd_stream_t *stream,
+                                      httpd_client_t *cl)
+{
+    httpd_message_t *answer = &cl->answer;
+    ssize_t val = 0;
+
+    vlc_rwlock_rdlock(&stream->buffer_lock);
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            goto out;
+
+        /* seek to the new keyframe */
+        answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+        cl->i_keyframe_wait_to_pass = -1;
+    }
+
+    if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
+        answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+
+    int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+    if (i_write <= 0)
+        goto out;   /* wait, no data available */
+
+    /* the data may wrap around the end of the circular buffer */
+    int i_pos = answer->i_body_offset % stream->i_buffer_size;
+    struct iovec iov[2];
+    int iovcnt = 1;
+
+    iov[0].iov_base = &stream->p_buffer[i_pos];
+    iov[0].iov_len = __MIN(i_write, stream->i_buffer_size - i_pos);
+    if ((int64_t)iov[0].iov_len < i_write) {
+        iov[1].iov_base = stream->p_buffer;
+        iov[1].iov_len = i_write - iov[0].iov_len;
+        iovcnt = 2;
+    }
+
+    vlc_tls_t *sock = cl->sock;
+    val = sock->ops->writev(sock, iov, iovcnt);
+    if (val > 0)
+        answer->i_body_offset += val;
+    else if (val == 0) {
+        errno = EPIPE;
+        val = -1;
+    }
+out:
+    vlc_rwlock_unlock(&stream->buffer_lock);
+    return val;
+}
+
+static void httpd_WorkerWake(struct httpd_worker *w)
+{
+    if (atomic_exchange(&w->woken, true))
+        return; /* already pending */
+
+    uint64_t value = 1;
+    int canc = vlc_savecancel();
+    if (write(w->wakefd, &value, sizeof (value)) < 0)
+        atomic_store(&w->woken, false);
+    vlc_restorecancel(canc);
+}
+
+static void httpd_WorkerPoll(struct httpd_worker *w, httpd_client_t *cl,
+                             uint32_t events)
+{
+    struct epoll_event ev = { .events = events, .data.ptr = cl };
+
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, vlc_tls_GetFD(cl->sock), &ev);
+}
+
+/* Sends what is available, then waits for the socket or for more data */
+static void httpd_WorkerSend(struct httpd_worker *w, httpd_client_t *cl)
+{
+    ssize_t val;
+    unsigned tries = 4;
+    bool progress = false;
+
+    /* until the socket is full (or new data keeps coming) */
+    while ((val = httpd_StreamSendClient(cl->stream, cl)) > 0) {
+        progress = true;
+        if (--tries == 0)
+            break;
+    }
+
+    if (val < 0 && errno != EAGAIN) {
+        cl->i_state = HTTPD_CLIENT_DEAD;
+        return;
+    }
+
+    if (progress || cl->i_state == HTTPD_CLIENT_WAITING)
+        cl->i_activity_date = vlc_tick_now();
+
+    if (val == 0) {
+        /* caught up, wait for httpd_StreamSend() */
+        if (cl->i_state == HTTPD_CLIENT_SENDING)
+            httpd_WorkerPoll(w, cl, 0);
+        cl->i_state = HTTPD_CLIENT_WAITING;
+    } else {
+        /* wait for the socket */
+        if (cl->i_state == HTTPD_CLIENT_WAITING)
+            httpd_WorkerPoll(w, cl, EPOLLOUT);
+        cl->i_state = HTTPD_CLIENT_SENDING;
+    }
+}
+
+static void httpd_WorkerDrop(struct httpd_worker *w, httpd_client_t *cl)
+{
+    epoll_ctl(w->epfd, EPOLL_CTL_DEL, vlc_tls_GetFD(cl->sock), NULL);
+    if (cl->stream != NULL)
+        atomic_fetch_sub(&cl->stream->worker_clients[w - w->host->workers], 1);
+    w->client_count--;
+    httpd_ClientDestroy(cl);
+}
+
+static void *httpd_WorkerThread(void *data)
+{
+    struct httpd_worker *w = data;
+    struct epoll_event ev[64];
+    vlc_tick_t last = VLC_TICK_0;
+    vlc_tick_t deadline = VLC_TICK_INVALID;
+
+    for (;;) {
+        int timeout = -1;
+        if (deadline != VLC_TICK_INVALID) {
+            vlc_tick_t delay = deadline - vlc_tick_now();
+            timeout = delay > 0 ? MS_FROM_VLC_TICK(delay) + 1 : 0;
+        }
+
+        int n = epoll_wait(w->epfd, ev, ARRAY_SIZE(ev), timeout);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            /* not transient: close the clients and stop serving */
+            msg_Err(w->host, "polling error: %s", vlc_strerror_c(errno));
+            break;
+        }
+
+        int canc = vlc_savecancel();
+
+        vlc_mutex_lock(&w->lock);
+        for (int i = 0; i < n; i++) {
+            httpd_client_t *cl = ev[i].data.ptr;
+
+            if (cl == NULL) {
+                /* new data, or clients to close */
+                uint64_t value;
+                if (read(w->wakefd, &value, sizeof (value)) < 0)
+                    continue;
+                if (deadline == VLC_TICK_INVALID)
+                    deadline = last + HTTPD_WORKER_PERIOD;
+                continue;
+            }
+
+            if (cl->i_state == HTTPD_CLIENT_DEAD)
+                continue; /* closed below */
+            if (ev[i].events & (EPOLLERR | EPOLLHUP))
+                cl->i_state = HTTPD_CLIENT_DEAD;
+            else
+                httpd_WorkerSend(w, cl);
+
+            if (cl->i_state == HTTPD_CLIENT_DEAD)
+                httpd_WorkerDrop(w, cl);
+        }
+
+        vlc_tick_t now = vlc_tick_now();
+        if (deadline != VLC_TICK_INVALID && deadline <= now) {
+            /* Serve the clients which had caught up. This is done at most
+             * once per period, so that the data sent in a row to each client
+             * are batched, rather than written (and woken up) block by
+             * block. */
+            httpd_client_t *cl;
+
+            atomic_store(&w->woken, false);
+            vlc_list_foreach(cl, &w->clients, node) {
+                if (cl->i_state == HTTPD_CLIENT_WAITING)
+                    httpd_WorkerSend(w, cl);
+                else if (cl->i_state == HTTPD_CLIENT_SENDING
+                      && cl->i_activity_timeout > 0
+                      && cl->i_activity_date + cl->i_activity_timeout < now)
+                    cl->i_state = HTTPD_CLIENT_DEAD; /* stalled client */
+
+                if (cl->i_state == HTTPD_CLIENT_DEAD)
+                    httpd_WorkerDrop(w, cl);
+            }
+            last = now;
+            deadline = VLC_TICK_INVALID;
+        }
+        vlc_mutex_unlock(&w->lock);
+        vlc_restorecancel(canc);
+    }
+
+    int canc = vlc_savecancel();
+    httpd_client_t *cl;
+
+    vlc_mutex_lock(&w->lock);
+    w->failed = true;
+    vlc_list_foreach(cl, &w->clients, node)
+        httpd_WorkerDrop(w, cl);
+    vlc_mutex_unlock(&w->lock);
+    vlc_restorecancel(canc);
+    return NULL;
+}
+
+/* Hands a client over to the least loaded worker.
+ * On success, the worker owns the client, which must not be touched anymore:
+ * it may already be gone. On failure, the client is left to the host. */
+static bool httpd_WorkerAdd(httpd_host_t *host, httpd_client_t *cl)
+{
+    struct httpd_worker *w = NULL;
+    size_t count = SIZE_MAX;
+
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        vlc_mutex_lock(&host->workers[i].lock);
+        if (!host->workers[i].failed
+         && host->workers[i].client_count < count) {
+            w = &host->workers[i];
+            count = w->client_count;
+        }
+        vlc_mutex_unlock(&host->workers[i].lock);
+    }
+    if (w == NULL)
+        return false; /* no streaming threads */
+
+    vlc_mutex_lock(&w->lock);
+    struct epoll_event ev = { .events = 0, .data.ptr = cl };
+    if (w->failed
+     || epoll_ctl(w->epfd, EPOLL_CTL_ADD, vlc_tls_GetFD(cl->sock), &ev)) {
+        vlc_mutex_unlock(&w->lock);
+        return false;
+    }
+
+    vlc_list_remove(&cl->node);
+    host->client_count--;
+    vlc_list_append(&cl->node, &w->clients);
+    w->client_count++;
+    atomic_fetch_add(&cl->stream->worker_clients[w - host->workers], 1);
+
+    cl->i_state = HTTPD_CLIENT_WAITING;
+    httpd_WorkerSend(w, cl);
+    if (cl->i_state == HTTPD_CLIENT_DEAD)
+        httpd_WorkerDrop(w, cl);
+    vlc_mutex_unlock(&w->lock);
+    return true;
+}
+
+static void httpd_WorkersStart(httpd_host_t *host, unsigned count)
+{
+    host->worker_count = 0;
+    if (count == 0)
+        count = vlc_GetCPUCount();
+
+    host->workers = vlc_alloc(count, sizeof (*host->workers));
+    if (unlikely(host->workers == NULL))
+        return;
+
+    while (host->worker_count < count) {
+        struct httpd_worker *w = &host->workers[host->worker_count];
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+
+        w->host = host;
+        vlc_list_init(&w->clients);
+        w->client_count = 0;
+        atomic_init(&w->woken, false);
+        w->failed = false;
+
+        w->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (w->epfd == -1)
+            break;
+        w->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (w->wakefd == -1) {
+            vlc_close(w->epfd);
+            break;
+        }
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->wakefd, &ev))
+            goto error;
+
+        vlc_mutex_init(&w->lock);
+        if (vlc_clone(&w->thread, httpd_WorkerThread, w,
+                      VLC_THREAD_PRIORITY_LOW)) {
+            vlc_mutex_destroy(&w->lock);
+            goto error;
+        }
+        host->worker_count++;
+        continue;
+error:
+        vlc_close(w->wakefd);
+        vlc_close(w->epfd);
+        break;
+    }
+
+    if (host->worker_count == 0)
+        msg_Warn(host, "cannot spawn HTTP streaming threads");
+    else
+        msg_Dbg(host, "%u HTTP streaming thread(s)", host->worker_count);
+}
+
+static void httpd_WorkersStop(httpd_host_t *host)
+{
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        struct httpd_worker *w = &host->workers[i];
+        httpd_client_t *cl;
+
+        vlc_cancel(w->thread);
+        vlc_join(w->thread, NULL);
+
+        vlc_list_foreach(cl, &w->clients, node)
+            httpd_WorkerDrop(w, cl);
+
+        vlc_close(w->wakefd);
+        vlc_close(w->epfd);
+        vlc_mutex_destroy(&w->lock);
+    }
+    free(host->workers);
+    host->workers = NULL;
+    host->worker_count = 0;
+}
+#endif
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -629,14 +997,16 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
     if (answer->i_body_offset > 0) {
         int     i_pos;
+        int     ret = VLC_EGENERIC;
 
+        vlc_rwlock_rdlock(&stream->buffer_lock);
         if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+            goto out;   /* wait, no data available */
 
         if (cl->i_keyframe_wait_to_pass >= 0) {
             if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
                 /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+                goto out;
 
             /* seek to the new keyframe */
             answer->i_body_offset = stream->i_last_keyframe_seen_pos;
@@ -652,7 +1022,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         if (i_write > HTTPD_CL_BUFSIZE)
             i_write = HTTPD_CL_BUFSIZE;
         else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+            goto out;   /* wait, no data available */
 
         /* Don't go past the end of the circular buffer */
         i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
@@ -667,8 +1037,10 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
 
         answer->i_body_offset += i_write;
-
-        return VLC_SUCCESS;
+        ret = VLC_SUCCESS;
+out:
+        vlc_rwlock_unlock(&stream->buffer_lock);
+        return ret;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -701,12 +1073,18 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 answer->p_body = xmalloc(stream->i_header);
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
+            vlc_rwlock_rdlock(&stream->buffer_lock);
             answer->i_body_offset = stream->i_buffer_last_pos;
             if (stream->b_has_keyframes)
                 cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
             else
                 cl->i_keyframe_wait_to_pass = -1;
+            vlc_rwlock_unlock(&stream->buffer_lock);
             vlc_mutex_unlock(&stream->lock);
+#ifdef HTTPD_WORKERS
+            if (stream->url->host->worker_count > 0)
+                cl->stream = stream;
+#endif
         } else {
             httpd_MsgAdd(answer, "Content-Length", "0");
             answer->i_body_offset = 0;
@@ -753,12 +1131,28 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
 
     stream->psz_mime = NULL;
     stream->p_buffer = NULL;
+#ifdef HTTPD_WORKERS
+    stream->worker_clients = NULL;
+#endif
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
         goto error;
 
+#ifdef HTTPD_WORKERS
+    /* the host, thus its workers, are set up before any of its streams */
+    if (host->worker_count > 0) {
+        stream->worker_clients = vlc_alloc(host->worker_count,
+                                           sizeof (*stream->worker_clients));
+        if (stream->worker_clients == NULL)
+            goto error;
+        for (unsigned i = 0; i < host->worker_count; i++)
+            atomic_init(&stream->worker_clients[i], 0);
+    }
+#endif
+
     vlc_mutex_init(&stream->lock);
+    vlc_rwlock_init(&stream->buffer_lock);
     if (psz_mime == NULL || psz_mime[0] == '\0')
         psz_mime = vlc_mime_Ext2Mime(psz_url);
 
@@ -794,6 +1188,9 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
 
 error:
     free(stream->psz_mime);
+#ifdef HTTPD_WORKERS
+    free(stream->worker_clients);
+#endif
 
     if (stream->url)
         httpd_UrlDelete(stream->url);
@@ -842,7 +1239,7 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
     if (!p_block || !p_block->p_buffer)
         return VLC_SUCCESS;
 
-    vlc_mutex_lock(&stream->lock);
+    vlc_rwlock_wrlock(&stream->buffer_lock);
 
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
@@ -854,7 +1251,15 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 
     httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
 
-    vlc_mutex_unlock(&stream->lock);
+    vlc_rwlock_unlock(&stream->buffer_lock);
+
+#ifdef HTTPD_WORKERS
+    /* only the workers serving this stream have new data to send */
+    httpd_host_t *host = stream->url->host;
+    for (unsigned i = 0; i < host->worker_count; i++)
+        if (atomic_load(&stream->worker_clients[i]) > 0)
+            httpd_WorkerWake(&host->workers[i]);
+#endif
     return VLC_SUCCESS;
 }
 
@@ -866,10 +1271,14 @@ void httpd_StreamDelete(httpd_stream_t *stream)
         free(stream->p_http_headers[i].value);
     }
     free(stream->p_http_headers);
+    vlc_rwlock_destroy(&stream->buffer_lock);
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
     free(stream->p_buffer);
+#ifdef HTTPD_WORKERS
+    free(stream->worker_clients);
+#endif
     free(stream);
 }
 
@@ -956,6 +1365,10 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_mutex_init(&host->lock);
     vlc_cond_init(&host->wait);
     atomic_init(&host->ref, 1);
+#ifdef HTTPD_WORKERS
+    host->workers = NULL;
+    host->worker_count = 0;
+#endif
 
     char *hostname = var_InheritString(p_this, hostvar);
 
@@ -974,6 +1387,12 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_list_init(&host->clients);
     host->p_tls    = p_tls;
 
+#ifdef HTTPD_WORKERS
+    /* TLS sessions are served by the host thread */
+    if (p_tls == NULL)
+        httpd_WorkersStart(host, var_InheritInteger(p_this, "http-workers"));
+#endif
+
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
                    VLC_THREAD_PRIORITY_LOW)) {
@@ -991,6 +1410,9 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+#ifdef HTTPD_WORKERS
+        httpd_WorkersStop(host);
+#endif
         net_ListenClose(host->fds);
         vlc_cond_destroy(&host->wait);
         vlc_mutex_destroy(&host->lock);
@@ -1025,6 +1447,9 @@ void httpd_HostDelete(httpd_host_t *host)
         msg_Warn(host, "client still connected");
         httpd_ClientDestroy(client);
     }
+#ifdef HTTPD_WORKERS
+    httpd_WorkersStop(host);
+#endif
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
@@ -1131,6 +1556,25 @@ void httpd_UrlDelete(httpd_url_t *url)
         host->client_count--;
         httpd_ClientDestroy(client);
     }
+#ifdef HTTPD_WORKERS
+    /* the workers close their clients of this url (streams) */
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        struct httpd_worker *w = &host->workers[i];
+        bool wake = false;
+
+        vlc_mutex_lock(&w->lock);
+        vlc_list_foreach(client, &w->clients, node)
+            if (client->url == url) {
+                client->i_state = HTTPD_CLIENT_DEAD;
+                client->url = NULL;
+                client->stream = NULL;
+                wake = true;
+            }
+        vlc_mutex_unlock(&w->lock);
+        if (wake)
+            httpd_WorkerWake(w);
+    }
+#endif
     free(url);
     vlc_mutex_unlock(&host->lock);
 }
@@ -1214,6 +1658,7 @@ static void httpd_ClientInit(httpd_client_t *cl, vlc_tick_t now)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->stream = NULL;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1617,7 +2062,8 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer += i_len;
 
         if (cl->i_buffer >= cl->i_buffer_size) {
-            if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
+            if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0
+             && cl->stream == NULL) {
                 /* catch more body data */
                 int     i_msg = cl->query.i_type;
                 int64_t i_offset = cl->answer.i_body_offset;
@@ -1940,6 +2386,10 @@ static void httpdLoop(httpd_host_t *host)
                     cl->i_buffer_size = 0;
 
                     cl->i_state = HTTPD_CLIENT_WAITING;
+#ifdef HTTPD_WORKERS
+                    if (cl->stream != NULL && httpd_WorkerAdd(host, cl))
+                        continue; /* not ours anymore */
+#endif
                 }
                 break;
 
@@ -33,6 +33,8 @@
 void
 vlc_playlist_ClearItems(vlc_playlist_t *playlist)
 {
+    vlc_playlist_LookupClear(playlist);
+
     vlc_playlist_item_t *item;
     vlc_vector_foreach(item, &playlist->items)
         vlc_playlist_item_Release(item);
@@ -60,6 +62,8 @@ vlc_playlist_ItemsReset(vlc_playlist_t *playlist)
 static void
 vlc_playlist_ItemsInserted(vlc_playlist_t *playlist, size_t index, size_t count)
 {
+    vlc_playlist_LookupAdd(playlist, index, count);
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
         randomizer_Add(&playlist->randomizer,
                        &playlist->items.data[index], count);
@@ -87,6 +91,8 @@ static void
 vlc_playlist_ItemsMoved(vlc_playlist_t *playlist, size_t index, size_t count,
                         size_t target)
 {
+    vlc_playlist_LookupMoved(playlist, index < target ? index : target);
+
     struct vlc_playlist_state state;
     vlc_playlist_state_Save(playlist, &state);
 
@@ -124,6 +130,8 @@ vlc_playlist_ItemsMoved(vlc_playlist_t *playlist, size_t index, size_t count,
 static void
 vlc_playlist_ItemsRemoving(vlc_playlist_t *playlist, size_t index, size_t count)
 {
+    vlc_playlist_LookupRemove(playlist, index, count);
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
         randomizer_Remove(&playlist->randomizer,
                           &playlist->items.data[index], count);
@@ -197,9 +205,7 @@ vlc_playlist_IndexOf(vlc_playlist_t *playlist, const vlc_playlist_item_t *item)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    ssize_t index;
-    vlc_vector_index_of(&playlist->items, item, &index);
-    return index;
+    return vlc_playlist_LookupItem(playlist, item);
 }
 
 ssize_t
@@ -207,11 +213,7 @@ vlc_playlist_IndexOfMedia(vlc_playlist_t *playlist, const input_item_t *media)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->media == media)
-            return i;
-    return -1;
+    return vlc_playlist_LookupMedia(playlist, media);
 }
 
 ssize_t
@@ -219,11 +221,7 @@ vlc_playlist_IndexOfId(vlc_playlist_t *playlist, uint64_t id)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->id == id)
-            return i;
-    return -1;
+    return vlc_playlist_LookupId(playlist, id);
 }
 
 void
@@ -342,6 +340,7 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
         randomizer_Add(&playlist->randomizer, &item, 1);
     }
 
+    vlc_playlist_LookupReplace(playlist, index, item);
     vlc_playlist_item_Release(playlist->items.data[index]);
     playlist->items.data[index] = item;
 
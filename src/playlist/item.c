@@ -37,6 +37,9 @@ vlc_playlist_item_New(input_item_t *media, uint64_t id)
     vlc_atomic_rc_init(&item->rc);
     item->id = id;
     item->media = media;
+    item->index = SIZE_MAX;
+    item->next_by_media = NULL;
+    item->next_by_id = NULL;
     input_item_Hold(media);
     return item;
 }
@@ -31,6 +31,11 @@ struct vlc_playlist_item
     input_item_t *media;
     uint64_t id;
     vlc_atomic_rc_t rc;
+
+    /* owned by the playlist lookup, see lookup.h */
+    size_t index; /* cached position in the playlist */
+    vlc_playlist_item_t *next_by_media;
+    vlc_playlist_item_t *next_by_id;
 };
 
 /* _New() is private, it is called when inserting new media in the playlist */
@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * playlist/lookup.c
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "lookup.h"
+
+#include "item.h"
+#include "playlist.h"
+
+static size_t
+Hash(uint64_t x)
+{
+    /* finalizer of MurmurHash3 */
+    x ^= x >> 33;
+    x *= UINT64_C(0xff51afd7ed558ccd);
+    x ^= x >> 33;
+    x *= UINT64_C(0xc4ceb9fe1a85ec53);
+    x ^= x >> 33;
+    return x;
+}
+
+static inline size_t
+HashMedia(const input_item_t *media)
+{
+    return Hash((uintptr_t) media);
+}
+
+void
+vlc_playlist_lookup_Init(struct vlc_playlist_lookup *lookup)
+{
+    lookup->by_media = NULL;
+    lookup->by_id = NULL;
+    lookup->buckets = 0;
+    lookup->valid = 0;
+}
+
+void
+vlc_playlist_lookup_Destroy(struct vlc_playlist_lookup *lookup)
+{
+    free(lookup->by_media);
+    free(lookup->by_id);
+}
+
+static void
+Link(struct vlc_playlist_lookup *lookup, vlc_playlist_item_t *item)
+{
+    size_t mask = lookup->buckets - 1;
+
+    vlc_playlist_item_t **by_media = &lookup->by_media[HashMedia(item->media)
+                                                       & mask];
+    item->next_by_media = *by_media;
+    *by_media = item;
+
+    vlc_playlist_item_t **by_id = &lookup->by_id[Hash(item->id) & mask];
+    item->next_by_id = *by_id;
+    *by_id = item;
+}
+
+static void
+Unlink(struct vlc_playlist_lookup *lookup, vlc_playlist_item_t *item)
+{
+    size_t mask = lookup->buckets - 1;
+
+    vlc_playlist_item_t **pp = &lookup->by_media[HashMedia(item->media) & mask];
+    while (*pp != item)
+        pp = &(*pp)->next_by_media;
+    *pp = item->next_by_media;
+
+    pp = &lookup->by_id[Hash(item->id) & mask];
+    while (*pp != item)
+        pp = &(*pp)->next_by_id;
+    *pp = item->next_by_id;
+}
+
+/* rehash if needed, the items [index, index + count) are not linked yet */
+static void
+Grow(vlc_playlist_t *playlist, size_t index, size_t count)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+    playlist_item_vector_t *items = &playlist->items;
+
+    size_t buckets = lookup->buckets ? lookup->buckets : 64;
+    while (buckets < items->size)
+        buckets *= 2;
+    if (buckets == lookup->buckets)
+        return;
+
+    vlc_playlist_item_t **by_media = calloc(buckets, sizeof(*by_media));
+    vlc_playlist_item_t **by_id = calloc(buckets, sizeof(*by_id));
+    if (unlikely(!by_media || !by_id))
+    {
+        /* keep the current tables (if any), with longer chains */
+        free(by_media);
+        free(by_id);
+        return;
+    }
+
+    free(lookup->by_media);
+    free(lookup->by_id);
+    lookup->by_media = by_media;
+    lookup->by_id = by_id;
+    lookup->buckets = buckets;
+
+    for (size_t i = 0; i < items->size; ++i)
+        if (i < index || i >= index + count)
+            Link(lookup, items->data[i]);
+}
+
+void
+vlc_playlist_LookupAdd(vlc_playlist_t *playlist, size_t index, size_t count)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+
+    if (lookup->valid > index)
+        lookup->valid = index;
+
+    Grow(playlist, index, count);
+    if (unlikely(!lookup->buckets))
+        return; /* lookups will fall back to linear searches */
+
+    for (size_t i = index; i < index + count; ++i)
+        Link(lookup, playlist->items.data[i]);
+}
+
+void
+vlc_playlist_LookupRemove(vlc_playlist_t *playlist, size_t index,
+                          size_t count)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+
+    if (lookup->valid > index)
+        lookup->valid = index;
+
+    if (lookup->buckets)
+        for (size_t i = index; i < index + count; ++i)
+            Unlink(lookup, playlist->items.data[i]);
+}
+
+void
+vlc_playlist_LookupReplace(vlc_playlist_t *playlist, size_t index,
+                           vlc_playlist_item_t *item)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+
+    if (lookup->buckets)
+    {
+        Unlink(lookup, playlist->items.data[index]);
+        Link(lookup, item);
+    }
+    item->index = index;
+}
+
+void
+vlc_playlist_LookupMoved(vlc_playlist_t *playlist, size_t index)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+
+    if (lookup->valid > index)
+        lookup->valid = index;
+}
+
+void
+vlc_playlist_LookupClear(vlc_playlist_t *playlist)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+
+    vlc_playlist_lookup_Destroy(lookup);
+    vlc_playlist_lookup_Init(lookup);
+}
+
+ssize_t
+vlc_playlist_LookupItem(vlc_playlist_t *playlist,
+                        const vlc_playlist_item_t *item)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+    playlist_item_vector_t *items = &playlist->items;
+
+    if (item->index < items->size && items->data[item->index] == item)
+        return item->index;
+
+    if (lookup->valid < items->size)
+    {
+        /* renumber the items moved since the last lookup */
+        for (size_t i = lookup->valid; i < items->size; ++i)
+            items->data[i]->index = i;
+        lookup->valid = items->size;
+
+        if (item->index < items->size && items->data[item->index] == item)
+            return item->index;
+    }
+    return -1;
+}
+
+ssize_t
+vlc_playlist_LookupMedia(vlc_playlist_t *playlist, const input_item_t *media)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+    if (unlikely(!lookup->buckets))
+    {
+        playlist_item_vector_t *items = &playlist->items;
+        for (size_t i = 0; i < items->size; ++i)
+            if (items->data[i]->media == media)
+                return i;
+        return -1;
+    }
+
+    /* the same media may be inserted several times, return the first one */
+    ssize_t index = -1;
+    vlc_playlist_item_t *item =
+        lookup->by_media[HashMedia(media) & (lookup->buckets - 1)];
+    for (; item; item = item->next_by_media)
+    {
+        if (item->media != media)
+            continue;
+        ssize_t i = vlc_playlist_LookupItem(playlist, item);
+        assert(i != -1);
+        if (index == -1 || i < index)
+            index = i;
+    }
+    return index;
+}
+
+ssize_t
+vlc_playlist_LookupId(vlc_playlist_t *playlist, uint64_t id)
+{
+    struct vlc_playlist_lookup *lookup = &playlist->lookup;
+    if (unlikely(!lookup->buckets))
+    {
+        playlist_item_vector_t *items = &playlist->items;
+        for (size_t i = 0; i < items->size; ++i)
+            if (items->data[i]->id == id)
+                return i;
+        return -1;
+    }
+
+    vlc_playlist_item_t *item = lookup->by_id[Hash(id) & (lookup->buckets - 1)];
+    for (; item; item = item->next_by_id)
+        if (item->id == id)
+            return vlc_playlist_LookupItem(playlist, item);
+    return -1;
+}
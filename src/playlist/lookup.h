@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * playlist/lookup.h
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_PLAYLIST_LOOKUP_H
+#define VLC_PLAYLIST_LOOKUP_H
+
+#include <vlc_common.h>
+
+typedef struct vlc_playlist vlc_playlist_t;
+typedef struct vlc_playlist_item vlc_playlist_item_t;
+typedef struct input_item_t input_item_t;
+
+/**
+ * Hash indexes of the playlist items, by media and by id.
+ *
+ * Each item caches its position in the playlist. The positions below "valid"
+ * are up-to-date; the others are recomputed on the next lookup, so that a
+ * batch of changes costs a single pass.
+ */
+struct vlc_playlist_lookup
+{
+    vlc_playlist_item_t **by_media;
+    vlc_playlist_item_t **by_id;
+    size_t buckets; /**< number of buckets of each table (power of 2), 0 if
+                         the tables could not be allocated */
+    size_t valid;
+};
+
+void
+vlc_playlist_lookup_Init(struct vlc_playlist_lookup *lookup);
+
+void
+vlc_playlist_lookup_Destroy(struct vlc_playlist_lookup *lookup);
+
+/* the items [index, index + count) have just been inserted */
+void
+vlc_playlist_LookupAdd(vlc_playlist_t *playlist, size_t index, size_t count);
+
+/* the items [index, index + count) are about to be removed */
+void
+vlc_playlist_LookupRemove(vlc_playlist_t *playlist, size_t index,
+                          size_t count);
+
+/* the item at index is about to be replaced by item */
+void
+vlc_playlist_LookupReplace(vlc_playlist_t *playlist, size_t index,
+                           vlc_playlist_item_t *item);
+
+/* the items have been reordered from index */
+void
+vlc_playlist_LookupMoved(vlc_playlist_t *playlist, size_t index);
+
+/* all the items are about to be removed */
+void
+vlc_playlist_LookupClear(vlc_playlist_t *playlist);
+
+ssize_t
+vlc_playlist_LookupItem(vlc_playlist_t *playlist,
+                        const vlc_playlist_item_t *item);
+
+ssize_t
+vlc_playlist_LookupMedia(vlc_playlist_t *playlist, const input_item_t *media);
+
+ssize_t
+vlc_playlist_LookupId(vlc_playlist_t *playlist, uint64_t id);
+
+#endif
@@ -383,6 +383,7 @@ vlc_playlist_Sort(vlc_playlist_t *playlist,
     /* apply the sorting result to the playlist */
     for (size_t i = 0; i < playlist->items.size; ++i)
         playlist->items.data[i] = array[i]->item;
+    vlc_playlist_LookupMoved(playlist, 0);
 
     vlc_playlist_DeleteMetaArray(array, playlist->items.size);
 
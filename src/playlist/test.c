@@ -25,6 +25,7 @@
 #endif
 
 #include <stdio.h>
+#include "content.h"
 #include "item.h"
 #include "playlist.h"
 #include "preparse.h"
@@ -1065,6 +1066,123 @@ test_index_of(void)
     vlc_playlist_Delete(playlist);
 }
 
+static void
+test_index_of_after_changes(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL);
+    assert(playlist);
+
+    input_item_t *media[10];
+    CreateDummyMediaArray(media, 10);
+
+    /* media[0], media[1], media[2] are inserted twice */
+    int ret = vlc_playlist_Append(playlist, media, 10);
+    assert(ret == VLC_SUCCESS);
+    ret = vlc_playlist_Append(playlist, media, 3);
+    assert(ret == VLC_SUCCESS);
+
+    /* the first occurrence is returned */
+    assert(vlc_playlist_IndexOfMedia(playlist, media[1]) == 1);
+
+    vlc_playlist_item_t *dup = vlc_playlist_Get(playlist, 11);
+    assert(dup->media == media[1]);
+    uint64_t dup_id = dup->id;
+    assert(vlc_playlist_IndexOfId(playlist, dup_id) == 11);
+
+    /* move the duplicate before the original */
+    vlc_playlist_Move(playlist, 11, 1, 0);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[1]) == 0);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[9]) == 10);
+    assert(vlc_playlist_IndexOfId(playlist, dup_id) == 0);
+    assert(vlc_playlist_IndexOf(playlist, dup) == 0);
+
+    /* remove it */
+    vlc_playlist_RemoveOne(playlist, 0);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[1]) == 1);
+    assert(vlc_playlist_IndexOfId(playlist, dup_id) == -1);
+
+    /* remove the original too */
+    vlc_playlist_RemoveOne(playlist, 1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[1]) == -1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[2]) == 1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[9]) == 8);
+
+    /* the index matches a linear search after a shuffle */
+    vlc_playlist_Shuffle(playlist);
+    for (size_t i = 0; i < vlc_playlist_Count(playlist); ++i)
+    {
+        vlc_playlist_item_t *item = vlc_playlist_Get(playlist, i);
+        assert(vlc_playlist_IndexOf(playlist, item) == (ssize_t) i);
+        assert(vlc_playlist_IndexOfId(playlist, item->id) == (ssize_t) i);
+        ssize_t first = vlc_playlist_IndexOfMedia(playlist, item->media);
+        assert(first != -1 && first <= (ssize_t) i);
+        for (ssize_t j = 0; j < first; ++j)
+            assert(vlc_playlist_Get(playlist, j)->media != item->media);
+    }
+
+    /* expand an item into 3 media */
+    ssize_t index = vlc_playlist_IndexOfMedia(playlist, media[5]);
+    assert(index != -1);
+    ret = vlc_playlist_Expand(playlist, index, &media[6], 3);
+    assert(ret == VLC_SUCCESS);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[5]) == -1);
+    assert(vlc_playlist_Get(playlist, index + 2)->media == media[8]);
+    vlc_playlist_item_t *item = vlc_playlist_Get(playlist, index + 2);
+    assert(vlc_playlist_IndexOfId(playlist, item->id) == index + 2);
+
+    vlc_playlist_Clear(playlist);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[0]) == -1);
+    assert(vlc_playlist_IndexOfId(playlist, dup_id) == -1);
+
+    DestroyMediaArray(media, 10);
+    vlc_playlist_Delete(playlist);
+}
+
+static void
+bench_index_of(size_t count)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL);
+    assert(playlist);
+
+    input_item_t **media = vlc_alloc(count, sizeof(*media));
+    assert(media);
+    CreateDummyMediaArray(media, count);
+
+    int ret = vlc_playlist_Append(playlist, media, count);
+    assert(ret == VLC_SUCCESS);
+
+    const size_t lookups = 10000;
+    vlc_tick_t start = vlc_tick_now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        size_t index = (i * 7919) % count;
+        ssize_t found = vlc_playlist_IndexOfMedia(playlist, media[index]);
+        assert(found == (ssize_t) index);
+    }
+    vlc_tick_t by_media = vlc_tick_now() - start;
+
+    /* removing from the front shifts all the positions */
+    const size_t removals = count / 2 < lookups / 10 ? count / 2 : lookups / 10;
+    start = vlc_tick_now();
+    for (size_t i = 0; i < removals; ++i)
+    {
+        vlc_playlist_RemoveOne(playlist, 0);
+        vlc_playlist_item_t *last = vlc_playlist_Get(playlist,
+                                            vlc_playlist_Count(playlist) - 1);
+        ssize_t found = vlc_playlist_IndexOfId(playlist, last->id);
+        assert(found == (ssize_t) vlc_playlist_Count(playlist) - 1);
+    }
+    vlc_tick_t by_id = vlc_tick_now() - start;
+
+    printf("%zu items: IndexOfMedia %"PRId64" ns, RemoveOne+IndexOfId %"
+           PRId64" ns\n", count, NS_FROM_VLC_TICK(by_media) / lookups,
+           NS_FROM_VLC_TICK(by_id) / removals);
+
+    vlc_playlist_Delete(playlist);
+    DestroyMediaArray(media, count);
+    free(media);
+}
+
 static void
 test_prev(void)
 {
@@ -2367,6 +2485,7 @@ int main(void)
     test_playback_order_changed_callbacks();
     test_callbacks_on_add_listener();
     test_index_of();
+    test_index_of_after_changes();
     test_prev();
     test_next();
     test_goto();
@@ -2384,6 +2503,9 @@ int main(void)
     test_random();
     test_shuffle();
     test_sort();
+    bench_index_of(1000);
+    bench_index_of(10000);
+    bench_index_of(100000);
     return 0;
 }
 
@@ -24,6 +24,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #undef NDEBUG
 #include <assert.h>
 
@@ -86,11 +87,204 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = VLC_TICK_FROM_SEC(1);
+
+    block_t *dup = block_Share (block);
+    assert (dup != NULL);
+    assert (dup->p_buffer == block->p_buffer);
+    assert (dup->i_buffer == block->i_buffer);
+    assert (dup->i_pts == block->i_pts);
+
+    block_t *dup2 = block_Share (dup);
+    assert (dup2 != NULL);
+    assert (dup2->p_buffer == block->p_buffer);
+
+    /* Growing a shared block must not write into the shared payload */
+    block = block_Realloc (block, 16, sizeof (text));
+    assert (block != NULL);
+    assert (block->p_buffer + 16 != dup->p_buffer);
+    memset (block->p_buffer, 'A', 16);
+    assert (!memcmp (block->p_buffer + 16, text, sizeof (text)));
+    block_Release (block);
+
+    /* Writable copy of a shared block */
+    dup = block_MakeWritable (dup);
+    assert (dup != NULL);
+    assert (dup->p_buffer != dup2->p_buffer);
+    memset (dup->p_buffer, 'A', dup->i_buffer);
+    assert (!memcmp (dup2->p_buffer, text, sizeof (text)));
+    block_Release (dup);
+
+    /* Last reference: no copy needed */
+    uint8_t *p = dup2->p_buffer;
+    dup2 = block_MakeWritable (dup2);
+    assert (dup2 != NULL);
+    assert (dup2->p_buffer == p);
+    block_Release (dup2);
+}
+
+#define FANOUT_OUTPUTS 6
+#define FANOUT_PACKETS 20000
+#define FANOUT_SIZE    (7 * 188)
+
+static void bench_block_Fanout (bool share)
+{
+    uint64_t copied = 0;
+    vlc_tick_t start = vlc_tick_now ();
+
+    for (unsigned i = 0; i < FANOUT_PACKETS; i++)
+    {
+        block_t *outs[FANOUT_OUTPUTS];
+        block_t *block = block_Alloc (FANOUT_SIZE);
+        assert (block != NULL);
+        memset (block->p_buffer, i, block->i_buffer);
+
+        for (unsigned j = 0; j < FANOUT_OUTPUTS - 1; j++)
+        {
+            if (share)
+                outs[j] = block_Share (block);
+            else
+            {
+                outs[j] = block_Duplicate (block);
+                copied += block->i_buffer;
+            }
+            assert (outs[j] != NULL);
+        }
+        outs[FANOUT_OUTPUTS - 1] = block;
+
+        for (unsigned j = 0; j < FANOUT_OUTPUTS; j++)
+            block_Release (outs[j]);
+    }
+
+    vlc_tick_t elapsed = vlc_tick_now () - start;
+    if (elapsed <= 0)
+        elapsed = 1;
+    printf ("1->%u fan-out using %s: %"PRIu64" bytes copied, %"PRIu64
+            " packets/s, %"PRIu64" bytes copied/s\n", FANOUT_OUTPUTS,
+            share ? "block_Share" : "block_Duplicate", copied,
+            (uint64_t)FANOUT_PACKETS * CLOCK_FREQ / elapsed,
+            copied * CLOCK_FREQ / elapsed);
+}
+
+static size_t get_rss (void)
+{
+    size_t rss = 0;
+#ifdef __linux__
+    FILE *stream = fopen ("/proc/self/statm", "re");
+    if (stream != NULL)
+    {
+        unsigned long size, resident;
+        if (fscanf (stream, "%lu %lu", &size, &resident) == 2)
+            rss = resident * sysconf (_SC_PAGESIZE);
+        fclose (stream);
+    }
+#endif
+    return rss;
+}
+
+#define POOL_WINDOW 4096
+#define POOL_ROUNDS 200000
+
+static void bench_block_Pool (bool enabled)
+{
+    static const size_t sizes[] = { 188, 1316, 1316, 188, 3000, 20000 };
+    block_t *window[POOL_WINDOW] = { NULL };
+
+    block_PoolEnable (enabled);
+
+    vlc_tick_t start = vlc_tick_now ();
+    for (unsigned i = 0; i < POOL_ROUNDS; i++)
+    {
+        unsigned slot = (i * 2654435761u) % POOL_WINDOW;
+
+        if (window[slot] != NULL)
+            block_Release (window[slot]);
+        window[slot] = block_Alloc (sizes[i % ARRAY_SIZE(sizes)]);
+        assert (window[slot] != NULL);
+        window[slot]->p_buffer[0] = i;
+    }
+    vlc_tick_t elapsed = vlc_tick_now () - start;
+    size_t rss = get_rss ();
+
+    for (unsigned i = 0; i < POOL_WINDOW; i++)
+        if (window[i] != NULL)
+            block_Release (window[i]);
+
+    if (elapsed <= 0)
+        elapsed = 1;
+    printf ("block_Alloc/block_Release with%s pool: %"PRIu64" blocks/s, "
+            "RSS %zu kB\n", enabled ? "" : "out",
+            (uint64_t)POOL_ROUNDS * CLOCK_FREQ / elapsed, rss / 1024);
+
+    if (enabled)
+    {
+        struct block_pool_stats st;
+
+        block_PoolGetStats (&st);
+        printf ("block pool: %"PRIu64" allocations, %"PRIu64" recycled, "
+                "%"PRIu64" released to the pool, %"PRIu64" freed, "
+                "%zu bytes cached\n", st.allocs, st.hits, st.recycled,
+                st.discarded, st.cached_bytes);
+        assert (st.hits <= st.allocs);
+        assert (st.hits <= st.recycled);
+    }
+    block_PoolEnable (false);
+}
+
+static void test_block_Pool (void)
+{
+    block_PoolEnable (true);
+
+    block_t *block = block_Alloc (100);
+    assert (block != NULL);
+    assert (block->i_buffer == 100);
+    assert (((uintptr_t)block->p_buffer % 32) == 0);
+    uint8_t *p = block->p_buffer;
+    block_Release (block);
+
+    /* Same size class from the same thread: recycled */
+    block = block_Alloc (60);
+    assert (block != NULL);
+    assert (block->p_buffer == p);
+    assert (block->i_buffer == 60);
+
+    /* Growing within the size class works in place */
+    block = block_Realloc (block, 0, 188);
+    assert (block != NULL);
+    assert (block->p_buffer == p);
+    assert (block->i_buffer == 188);
+    block_Release (block);
+
+    /* Sizes beyond the largest class are not pooled */
+    block = block_Alloc (1 << 20);
+    assert (block != NULL);
+    block_Release (block);
+
+    /* Disabling the pool frees the cached blocks */
+    block_PoolEnable (false);
+
+    struct block_pool_stats st;
+
+    block_PoolGetStats (&st);
+    assert (st.cached_bytes == 0);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Share ();
+    bench_block_Fanout (false);
+    bench_block_Fanout (true);
+    test_block_Pool ();
+    bench_block_Pool (false);
+    bench_block_Pool (true);
     return 0;
 }
 
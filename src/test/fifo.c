@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * fifo.c: Test for block FIFO
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#define PACKETS 200000
+#define PRODUCERS 2
+
+struct producer
+{
+    vlc_fifo_t *fifo;
+    bool lockless;
+    unsigned id;
+    unsigned count;
+};
+
+static void *Produce(void *data)
+{
+    struct producer *p = data;
+
+    for (unsigned i = 0; i < p->count; i++)
+    {
+        block_t *block = block_Alloc(16);
+        assert(block != NULL);
+        block->i_dts = i;
+        block->p_buffer[0] = p->id;
+
+        if (p->lockless)
+            vlc_fifo_QueueLockless(p->fifo, block);
+        else
+            block_FifoPut(p->fifo, block);
+    }
+    return NULL;
+}
+
+/* Consumes like the DecoderThread does */
+static void Consume(vlc_fifo_t *fifo, unsigned producers, unsigned count)
+{
+    vlc_tick_t next[PRODUCERS] = { 0 };
+    unsigned received = 0;
+
+    vlc_fifo_Lock(fifo);
+    while (received < producers * count)
+    {
+        block_t *block = vlc_fifo_DequeueUnlocked(fifo);
+        if (block == NULL)
+        {
+            vlc_fifo_Wait(fifo);
+            continue;
+        }
+        vlc_fifo_Unlock(fifo);
+
+        /* Each producer's blocks come out in order */
+        unsigned id = block->p_buffer[0];
+        assert(id < producers);
+        assert(block->i_dts == next[id]);
+        next[id]++;
+        received++;
+        block_Release(block);
+
+        vlc_fifo_Lock(fifo);
+    }
+    assert(vlc_fifo_IsEmpty(fifo));
+    vlc_fifo_Unlock(fifo);
+}
+
+static void test_fifo_Lockless(void)
+{
+    vlc_fifo_t *fifo = block_FifoNewLockless();
+    assert(fifo != NULL);
+
+    /* More blocks than the ring holds without consumer: falls back to the
+     * locked list, in order */
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        block_t *block = block_Alloc(1);
+        assert(block != NULL);
+        block->i_dts = i;
+        vlc_fifo_QueueLockless(fifo, block);
+        /* The producer sees the size of what it queued */
+        assert(vlc_fifo_GetBytesLockless(fifo) == i + 1);
+    }
+
+    vlc_fifo_Lock(fifo);
+    assert(vlc_fifo_GetCount(fifo) == 1000);
+    assert(vlc_fifo_GetBytes(fifo) == 1000);
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        block_t *block = vlc_fifo_DequeueUnlocked(fifo);
+        assert(block != NULL);
+        assert(block->i_dts == i);
+        block_Release(block);
+    }
+    vlc_fifo_Unlock(fifo);
+    assert(vlc_fifo_GetBytesLockless(fifo) == 0);
+
+    /* Chains and leftovers released with the FIFO */
+    block_t *chain = block_Alloc(1);
+    assert(chain != NULL);
+    chain->p_next = block_Alloc(2);
+    assert(chain->p_next != NULL);
+    vlc_fifo_QueueLockless(fifo, chain);
+    vlc_fifo_QueueLockless(fifo, NULL);
+    vlc_fifo_Lock(fifo);
+    assert(vlc_fifo_GetCount(fifo) == 2);
+    assert(vlc_fifo_GetBytes(fifo) == 3);
+    vlc_fifo_Unlock(fifo);
+    assert(vlc_fifo_GetBytesLockless(fifo) == 3);
+    block_FifoEmpty(fifo);
+    assert(vlc_fifo_GetBytesLockless(fifo) == 0);
+    vlc_fifo_QueueLockless(fifo, block_Alloc(4));
+    block_FifoRelease(fifo);
+
+    /* Not enabled: plain queue */
+    fifo = block_FifoNew();
+    assert(fifo != NULL);
+    vlc_fifo_QueueLockless(fifo, block_Alloc(1));
+    vlc_fifo_Lock(fifo);
+    assert(vlc_fifo_GetCount(fifo) == 1);
+    vlc_fifo_Unlock(fifo);
+    block_FifoRelease(fifo);
+}
+
+static void bench_fifo(bool lockless, unsigned producers)
+{
+    vlc_fifo_t *fifo = lockless ? block_FifoNewLockless() : block_FifoNew();
+    assert(fifo != NULL);
+
+    struct producer p[PRODUCERS];
+    vlc_thread_t th[PRODUCERS];
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned i = 0; i < producers; i++)
+    {
+        p[i].fifo = fifo;
+        p[i].lockless = lockless;
+        p[i].id = i;
+        p[i].count = PACKETS / producers;
+        int ret = vlc_clone(&th[i], Produce, &p[i], VLC_THREAD_PRIORITY_LOW);
+        assert(ret == 0);
+    }
+
+    Consume(fifo, producers, PACKETS / producers);
+
+    for (unsigned i = 0; i < producers; i++)
+        vlc_join(th[i], NULL);
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    if (elapsed <= 0)
+        elapsed = 1;
+    printf("%u producer(s) %s: %"PRIu64" blocks/s\n", producers,
+           lockless ? "vlc_fifo_QueueLockless" : "block_FifoPut",
+           (uint64_t)PACKETS * CLOCK_FREQ / elapsed);
+
+    block_FifoRelease(fifo);
+}
+
+int main(void)
+{
+    test_fifo_Lockless();
+    bench_fifo(false, 1);
+    bench_fifo(true, 1);
+    bench_fifo(false, PRODUCERS);
+    bench_fifo(true, PRODUCERS);
+    return 0;
+}
@@ -86,6 +86,10 @@ struct spu_private_t {
     vlc_mutex_t textlock;
     filter_t *scale_yuvp;                     /**< scaling module for YUVP */
     filter_t *scale;                    /**< scaling module (all but YUVP) */
+    struct {
+        unsigned done;                     /**< regions scaled or converted */
+        unsigned avoided;          /**< region renders reusing a conversion */
+    } conversions;
     bool force_crop;                     /**< force cropping of subpicture */
     struct {
         int x;
@@ -774,6 +778,48 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
 
 
 
+/**
+ * Tells if the cached conversion of a region is still up to date.
+ */
+static bool SpuRegionCacheIsValid(const subpicture_region_t *region,
+                                  unsigned dst_width, unsigned dst_height,
+                                  vlc_fourcc_t dst_chroma)
+{
+    const subpicture_region_private_t *private = region->p_private;
+    const video_format_t *src = &private->source_fmt;
+
+    /* Check content changes */
+    if (private->p_source != region->p_picture ||
+        src->i_chroma         != region->fmt.i_chroma ||
+        src->i_x_offset       != region->fmt.i_x_offset ||
+        src->i_y_offset       != region->fmt.i_y_offset ||
+        src->i_visible_width  != region->fmt.i_visible_width ||
+        src->i_visible_height != region->fmt.i_visible_height)
+        return false;
+
+    /* Check palette changes, including a palette being added or removed */
+    const video_palette_t *old_palette = src->p_palette;
+    const video_palette_t *palette = region->fmt.p_palette;
+    if ((old_palette == NULL) != (palette == NULL))
+        return false;
+    if (palette != NULL) {
+        if (old_palette->i_entries != palette->i_entries)
+            return false;
+        const size_t entries = VLC_CLIP(palette->i_entries, 0,
+                                        VIDEO_PALETTE_COLORS_MAX);
+        if (memcmp(old_palette->palette, palette->palette,
+                   entries * sizeof (palette->palette[0])))
+            return false;
+    }
+
+    /* Check resize changes */
+    if (dst_width  != private->fmt.i_visible_width ||
+        dst_height != private->fmt.i_visible_height)
+        return false;
+
+    return dst_chroma == 0 || private->fmt.i_chroma == dst_chroma;
+}
+
 /**
  * It will transform the provided region into another region suitable for rendering.
  */
@@ -954,25 +1000,13 @@ static void SpuRenderRegion(spu_t *spu,
 
         /* Destroy the cache if unusable */
         if (region->p_private) {
-            subpicture_region_private_t *private = region->p_private;
-            bool is_changed = false;
-
-            /* Check resize changes */
-            if (dst_width  != private->fmt.i_visible_width ||
-                dst_height != private->fmt.i_visible_height)
-                is_changed = true;
-
-            /* Check forced palette changes */
-            if (changed_palette)
-                is_changed = true;
-
-            if (convert_chroma && private->fmt.i_chroma != chroma_list[0])
-                is_changed = true;
-
-            if (is_changed) {
-                subpicture_region_private_Delete(private);
+            if (changed_palette ||
+                !SpuRegionCacheIsValid(region, dst_width, dst_height,
+                                       convert_chroma ? chroma_list[0] : 0)) {
+                subpicture_region_private_Delete(region->p_private);
                 region->p_private = NULL;
-            }
+            } else
+                sys->conversions.avoided++;
         }
 
         /* Scale if needed into cache */
@@ -1032,13 +1066,16 @@ static void SpuRenderRegion(spu_t *spu,
                 region->p_private = subpicture_region_private_New(&picture->format);
                 if (region->p_private) {
                     region->p_private->p_picture = picture;
-                    if (!region->p_private->p_picture) {
+                    region->p_private->p_source = picture_Hold(region->p_picture);
+                    if (video_format_Copy(&region->p_private->source_fmt,
+                                          &region->fmt) != VLC_SUCCESS) {
                         subpicture_region_private_Delete(region->p_private);
                         region->p_private = NULL;
                     }
                 } else {
                     picture_Release(picture);
                 }
+                sys->conversions.done++;
             }
         }
 
@@ -1582,6 +1619,9 @@ static void spu_Cleanup(spu_t *spu)
 {
     spu_private_t *sys = spu->p;
 
+    msg_Dbg(spu, "%u subpicture region conversions, %u avoided by reuse",
+            sys->conversions.done, sys->conversions.avoided);
+
     if (sys->text)
         FilterRelease(sys->text);
     vlc_mutex_destroy(&sys->textlock);
@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <signal.h>
 
@@ -100,4 +101,36 @@ static inline void test_init (void)
     setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
 }
 
+/* Verbose instance ignoring the user configuration, with extra options */
+static inline libvlc_instance_t *test_libvlc_new(int argc,
+                                                 const char *const *argv)
+{
+    const char *args[2 + argc];
+
+    args[0] = "-v";
+    args[1] = "--ignore-config";
+    for (int i = 0; i < argc; i++)
+        args[2 + i] = argv[i];
+
+    libvlc_instance_t *vlc = libvlc_new(2 + argc, args);
+    assert(vlc != NULL);
+    return vlc;
+}
+
+/* Reproducible pseudo-random numbers for test data */
+static inline uint32_t test_rand(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed;
+}
+
+/* Prints the throughput of a benchmark: count units processed in elapsed
+ * microseconds */
+static inline void test_print_rate(const char *name, const char *unit,
+                                   double count, int64_t elapsed)
+{
+    printf("%s: %.1f %s/s\n", name,
+           count * 1000000. / (elapsed > 0 ? elapsed : 1), unit);
+}
+
 #endif /* TEST_H */
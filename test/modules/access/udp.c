@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * udp.c: UDP access loopback test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+
+#include <inttypes.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define DGRAM_SIZE  (7 * 188)
+#define DGRAM_COUNT 50000
+
+/* Datagrams larger than the initial receive slots, sent in bursts so that
+ * several of them are received by the same call */
+#define LARGE_SIZE  9000
+#define LARGE_COUNT 256
+#define LARGE_BURST 8
+
+struct sender
+{
+    uint16_t port;
+    uint64_t sent;
+};
+
+static void *SendLarge(void *data)
+{
+    struct sender *snd = data;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(snd->port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    uint8_t buf[LARGE_SIZE];
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+
+    vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(200));
+
+    for (uint32_t seq = 0; seq < LARGE_COUNT; seq++)
+    {
+        for (size_t i = 0; i < sizeof (buf); i++)
+            buf[i] = seq + i;
+        if (sendto(fd, buf, sizeof (buf), 0, (struct sockaddr *)&addr,
+                   sizeof (addr)) == sizeof (buf))
+            snd->sent++;
+        if ((seq % LARGE_BURST) == LARGE_BURST - 1)
+            vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(10));
+    }
+    close(fd);
+    return NULL;
+}
+
+static void *Send(void *data)
+{
+    struct sender *snd = data;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(snd->port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    uint8_t buf[DGRAM_SIZE];
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+
+    /* Opening the stream probes data: leave time for the receiver to bind
+     * its socket before sending. */
+    vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(200));
+
+    for (uint32_t seq = 0; seq < DGRAM_COUNT; seq++)
+    {
+        memset(buf, 0x47, sizeof (buf));
+        SetDWBE(buf + 4, seq);
+        if (sendto(fd, buf, sizeof (buf), 0, (struct sockaddr *)&addr,
+                   sizeof (addr)) == sizeof (buf))
+            snd->sent++;
+        /* Pace a little to keep loopback losses low */
+        if ((seq % 128) == 127)
+            vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(1));
+    }
+    close(fd);
+    return NULL;
+}
+
+static uint16_t GetFreePort(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t len = sizeof (addr);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    assert(bind(fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&addr, &len) == 0);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void test_udp(unsigned batch)
+{
+    char batch_arg[32];
+    snprintf(batch_arg, sizeof (batch_arg), "--udp-batch=%u", batch);
+
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--udp-timeout=1",
+        batch_arg,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    struct sender snd = { .port = GetFreePort(), .sent = 0 };
+
+    char url[64];
+    snprintf(url, sizeof (url), "udp://@127.0.0.1:%"PRIu16, snd.port);
+
+    vlc_thread_t th;
+    assert(vlc_clone(&th, Send, &snd, VLC_THREAD_PRIORITY_LOW) == 0);
+
+    stream_t *s = vlc_stream_NewURL(vlc->p_libvlc_int, url);
+    assert(s != NULL);
+
+    uint8_t buf[DGRAM_SIZE];
+    uint64_t received = 0;
+    int64_t last = -1;
+    vlc_tick_t start = VLC_TICK_INVALID, end = VLC_TICK_INVALID;
+
+    while (vlc_stream_Read(s, buf, sizeof (buf)) == sizeof (buf))
+    {
+        end = vlc_tick_now();
+        if (start == VLC_TICK_INVALID)
+            start = end;
+
+        /* Datagrams are delivered whole and in order */
+        assert(buf[0] == 0x47 && buf[DGRAM_SIZE - 1] == 0x47);
+        int64_t seq = GetDWBE(buf + 4);
+        assert(seq > last);
+        last = seq;
+        received++;
+    }
+
+    vlc_join(th, NULL);
+    vlc_stream_Delete(s);
+    libvlc_release(vlc);
+
+    assert(received > 0);
+    assert(received <= snd.sent);
+
+    vlc_tick_t elapsed = end - start;
+    if (elapsed <= 0)
+        elapsed = 1;
+    test_log("udp-batch=%u: received %"PRIu64"/%"PRIu64" datagrams, "
+             "%"PRIu64" datagrams/s, %"PRIu64" kbit/s\n", batch, received,
+             snd.sent, received * CLOCK_FREQ / elapsed,
+             received * DGRAM_SIZE * 8 * CLOCK_FREQ / elapsed / 1000);
+}
+
+static void test_udp_large(unsigned batch)
+{
+    char batch_arg[32];
+    snprintf(batch_arg, sizeof (batch_arg), "--udp-batch=%u", batch);
+
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--udp-timeout=1",
+        batch_arg,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    struct sender snd = { .port = GetFreePort(), .sent = 0 };
+
+    char url[64];
+    snprintf(url, sizeof (url), "udp://@127.0.0.1:%"PRIu16, snd.port);
+
+    vlc_thread_t th;
+    assert(vlc_clone(&th, SendLarge, &snd, VLC_THREAD_PRIORITY_LOW) == 0);
+
+    stream_t *s = vlc_stream_NewURL(vlc->p_libvlc_int, url);
+    assert(s != NULL);
+
+    uint8_t buf[LARGE_SIZE];
+    uint64_t received = 0, lost = 0;
+    uint8_t seq = 0;
+
+    while (vlc_stream_Read(s, buf, sizeof (buf)) == sizeof (buf))
+    {
+        /* Whole and in order. Only the last of the datagrams larger than
+         * the receive slots in the same batch is kept, and only until the
+         * slots grow: none are missing after the first ones. */
+        if (buf[0] != seq)
+        {
+            assert(received == 0);
+            lost = (uint8_t)(buf[0] - seq);
+            seq = buf[0];
+        }
+        for (size_t i = 0; i < sizeof (buf); i++)
+            assert(buf[i] == (uint8_t)(seq + i));
+        received++;
+        seq++;
+    }
+
+    vlc_join(th, NULL);
+    vlc_stream_Delete(s);
+    libvlc_release(vlc);
+
+    test_log("udp-batch=%u: received %"PRIu64"/%"PRIu64" large datagrams\n",
+             batch, received, snd.sent);
+    assert(lost < batch);
+    assert(received + lost == snd.sent);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_udp(1);
+    test_udp(32);
+    test_udp_large(1);
+    test_udp_large(32);
+    return 0;
+}
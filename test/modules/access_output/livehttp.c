@@ -0,0 +1,357 @@
+/*****************************************************************************
+ * livehttp.c: HTTP live streaming access output test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_modules.h>
+#include <vlc_sout.h>
+
+#include <gcrypt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BLOCK_SIZE 1000 /* not a multiple of the AES block size */
+#define BLOCKS     30
+
+static const uint8_t key[16] = "0123456789abcdef";
+
+/* Each block starts with its number, so that every segment can be checked
+ * on its own */
+static uint8_t Pattern(unsigned block, unsigned offset)
+{
+    if (offset < 4)
+        return block >> (8 * (3 - offset));
+    return block * 31 + offset;
+}
+
+static void WriteBlocks(sout_access_out_t *access, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        block_t *block = block_Alloc(BLOCK_SIZE);
+        assert(block != NULL);
+
+        for (unsigned j = 0; j < BLOCK_SIZE; j++)
+            block->p_buffer[j] = Pattern(i, j);
+        block->i_length = VLC_TICK_FROM_SEC(1);
+        block->i_flags |= BLOCK_FLAG_HEADER;
+        sout_AccessOutWrite(access, block);
+    }
+}
+
+/* Decrypts a segment (AES-128-CBC, segment number as IV), checks its
+ * blocks and returns the number of its first block */
+static unsigned CheckSegment(unsigned number, uint8_t *data, size_t len)
+{
+    uint8_t iv[16] = { 0 };
+    gcry_cipher_hd_t hd;
+
+    iv[12] = number >> 24;
+    iv[13] = number >> 16;
+    iv[14] = number >> 8;
+    iv[15] = number;
+
+    assert(len > 0 && (len % 16) == 0);
+    assert(gcry_cipher_open(&hd, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CBC, 0) == 0);
+    assert(gcry_cipher_setkey(hd, key, sizeof (key)) == 0);
+    assert(gcry_cipher_setiv(hd, iv, sizeof (iv)) == 0);
+    assert(gcry_cipher_decrypt(hd, data, len, NULL, 0) == 0);
+    gcry_cipher_close(hd);
+
+    /* PKCS#7 padding */
+    unsigned pad = data[len - 1];
+    assert(pad >= 1 && pad <= 16);
+    for (unsigned i = 1; i <= pad; i++)
+        assert(data[len - i] == pad);
+    len -= pad;
+
+    assert(len > 0 && (len % BLOCK_SIZE) == 0);
+    unsigned first = GetDWBE(data);
+    for (size_t i = 0; i < len; i++)
+        assert(data[i] == Pattern(first + i / BLOCK_SIZE, i % BLOCK_SIZE));
+    return first;
+}
+
+static unsigned SegmentNumber(const char *uri)
+{
+    unsigned number;
+    const char *name = strrchr(uri, '/');
+
+    assert(name != NULL);
+    assert(sscanf(name, "/seg-%u.ts", &number) == 1);
+    return number;
+}
+
+static size_t SegmentBlocks(const uint8_t *data, size_t len)
+{
+    return (len - data[len - 1]) / BLOCK_SIZE;
+}
+
+static char *ReadFile(const char *path, size_t *len)
+{
+    FILE *stream = vlc_fopen(path, "rb");
+    assert(stream != NULL);
+
+    char *data = NULL;
+    size_t size = 0;
+    for (;;)
+    {
+        data = realloc(data, size + 4096 + 1);
+        assert(data != NULL);
+        size_t val = fread(data + size, 1, 4096, stream);
+        size += val;
+        if (val == 0)
+            break;
+    }
+    fclose(stream);
+    data[size] = '\0';
+    *len = size;
+    return data;
+}
+
+static void test_files(libvlc_instance_t *vlc, const char *dir)
+{
+    char keypath[256], index[256], path[256], chain[1024];
+
+    snprintf(keypath, sizeof (keypath), "%s/key.bin", dir);
+    snprintf(index, sizeof (index), "%s/live.m3u8", dir);
+    snprintf(path, sizeof (path), "%s/seg-###.ts", dir);
+    snprintf(chain, sizeof (chain), "livehttp{seglen=2,index=\"%s\","
+             "key-uri=key.bin,key-file=\"%s\",queue-size=1}", index, keypath);
+
+    sout_access_out_t *access =
+        sout_AccessOutNew(vlc->p_libvlc_int, chain, path);
+    assert(access != NULL);
+    WriteBlocks(access, BLOCKS);
+    sout_AccessOutDelete(access);
+
+    /* Every segment of the finished stream is listed and kept */
+    size_t len;
+    char *m3u = ReadFile(index, &len);
+    assert(strstr(m3u, "#EXT-X-KEY:METHOD=AES-128,URI=\"key.bin\"\n"));
+    assert(strstr(m3u, "#EXT-X-ENDLIST") != NULL);
+
+    unsigned next = 0;
+    for (char *line = strtok(m3u, "\n"); line; line = strtok(NULL, "\n"))
+    {
+        if (line[0] == '#')
+            continue;
+
+        uint8_t *data = (uint8_t *)ReadFile(line, &len);
+        assert(CheckSegment(SegmentNumber(line), data, len) == next);
+        next += SegmentBlocks(data, len);
+        free(data);
+        vlc_unlink(line);
+    }
+    assert(next == BLOCKS);
+    free(m3u);
+    vlc_unlink(index);
+}
+
+static uint16_t FreePort(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof (addr);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd != -1);
+    int ret = bind(fd, (struct sockaddr *)&addr, sizeof (addr));
+    assert(ret == 0);
+    ret = getsockname(fd, (struct sockaddr *)&addr, &addrlen);
+    assert(ret == 0);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/* Returns the HTTP status, and the body in *body */
+static int Get(uint16_t port, const char *url, char **body, size_t *len)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    char req[256];
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd != -1);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    snprintf(req, sizeof (req), "GET %s HTTP/1.0\r\n\r\n", url);
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+
+    char *data = NULL;
+    size_t size = 0;
+    for (;;)
+    {
+        data = realloc(data, size + 4096 + 1);
+        assert(data != NULL);
+        ssize_t val = read(fd, data + size, 4096);
+        assert(val >= 0);
+        if (val == 0)
+            break;
+        size += val;
+    }
+    close(fd);
+    data[size] = '\0';
+
+    int status;
+    assert(sscanf(data, "HTTP/1.%*d %d", &status) == 1);
+    char *end = strstr(data, "\r\n\r\n");
+    assert(end != NULL);
+    end += 4;
+    *len = size - (end - data);
+    *body = malloc(*len + 1);
+    assert(*body != NULL);
+    memcpy(*body, end, *len + 1);
+    free(data);
+    return status;
+}
+
+static void test_memory(const char *dir)
+{
+    char keypath[256], port_arg[32], url[32];
+    uint16_t port = FreePort();
+
+    snprintf(keypath, sizeof (keypath), "%s/key.bin", dir);
+    snprintf(port_arg, sizeof (port_arg), "--http-port=%u", port);
+
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "--http-host=127.0.0.1",
+        port_arg,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    /* Segments in memory would never be freed without a limit */
+    char chain[1024];
+    snprintf(chain, sizeof (chain), "livehttp{memory,index=/live.m3u8,"
+             "key-uri=key.bin,key-file=\"%s\"}", keypath);
+    sout_access_out_t *access =
+        sout_AccessOutNew(vlc->p_libvlc_int, chain, "/seg-###.ts");
+    assert(access == NULL);
+
+    snprintf(chain, sizeof (chain), "livehttp{memory,seglen=2,numsegs=2,"
+             "delsegs=false,index=/live.m3u8,key-uri=key.bin,"
+             "key-file=\"%s\"}", keypath);
+    access = sout_AccessOutNew(vlc->p_libvlc_int, chain, "/seg-###.ts");
+    assert(access != NULL);
+    WriteBlocks(access, BLOCKS);
+
+    /* With a header on every one-second block, the first segment holds one
+     * block and each following one two blocks: one segment is queued for
+     * every two blocks. Wait for the writer thread to index the last one. */
+    char *m3u;
+    size_t len;
+    snprintf(url, sizeof (url), "/seg-%03u.ts", BLOCKS / 2);
+    for (;;)
+    {
+        assert(Get(port, "/live.m3u8", &m3u, &len) == 200);
+        if (strstr(m3u, url) != NULL)
+            break;
+        free(m3u);
+        vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(10));
+    }
+
+    /* Old segments are freed despite delsegs=false */
+    char *data;
+    assert(strstr(m3u, "/seg-001.ts") == NULL);
+    assert(Get(port, "/seg-001.ts", &data, &len) == 404);
+    free(data);
+
+    unsigned count = 0, next = 0;
+    for (char *line = strtok(m3u, "\n"); line; line = strtok(NULL, "\n"))
+    {
+        if (line[0] == '#')
+            continue;
+
+        assert(Get(port, line, &data, &len) == 200);
+        unsigned first = CheckSegment(SegmentNumber(line), (uint8_t *)data,
+                                      len);
+        assert(count == 0 || first == next);
+        next = first + SegmentBlocks((uint8_t *)data, len);
+        count++;
+        free(data);
+    }
+    assert(count >= 2 && count < BLOCKS / 2);
+    assert(next == BLOCKS - 1);
+    free(m3u);
+
+    sout_AccessOutDelete(access);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    test_init();
+
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    if (!module_exists("access_output_livehttp"))
+    {
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    char dir[] = "/tmp/vlc-livehttp-XXXXXX";
+    assert(mkdtemp(dir) != NULL);
+
+    char keypath[256];
+    snprintf(keypath, sizeof (keypath), "%s/key.bin", dir);
+    FILE *stream = vlc_fopen(keypath, "wb");
+    assert(stream != NULL);
+    assert(fwrite(key, 1, sizeof (key), stream) == sizeof (key));
+    fclose(stream);
+
+    gcry_check_version(NULL);
+
+    test_files(vlc, dir);
+    libvlc_release(vlc);
+
+    test_memory(dir);
+
+    vlc_unlink(keypath);
+    assert(rmdir(dir) == 0);
+    return 0;
+}
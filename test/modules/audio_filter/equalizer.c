@@ -0,0 +1,342 @@
+/*****************************************************************************
+ * equalizer.c: equalizer test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+#define RATE     48000
+#define CHANNELS 2
+#define SAMPLES  (RATE / 10) /* per block */
+#define BLOCKS   20
+
+#define BANDS    10
+#define GAINS    "-6 3 8 4 0 -3 -5 2 7 9"
+#define PREAMP   -4.f
+
+/* Reference scalar equalizer, as the plugin used to run it */
+static const float frequencies[BANDS] = {
+    60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000,
+};
+
+struct reference
+{
+    float alpha[BANDS], beta[BANDS], gamma[BANDS];
+    float amp[BANDS];
+    float gamp;
+    bool two_pass;
+    float x[CHANNELS][2], y[CHANNELS][BANDS][2];
+    float x2[CHANNELS][2], y2[CHANNELS][BANDS][2];
+};
+
+static void ReferenceInit(struct reference *ref, const float *db,
+                          float preamp, bool two_pass)
+{
+    const float rate = RATE;
+    const float octave_factor = powf(2.0f, 0.5f);
+    const float octave_factor_1 = 0.5f * (octave_factor + 1.0f);
+    const float octave_factor_2 = 0.5f * (octave_factor - 1.0f);
+
+    memset(ref, 0, sizeof (*ref));
+    for (int i = 0; i < BANDS; i++)
+    {
+        float theta_1 = (2.0f * (float) M_PI * frequencies[i]) / rate;
+        float theta_2 = theta_1 / octave_factor;
+        float sin = sinf(theta_2);
+        float sin_prd = sinf(theta_2 * octave_factor_1)
+                      * sinf(theta_2 * octave_factor_2);
+        float sin_hlf = sin * 0.5f;
+        float den = sin_hlf + sin_prd;
+
+        ref->alpha[i] = sin_prd / den;
+        ref->beta[i] = (sin_hlf - sin_prd) / den;
+        ref->gamma[i] = sin * cosf(theta_1) / den;
+        ref->amp[i] = 0.25f * (powf(10.0f, db[i] / 20.0f) - 1.0f);
+    }
+    ref->gamp = powf(10.f, preamp / 20.f);
+    ref->two_pass = two_pass;
+}
+
+static void ReferenceFilter(struct reference *ref, float *out, const float *in,
+                            int samples)
+{
+    for (int i = 0; i < samples; i++)
+    {
+        for (int ch = 0; ch < CHANNELS; ch++)
+        {
+            const float x = in[ch];
+            float o = 0.0f;
+
+            for (int j = 0; j < BANDS; j++)
+            {
+                float y = ref->alpha[j] * (x - ref->x[ch][1]) +
+                          ref->gamma[j] * ref->y[ch][j][0] -
+                          ref->beta[j]  * ref->y[ch][j][1];
+
+                ref->y[ch][j][1] = ref->y[ch][j][0];
+                ref->y[ch][j][0] = y;
+
+                o += y * ref->amp[j];
+            }
+            ref->x[ch][1] = ref->x[ch][0];
+            ref->x[ch][0] = x;
+
+            if (ref->two_pass)
+            {
+                const float x2 = 0.25f * x + o;
+                o = 0.0f;
+                for (int j = 0; j < BANDS; j++)
+                {
+                    float y = ref->alpha[j] * (x2 - ref->x2[ch][1]) +
+                              ref->gamma[j] * ref->y2[ch][j][0] -
+                              ref->beta[j]  * ref->y2[ch][j][1];
+
+                    ref->y2[ch][j][1] = ref->y2[ch][j][0];
+                    ref->y2[ch][j][0] = y;
+
+                    o += y * ref->amp[j];
+                }
+                ref->x2[ch][1] = ref->x2[ch][0];
+                ref->x2[ch][0] = x2;
+
+                out[ch] = ref->gamp * ref->gamp * (0.25f * x2 + o);
+            }
+            else
+                out[ch] = ref->gamp * (0.25f * x + o);
+        }
+        in += CHANNELS;
+        out += CHANNELS;
+    }
+}
+
+static float input[BLOCKS][SAMPLES * CHANNELS];
+
+/* Noise with a slow sine, to excite the low and the high bands */
+static void CreateInputs(void)
+{
+    uint32_t seed = 1;
+
+    for (unsigned i = 0; i < BLOCKS; i++)
+        for (unsigned j = 0; j < SAMPLES * CHANNELS; j++)
+        {
+            input[i][j] = 0.3f * ((int32_t)test_rand(&seed) / 2147483648.f)
+                        + 0.3f * sinf(j * 0.01f);
+        }
+}
+
+static filter_t *CreateFilter(libvlc_instance_t *vlc)
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+
+    filter->p_module = module_need(filter, "audio filter", "equalizer", true);
+    assert(filter->p_module != NULL);
+    return filter;
+}
+
+static void DeleteFilter(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_delete(filter);
+}
+
+/* Filters all the input blocks, calls check on each of them and returns the
+ * processing time */
+static vlc_tick_t Run(filter_t *filter,
+                      void (*check)(unsigned, const float *, void *),
+                      void *opaque)
+{
+    vlc_tick_t elapsed = 0;
+
+    for (unsigned i = 0; i < BLOCKS; i++)
+    {
+        block_t *block = block_Alloc(sizeof (input[i]));
+        assert(block != NULL);
+        memcpy(block->p_buffer, input[i], sizeof (input[i]));
+        block->i_nb_samples = SAMPLES;
+
+        vlc_tick_t start = vlc_tick_now();
+        block = filter->pf_audio_filter(filter, block);
+        elapsed += vlc_tick_now() - start;
+
+        assert(block != NULL);
+        assert(block->i_buffer == sizeof (input[i]));
+        check(i, (const float *)block->p_buffer, opaque);
+        block_Release(block);
+    }
+    return elapsed;
+}
+
+static void CheckReference(unsigned i, const float *out, void *opaque)
+{
+    struct reference *ref = opaque;
+    float expected[SAMPLES * CHANNELS];
+
+    ReferenceFilter(ref, expected, input[i], SAMPLES);
+    /* The bands are summed in another order */
+    for (unsigned j = 0; j < SAMPLES * CHANNELS; j++)
+        assert(fabsf(out[j] - expected[j]) <= 1e-5f * (1.f + fabsf(expected[j])));
+}
+
+static void test_reference(bool two_pass)
+{
+    const char *argv[] = {
+        "--equalizer-bands="GAINS,
+        "--equalizer-preamp=-4",
+        two_pass ? "--equalizer-2pass" : "--no-equalizer-2pass",
+    };
+
+    libvlc_instance_t *vlc = test_libvlc_new(ARRAY_SIZE(argv), argv);
+
+    const float db[BANDS] = { -6, 3, 8, 4, 0, -3, -5, 2, 7, 9 };
+    struct reference ref;
+    filter_t *filter = CreateFilter(vlc);
+
+    /* Time the reference alone */
+    ReferenceInit(&ref, db, PREAMP, two_pass);
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < BLOCKS; i++)
+    {
+        float out[SAMPLES * CHANNELS];
+        ReferenceFilter(&ref, out, input[i], SAMPLES);
+    }
+    vlc_tick_t scalar = vlc_tick_now() - start;
+
+    ReferenceInit(&ref, db, PREAMP, two_pass);
+    vlc_tick_t elapsed = Run(filter, CheckReference, &ref);
+
+    char name[32];
+    snprintf(name, sizeof (name), "%u band(s), %d pass", BANDS,
+             two_pass ? 2 : 1);
+    test_print_rate(name, "Msamples", SAMPLES * CHANNELS * BLOCKS / 1e6,
+                    elapsed);
+    strcat(name, " scalar");
+    test_print_rate(name, "Msamples", SAMPLES * CHANNELS * BLOCKS / 1e6,
+                    scalar);
+
+    DeleteFilter(filter);
+    libvlc_release(vlc);
+}
+
+/* Keeps the output of all the blocks */
+static void Store(unsigned i, const float *out, void *opaque)
+{
+    float (*output)[SAMPLES * CHANNELS] = opaque;
+
+    memcpy(output[i], out, sizeof (output[i]));
+}
+
+static float output[2][BLOCKS][SAMPLES * CHANNELS];
+
+static vlc_tick_t RunOptions(const char *count, const char *bands,
+                             const char *channel_bands,
+                             float (*out)[SAMPLES * CHANNELS])
+{
+    const char *argv[] = {
+        "--equalizer-preamp=0",
+        count,
+        bands,
+        channel_bands,
+    };
+
+    libvlc_instance_t *vlc = test_libvlc_new(ARRAY_SIZE(argv), argv);
+
+    filter_t *filter = CreateFilter(vlc);
+    vlc_tick_t elapsed = Run(filter, Store, out);
+
+    DeleteFilter(filter);
+    libvlc_release(vlc);
+    return elapsed;
+}
+
+static void test_band_count(void)
+{
+    /* 10 gains are interpolated over the 31 bands */
+    vlc_tick_t elapsed = RunOptions("--equalizer-band-count=31",
+                                    "--equalizer-bands=6 6 6 6 6 6 6 6 6 6",
+                                    "--equalizer-channel-bands=", output[0]);
+    RunOptions("--equalizer-band-count=31", "--equalizer-bands="
+               "6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6 6",
+               "--equalizer-channel-bands=", output[1]);
+    assert(memcmp(output[0], output[1], sizeof (output[0])) == 0);
+
+    test_print_rate("31 band(s), 1 pass", "Msamples",
+                    SAMPLES * CHANNELS * BLOCKS / 1e6, elapsed);
+
+    /* Flat bands leave the input as is, but for the factor of the filter */
+    RunOptions("--equalizer-band-count=15", "--equalizer-bands=0",
+               "--equalizer-channel-bands=", output[0]);
+    for (unsigned i = 0; i < BLOCKS; i++)
+        for (unsigned j = 0; j < SAMPLES * CHANNELS; j++)
+            assert(output[0][i][j] == 0.25f * input[i][j]);
+}
+
+static void test_channel_bands(void)
+{
+    /* Only the second channel gets its bands raised */
+    RunOptions("--equalizer-band-count=10", "--equalizer-bands=0",
+               "--equalizer-channel-bands=;12 12 12 12 12 12 12 12 12 12",
+               output[0]);
+
+    bool differs = false;
+
+    for (unsigned i = 0; i < BLOCKS; i++)
+        for (unsigned j = 0; j < SAMPLES * CHANNELS; j += CHANNELS)
+        {
+            assert(output[0][i][j] == 0.25f * input[i][j]);
+            if (output[0][i][j + 1] != 0.25f * input[i][j + 1])
+                differs = true;
+        }
+    assert(differs);
+}
+
+int main(void)
+{
+    test_init();
+    CreateInputs();
+
+    test_reference(false);
+    test_reference(true);
+    test_band_count();
+    test_channel_bands();
+    return 0;
+}
@@ -0,0 +1,354 @@
+/*****************************************************************************
+ * format.c: PCM format converter test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+const char vlc_module_name[] = "test_audio_format";
+
+/* The plugin is also built in, to reach every kernel and not only the one
+ * picked at opening */
+#define MODULE_STRING "audio_format"
+#include "../modules/audio_filter/converter/format.c"
+
+/* One second of 8 channels at 192 kHz, plus a tail for the scalar code */
+#define SAMPLES (192000 * 8 + 13)
+#define RUNS    8
+
+/* Reference scalar conversions, as in the plugin */
+static void RefS16toFl32(void *p_dst, const void *p_src, size_t count)
+{
+    const int16_t *src = p_src;
+    float *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        union { float f; int32_t i; } u;
+        u.i = src[i] + 0x43c00000;
+        dst[i] = u.f - 384.f;
+    }
+}
+
+static void RefS16toS32(void *p_dst, const void *p_src, size_t count)
+{
+    const int16_t *src = p_src;
+    int32_t *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i] << 16;
+}
+
+static void RefFl32toS16(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int16_t *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        union { float f; int32_t i; } u;
+        u.f = src[i] + 384.f;
+        if (u.i > 0x43c07fff)
+            dst[i] = 32767;
+        else if (u.i < 0x43bf8000)
+            dst[i] = -32768;
+        else
+            dst[i] = u.i - 0x43c00000;
+    }
+}
+
+static void RefFl32toS32(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    int32_t *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float s = src[i] * 2147483648.f;
+        if (s >= 2147483647.f)
+            dst[i] = 2147483647;
+        else if (s <= -2147483648.f)
+            dst[i] = -2147483648;
+        else
+            dst[i] = lroundf(s);
+    }
+}
+
+static void RefFl32toFl64(void *p_dst, const void *p_src, size_t count)
+{
+    const float *src = p_src;
+    double *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i];
+}
+
+static void RefS32toS16(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    int16_t *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i] >> 16;
+}
+
+static void RefS32toFl32(void *p_dst, const void *p_src, size_t count)
+{
+    const int32_t *src = p_src;
+    float *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+        dst[i] = (float)src[i] / 2147483648.f;
+}
+
+static void RefFl64toFl32(void *p_dst, const void *p_src, size_t count)
+{
+    const double *src = p_src;
+    float *dst = p_dst;
+
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i];
+}
+
+static const struct
+{
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    void (*reference)(void *, const void *, size_t);
+} conversions[] = {
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, RefS16toFl32  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, RefS16toS32   },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, RefFl32toS16  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, RefFl32toS32  },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, RefFl32toFl64 },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, RefS32toS16   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, RefS32toFl32  },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, RefFl64toFl32 },
+};
+
+static uint32_t seed = 1;
+
+/* Samples around the rounding and clipping thresholds, then noise */
+static void FillFloats(float *buf, size_t count)
+{
+    static const float edges[] = {
+        0.f, -0.f, 1.f, -1.f, 1.5f, -1.5f, 1e30f, -1e30f, 1e-40f, -1e-40f,
+        32767.f / 32768.f, -32767.f / 32768.f, 32767.5f / 32768.f,
+        -32768.5f / 32768.f, .5f / 32768.f, -.5f / 32768.f,
+        1.5f / 32768.f, -1.5f / 32768.f, .5f / 2147483648.f,
+        -.5f / 2147483648.f, 2.5f / 2147483648.f, -2.5f / 2147483648.f,
+        8388607.5f / 2147483648.f, -8388607.5f / 2147483648.f,
+        2147483520.f / 2147483648.f, -2147483520.f / 2147483648.f,
+    };
+    size_t i;
+
+    for (i = 0; i < count && i < ARRAY_SIZE(edges); i++)
+        buf[i] = edges[i];
+    for (; i < count; i++)
+        buf[i] = ((int32_t)test_rand(&seed) / 2147483648.f) * 1.25f;
+}
+
+static void Fill(vlc_fourcc_t codec, void *buf, size_t count)
+{
+    switch (codec)
+    {
+        case VLC_CODEC_S16N:
+            for (size_t i = 0; i < count; i++)
+                ((int16_t *)buf)[i] = test_rand(&seed) >> 16;
+            break;
+        case VLC_CODEC_S32N:
+            for (size_t i = 0; i < count; i++)
+                ((int32_t *)buf)[i] = test_rand(&seed);
+            ((int32_t *)buf)[0] = INT32_MIN;
+            ((int32_t *)buf)[1] = INT32_MAX;
+            break;
+        case VLC_CODEC_FL32:
+            FillFloats(buf, count);
+            break;
+        case VLC_CODEC_FL64:
+        {
+            float *tmp = malloc(count * sizeof (*tmp));
+            assert(tmp != NULL);
+            FillFloats(tmp, count);
+            for (size_t i = 0; i < count; i++)
+                /* Not exactly representable as floats */
+                ((double *)buf)[i] = tmp[i] * (1. + 1e-9);
+            free(tmp);
+            break;
+        }
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+static void test_conversion(libvlc_instance_t *vlc, vlc_fourcc_t src_codec,
+                            vlc_fourcc_t dst_codec,
+                            void (*reference)(void *, const void *, size_t))
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, src_codec);
+    filter->fmt_in.audio.i_format = src_codec;
+    filter->fmt_in.audio.i_rate = 192000;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_7_1;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+    filter->fmt_out.i_codec = filter->fmt_out.audio.i_format = dst_codec;
+    aout_FormatPrepare(&filter->fmt_out.audio);
+
+    filter->p_module = module_need(filter, "audio converter", "audio_format",
+                                   true);
+    assert(filter->p_module != NULL);
+
+    const size_t src_size = aout_BitsPerSample(src_codec) / 8;
+    const size_t dst_size = aout_BitsPerSample(dst_codec) / 8;
+    void *input = malloc(SAMPLES * src_size);
+    assert(input != NULL);
+
+    Fill(src_codec, input, SAMPLES);
+
+    vlc_tick_t scalar = 0, converter = 0;
+
+    for (unsigned run = 0; run < RUNS; run++)
+    {
+        /* Like the plugin, convert in place unless the samples grow */
+        block_t *ref = block_Alloc(SAMPLES * src_size);
+        assert(ref != NULL);
+        memcpy(ref->p_buffer, input, SAMPLES * src_size);
+
+        vlc_tick_t start = vlc_tick_now();
+        if (dst_size > src_size)
+        {
+            block_t *out = block_Alloc(SAMPLES * dst_size);
+            assert(out != NULL);
+            reference(out->p_buffer, ref->p_buffer, SAMPLES);
+            block_Release(ref);
+            ref = out;
+        }
+        else
+            reference(ref->p_buffer, ref->p_buffer, SAMPLES);
+        scalar += vlc_tick_now() - start;
+
+        block_t *block = block_Alloc(SAMPLES * src_size);
+        assert(block != NULL);
+        memcpy(block->p_buffer, input, SAMPLES * src_size);
+
+        start = vlc_tick_now();
+        block = filter->pf_audio_filter(filter, block);
+        converter += vlc_tick_now() - start;
+
+        /* Bit-exact with the scalar code */
+        assert(block != NULL);
+        assert(block->i_buffer == SAMPLES * dst_size);
+        assert(memcmp(block->p_buffer, ref->p_buffer, block->i_buffer) == 0);
+        block_Release(block);
+        block_Release(ref);
+    }
+
+    char name[32];
+    snprintf(name, sizeof (name), "%4.4s->%4.4s",
+             (const char *)&src_codec, (const char *)&dst_codec);
+    test_print_rate(name, "Msamples", SAMPLES * RUNS / 1e6, converter);
+    strcat(name, " scalar");
+    test_print_rate(name, "Msamples", SAMPLES * RUNS / 1e6, scalar);
+
+    free(input);
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_delete(filter);
+}
+
+/* Checks every kernel supported by the CPU, not only the one the plugin
+ * picks, against the scalar code */
+static void test_kernels(void)
+{
+    for (size_t i = 0; cvt_kernels[i].convert != NULL; i++)
+    {
+        const struct cvt_kernel *kernel = &cvt_kernels[i];
+        if (!kernel->available())
+            continue;
+
+        void (*reference)(void *, const void *, size_t) = NULL;
+        for (size_t j = 0; j < ARRAY_SIZE(conversions); j++)
+            if (conversions[j].src == kernel->src
+             && conversions[j].dst == kernel->dst)
+                reference = conversions[j].reference;
+        assert(reference != NULL);
+
+        const size_t src_size = aout_BitsPerSample(kernel->src) / 8;
+        const size_t dst_size = aout_BitsPerSample(kernel->dst) / 8;
+        void *input = malloc(SAMPLES * src_size);
+        void *ref = malloc(SAMPLES * dst_size);
+        void *out = malloc(SAMPLES * __MAX(src_size, dst_size));
+        assert(input != NULL && ref != NULL && out != NULL);
+
+        Fill(kernel->src, input, SAMPLES);
+        reference(ref, input, SAMPLES);
+
+        /* Only the tail is left to the scalar code */
+        size_t count = kernel->convert(out, input, SAMPLES);
+        assert(count <= SAMPLES && SAMPLES - count < 32);
+        assert(memcmp(out, ref, count * dst_size) == 0);
+
+        if (dst_size <= src_size)
+        {
+            memcpy(out, input, SAMPLES * src_size);
+            assert(kernel->convert(out, out, SAMPLES) == count);
+            assert(memcmp(out, ref, count * dst_size) == 0);
+        }
+
+        printf("%4.4s->%4.4s: kernel %zu is bit-exact\n",
+               (const char *)&kernel->src, (const char *)&kernel->dst, i);
+        free(out);
+        free(ref);
+        free(input);
+    }
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = test_libvlc_new(0, NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(conversions); i++)
+        test_conversion(vlc, conversions[i].src, conversions[i].dst,
+                        conversions[i].reference);
+
+    libvlc_release(vlc);
+
+    test_kernels();
+    return 0;
+}
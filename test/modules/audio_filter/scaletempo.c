@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * scaletempo.c: audio tempo scaler test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+#define RATE     48000
+#define SECONDS  10
+#define BLOCK    (RATE / 50) /* frames per block */
+#define PERIOD   192         /* frames, 250 Hz */
+#define SKIP     (RATE / 10) /* frames before the filter is warmed up */
+
+static const double rates[] = { 1.5, 2., 3., 4. };
+
+/* Harmonics of the same fundamental on each channel: some search offsets
+ * line all the channels up exactly, and the output is then free of
+ * discontinuities */
+static float Sample(unsigned frame, unsigned channel)
+{
+    return 0.5f * sinf(2.f * (float)M_PI * (channel + 1)
+                       * (float)(frame % PERIOD) / PERIOD);
+}
+
+/* Deviation of the output from a sine on each channel, relative to its
+ * amplitude: s[n+1] + s[n-1] = 2 cos(w) s[n] */
+static float Distortion(const float *out, unsigned frames, unsigned channels)
+{
+    float worst = 0.f;
+
+    for (unsigned c = 0; c < channels; c++)
+    {
+        float k = 2.f * cosf(2.f * (float)M_PI * (c + 1) / PERIOD);
+
+        for (unsigned n = SKIP + 1; n + 1 < frames; n++)
+        {
+            const float *s = out + n * channels + c;
+            float d = fabsf(s[channels] + s[-(int)channels] - k * s[0]) / 0.5f;
+
+            worst = __MAX(worst, d);
+        }
+    }
+    return worst;
+}
+
+static void test_rate(libvlc_instance_t *vlc, uint16_t physical_channels,
+                      double rate, bool normalize)
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    assert(filter != NULL);
+
+    var_Create(filter, "scaletempo-normalize", VLC_VAR_BOOL);
+    var_SetBool(filter, "scaletempo-normalize", normalize);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = physical_channels;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+
+    filter->p_module = module_need(filter, "audio filter", "scaletempo", true);
+    assert(filter->p_module != NULL);
+
+    const unsigned channels = aout_FormatNbChannels(&filter->fmt_in.audio);
+    const unsigned max_frames = RATE * SECONDS;
+    float *out = malloc(max_frames * channels * sizeof (*out));
+    assert(out != NULL);
+
+    unsigned frames = 0;
+    vlc_tick_t elapsed = 0;
+
+    /* The audio output plays faster by raising the input rate */
+    filter->fmt_in.audio.i_rate = lround(RATE * rate);
+
+    for (unsigned i = 0; i < RATE * SECONDS; i += BLOCK)
+    {
+        block_t *block = block_Alloc(BLOCK * channels * sizeof (float));
+        assert(block != NULL);
+
+        float *in = (float *)block->p_buffer;
+        for (unsigned n = 0; n < BLOCK; n++)
+            for (unsigned c = 0; c < channels; c++)
+                *in++ = Sample(i + n, c);
+        block->i_nb_samples = BLOCK;
+        block->i_pts = block->i_dts = VLC_TICK_0;
+
+        vlc_tick_t start = vlc_tick_now();
+        block = filter->pf_audio_filter(filter, block);
+        elapsed += vlc_tick_now() - start;
+
+        if (block != NULL)
+        {
+            assert(frames + block->i_nb_samples <= max_frames);
+            memcpy(out + frames * channels, block->p_buffer, block->i_buffer);
+            frames += block->i_nb_samples;
+            block_Release(block);
+        }
+    }
+
+    /* The output lasts as long as the input played faster, but for the
+     * queued samples */
+    const unsigned expected = RATE * SECONDS / rate;
+    assert(frames <= expected && frames + RATE / 10 >= expected);
+
+    float distortion = Distortion(out, frames, channels);
+
+    char name[64];
+    snprintf(name, sizeof (name), "%u channel(s) at %.1fx%s, distortion %g",
+             channels, rate, normalize ? " normalized" : "", distortion);
+    test_print_rate(name, "audio seconds", SECONDS, elapsed);
+    assert(distortion < 1e-3f);
+
+    free(out);
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_delete(filter);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = test_libvlc_new(0, NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++)
+    {
+        test_rate(vlc, AOUT_CHANS_STEREO, rates[i], false);
+        test_rate(vlc, AOUT_CHANS_5_1, rates[i], false);
+        test_rate(vlc, AOUT_CHANS_5_1, rates[i], true);
+    }
+
+    libvlc_release(vlc);
+    return 0;
+}
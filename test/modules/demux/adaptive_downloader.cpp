@@ -0,0 +1,417 @@
+/*****************************************************************************
+ * adaptive_downloader.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../lib/libvlc_internal.h"
+
+#include "../modules/demux/adaptive/ID.cpp"
+#include "../modules/demux/adaptive/tools/Helper.cpp"
+#include "../modules/demux/adaptive/http/BytesRange.cpp"
+#include "../modules/demux/adaptive/http/ConnectionParams.cpp"
+#include "../modules/demux/adaptive/http/AuthStorage.cpp"
+#include "../modules/demux/adaptive/http/Transport.cpp"
+#include "../modules/demux/adaptive/http/HTTPConnection.cpp"
+#include "../modules/demux/adaptive/http/HTTPConnectionManager.cpp"
+#include "../modules/demux/adaptive/http/Downloader.cpp"
+#include "../modules/demux/adaptive/http/SegmentCache.cpp"
+#include "../modules/demux/adaptive/http/Chunk.cpp"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#undef NDEBUG
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace adaptive;
+using namespace adaptive::http;
+
+const char vlc_module_name[] = "test_adaptive_downloader";
+
+/* Local HTTP/1.1 stand-in serving paced "segments" */
+#define VIDEO_SIZE  (256 * 1024)
+#define AUDIO_SIZE  (16 * 1024)
+#define SEND_SIZE   4096
+#define MAX_CLIENTS 16
+
+struct server
+{
+    int fd;
+    uint16_t port;
+    vlc_thread_t thread;
+    vlc_thread_t clients[MAX_CLIENTS];
+    int clientfds[MAX_CLIENTS];
+    unsigned count;
+};
+
+static uint8_t Pattern(size_t offset, size_t size)
+{
+    return (offset * 7 + size) & 0xff;
+}
+
+static void *Serve(void *data)
+{
+    int fd = (intptr_t) data;
+    char req[512];
+    size_t reqlen = 0;
+
+    for(;;)
+    {
+        ssize_t val = recv(fd, &req[reqlen], 1, 0);
+        if(val <= 0)
+            break;
+        if(++reqlen == sizeof(req))
+            break;
+        if(reqlen < 4 || memcmp(&req[reqlen - 4], "\r\n\r\n", 4))
+            continue;
+
+        req[reqlen] = 0;
+        reqlen = 0;
+        size_t size = strncmp(req, "GET /video/", 11) ? AUDIO_SIZE : VIDEO_SIZE;
+
+        char hdr[128];
+        int hdrlen = snprintf(hdr, sizeof(hdr), "HTTP/1.1 200 OK\r\n"
+                              "Content-Length: %zu\r\n\r\n", size);
+        if(send(fd, hdr, hdrlen, MSG_NOSIGNAL) != hdrlen)
+            break;
+
+        uint8_t buf[SEND_SIZE];
+        for(size_t sent = 0; sent < size; sent += SEND_SIZE)
+        {
+            for(size_t i = 0; i < SEND_SIZE; i++)
+                buf[i] = Pattern(sent + i, size);
+            if(send(fd, buf, SEND_SIZE, MSG_NOSIGNAL) != SEND_SIZE)
+                return NULL;
+            vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(1));
+        }
+    }
+    return NULL;
+}
+
+static void *Accept(void *data)
+{
+    struct server *srv = static_cast<struct server *>(data);
+
+    while(srv->count < MAX_CLIENTS)
+    {
+        int fd = accept(srv->fd, NULL, NULL);
+        if(fd == -1)
+            break;
+        srv->clientfds[srv->count] = fd;
+        assert(vlc_clone(&srv->clients[srv->count], Serve, (void *)(intptr_t) fd,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+        srv->count++;
+    }
+    return NULL;
+}
+
+static void StartServer(struct server *srv)
+{
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    srv->count = 0;
+    srv->fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(srv->fd != -1);
+    assert(bind(srv->fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(srv->fd, MAX_CLIENTS) == 0);
+    assert(getsockname(srv->fd, (struct sockaddr *)&addr, &addrlen) == 0);
+    srv->port = ntohs(addr.sin_port);
+    assert(vlc_clone(&srv->thread, Accept, srv, VLC_THREAD_PRIORITY_LOW) == 0);
+}
+
+static void StopServer(struct server *srv)
+{
+    shutdown(srv->fd, SHUT_RDWR);
+    vlc_join(srv->thread, NULL);
+    close(srv->fd);
+    for(unsigned i = 0; i < srv->count; i++)
+    {
+        shutdown(srv->clientfds[i], SHUT_RDWR);
+        vlc_join(srv->clients[i], NULL);
+        close(srv->clientfds[i]);
+    }
+}
+
+class RateObserver : public IDownloadRateObserver
+{
+    public:
+        RateObserver()
+        {
+            vlc_mutex_init(&lock);
+        }
+        virtual ~RateObserver()
+        {
+            vlc_mutex_destroy(&lock);
+        }
+        virtual void updateDownloadRate(const ID &id, size_t size, vlc_tick_t time)
+        {
+            vlc_mutex_locker locker(&lock);
+            assert(time > 0);
+            completed.push_back(id.str());
+            bytes += size;
+        }
+        vlc_mutex_t lock;
+        std::vector<std::string> completed;
+        size_t bytes = 0;
+};
+
+static void ReadSource(AbstractChunkSource *source, size_t size)
+{
+    size_t offset = 0;
+    block_t *p_block;
+    while((p_block = source->readBlock()))
+    {
+        for(size_t i = 0; i < p_block->i_buffer; i++)
+            assert(p_block->p_buffer[i] == Pattern(offset + i, size));
+        offset += p_block->i_buffer;
+        block_Release(p_block);
+    }
+    assert(offset == size);
+}
+
+static void test_downloader(unsigned workers)
+{
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    var_Create(obj, "adaptive-downloaders", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "adaptive-downloaders", workers);
+
+    struct server srv;
+    StartServer(&srv);
+
+    AuthStorage *auth = new AuthStorage(obj);
+    HTTPConnectionManager *manager = new HTTPConnectionManager(obj, auth);
+    RateObserver observer;
+    manager->setDownloadRateObserver(&observer);
+
+    char url[64];
+    const ID video("video"), audio("audio");
+    std::vector<HTTPChunkBufferedSource *> sources;
+
+    vlc_tick_t start = vlc_tick_now();
+
+    /* One segment being read plus prefetched ones on a heavy stream,
+     * then a small segment on another stream, scheduled last */
+    for(unsigned i = 0; i < 3; i++)
+    {
+        snprintf(url, sizeof(url), "http://127.0.0.1:%u/video/%u", srv.port, i);
+        sources.push_back(new HTTPChunkBufferedSource(url, manager, video));
+        manager->start(sources.back());
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/audio/0", srv.port);
+    HTTPChunkBufferedSource *audiosource = new HTTPChunkBufferedSource(url, manager, audio);
+    manager->start(audiosource);
+
+    ReadSource(audiosource, AUDIO_SIZE);
+    vlc_tick_t audiotime = vlc_tick_now() - start;
+    for(unsigned i = 0; i < sources.size(); i++)
+        ReadSource(sources[i], VIDEO_SIZE);
+    vlc_tick_t totaltime = vlc_tick_now() - start;
+
+    /* The small stream must not wait behind the heavy one */
+    assert(observer.completed.size() == 4);
+    assert(observer.completed.front() == audio.str());
+    assert(observer.bytes == AUDIO_SIZE + 3 * VIDEO_SIZE);
+
+    std::cout << "adaptive-downloaders=" << workers
+              << ": audio segment in " << MS_FROM_VLC_TICK(audiotime)
+              << " ms, all segments in " << MS_FROM_VLC_TICK(totaltime)
+              << " ms" << std::endl;
+
+    delete audiosource;
+    for(unsigned i = 0; i < sources.size(); i++)
+        delete sources[i];
+    delete manager;
+    delete auth;
+
+    StopServer(&srv);
+    libvlc_release(vlc);
+}
+
+static void test_priority(void)
+{
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    var_Create(obj, "adaptive-downloaders", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "adaptive-downloaders", 1);
+
+    struct server srv;
+    StartServer(&srv);
+
+    AuthStorage *auth = new AuthStorage(obj);
+    HTTPConnectionManager *manager = new HTTPConnectionManager(obj, auth);
+    RateObserver observer;
+    manager->setDownloadRateObserver(&observer);
+
+    /* Same sized segments, the stream scheduled last is starving */
+    char url[64];
+    const ID full("full"), starving("starving");
+    manager->updateBufferingLevel(full, VLC_TICK_FROM_SEC(10));
+    manager->updateBufferingLevel(starving, VLC_TICK_FROM_MS(100));
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/video/0", srv.port);
+    HTTPChunkBufferedSource *fullsource = new HTTPChunkBufferedSource(url, manager, full);
+    manager->start(fullsource);
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/video/1", srv.port);
+    HTTPChunkBufferedSource *starvingsource = new HTTPChunkBufferedSource(url, manager, starving);
+    manager->start(starvingsource);
+
+    ReadSource(starvingsource, VIDEO_SIZE);
+    ReadSource(fullsource, VIDEO_SIZE);
+
+    /* The least buffered stream is downloaded first */
+    assert(observer.completed.size() == 2);
+    assert(observer.completed.front() == starving.str());
+
+    delete starvingsource;
+    delete fullsource;
+    delete manager;
+    delete auth;
+
+    StopServer(&srv);
+    libvlc_release(vlc);
+}
+
+static void test_cache(void)
+{
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    var_Create(obj, "adaptive-downloaders", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "adaptive-downloaders", 2);
+
+    struct server srv;
+    StartServer(&srv);
+
+    AuthStorage *auth = new AuthStorage(obj);
+    HTTPConnectionManager *manager = new HTTPConnectionManager(obj, auth);
+    /* room for a single video segment */
+    SegmentCache *cache = new SegmentCache(obj, VIDEO_SIZE + AUDIO_SIZE);
+
+    char url[2][64];
+    std::string contentType;
+    const ID video("video");
+    for(unsigned i = 0; i < 2; i++)
+    {
+        snprintf(url[i], sizeof(url[i]), "http://127.0.0.1:%u/video/%u", srv.port, i);
+        const std::string key = SegmentCache::makeKey(url[i], BytesRange());
+        assert(cache->get(key, &contentType) == NULL);
+
+        HTTPChunkBufferedSource *source = new HTTPChunkBufferedSource(url[i], manager, video);
+        source->setCache(cache, key);
+        manager->start(source);
+        ReadSource(source, VIDEO_SIZE);
+        delete source;
+    }
+
+    /* least recently used one was evicted */
+    assert(cache->get(SegmentCache::makeKey(url[0], BytesRange()), &contentType) == NULL);
+    block_t *p_data = cache->get(SegmentCache::makeKey(url[1], BytesRange()), &contentType);
+    assert(p_data != NULL);
+    CachedChunkSource *memsource = new CachedChunkSource(p_data, contentType);
+    ReadSource(memsource, VIDEO_SIZE);
+    delete memsource;
+
+    /* hits share the cached data, which is copied before being modified */
+    block_t *p_hit[2];
+    for(unsigned i = 0; i < 2; i++)
+    {
+        p_hit[i] = cache->get(SegmentCache::makeKey(url[1], BytesRange()), &contentType);
+        assert(p_hit[i] != NULL);
+    }
+    assert(p_hit[0]->p_buffer == p_hit[1]->p_buffer);
+
+    memsource = new CachedChunkSource(p_hit[0], contentType);
+    block_t *p_block = memsource->read(16);
+    assert(p_block != NULL && p_block->i_buffer == 16);
+    assert(p_block->p_buffer == p_hit[1]->p_buffer);
+    p_block = block_MakeWritable(p_block);
+    assert(p_block != NULL && p_block->p_buffer != p_hit[1]->p_buffer);
+    memset(p_block->p_buffer, 0, p_block->i_buffer);
+    block_Release(p_block);
+    delete memsource;
+
+    memsource = new CachedChunkSource(p_hit[1], contentType);
+    ReadSource(memsource, VIDEO_SIZE);
+    delete memsource;
+
+    /* a range is a different segment */
+    assert(cache->get(SegmentCache::makeKey(url[1], BytesRange(0, 1023)), &contentType) == NULL);
+
+    delete cache;
+    delete manager;
+    delete auth;
+
+    StopServer(&srv);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    alarm(10);
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    test_downloader(1);
+    test_downloader(3);
+    test_priority();
+    test_cache();
+    return 0;
+}
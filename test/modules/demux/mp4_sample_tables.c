@@ -0,0 +1,443 @@
+/*****************************************************************************
+ * mp4_sample_tables.c: MP4 demux sample tables test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TIMESCALE     30000
+#define CHUNK_SAMPLES 4
+#define SAMPLE_SIZE   8
+#define MAX_BLOCKS    16
+
+/*
+ * Synthetic file: one video track, with small samples holding their own
+ * index, sparse stts/ctts tables whose entries straddle the chunks, and
+ * variable sample sizes.
+ */
+static unsigned SampleDelta(uint32_t i)
+{
+    return (i / 3) % 2 ? 1002 : 1000; /* stts entries of 3 samples */
+}
+
+static unsigned SampleOffset(uint32_t i)
+{
+    return (i / 5) % 2 ? 1000 : 3000; /* ctts entries of 5 samples */
+}
+
+static unsigned SampleSize(uint32_t i)
+{
+    return SAMPLE_SIZE + i % 2;
+}
+
+struct buffer
+{
+    uint8_t *data;
+    size_t size;
+};
+
+static void Put(struct buffer *b, const void *data, size_t size)
+{
+    memcpy(&b->data[b->size], data, size);
+    b->size += size;
+}
+
+static void Put32(struct buffer *b, uint32_t v)
+{
+    uint8_t buf[4];
+    SetDWBE(buf, v);
+    Put(b, buf, 4);
+}
+
+static void PutZero(struct buffer *b, size_t size)
+{
+    memset(&b->data[b->size], 0, size);
+    b->size += size;
+}
+
+static size_t BoxStart(struct buffer *b, const char *type)
+{
+    size_t start = b->size;
+    Put32(b, 0);
+    Put(b, type, 4);
+    return start;
+}
+
+static size_t FullBoxStart(struct buffer *b, const char *type, uint32_t flags)
+{
+    size_t start = BoxStart(b, type);
+    Put32(b, flags);
+    return start;
+}
+
+static void BoxEnd(struct buffer *b, size_t start)
+{
+    SetDWBE(&b->data[start], b->size - start);
+}
+
+static void PutMatrix(struct buffer *b)
+{
+    static const uint32_t matrix[9] = {
+        0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000,
+    };
+    for (unsigned i = 0; i < 9; i++)
+        Put32(b, matrix[i]);
+}
+
+static struct buffer CreateFile(uint32_t samples, uint64_t *duration)
+{
+    uint32_t chunks = samples / CHUNK_SAMPLES;
+    struct buffer b;
+
+    *duration = 0;
+    for (uint32_t i = 0; i < samples; i++)
+        *duration += SampleDelta(i);
+
+    b.size = 0;
+    b.data = malloc(samples * (SAMPLE_SIZE + 1 + 24) + 4096);
+    assert(b.data != NULL);
+
+    size_t box = BoxStart(&b, "ftyp");
+    Put(&b, "isom", 4);
+    Put32(&b, 0);
+    Put(&b, "isom", 4);
+    BoxEnd(&b, box);
+
+    /* media data first, so that the chunk offsets are known */
+    size_t mdat = BoxStart(&b, "mdat");
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        Put32(&b, i);
+        Put32(&b, ~i);
+        PutZero(&b, SampleSize(i) - SAMPLE_SIZE);
+    }
+    BoxEnd(&b, mdat);
+
+    size_t moov = BoxStart(&b, "moov");
+    box = FullBoxStart(&b, "mvhd", 0);
+    Put32(&b, 0);
+    Put32(&b, 0);
+    Put32(&b, TIMESCALE);
+    Put32(&b, *duration);
+    Put32(&b, 0x10000);
+    Put32(&b, 0x01000000);
+    PutZero(&b, 8);
+    PutMatrix(&b);
+    PutZero(&b, 24);
+    Put32(&b, 2);
+    BoxEnd(&b, box);
+
+    size_t trak = BoxStart(&b, "trak");
+    box = FullBoxStart(&b, "tkhd", 3);
+    Put32(&b, 0);
+    Put32(&b, 0);
+    Put32(&b, 1);
+    Put32(&b, 0);
+    Put32(&b, *duration);
+    PutZero(&b, 16);
+    PutMatrix(&b);
+    Put32(&b, 64 << 16);
+    Put32(&b, 48 << 16);
+    BoxEnd(&b, box);
+
+    size_t mdia = BoxStart(&b, "mdia");
+    box = FullBoxStart(&b, "mdhd", 0);
+    Put32(&b, 0);
+    Put32(&b, 0);
+    Put32(&b, TIMESCALE);
+    Put32(&b, *duration);
+    Put32(&b, 0x55c40000); /* und */
+    BoxEnd(&b, box);
+
+    box = FullBoxStart(&b, "hdlr", 0);
+    Put32(&b, 0);
+    Put(&b, "vide", 4);
+    PutZero(&b, 13);
+    BoxEnd(&b, box);
+
+    size_t minf = BoxStart(&b, "minf");
+    box = FullBoxStart(&b, "vmhd", 1);
+    PutZero(&b, 8);
+    BoxEnd(&b, box);
+
+    size_t dinf = BoxStart(&b, "dinf");
+    size_t dref = FullBoxStart(&b, "dref", 0);
+    Put32(&b, 1);
+    box = FullBoxStart(&b, "url ", 1);
+    BoxEnd(&b, box);
+    BoxEnd(&b, dref);
+    BoxEnd(&b, dinf);
+
+    size_t stbl = BoxStart(&b, "stbl");
+    size_t stsd = FullBoxStart(&b, "stsd", 0);
+    Put32(&b, 1);
+    box = BoxStart(&b, "jpeg");
+    PutZero(&b, 6);
+    Put32(&b, 1 << 16); /* data reference index, pre-defined */
+    PutZero(&b, 12);
+    Put32(&b, (64 << 16) | 48);
+    Put32(&b, 72 << 16);
+    Put32(&b, 72 << 16);
+    Put32(&b, 0);
+    Put32(&b, 1 << 16); /* frame count, compressor name */
+    PutZero(&b, 30);
+    Put32(&b, (24 << 16) | 0xffff);
+    BoxEnd(&b, box);
+    BoxEnd(&b, stsd);
+
+    box = FullBoxStart(&b, "stts", 0);
+    Put32(&b, (samples + 2) / 3);
+    for (uint32_t i = 0; i < samples; i += 3)
+    {
+        Put32(&b, __MIN(3, samples - i));
+        Put32(&b, SampleDelta(i));
+    }
+    BoxEnd(&b, box);
+
+    box = FullBoxStart(&b, "ctts", 0);
+    Put32(&b, (samples + 4) / 5);
+    for (uint32_t i = 0; i < samples; i += 5)
+    {
+        Put32(&b, __MIN(5, samples - i));
+        Put32(&b, SampleOffset(i));
+    }
+    BoxEnd(&b, box);
+
+    box = FullBoxStart(&b, "stsc", 0);
+    Put32(&b, 1);
+    Put32(&b, 1);
+    Put32(&b, CHUNK_SAMPLES);
+    Put32(&b, 1);
+    BoxEnd(&b, box);
+
+    box = FullBoxStart(&b, "stsz", 0);
+    Put32(&b, 0);
+    Put32(&b, samples);
+    for (uint32_t i = 0; i < samples; i++)
+        Put32(&b, SampleSize(i));
+    BoxEnd(&b, box);
+
+    box = FullBoxStart(&b, "stco", 0);
+    Put32(&b, chunks);
+    uint64_t offset = mdat + 8;
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        if (i % CHUNK_SAMPLES == 0)
+            Put32(&b, offset);
+        offset += SampleSize(i);
+    }
+    BoxEnd(&b, box);
+
+    BoxEnd(&b, stbl);
+    BoxEnd(&b, minf);
+    BoxEnd(&b, mdia);
+    BoxEnd(&b, trak);
+    BoxEnd(&b, moov);
+    return b;
+}
+
+static struct
+{
+    unsigned count;
+    uint32_t index[MAX_BLOCKS];
+    vlc_tick_t dts[MAX_BLOCKS];
+    vlc_tick_t pts[MAX_BLOCKS];
+} blocks;
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) out;
+    assert(fmt->i_codec == VLC_CODEC_MJPG);
+    return (es_out_id_t *)(uintptr_t)1;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    (void) out; (void) id;
+    if (blocks.count < MAX_BLOCKS)
+    {
+        assert(block->i_buffer >= SAMPLE_SIZE);
+        uint32_t index = GetDWBE(block->p_buffer);
+        assert(GetDWBE(&block->p_buffer[4]) == ~index);
+        assert(block->i_buffer == SampleSize(index));
+
+        blocks.index[blocks.count] = index;
+        blocks.dts[blocks.count] = block->i_dts;
+        blocks.pts[blocks.count] = block->i_pts;
+        blocks.count++;
+    }
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+    if (query == ES_OUT_GET_ES_STATE)
+    {
+        (void) va_arg(args, es_out_id_t *);
+        *va_arg(args, bool *) = true;
+        return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
+static const struct es_out_callbacks es_out_cbs = {
+    .add = EsOutAdd,
+    .send = EsOutSend,
+    .del = EsOutDel,
+    .control = EsOutControl,
+};
+
+static vlc_tick_t SampleTime(uint64_t t)
+{
+    return VLC_TICK_0 + vlc_tick_from_samples(t, TIMESCALE);
+}
+
+static size_t ResidentKiB(void)
+{
+    unsigned long size, resident = 0;
+    FILE *stream = fopen("/proc/self/statm", "r");
+
+    if (stream != NULL)
+    {
+        if (fscanf(stream, "%lu %lu", &size, &resident) != 2)
+            resident = 0;
+        fclose(stream);
+    }
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+/* Demuxes the next blocks and checks them against the sample tables */
+static uint32_t CheckBlocks(demux_t *demux, const uint64_t *dts)
+{
+    memset(&blocks, 0, sizeof (blocks));
+    while (blocks.count < MAX_BLOCKS)
+        assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+
+    for (unsigned i = 0; i < blocks.count; i++)
+    {
+        uint32_t index = blocks.index[i];
+
+        assert(i == 0 || index == blocks.index[i - 1] + 1);
+        assert(blocks.dts[i] == SampleTime(dts[index]));
+        assert(blocks.pts[i] == SampleTime(dts[index])
+               + vlc_tick_from_samples(SampleOffset(index), TIMESCALE));
+    }
+    return blocks.index[0];
+}
+
+static void test_samples(vlc_object_t *obj, uint32_t samples)
+{
+    es_out_t out = { .cbs = &es_out_cbs };
+    uint64_t duration;
+
+    struct buffer file = CreateFile(samples, &duration);
+
+    uint64_t *dts = malloc((samples + 1) * sizeof (*dts));
+    assert(dts != NULL);
+    dts[0] = 0;
+    for (uint32_t i = 0; i < samples; i++)
+        dts[i + 1] = dts[i] + SampleDelta(i);
+    assert(dts[samples] == duration);
+
+    stream_t *s = vlc_stream_MemoryNew(obj, file.data, file.size, true);
+    assert(s != NULL);
+
+    size_t rss = ResidentKiB();
+    vlc_tick_t start = vlc_tick_now();
+    demux_t *demux = demux_New(obj, "mp4", s, &out);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    assert(demux != NULL);
+    rss = ResidentKiB() - rss;
+
+    printf("%"PRIu32" samples in %"PRIu32" chunks: opened in %"PRId64" us, "
+           "%zu KiB of resident memory\n", samples, samples / CHUNK_SAMPLES,
+           US_FROM_VLC_TICK(elapsed), rss);
+
+    vlc_tick_t length;
+    assert(demux_Control(demux, DEMUX_GET_LENGTH, &length) == VLC_SUCCESS);
+    assert(length == vlc_tick_from_samples(duration, TIMESCALE));
+
+    /* From the start */
+    assert(CheckBlocks(demux, dts) == 0);
+
+    /* Seek to samples in the middle of chunks and of table entries */
+    const uint32_t targets[] = { samples / 2 + 1, samples - 2 * MAX_BLOCKS,
+                                 7, samples / 3 + 2 };
+    start = vlc_tick_now();
+    for (size_t i = 0; i < ARRAY_SIZE(targets); i++)
+    {
+        /* halfway in the sample, to stay clear of rounding */
+        vlc_tick_t time = vlc_tick_from_samples(dts[targets[i]]
+                                                + SampleDelta(targets[i]) / 2,
+                                                TIMESCALE);
+        assert(demux_Control(demux, DEMUX_SET_TIME, time, true)
+               == VLC_SUCCESS);
+        /* the demuxer restarts from the chunk holding the sample */
+        uint32_t index = CheckBlocks(demux, dts);
+        assert(index <= targets[i] && targets[i] - index < CHUNK_SAMPLES);
+    }
+    elapsed = vlc_tick_now() - start;
+    printf("%zu seeks in %"PRId64" us\n", ARRAY_SIZE(targets),
+           US_FROM_VLC_TICK(elapsed));
+
+    demux_Delete(demux);
+    free(dts);
+    free(file.data);
+}
+
+int main(void)
+{
+    static const char *const argv[] = {
+        "-v",
+        "--ignore-config",
+    };
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_samples(obj, 4096);
+    test_samples(obj, 1 << 20);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*****************************************************************************
+ * freetype.c: freetype text renderer glyph cache test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_subpicture.h>
+#include <vlc_text_style.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FRAMES 300
+
+static const char *const fonts[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/TTF/DejaVuSans.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/truetype/freefont/FreeSerifBold.ttf",
+};
+
+static const char *const lines[] = {
+    "Twinkle, twinkle, little star,",
+    "How I wonder what you are!",
+    "Up above the world so high,",
+    "Like a diamond in the sky.",
+};
+
+/* Order-dependent digest of the rendered pictures */
+static uint64_t Digest(uint64_t h, const picture_t *pic)
+{
+    const plane_t *p = &pic->p[0];
+
+    for (int y = 0; y < p->i_visible_lines; y++)
+        for (int x = 0; x < p->i_visible_pitch; x++)
+            h = (h ^ p->p_pixels[y * p->i_pitch + x]) * 1099511628211ULL;
+    return h;
+}
+
+/* Renders karaoke-like subtitles, updated on every frame */
+static uint64_t test_render(const char *font, const char *cache_size)
+{
+    char font_arg[256], cache_arg[64];
+
+    snprintf(font_arg, sizeof (font_arg), "--freetype-font=%s", font);
+    snprintf(cache_arg, sizeof (cache_arg), "--freetype-cache-size=%s",
+             cache_size);
+
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        font_arg,
+        cache_arg,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    filter_t *text = vlc_object_create(vlc->p_libvlc_int, sizeof (*text));
+    assert(text != NULL);
+
+    es_format_Init(&text->fmt_in, VIDEO_ES, 0);
+    es_format_Init(&text->fmt_out, VIDEO_ES, 0);
+    text->fmt_out.video.i_width = text->fmt_out.video.i_visible_width = 1280;
+    text->fmt_out.video.i_height = text->fmt_out.video.i_visible_height = 720;
+
+    text->p_module = module_need(text, "text renderer", "freetype", true);
+    assert(text->p_module != NULL);
+
+    static const vlc_fourcc_t chromas[] = { VLC_CODEC_RGBA, 0 };
+    uint64_t digest = 14695981039346656037ULL; /* FNV-1a */
+    vlc_tick_t start = vlc_tick_now();
+    unsigned glyphs = 0;
+
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        const char *line = lines[(i / 30) % ARRAY_SIZE(lines)];
+        size_t sung = strlen(line) * (i % 30) / 29;
+        char buf[64];
+
+        video_format_t fmt;
+        video_format_Init(&fmt, VLC_CODEC_TEXT);
+        subpicture_region_t *region = subpicture_region_New(&fmt);
+        assert(region != NULL);
+
+        /* the sung part is highlighted */
+        snprintf(buf, sizeof (buf), "%.*s", (int)sung, line);
+        region->p_text = text_segment_New(buf);
+        region->p_text->style = text_style_Create(STYLE_NO_DEFAULTS);
+        region->p_text->style->i_font_color = 0x00FFFF;
+        region->p_text->style->i_features |= STYLE_HAS_FONT_COLOR;
+        region->p_text->p_next = text_segment_New(line + sung);
+        glyphs += strlen(line);
+
+        int ret = text->pf_render(text, region, region, chromas);
+        assert(ret == VLC_SUCCESS && region->p_picture != NULL);
+        digest = Digest(digest, region->p_picture);
+        subpicture_region_Delete(region);
+    }
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    printf("freetype-cache-size=%s: %d frames in %"PRId64" ms, "
+           "%.0f frames/s, %.0f glyphs/s\n", cache_size, FRAMES,
+           MS_FROM_VLC_TICK(elapsed), (double)FRAMES * CLOCK_FREQ / elapsed,
+           (double)glyphs * CLOCK_FREQ / elapsed);
+
+    module_unneed(text, text->p_module);
+    es_format_Clean(&text->fmt_in);
+    es_format_Clean(&text->fmt_out);
+    vlc_object_delete(text);
+    libvlc_release(vlc);
+    return digest;
+}
+
+int main(void)
+{
+    const char *font = NULL;
+
+    test_init();
+
+    for (size_t i = 0; i < ARRAY_SIZE(fonts) && font == NULL; i++)
+        if (access(fonts[i], R_OK) == 0)
+            font = fonts[i];
+    if (font == NULL)
+        return 77; /* skipped */
+
+    uint64_t uncached = test_render(font, "0");
+    uint64_t cached = test_render(font, "1024");
+
+    /* The cached glyphs are rendered exactly alike */
+    assert(cached == uncached);
+    return 0;
+}
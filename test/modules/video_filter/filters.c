@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * filters.c: slice-parallel video filters test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include <stdio.h>
+
+#define WIDTH  1280
+#define HEIGHT 720
+#define FRAMES 16
+
+static const struct
+{
+    const char *module;
+    const char *option;
+} filters[] = {
+    { "adjust",       "--saturation=1.5" },
+    { "sharpen",      "--sharpen-sigma=1" },
+    { "gaussianblur", "--gaussianblur-sigma=2" },
+    { "rotate",       "--rotate-angle=30" },
+    { "hqdn3d",       "--hqdn3d-luma-spat=4" },
+    { "hqdn3d",       "--hqdn3d-luma-temp=0" }, /* spatial only on luma */
+    { "deinterlace",  "--deinterlace-mode=yadif" },
+    { "deinterlace",  "--deinterlace-mode=blend" },
+    { "deinterlace",  "--deinterlace-mode=mean" },
+};
+
+static picture_t *inputs[FRAMES];
+
+/* Moving gradients with some noise, for the filters to chew on */
+static void CreateInputs(void)
+{
+    video_format_t fmt;
+    uint32_t seed = 1;
+
+    video_format_Init(&fmt, VLC_CODEC_I420);
+    video_format_Setup(&fmt, VLC_CODEC_I420, WIDTH, HEIGHT, WIDTH, HEIGHT,
+                       1, 1);
+
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        picture_t *pic = picture_NewFromFormat(&fmt);
+        assert(pic != NULL);
+
+        for (int n = 0; n < pic->i_planes; n++)
+        {
+            plane_t *p = &pic->p[n];
+
+            for (int y = 0; y < p->i_visible_lines; y++)
+                for (int x = 0; x < p->i_visible_pitch; x++)
+                {
+                    p->p_pixels[y * p->i_pitch + x] =
+                        (x + 2 * y + 8 * i + n * 64)
+                        + ((test_rand(&seed) >> 16) & 15);
+                }
+        }
+        pic->date = VLC_TICK_0 + i * VLC_TICK_FROM_MS(40);
+        pic->b_progressive = false;
+        pic->b_top_field_first = true;
+        pic->i_nb_fields = 2;
+        inputs[i] = pic;
+    }
+}
+
+/* Order-dependent digest of the filtered pictures */
+static uint64_t Digest(uint64_t h, const picture_t *pic)
+{
+    for (int n = 0; n < pic->i_planes; n++)
+    {
+        const plane_t *p = &pic->p[n];
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            for (int x = 0; x < p->i_visible_pitch; x++)
+                h = (h ^ p->p_pixels[y * p->i_pitch + x]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static bool test_filter(const char *module, const char *option,
+                        unsigned threads, uint64_t *digest)
+{
+    char threads_arg[64];
+
+    snprintf(threads_arg, sizeof (threads_arg), "--video-filter-threads=%u",
+             threads);
+
+    const char *argv[] = {
+        threads_arg,
+        option,
+    };
+
+    libvlc_instance_t *vlc = test_libvlc_new(ARRAY_SIZE(argv), argv);
+
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, VIDEO_ES, VLC_CODEC_I420);
+    video_format_Copy(&filter->fmt_in.video, &inputs[0]->format);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+
+    filter->p_module = module_need(filter, "video filter", module, true);
+    if (filter->p_module == NULL)
+    {
+        printf("%s %s: not available, skipped\n", module, option);
+        es_format_Clean(&filter->fmt_in);
+        es_format_Clean(&filter->fmt_out);
+        vlc_object_delete(filter);
+        libvlc_release(vlc);
+        return false;
+    }
+
+    vlc_tick_t elapsed = 0;
+    unsigned frames = 0;
+
+    *digest = 14695981039346656037ULL; /* FNV-1a */
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        picture_t *out = filter->pf_video_filter(filter,
+                                                 picture_Hold(inputs[i]));
+        elapsed += vlc_tick_now() - start;
+
+        while (out != NULL)
+        {
+            picture_t *next = out->p_next;
+
+            *digest = Digest(*digest, out);
+            picture_Release(out);
+            out = next;
+            frames++;
+        }
+    }
+
+    char name[128];
+    snprintf(name, sizeof (name), "%s %s with %u slice(s)", module, option,
+             threads);
+    test_print_rate(name, "frames", frames, elapsed);
+    assert(frames > 0);
+
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_delete(filter);
+    libvlc_release(vlc);
+    return true;
+}
+
+int main(void)
+{
+    test_init();
+    CreateInputs();
+
+    for (size_t i = 0; i < ARRAY_SIZE(filters); i++)
+    {
+        uint64_t serial, sliced;
+
+        if (!test_filter(filters[i].module, filters[i].option, 1, &serial))
+            continue;
+        assert(test_filter(filters[i].module, filters[i].option, 4, &sliced));
+
+        /* The slices render exactly like the whole picture */
+        assert(sliced == serial);
+    }
+
+    for (unsigned i = 0; i < FRAMES; i++)
+        picture_Release(inputs[i]);
+    return 0;
+}
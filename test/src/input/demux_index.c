@@ -0,0 +1,437 @@
+/*****************************************************************************
+ * demux_index.c: test for the persistent seek index cache
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_threads.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+static char tmpdir[] = "/tmp/vlc-index-XXXXXX";
+static char media[sizeof (tmpdir) + 16];
+static char indexdir[sizeof (tmpdir) + 16];
+
+static void WriteMedia(const char *data)
+{
+    FILE *file = fopen(media, "wb");
+    assert(file != NULL);
+    fputs(data, file);
+    fclose(file);
+}
+
+static bool Loads(demux_t *demux, const char *name,
+                  const void *data, size_t size)
+{
+    block_t *block = demux_IndexCacheLoad(demux, name);
+    if (block == NULL)
+        return false;
+
+    assert(block->i_buffer == size && !memcmp(block->p_buffer, data, size));
+    block_Release(block);
+    return true;
+}
+
+/* Sets the modification time of a file, without sub-second part */
+static void SetTime(const char *path, time_t date)
+{
+    struct utimbuf times = { .actime = date, .modtime = date };
+    int ret = utime(path, &times);
+    assert(ret == 0);
+    (void) ret;
+}
+
+/* Calls func on every cached index, returns their count */
+static unsigned ForEachIndex(void (*func)(const char *))
+{
+    DIR *dir = opendir(indexdir);
+    if (dir == NULL)
+        return 0; /* nothing was ever stored */
+
+    struct dirent *ent;
+    unsigned count = 0;
+
+    while ((ent = readdir(dir)) != NULL)
+    {
+        char path[sizeof (indexdir) + 256];
+
+        if (ent->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof (path), "%s/%s", indexdir, ent->d_name);
+        if (func != NULL)
+            func(path);
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+/* Flips one byte of the payload of an index */
+static void Corrupt(const char *path)
+{
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    fseek(file, -1, SEEK_END);
+    int c = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(c ^ 0xff, file);
+    fclose(file);
+}
+
+static void CreateEntry(const char *name, off_t size, time_t date)
+{
+    char path[sizeof (indexdir) + 16];
+    snprintf(path, sizeof (path), "%s/%s", indexdir, name);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    assert(fd != -1);
+    int ret = ftruncate(fd, size); /* sparse */
+    assert(ret == 0);
+    (void) ret;
+    close(fd);
+    SetTime(path, date);
+}
+
+static bool EntryExists(const char *name)
+{
+    char path[sizeof (indexdir) + 16];
+    struct stat st;
+
+    snprintf(path, sizeof (path), "%s/%s", indexdir, name);
+    return stat(path, &st) == 0;
+}
+
+/* The cache is pruned in the background */
+static void WaitRemoved(const char *name)
+{
+    while (EntryExists(name))
+        vlc_tick_sleep(VLC_TICK_FROM_MS(10));
+}
+
+static void test_cache(libvlc_instance_t *vlc)
+{
+    static const char index[] = "seek index data";
+    static const char other[] = "another index";
+
+    demux_t *demux = vlc_object_create(vlc->p_libvlc_int, sizeof (*demux));
+    assert(demux != NULL);
+
+    /* Nothing is cached without a local file */
+    assert(demux_IndexCacheStore(demux, "test", index, sizeof (index)));
+    assert(demux_IndexCacheLoad(demux, "test") == NULL);
+
+    demux->psz_filepath = media;
+    assert(demux_IndexCacheLoad(demux, "test") == NULL);
+
+    /* Each index is stored separately, without leaving temporary files */
+    assert(!demux_IndexCacheStore(demux, "test", index, sizeof (index)));
+    assert(!demux_IndexCacheStore(demux, "other", other, sizeof (other)));
+    assert(Loads(demux, "test", index, sizeof (index)));
+    assert(Loads(demux, "other", other, sizeof (other)));
+    assert(ForEachIndex(NULL) == 2);
+
+    /* Storing again replaces the index */
+    assert(!demux_IndexCacheStore(demux, "other", index, sizeof (index)));
+    assert(Loads(demux, "other", index, sizeof (index)));
+    assert(ForEachIndex(NULL) == 2);
+
+    /* Corrupted indexes are rejected */
+    ForEachIndex(Corrupt);
+    assert(!Loads(demux, "test", index, sizeof (index)));
+
+    /* So are the indexes of a modified file */
+    assert(!demux_IndexCacheStore(demux, "test", index, sizeof (index)));
+    WriteMedia("modified media file");
+    assert(!Loads(demux, "test", index, sizeof (index)));
+
+    /* Even with the same size and date */
+    time_t date = time(NULL) - 3600;
+    SetTime(media, date);
+    assert(!demux_IndexCacheStore(demux, "test", index, sizeof (index)));
+    assert(Loads(demux, "test", index, sizeof (index)));
+    WriteMedia("modified media File");
+    SetTime(media, date);
+    assert(!Loads(demux, "test", index, sizeof (index)));
+
+    /* Expired indexes are removed */
+    CreateEntry("expired", 16, time(NULL) - 31 * 24 * 3600);
+    assert(!demux_IndexCacheStore(demux, "test", index, sizeof (index)));
+    WaitRemoved("expired");
+
+    /* So are the oldest ones, beyond the cache size */
+    CreateEntry("large", 48 << 20, time(NULL) - 60);
+    CreateEntry("larger", 32 << 20, time(NULL) - 120);
+    assert(!demux_IndexCacheStore(demux, "test", index, sizeof (index)));
+    WaitRemoved("larger");
+    assert(EntryExists("large"));
+    assert(Loads(demux, "test", index, sizeof (index)));
+
+    /* The cache can be disabled */
+    var_Create(demux, "demux-index-cache", VLC_VAR_BOOL);
+    var_SetBool(demux, "demux-index-cache", false);
+    assert(!Loads(demux, "test", index, sizeof (index)));
+
+    demux->psz_filepath = NULL;
+    vlc_object_delete(demux);
+}
+
+/* AVI file with frames of increasing sizes */
+#define AVI_FRAMES 50
+
+static void PutDWLE(FILE *file, uint32_t value)
+{
+    uint8_t buf[4];
+    SetDWLE(buf, value);
+    fwrite(buf, sizeof (buf), 1, file);
+}
+
+static void PutChunk(FILE *file, const char *fourcc, uint32_t size)
+{
+    fwrite(fourcc, 4, 1, file);
+    PutDWLE(file, size);
+}
+
+/* Writes an idx1 index with the given entry flags if idx1 is set */
+static void WriteAvi(bool idx1, uint32_t flags)
+{
+    FILE *file = fopen(media, "wb");
+    assert(file != NULL);
+
+    uint32_t movi = 4;
+    for (unsigned i = 0; i < AVI_FRAMES; i++)
+        movi += 8 + ((16 + i + 1) & ~1);
+
+    const uint32_t strl = 4 + (8 + 56) + (8 + 40);
+    const uint32_t hdrl = 4 + (8 + 56) + (8 + strl);
+
+    const uint32_t idx1size = idx1 ? 16 * AVI_FRAMES : 0;
+
+    PutChunk(file, "RIFF", 4 + (8 + hdrl) + (8 + movi) + (idx1 ? 8 + idx1size : 0));
+    fwrite("AVI ", 4, 1, file);
+
+    PutChunk(file, "LIST", hdrl);
+    fwrite("hdrl", 4, 1, file);
+    PutChunk(file, "avih", 56);
+    const uint32_t avih[14] = {
+        40000, 0, 0, idx1 ? 0x10 /* AVIF_HASINDEX */ : 0, AVI_FRAMES, 0, 1, 0, 16, 16,
+    };
+    for (unsigned i = 0; i < ARRAY_SIZE(avih); i++)
+        PutDWLE(file, avih[i]);
+
+    PutChunk(file, "LIST", strl);
+    fwrite("strl", 4, 1, file);
+    PutChunk(file, "strh", 56);
+    fwrite("vidsMJPG", 8, 1, file);
+    const uint32_t strh[12] = {
+        0, 0, 0, 1 /* scale */, 25 /* rate */, 0, AVI_FRAMES, 0, 0, 0,
+    };
+    for (unsigned i = 0; i < ARRAY_SIZE(strh); i++)
+        PutDWLE(file, strh[i]);
+
+    PutChunk(file, "strf", 40);
+    const uint32_t strf[10] = {
+        40, 16, 16, 1 | (24 << 16), VLC_FOURCC('M','J','P','G'),
+    };
+    for (unsigned i = 0; i < ARRAY_SIZE(strf); i++)
+        PutDWLE(file, strf[i]);
+
+    PutChunk(file, "LIST", movi);
+    fwrite("movi", 4, 1, file);
+    for (unsigned i = 0; i < AVI_FRAMES; i++)
+    {
+        uint8_t frame[16 + AVI_FRAMES + 1] = { 0 };
+
+        PutChunk(file, "00dc", 16 + i);
+        fwrite(frame, (16 + i + 1) & ~1, 1, file);
+    }
+
+    if (idx1)
+    {
+        /* offsets relative to the movi fourcc */
+        uint32_t offset = 4;
+
+        PutChunk(file, "idx1", idx1size);
+        for (unsigned i = 0; i < AVI_FRAMES; i++)
+        {
+            fwrite("00dc", 4, 1, file);
+            PutDWLE(file, flags);
+            PutDWLE(file, offset);
+            PutDWLE(file, 16 + i);
+            offset += 8 + ((16 + i + 1) & ~1);
+        }
+    }
+    fclose(file);
+}
+
+static ino_t index_ino;
+
+static void GetInode(const char *path)
+{
+    struct stat st;
+
+    assert(stat(path, &st) == 0);
+    index_ino = st.st_ino;
+}
+
+/* Returns the inode of the only cached index: storing an index again
+ * replaces the file */
+static ino_t IndexInode(void)
+{
+    index_ino = 0;
+    assert(ForEachIndex(GetInode) == 1);
+    return index_ino;
+}
+
+static void ParseEnded(const libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static void Parse(libvlc_instance_t *vlc)
+{
+    libvlc_media_t *md = libvlc_media_new_path(vlc, media);
+    assert(md != NULL);
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+
+    libvlc_event_manager_t *em = libvlc_media_event_manager(md);
+    libvlc_event_attach(em, libvlc_MediaParsedChanged, ParseEnded, &sem);
+    assert(libvlc_media_parse_with_options(md, libvlc_media_parse_local,
+                                           -1) == 0);
+    vlc_sem_wait(&sem);
+    assert(libvlc_media_get_parsed_status(md)
+           == libvlc_media_parsed_status_done);
+    libvlc_media_release(md);
+}
+
+/* The index that the AVI demultiplexer builds by scanning the file is
+ * reused when the file is opened again */
+static void test_avi(void)
+{
+    static const char *const argv[] = {
+        "-v",
+        "--ignore-config",
+        "--demux-index-cache",
+        "--avi-index=1", /* always build the index */
+    };
+    char cmd[sizeof (indexdir) + 16];
+
+    snprintf(cmd, sizeof (cmd), "rm -rf %s", indexdir);
+    int ret = system(cmd);
+    assert(ret == 0);
+    (void) ret;
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    WriteAvi(false, 0);
+    Parse(vlc);
+    ino_t ino = IndexInode();
+
+    /* The index is loaded, rather than built and stored again */
+    Parse(vlc);
+    assert(IndexInode() == ino);
+
+    /* Rewriting the file invalidates the index */
+    WriteAvi(false, 0);
+    SetTime(media, time(NULL) - 60);
+    Parse(vlc);
+    assert(IndexInode() != ino);
+
+    libvlc_release(vlc);
+}
+
+/* The index of the file is read as fast as a cached one: it is not stored,
+ * even once repaired */
+static void test_avi_idx1(void)
+{
+    static const char *const argv[] = {
+        "-v",
+        "--ignore-config",
+        "--demux-index-cache",
+    };
+    char cmd[sizeof (indexdir) + 16];
+
+    snprintf(cmd, sizeof (cmd), "rm -rf %s", indexdir);
+    int ret = system(cmd);
+    assert(ret == 0);
+    (void) ret;
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    WriteAvi(true, 0x10 /* AVIIF_KEYFRAME */);
+    Parse(vlc);
+    assert(ForEachIndex(NULL) == 0);
+
+    /* Key frame flags are missing and get fixed */
+    WriteAvi(true, 0);
+    SetTime(media, time(NULL) - 60);
+    Parse(vlc);
+    assert(ForEachIndex(NULL) == 0);
+
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    static const char *const argv[] = {
+        "-v",
+        "--ignore-config",
+        "--demux-index-cache",
+    };
+
+    test_init();
+
+    if (mkdtemp(tmpdir) == NULL)
+        return 77; /* skipped */
+    setenv("XDG_CACHE_HOME", tmpdir, 1);
+    snprintf(media, sizeof (media), "%s/media", tmpdir);
+    snprintf(indexdir, sizeof (indexdir), "%s/vlc/index", tmpdir);
+    WriteMedia("media file");
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    test_cache(vlc);
+    libvlc_release(vlc);
+
+    snprintf(media, sizeof (media), "%s/media.avi", tmpdir);
+    test_avi();
+    test_avi_idx1();
+
+    char cmd[sizeof (tmpdir) + 16];
+    snprintf(cmd, sizeof (cmd), "rm -rf %s", tmpdir);
+    return system(cmd) != 0;
+}
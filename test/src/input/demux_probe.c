@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * demux_probe.c: test for the demux probing by signature
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+#include <string.h>
+
+/* Demuxers declaring signatures, which must not be probed on other data */
+static const char *const signed_demuxers[] = {
+    "asf", "au", "aiff", "caf", "flac", "mp4", "nsv", "ogg", "smf", "voc",
+    "wav", "xa",
+};
+
+static struct
+{
+    unsigned probes;
+    vlc_tick_t time;
+    char module[32];
+    bool probed[ARRAY_SIZE(signed_demuxers)];
+} stats;
+
+static void LogCallback(void *data, int level, const libvlc_log_t *ctx,
+                        const char *fmt, va_list ap)
+{
+    char msg[256], name[32];
+    unsigned long us;
+
+    (void) data; (void) level; (void) ctx;
+    vsnprintf(msg, sizeof (msg), fmt, ap);
+
+    if (sscanf(msg, "using demux module \"%31[^\"]\"", stats.module) == 1)
+        return;
+    if (sscanf(msg, "demux module \"%31[^\"]\" probe %*s in %lu us",
+               name, &us) != 2)
+        return;
+
+    stats.probes++;
+    stats.time += VLC_TICK_FROM_US(us);
+    for (size_t i = 0; i < ARRAY_SIZE(signed_demuxers); i++)
+        if (!strcmp(name, signed_demuxers[i]))
+            stats.probed[i] = true;
+}
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) out; (void) fmt;
+    return (es_out_id_t *)(uintptr_t)1;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    (void) out; (void) id;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out; (void) query; (void) args;
+    return VLC_EGENERIC;
+}
+
+static const struct es_out_callbacks es_out_cbs = {
+    .add = EsOutAdd,
+    .send = EsOutSend,
+    .del = EsOutDel,
+    .control = EsOutControl,
+};
+
+static void test_probe(vlc_object_t *obj, const char *expected,
+                       const uint8_t *buf, size_t size)
+{
+    es_out_t out = { .cbs = &es_out_cbs };
+
+    memset(&stats, 0, sizeof (stats));
+
+    stream_t *s = vlc_stream_MemoryNew(obj, (uint8_t *)buf, size, true);
+    assert(s != NULL);
+
+    demux_t *demux = demux_New(obj, "any", s, &out);
+    if (demux != NULL)
+        demux_Delete(demux);
+    else
+        vlc_stream_Delete(s);
+
+    printf("%s: %u probes in %"PRId64" us\n",
+           stats.module[0] ? stats.module : "(none)",
+           stats.probes, US_FROM_VLC_TICK(stats.time));
+
+    if (expected != NULL)
+        assert(!strcmp(stats.module, expected));
+
+    /* Only the demuxer with the matching signature was probed */
+    assert(stats.probes > 0);
+    for (size_t i = 0; i < ARRAY_SIZE(signed_demuxers); i++)
+        assert(stats.probed[i] == (expected != NULL
+                                && !strcmp(expected, signed_demuxers[i])));
+}
+
+int main(void)
+{
+    static const char *const argv[] = {
+        "-vv",
+        "--ignore-config",
+    };
+    static uint8_t au[1024] = {
+        '.', 's', 'n', 'd',
+        0, 0, 0, 24,       /* header size */
+        0, 0, 3, 232,      /* data size */
+        0, 0, 0, 2,        /* 8-bit linear PCM */
+        0, 0, 0x1f, 0x40,  /* 8000 Hz */
+        0, 0, 0, 1,        /* mono */
+    };
+    static uint8_t garbage[4096];
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    libvlc_log_set(vlc, LogCallback, NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_probe(obj, "au", au, sizeof (au));
+
+    srand(0);
+    for (size_t i = 0; i < sizeof (garbage); i++)
+        garbage[i] = rand();
+    test_probe(obj, NULL, garbage, sizeof (garbage));
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -182,7 +182,7 @@ stream_close( struct reader *p_reader )
 }
 
 static struct reader *
-stream_open( const char *psz_url )
+stream_open( const char *psz_url, const char *psz_filter )
 {
     libvlc_instance_t *p_vlc;
     struct reader *p_reader;
@@ -194,6 +194,7 @@ stream_open( const char *psz_url )
         "--no-media-library",
         "--vout=dummy",
         "--aout=dummy",
+        "--cache-range-size=256", /* smaller than the test file */
     };
 
     p_reader = calloc( 1, sizeof(struct reader) );
@@ -209,6 +210,12 @@ stream_open( const char *psz_url )
         free( p_reader );
         return NULL;
     }
+    if( psz_filter )
+    {
+        stream_t *p_filter = vlc_stream_FilterNew( p_reader->u.s, psz_filter );
+        assert( p_filter );
+        p_reader->u.s = p_filter;
+    }
     p_reader->pf_close = stream_close;
     p_reader->pf_getsize = stream_getsize;
     p_reader->pf_read = stream_read;
@@ -216,7 +223,7 @@ stream_open( const char *psz_url )
     p_reader->pf_tell = stream_tell;
     p_reader->pf_seek = stream_seek;
     p_reader->p_data = p_vlc;
-    p_reader->psz_name = "stream";
+    p_reader->psz_name = psz_filter ? psz_filter : "stream";
     return p_reader;
 }
 
@@ -377,15 +384,28 @@ main( void )
     test_log( "Generating random file...\n" );
     i_tmp_fd = vlc_mkstemp( psz_tmp_path );
     fill_rand( i_tmp_fd, RAND_FILE_SIZE );
-    test_log( "Testing random file with libc, and stream...\n" );
+    test_log( "Testing random file with libc, stream and range cache...\n" );
     assert( i_tmp_fd != -1 );
     assert( asprintf( &psz_url, "file://%s", psz_tmp_path ) != -1 );
 
     assert( ( pp_readers[0] = libc_open( psz_tmp_path ) ) );
-    assert( ( pp_readers[1] = stream_open( psz_url ) ) );
-
-    test( pp_readers, 2, NULL );
-    for( unsigned int i = 0; i < 2; ++i )
+    assert( ( pp_readers[1] = stream_open( psz_url, NULL ) ) );
+    assert( ( pp_readers[2] = stream_open( psz_url, "cache_range" ) ) );
+
+    test( pp_readers, 3, NULL );
+
+    stream_cache_stats_t stats;
+    assert( vlc_stream_Control( pp_readers[2]->u.s, STREAM_GET_CACHE_STATS,
+                                &stats ) == VLC_SUCCESS );
+    test_log( "range cache: %"PRIu64" hits, %"PRIu64" misses, "
+              "%"PRIu64" evictions\n", stats.hits, stats.misses,
+              stats.evictions );
+    assert( stats.hits > 0 && stats.misses > 0 && stats.evictions > 0 );
+    assert( stats.cached <= stats.budget );
+    /* going back over the cached ranges does not fetch them again */
+    assert( stats.read_bytes < 2 * RAND_FILE_SIZE );
+
+    for( unsigned int i = 0; i < 3; ++i )
         pp_readers[i]->pf_close( pp_readers[i] );
     free( psz_url );
 
@@ -394,7 +414,7 @@ main( void )
 
     test_log( "Testing http url with stream...\n" );
     alarm( 0 );
-    if( !( pp_readers[0] = stream_open( HTTP_URL ) ) )
+    if( !( pp_readers[0] = stream_open( HTTP_URL, NULL ) ) )
     {
         test_log( "WARNING: can't test http url" );
         return 0;
@@ -78,12 +78,11 @@ static void thumbnailer_callback( void* data, picture_t* thumbnail )
                 "Expected failure but got a thumbnail" );
         assert( thumbnail->format.i_chroma == VLC_CODEC_ARGB );
 
-        /* TODO: Enable this once the new clock is merged */
-#if 0
         vlc_tick_t expected_date;
         /* Don't rely on the expected date if it was purposely invalid */
         if ( test_params[p_ctx->test_idx].b_use_pos == true )
-            expected_date = MOCK_DURATION * test_params[p_ctx->test_idx].f_pos;
+            expected_date = test_params[p_ctx->test_idx].f_pos *
+                            (double) MOCK_DURATION;
         else if ( test_params[p_ctx->test_idx].i_add_video_track_at != VLC_TICK_INVALID )
             expected_date = test_params[p_ctx->test_idx].i_add_video_track_at;
         else
@@ -94,7 +93,6 @@ static void thumbnailer_callback( void* data, picture_t* thumbnail )
                 expected_date = test_params[p_ctx->test_idx].i_time;
         }
         assert( thumbnail->date == expected_date && "Unexpected picture date");
-#endif
     }
     else
         assert( !test_params[p_ctx->test_idx].b_expected_success &&
@@ -207,6 +205,125 @@ static void test_cancel_thumbnail( libvlc_instance_t* p_vlc )
     vlc_thumbnailer_Release( p_thumbnailer );
 }
 
+#define BATCH_COUNT 8
+
+static const vlc_tick_t batch_times[BATCH_COUNT] = {
+    VLC_TICK_FROM_SEC( 10 ), VLC_TICK_FROM_SEC( 45 ), VLC_TICK_FROM_SEC( 80 ),
+    VLC_TICK_FROM_SEC( 115 ), VLC_TICK_FROM_SEC( 150 ),
+    VLC_TICK_FROM_SEC( 185 ), VLC_TICK_FROM_SEC( 220 ),
+    VLC_TICK_FROM_SEC( 255 ),
+};
+
+struct batch_ctx
+{
+    vlc_cond_t cond;
+    vlc_mutex_t lock;
+    size_t received;
+    unsigned width, height; /* expected size */
+};
+
+static void thumbnailer_callback_batch( void* data, size_t index,
+                                        picture_t* p_thumbnail )
+{
+    struct batch_ctx* p_ctx = data;
+
+    assert( p_thumbnail != NULL );
+    assert( p_thumbnail->format.i_chroma == VLC_CODEC_ARGB );
+
+    vlc_mutex_lock( &p_ctx->lock );
+    assert( p_thumbnail->format.i_visible_width == p_ctx->width );
+    assert( p_thumbnail->format.i_visible_height == p_ctx->height );
+    assert( index == p_ctx->received );
+    assert( p_thumbnail->date >= batch_times[index] );
+    p_ctx->received++;
+    vlc_cond_signal( &p_ctx->cond );
+    vlc_mutex_unlock( &p_ctx->lock );
+}
+
+static void thumbnailer_callback_single( void* data, picture_t* p_thumbnail )
+{
+    struct batch_ctx* p_ctx = data;
+
+    assert( p_thumbnail != NULL );
+
+    vlc_mutex_lock( &p_ctx->lock );
+    assert( p_thumbnail->date >= batch_times[p_ctx->received] );
+    p_ctx->received++;
+    vlc_cond_signal( &p_ctx->cond );
+    vlc_mutex_unlock( &p_ctx->lock );
+}
+
+/* Runs a batch request on the mock item, and returns its completion time */
+static vlc_tick_t run_batch( vlc_thumbnailer_t* p_thumbnailer,
+                             input_item_t* p_item, struct batch_ctx* p_ctx,
+                             unsigned width, unsigned height,
+                             unsigned expected_width, unsigned expected_height )
+{
+    vlc_mutex_lock( &p_ctx->lock );
+    p_ctx->received = 0;
+    p_ctx->width = expected_width;
+    p_ctx->height = expected_height;
+    vlc_thumbnailer_request_t* p_req = vlc_thumbnailer_RequestBatch(
+        p_thumbnailer, batch_times, BATCH_COUNT, VLC_THUMBNAILER_SEEK_PRECISE,
+        width, height, p_item, VLC_TICK_FROM_SEC( 5 ),
+        thumbnailer_callback_batch, p_ctx );
+    assert( p_req != NULL );
+    while ( p_ctx->received < BATCH_COUNT )
+        vlc_cond_wait( &p_ctx->cond, &p_ctx->lock );
+    vlc_mutex_unlock( &p_ctx->lock );
+    return vlc_tick_now();
+}
+
+static void test_batch_thumbnails( libvlc_instance_t* p_vlc )
+{
+    vlc_thumbnailer_t* p_thumbnailer = vlc_thumbnailer_Create(
+                VLC_OBJECT( p_vlc->p_libvlc_int ) );
+    assert( p_thumbnailer != NULL );
+
+    struct batch_ctx batch;
+    vlc_cond_init( &batch.cond );
+    vlc_mutex_init( &batch.lock );
+
+    char* psz_mrl;
+    if ( asprintf( &psz_mrl, "mock://video_track_count=1;audio_track_count=1"
+                   ";length=%" PRId64 ";video_chroma=ARGB", MOCK_DURATION ) < 0 )
+        assert( !"Failed to allocate mock mrl" );
+    input_item_t* p_item = input_item_New( psz_mrl, "mock item" );
+    assert( p_item != NULL );
+
+    /* One request per thumbnail */
+    vlc_tick_t start = vlc_tick_now();
+    batch.received = 0;
+    for ( size_t i = 0; i < BATCH_COUNT; ++i )
+    {
+        vlc_mutex_lock( &batch.lock );
+        vlc_thumbnailer_RequestByTime( p_thumbnailer, batch_times[i],
+            VLC_THUMBNAILER_SEEK_PRECISE, p_item, VLC_TICK_FROM_SEC( 5 ),
+            thumbnailer_callback_single, &batch );
+        while ( batch.received == i )
+            vlc_cond_wait( &batch.cond, &batch.lock );
+        vlc_mutex_unlock( &batch.lock );
+    }
+    vlc_tick_t single = vlc_tick_now() - start;
+
+    /* A single batch request, at the source size */
+    start = vlc_tick_now();
+    vlc_tick_t batched = run_batch( p_thumbnailer, p_item, &batch, 0, 0,
+                                    640, 480 ) - start;
+
+    printf( "%d thumbnails: %.1f thumbnails/s with single requests, "
+            "%.1f thumbnails/s with a batch request\n", BATCH_COUNT,
+            (double)BATCH_COUNT * CLOCK_FREQ / __MAX( single, 1 ),
+            (double)BATCH_COUNT * CLOCK_FREQ / __MAX( batched, 1 ) );
+
+    /* Scaled to a width of 160, keeping the aspect ratio */
+    run_batch( p_thumbnailer, p_item, &batch, 160, 0, 160, 120 );
+
+    input_item_Release( p_item );
+    free( psz_mrl );
+    vlc_thumbnailer_Release( p_thumbnailer );
+}
+
 int main()
 {
     test_init();
@@ -220,6 +337,7 @@ int main()
 
     test_thumbnails( vlc );
     test_cancel_thumbnail( vlc );
+    test_batch_thumbnails( vlc );
 
     libvlc_release( vlc );
 }
@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * messages.c: test and benchmark for the asynchronous message log
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define THREADS  4
+#define MESSAGES 2000
+#define ERRORS   100 /* one error every so many messages */
+
+static const char dropped_fmt[] = "%u log messages dropped";
+static const char limited_fmt[] = "%u debug messages rate limited";
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned received;
+    unsigned dropped;
+    unsigned limited;
+    unsigned errors;
+} sink;
+
+/* A slow log output, serialized like the file logger */
+static void LogCb(void *data, int level, const libvlc_log_t *ctx,
+                  const char *fmt, va_list ap)
+{
+    char msg[256];
+
+    (void) data; (void) ctx;
+    vlc_mutex_lock(&sink.lock);
+    if (!strcmp(fmt, dropped_fmt))
+        sink.dropped += va_arg(ap, unsigned);
+    else if (!strcmp(fmt, limited_fmt))
+        sink.limited += va_arg(ap, unsigned);
+    else
+    {
+        vsnprintf(msg, sizeof (msg), fmt, ap);
+        if (!strncmp(msg, "hot message", 11))
+            sink.received++;
+        else if (!strncmp(msg, "error", 5))
+        {
+            assert(level == LIBVLC_ERROR);
+            sink.errors++;
+        }
+    }
+
+    vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_US(2);
+    while (vlc_tick_now() < deadline);
+    vlc_mutex_unlock(&sink.lock);
+}
+
+struct hot_thread
+{
+    vlc_thread_t thread;
+    vlc_object_t *obj;
+    unsigned id;
+    vlc_tick_t total;
+    vlc_tick_t max;
+};
+
+/* Logs from a thread with real-time constraints, like a decoder */
+static void *HotThread(void *data)
+{
+    struct hot_thread *hot = data;
+
+    for (unsigned i = 0; i < MESSAGES; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+
+        vlc_object_Log(hot->obj, VLC_MSG_DBG, "test", __FILE__, __LINE__,
+                       __func__, "hot message %u from thread %u: %s", i,
+                       hot->id, "with some text to format");
+        if ((i % ERRORS) == 0)
+            vlc_object_Log(hot->obj, VLC_MSG_ERR, "test", __FILE__, __LINE__,
+                           __func__, "error %u from thread %u", i, hot->id);
+
+        vlc_tick_t latency = vlc_tick_now() - start;
+        hot->total += latency;
+        if (latency > hot->max)
+            hot->max = latency;
+    }
+    return NULL;
+}
+
+static void test_latency(const char *name, libvlc_instance_t *vlc)
+{
+    struct hot_thread threads[THREADS];
+    vlc_tick_t total = 0, max = 0;
+
+    for (unsigned i = 0; i < THREADS; i++)
+    {
+        threads[i].obj = VLC_OBJECT(vlc->p_libvlc_int);
+        threads[i].id = i;
+        threads[i].total = threads[i].max = 0;
+        assert(vlc_clone(&threads[i].thread, HotThread, &threads[i],
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    }
+
+    for (unsigned i = 0; i < THREADS; i++)
+    {
+        vlc_join(threads[i].thread, NULL);
+        total += threads[i].total;
+        if (threads[i].max > max)
+            max = threads[i].max;
+    }
+
+    printf("%s log: %.2f us per call on average, %"PRId64" us at most\n",
+           name, (double)total / (THREADS * MESSAGES), US_FROM_VLC_TICK(max));
+}
+
+static libvlc_instance_t *Create(const char *const *argv, int argc)
+{
+    libvlc_instance_t *vlc = libvlc_new(argc, argv);
+    assert(vlc != NULL);
+
+    libvlc_log_set(vlc, LogCb, NULL);
+    vlc_mutex_lock(&sink.lock);
+    sink.received = sink.dropped = sink.limited = sink.errors = 0;
+    vlc_mutex_unlock(&sink.lock);
+    return vlc;
+}
+
+/* The log module filters the queued messages on the log thread */
+static void test_verbosity(void)
+{
+    char path[] = "/tmp/vlc-messages-XXXXXX";
+    int fd = vlc_mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+
+    char logfile[64];
+    snprintf(logfile, sizeof (logfile), "--logfile=%s", path);
+    const char *argv[] = {
+        "--ignore-config", "--verbose=1", "--log-async", "--file-logging",
+        logfile,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    /* Fewer messages than the ring slots, so that none is dropped */
+    for (unsigned i = 0; i < 100; i++)
+        vlc_object_Log(VLC_OBJECT(vlc->p_libvlc_int), VLC_MSG_DBG, "test",
+                       __FILE__, __LINE__, __func__, "hot message %u", i);
+    vlc_object_Log(VLC_OBJECT(vlc->p_libvlc_int), VLC_MSG_ERR, "test",
+                   __FILE__, __LINE__, __func__, "error");
+    libvlc_release(vlc);
+
+    FILE *stream = vlc_fopen(path, "rt");
+    assert(stream != NULL);
+
+    char line[256];
+    unsigned errors = 0;
+    bool logged = false; /* if the file logger is available */
+    while (fgets(line, sizeof (line), stream) != NULL)
+    {
+        if (strstr(line, "-- logger module started --") != NULL)
+            logged = true;
+        assert(strstr(line, "hot message") == NULL);
+        assert(strstr(line, "dropped") == NULL);
+        if (strstr(line, "test error: error") != NULL)
+            errors++;
+    }
+    fclose(stream);
+    vlc_unlink(path);
+    assert(errors == (logged ? 1 : 0));
+}
+
+int main(void)
+{
+    static const char *const argv_sync[] = {
+        "-v", "--ignore-config",
+    };
+    static const char *const argv_async[] = {
+        "-v", "--ignore-config", "--log-async",
+    };
+    static const char *const argv_limited[] = {
+        "-v", "--ignore-config", "--log-async", "--log-rate-limit=100",
+    };
+
+    test_init();
+    vlc_mutex_init(&sink.lock);
+
+    /* Synchronous logging: nothing is lost */
+    libvlc_instance_t *vlc = Create(argv_sync, ARRAY_SIZE(argv_sync));
+    test_latency("synchronous", vlc);
+    libvlc_release(vlc);
+    assert(sink.received == THREADS * MESSAGES);
+    assert(sink.errors == THREADS * MESSAGES / ERRORS);
+    assert(sink.dropped == 0);
+
+    /* Asynchronous logging: every message is either passed or counted, and
+     * debug messages are dropped first */
+    vlc = Create(argv_async, ARRAY_SIZE(argv_async));
+    test_latency("asynchronous", vlc);
+    libvlc_release(vlc);
+    printf("%u messages passed, %u dropped\n", sink.received, sink.dropped);
+    /* Dropped messages can include debug messages of libvlc itself */
+    assert(sink.received <= THREADS * MESSAGES);
+    assert(sink.received + sink.dropped >= THREADS * MESSAGES);
+    assert(sink.errors == THREADS * MESSAGES / ERRORS);
+    assert(sink.limited == 0);
+
+    /* Debug messages are rate limited per module, errors are not */
+    vlc = Create(argv_limited, ARRAY_SIZE(argv_limited));
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        vlc_object_Log(VLC_OBJECT(vlc->p_libvlc_int), VLC_MSG_DBG, "noisy",
+                       __FILE__, __LINE__, __func__, "hot message %u", i);
+        vlc_object_Log(VLC_OBJECT(vlc->p_libvlc_int), VLC_MSG_ERR, "noisy",
+                       __FILE__, __LINE__, __func__, "error %u", i);
+    }
+    libvlc_release(vlc);
+    printf("%u messages passed, %u rate limited\n", sink.received,
+           sink.limited);
+    /* Dropped messages can include debug messages of libvlc itself */
+    assert(sink.received + sink.errors + sink.limited <= 2000);
+    assert(sink.received + sink.errors + sink.limited + sink.dropped >= 2000);
+    /* The rate limiter counts per second of the wall clock, so how many
+     * debug messages pass depends on the scheduling */
+    assert(sink.received <= 1000);
+    assert(sink.errors > 200);
+
+    test_verbosity();
+
+    vlc_mutex_destroy(&sink.lock);
+    return 0;
+}
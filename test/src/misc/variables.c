@@ -444,6 +444,145 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOVAR );
 }
 
+static void test_many( libvlc_int_t *p_libvlc )
+{
+    vlc_object_t *obj = vlc_object_create( p_libvlc, sizeof (*obj) );
+    assert( obj != NULL );
+    char name[16];
+
+    /* Enough to grow the hash table a few times */
+    for( int i = 0; i < 1000; i++ )
+    {
+        snprintf( name, sizeof (name), "many-%d", i );
+        assert( var_Create( obj, name, VLC_VAR_INTEGER ) == VLC_SUCCESS );
+        var_SetInteger( obj, name, i );
+    }
+    for( int i = 0; i < 1000; i++ )
+    {
+        snprintf( name, sizeof (name), "many-%d", i );
+        assert( var_GetInteger( obj, name ) == i );
+    }
+    for( int i = 0; i < 1000; i += 2 )
+    {
+        snprintf( name, sizeof (name), "many-%d", i );
+        var_Destroy( obj, name );
+    }
+    for( int i = 0; i < 1000; i++ )
+    {
+        vlc_value_t val;
+        snprintf( name, sizeof (name), "many-%d", i );
+        assert( var_Get( obj, name, &val ) == ((i & 1) ? VLC_SUCCESS : VLC_ENOVAR) );
+    }
+
+    /* Inherited from the parent, shadowed by the object */
+    var_Create( p_libvlc, "many-inherit", VLC_VAR_INTEGER );
+    var_SetInteger( p_libvlc, "many-inherit", 42 );
+    assert( var_InheritInteger( obj, "many-inherit" ) == 42 );
+    var_Create( obj, "many-inherit", VLC_VAR_INTEGER );
+    var_SetInteger( obj, "many-inherit", 43 );
+    assert( var_InheritInteger( obj, "many-inherit" ) == 43 );
+    var_Destroy( obj, "many-inherit" );
+    assert( var_InheritInteger( obj, "many-inherit" ) == 42 );
+    var_Destroy( p_libvlc, "many-inherit" );
+
+    vlc_object_delete( obj );
+}
+
+#define BENCH_THREADS 4
+#define BENCH_DEPTH 3
+#define BENCH_LOOPS 100000
+
+struct bench
+{
+    vlc_object_t *leaf;
+    unsigned id;
+    unsigned op;
+};
+
+static void *bench_thread( void *data )
+{
+    struct bench *b = data;
+    char name[16];
+
+    snprintf( name, sizeof (name), "bench-%u", b->id );
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+    {
+        switch( b->op )
+        {
+            case 0:
+                assert( var_GetInteger( b->leaf, "bench-shared" ) == 1 );
+                break;
+            case 1:
+                var_SetInteger( b->leaf, name, i );
+                break;
+            case 2:
+                assert( var_InheritInteger( b->leaf, "bench-inherit" ) == 2 );
+                break;
+        }
+    }
+    return NULL;
+}
+
+static void bench_variables( libvlc_int_t *p_libvlc, unsigned threads )
+{
+    static const char *const ops[] = { "get", "set", "inherit" };
+    vlc_object_t *objs[BENCH_DEPTH];
+    vlc_object_t *parent = VLC_OBJECT(p_libvlc);
+
+    var_Create( p_libvlc, "bench-inherit", VLC_VAR_INTEGER );
+    var_SetInteger( p_libvlc, "bench-inherit", 2 );
+    for( unsigned i = 0; i < BENCH_DEPTH; i++ )
+    {
+        objs[i] = vlc_object_create( parent, sizeof (*objs[i]) );
+        assert( objs[i] != NULL );
+        /* Some unrelated variables on each object */
+        for( unsigned j = 0; j < 20; j++ )
+        {
+            char name[16];
+            snprintf( name, sizeof (name), "unrelated-%u", j );
+            var_Create( objs[i], name, VLC_VAR_FLOAT );
+        }
+        parent = objs[i];
+    }
+    vlc_object_t *leaf = objs[BENCH_DEPTH - 1];
+    var_Create( leaf, "bench-shared", VLC_VAR_INTEGER );
+    var_SetInteger( leaf, "bench-shared", 1 );
+    for( unsigned i = 0; i < threads; i++ )
+    {
+        char name[16];
+        snprintf( name, sizeof (name), "bench-%u", i );
+        var_Create( leaf, name, VLC_VAR_INTEGER );
+    }
+
+    for( unsigned op = 0; op < ARRAY_SIZE(ops); op++ )
+    {
+        struct bench b[BENCH_THREADS];
+        vlc_thread_t th[BENCH_THREADS];
+        vlc_tick_t start = vlc_tick_now();
+
+        for( unsigned i = 0; i < threads; i++ )
+        {
+            b[i].leaf = leaf;
+            b[i].id = i;
+            b[i].op = op;
+            assert( vlc_clone( &th[i], bench_thread, &b[i],
+                               VLC_THREAD_PRIORITY_LOW ) == 0 );
+        }
+        for( unsigned i = 0; i < threads; i++ )
+            vlc_join( th[i], NULL );
+
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+        if( elapsed <= 0 )
+            elapsed = 1;
+        test_log( "%u thread(s) %s: %"PRIu64" calls/s\n", threads, ops[op],
+                  (uint64_t)threads * BENCH_LOOPS * CLOCK_FREQ / elapsed );
+    }
+
+    for( unsigned i = BENCH_DEPTH; i-- > 0; )
+        vlc_object_delete( objs[i] );
+    var_Destroy( p_libvlc, "bench-inherit" );
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -481,6 +620,13 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     test_log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    test_log( "Testing many variables\n" );
+    test_many( p_libvlc );
+
+    test_log( "Benchmarking under contention\n" );
+    bench_variables( p_libvlc, 1 );
+    bench_variables( p_libvlc, BENCH_THREADS );
 }
 
 
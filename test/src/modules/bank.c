@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * bank.c: plugins bank and cache test and startup benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RUNS 5
+
+/* The plugins cache is written next to the plugins: the tests use links to
+ * the built plugins, so that they do not rewrite the cache of the tree. */
+static char plugindir[] = "/tmp/vlc-plugins-XXXXXX";
+
+static void LinkPlugins(const char *dir, unsigned depth)
+{
+    DIR *dh = opendir(dir);
+    if (dh == NULL || depth == 0)
+    {
+        if (dh != NULL)
+            closedir(dh);
+        return;
+    }
+
+    static const char suffix[] = "_plugin"LIBEXT;
+    const struct dirent *ent;
+
+    while ((ent = readdir(dh)) != NULL)
+    {
+        char path[PATH_MAX], link[PATH_MAX];
+        struct stat st;
+        size_t len = strlen(ent->d_name);
+
+        if (ent->d_name[0] == '.' && strcmp(ent->d_name, ".libs"))
+            continue;
+        snprintf(path, sizeof (path), "%s/%s", dir, ent->d_name);
+        if (stat(path, &st))
+            continue;
+
+        if (S_ISDIR(st.st_mode))
+            LinkPlugins(path, depth - 1);
+        else if (S_ISREG(st.st_mode) && !strncmp(ent->d_name, "lib", 3)
+              && len > strlen(suffix)
+              && !strcmp(ent->d_name + len - strlen(suffix), suffix))
+        {
+            char *abspath = realpath(path, NULL);
+            assert(abspath != NULL);
+            snprintf(link, sizeof (link), "%s/%s", plugindir, ent->d_name);
+            if (symlink(abspath, link))
+                assert(errno == EEXIST); /* keeps the first of duplicates */
+            free(abspath);
+        }
+    }
+    closedir(dh);
+}
+
+/* Digest of the module bank, in order: modules of equal scores are probed
+ * in the order that they were loaded in. */
+static uint64_t BankDigest(size_t *count)
+{
+    module_t **list = module_list_get(count);
+    uint64_t h = 14695981039346656037ULL; /* FNV-1a */
+
+    for (size_t i = 0; i < *count; i++)
+    {
+        const char *strs[] = {
+            module_get_object(list[i]), module_get_capability(list[i]),
+        };
+
+        for (size_t j = 0; j < ARRAY_SIZE(strs); j++)
+        {
+            for (const char *p = strs[j]; p != NULL && *p; p++)
+                h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+            h *= 1099511628211ULL; /* hashes the nul terminator */
+        }
+        h = (h ^ (unsigned)module_get_score(list[i])) * 1099511628211ULL;
+    }
+    module_list_free(list);
+    return h;
+}
+
+static void RemovePlugins(void)
+{
+    DIR *dh = opendir(plugindir);
+    assert(dh != NULL);
+
+    const struct dirent *ent;
+
+    while ((ent = readdir(dh)) != NULL)
+    {
+        char path[PATH_MAX];
+
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+            continue;
+        snprintf(path, sizeof (path), "%s/%s", plugindir, ent->d_name);
+        if (unlink(path))
+            perror(path);
+    }
+    closedir(dh);
+    if (rmdir(plugindir))
+        perror(plugindir);
+}
+
+static uint64_t test_startup(const char *mode, const char *opt, bool bench)
+{
+    const char *argv[] = { "--ignore-config", "-q", opt };
+    vlc_tick_t best = INT64_MAX, total = 0;
+    uint64_t digest = 0;
+    size_t count = 0;
+
+    for (unsigned i = 0; i < (bench ? RUNS : 1); i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+        assert(vlc != NULL);
+
+        uint64_t d = BankDigest(&count);
+        assert(count > 1);
+        assert(i == 0 || d == digest);
+        digest = d;
+
+        libvlc_release(vlc);
+        if (elapsed < best)
+            best = elapsed;
+        total += elapsed;
+    }
+
+    if (bench)
+        printf("libvlc_new %-11s: %zu modules, best %"PRId64" us, "
+               "mean %"PRId64" us\n", mode, count, US_FROM_VLC_TICK(best),
+               US_FROM_VLC_TICK(total / RUNS));
+    return digest;
+}
+
+int main(void)
+{
+    test_init();
+
+    const char *modules = getenv("VLC_PLUGIN_PATH");
+    assert(modules != NULL);
+    if (mkdtemp(plugindir) == NULL)
+    {
+        perror("mkdtemp");
+        return 77;
+    }
+    LinkPlugins(modules, 5);
+    setenv("VLC_PLUGIN_PATH", plugindir, 1);
+
+    uint64_t cold = test_startup("cold", "--no-plugins-cache", true);
+
+    /* Write a fresh cache, then start from it */
+    test_startup("reset", "--reset-plugins-cache", false);
+    uint64_t warm = test_startup("warm", "--plugins-cache", true);
+    uint64_t noscan = test_startup("warm/noscan", "--no-plugins-scan", true);
+
+    /* The cache describes exactly the same modules as the plugins */
+    assert(cold == warm);
+    assert(cold == noscan);
+
+    RemovePlugins();
+    return 0;
+}
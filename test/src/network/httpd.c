@@ -0,0 +1,322 @@
+/*****************************************************************************
+ * httpd.c: HTTP live stream server test and load benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_httpd.h>
+#include <vlc_block.h>
+
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BLOCK_SIZE  1316 /* 7 TS packets */
+#define MAX_CLIENTS 512
+#define HEADER      "HDR!"
+
+/*
+ * Each block starts with its absolute position in the stream, so that the
+ * clients can check the data wherever they start from.
+ */
+static uint8_t Pattern(uint64_t pos)
+{
+    uint64_t start = pos - (pos - 1) % BLOCK_SIZE;
+    unsigned offset = pos - start;
+
+    if (offset < 8)
+        return start >> (8 * offset);
+    return pos * 7;
+}
+
+struct client
+{
+    int fd;
+    char head[256];
+    size_t headlen;
+    bool body;
+    size_t hdr;      /* stream header bytes received */
+    uint64_t start;  /* position of the first block */
+    unsigned startlen;
+    uint64_t pos;
+    bool eof;
+    bool done;
+};
+
+struct clients
+{
+    struct client cl[MAX_CLIENTS];
+    unsigned count;
+    atomic_uint_fast64_t end; /* stream position once fully sent */
+    atomic_uint done; /* clients that received the whole stream */
+    vlc_thread_t thread;
+    vlc_tick_t cpu;
+};
+
+static void ClientParse(struct client *c, const uint8_t *buf, size_t len)
+{
+    while (len > 0 && !c->body) {
+        assert(c->headlen < sizeof (c->head));
+        c->head[c->headlen++] = *(buf++);
+        len--;
+        if (c->headlen >= 4
+         && !memcmp(&c->head[c->headlen - 4], "\r\n\r\n", 4)) {
+            assert(!strncmp(c->head, "HTTP/1.0 200 ", 13));
+            c->body = true;
+        }
+    }
+
+    for (; len > 0 && c->hdr < strlen(HEADER); buf++, len--)
+        assert(*buf == HEADER[c->hdr++]);
+
+    for (; len > 0 && c->startlen < 8; buf++, len--)
+        c->start |= (uint64_t)*buf << (8 * c->startlen++);
+    if (c->startlen < 8)
+        return;
+    if (c->pos == 0) {
+        assert(c->start >= 1 && (c->start - 1) % BLOCK_SIZE == 0);
+        c->pos = c->start + 8;
+    }
+
+    for (; len > 0; buf++, len--)
+        assert(*buf == Pattern(c->pos++));
+}
+
+static vlc_tick_t ThreadCPUTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return vlc_tick_from_timespec(&ts);
+}
+
+static vlc_tick_t ProcessCPUTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return vlc_tick_from_timespec(&ts);
+}
+
+static void *ClientsThread(void *data)
+{
+    struct clients *cls = data;
+    struct pollfd ufd[MAX_CLIENTS];
+    static uint8_t buf[65536];
+
+    for (;;) {
+        uint64_t end = atomic_load(&cls->end);
+        unsigned n = 0;
+        for (unsigned i = 0; i < cls->count; i++) {
+            struct client *c = &cls->cl[i];
+
+            if (!c->done && c->pos == end) {
+                c->done = true;
+                atomic_fetch_add(&cls->done, 1);
+            }
+        }
+
+        for (unsigned i = 0; i < cls->count; i++)
+            if (!cls->cl[i].eof) {
+                ufd[n].fd = cls->cl[i].fd;
+                ufd[n].events = POLLIN;
+                n++;
+            }
+        if (n == 0)
+            break;
+
+        if (poll(ufd, n, 20) <= 0)
+            continue;
+
+        n = 0;
+        for (unsigned i = 0; i < cls->count; i++) {
+            struct client *c = &cls->cl[i];
+            if (c->eof)
+                continue;
+            if (ufd[n++].revents == 0)
+                continue;
+
+            ssize_t val = read(c->fd, buf, sizeof (buf));
+            if (val > 0)
+                ClientParse(c, buf, val);
+            else
+                c->eof = true;
+        }
+    }
+
+    cls->cpu = ThreadCPUTime();
+    return NULL;
+}
+
+static void ClientsStart(struct clients *cls, uint16_t port, unsigned count)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    static const char req[] = "GET /stream HTTP/1.0\r\n\r\n";
+
+    memset(cls, 0, sizeof (*cls));
+    atomic_init(&cls->end, UINT64_MAX);
+    atomic_init(&cls->done, 0);
+
+    for (unsigned i = 0; i < count; i++) {
+        struct client *c = &cls->cl[i];
+        c->fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(c->fd != -1);
+        int ret = connect(c->fd, (struct sockaddr *)&addr, sizeof (addr));
+        assert(ret == 0);
+        ret = write(c->fd, req, strlen(req));
+        assert(ret == (int)strlen(req));
+    }
+    cls->count = count;
+
+    int ret = vlc_clone(&cls->thread, ClientsThread, cls,
+                        VLC_THREAD_PRIORITY_LOW);
+    assert(ret == 0);
+}
+
+static void ClientsStop(struct clients *cls)
+{
+    vlc_join(cls->thread, NULL);
+    for (unsigned i = 0; i < cls->count; i++)
+        close(cls->cl[i].fd);
+}
+
+static uint16_t FreePort(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof (addr);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd != -1);
+    int ret = bind(fd, (struct sockaddr *)&addr, sizeof (addr));
+    assert(ret == 0);
+    ret = getsockname(fd, (struct sockaddr *)&addr, &addrlen);
+    assert(ret == 0);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void test_stream(unsigned workers, unsigned count, unsigned rate)
+{
+    char port_arg[32], workers_arg[32];
+    uint16_t port = FreePort();
+
+    snprintf(port_arg, sizeof (port_arg), "--http-port=%u", port);
+    snprintf(workers_arg, sizeof (workers_arg), "--http-workers=%u", workers);
+
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "--http-host=127.0.0.1",
+        port_arg,
+        workers_arg,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    httpd_host_t *host = vlc_http_HostNew(VLC_OBJECT(vlc->p_libvlc_int));
+    assert(host != NULL);
+    httpd_stream_t *stream = httpd_StreamNew(host, "/stream",
+                                             "application/octet-stream",
+                                             NULL, NULL);
+    assert(stream != NULL);
+    httpd_StreamHeader(stream, (uint8_t *)HEADER, strlen(HEADER));
+
+    struct clients *cls = malloc(sizeof (*cls));
+    assert(cls != NULL);
+    ClientsStart(cls, port, count);
+
+    block_t *block = block_Alloc(BLOCK_SIZE);
+    assert(block != NULL);
+
+    vlc_tick_t cpu = ProcessCPUTime();
+    vlc_tick_t main_cpu = ThreadCPUTime();
+    vlc_tick_t start = vlc_tick_now();
+    vlc_tick_t duration = VLC_TICK_FROM_SEC(1);
+    uint64_t pos = 1; /* the stream buffer positions start at 1 */
+    unsigned blocks = rate / BLOCK_SIZE / 100 + 1; /* per 10 ms */
+
+    for (vlc_tick_t date = start; date < start + duration;
+         date += VLC_TICK_FROM_MS(10)) {
+        vlc_tick_wait(date);
+        for (unsigned b = 0; b < blocks; b++) {
+            for (unsigned i = 0; i < BLOCK_SIZE; i++)
+                block->p_buffer[i] = Pattern(pos + i);
+            httpd_StreamSend(stream, block);
+            pos += BLOCK_SIZE;
+        }
+    }
+
+    /* wait for every client to receive the whole stream */
+    atomic_store(&cls->end, pos);
+    while (atomic_load(&cls->done) < count)
+        vlc_tick_sleep(VLC_TICK_FROM_MS(10));
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    main_cpu = ThreadCPUTime() - main_cpu;
+
+    /* the clients see the end of the stream */
+    httpd_StreamDelete(stream);
+    ClientsStop(cls);
+    cpu = ProcessCPUTime() - cpu - main_cpu - cls->cpu;
+    if (cpu <= 0)
+        cpu = 1;
+
+    for (unsigned i = 0; i < count; i++) {
+        struct client *c = &cls->cl[i];
+        /* clients may join late, but then get everything from a block
+         * boundary up to the end of the stream */
+        assert(c->body && c->hdr == strlen(HEADER));
+        assert(c->done && c->pos == pos);
+    }
+
+    printf("http-workers=%u, %u clients at %u kB/s: server CPU %.1f%%, "
+           "%.0f clients per core\n", workers, count, rate / 1000,
+           100. * cpu / elapsed, (double)count * elapsed / cpu);
+
+    block_Release(block);
+    free(cls);
+    httpd_HostDelete(host);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_stream(1, 4, 100000);
+    test_stream(2, 64, 500000);
+    test_stream(0, 256, 100000);
+    return 0;
+}
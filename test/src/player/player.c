@@ -172,6 +172,8 @@ struct media_params
 
     bool video_packetized, audio_packetized, sub_packetized;
 
+    unsigned video_width;
+    unsigned video_height;
     unsigned video_frame_rate;
     unsigned video_frame_rate_base;
 
@@ -180,6 +182,7 @@ struct media_params
 
     bool can_seek;
     bool can_pause;
+    bool can_control_pace;
     bool error;
     bool null_names;
 };
@@ -194,12 +197,15 @@ struct media_params
     }, \
     .program_count = 0, \
     .video_packetized = true, .audio_packetized = true, .sub_packetized = true,\
+    .video_width = 4, \
+    .video_height = 4, \
     .video_frame_rate = 25, \
     .video_frame_rate_base = 1, \
     .title_count = 0, \
     .chapter_count = 0, \
     .can_seek = true, \
     .can_pause = true, \
+    .can_control_pace = true, \
     .error = false, \
     .null_names = false, \
 }
@@ -656,20 +662,22 @@ create_mock_media(const char *name, const struct media_params *params)
     assert(params);
     char *url;
     int ret = asprintf(&url,
-        "mock://video_width=4;video_height=4;"
+        "mock://video_width=%u;video_height=%u;"
         "video_track_count=%zu;audio_track_count=%zu;sub_track_count=%zu;"
         "program_count=%zu;video_packetized=%d;audio_packetized=%d;"
         "sub_packetized=%d;length=%"PRId64";audio_sample_length=%"PRId64";"
         "video_frame_rate=%u;video_frame_rate_base=%u;"
         "title_count=%zu;chapter_count=%zu;"
-        "can_seek=%d;can_pause=%d;error=%d;null_names=%d",
+        "can_seek=%d;can_pause=%d;can_control_pace=%d;error=%d;null_names=%d",
+        params->video_width, params->video_height,
         params->track_count[VIDEO_ES], params->track_count[AUDIO_ES],
         params->track_count[SPU_ES], params->program_count,
         params->video_packetized, params->audio_packetized,
         params->sub_packetized, params->length, params->audio_sample_length,
         params->video_frame_rate, params->video_frame_rate_base,
         params->title_count, params->chapter_count,
-        params->can_seek, params->can_pause, params->error, params->null_names);
+        params->can_seek, params->can_pause, params->can_control_pace,
+        params->error, params->null_names);
     assert(ret != -1);
 
     input_item_t *item = input_item_New(url, name);
@@ -1553,6 +1561,103 @@ test_pause(struct ctx *ctx)
     test_end(ctx);
 }
 
+static void
+test_timeshift(struct ctx *ctx, int64_t ram_size, bool files, bool drops)
+{
+    test_log("timeshift (ram: %"PRId64" MiB, files: %d)\n", ram_size, files);
+    vlc_player_t *player = ctx->player;
+
+    vlc_object_t *obj = VLC_OBJECT(ctx->vlc->p_libvlc_int);
+    var_Create(obj, "input-timeshift-ram", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "input-timeshift-ram", ram_size);
+    var_Create(obj, "input-timeshift-files", VLC_VAR_BOOL);
+    var_SetBool(obj, "input-timeshift-files", files);
+
+    /* A live source: the input uses the timeshift to pause. Its frames are
+     * large enough to fill a small memory budget during the pause. */
+    const vlc_tick_t length = VLC_TICK_FROM_MS(500);
+    struct media_params params = DEFAULT_MEDIA_PARAMS(length);
+    params.can_pause = params.can_control_pace = false;
+    params.video_width = 640;
+    params.video_height = 480;
+    player_set_next_mock_media(ctx, "media1", &params);
+
+    player_start(ctx);
+    {
+        vec_on_position_changed *vec = &ctx->report.on_position_changed;
+        while (vec->size == 0)
+            vlc_player_CondWait(player, &ctx->wait);
+    }
+    /* The live source started before its first position: it has delivered
+     * all its data by then */
+    const vlc_tick_t live_end = vlc_tick_now() + length;
+
+    vlc_tick_t start = vlc_tick_now();
+    vlc_player_Pause(player);
+    {
+        vec_on_state_changed *vec = &ctx->report.on_state_changed;
+        while (VEC_LAST(vec) != VLC_PLAYER_STATE_PAUSED)
+            vlc_player_CondWait(player, &ctx->wait);
+    }
+    vlc_tick_t pause_latency = vlc_tick_now() - start;
+
+    /* Let the timeshift store all the live data left */
+    vlc_player_Unlock(player);
+    vlc_tick_wait(live_end);
+    vlc_player_Lock(player);
+
+    size_t position_count = ctx->report.on_position_changed.size;
+    vlc_tick_t paused_time = VEC_LAST(&ctx->report.on_position_changed).time;
+    start = vlc_tick_now();
+    vlc_player_Resume(player);
+    {
+        vec_on_position_changed *vec = &ctx->report.on_position_changed;
+        while (vec->size == position_count)
+            vlc_player_CondWait(player, &ctx->wait);
+    }
+    vlc_tick_t resume_latency = vlc_tick_now() - start;
+
+    /* Play what the timeshift kept: the input does not end while the
+     * timeshift still holds some data */
+    {
+        vec_on_state_changed *vec = &ctx->report.on_state_changed;
+        while (VEC_LAST(vec) != VLC_PLAYER_STATE_STOPPED)
+            vlc_player_CondWait(player, &ctx->wait);
+    }
+
+    /* Largest span of the media skipped since the pause */
+    vlc_tick_t skipped = 0, prev = paused_time;
+    vec_on_position_changed *vec = &ctx->report.on_position_changed;
+    for (size_t i = position_count; i < vec->size; ++i)
+    {
+        if (vec->data[i].time - prev > skipped)
+            skipped = vec->data[i].time - prev;
+        prev = vec->data[i].time;
+    }
+
+    test_log("timeshift (ram: %"PRId64" MiB, files: %d): pause in %"PRId64
+             " us, resume in %"PRId64" us, skipped %"PRId64" ms\n",
+             ram_size, files, US_FROM_VLC_TICK(pause_latency),
+             US_FROM_VLC_TICK(resume_latency), MS_FROM_VLC_TICK(skipped));
+
+    if (!drops)
+    {
+        /* Everything stored during the pause is played afterwards */
+        assert(skipped < length / 2);
+    }
+    else
+    {
+        /* Dropping the oldest data brings the playback back near the live
+         * source, instead of playing the dropped span */
+        assert(skipped >= length / 2);
+    }
+
+    test_end(ctx);
+
+    var_Destroy(obj, "input-timeshift-files");
+    var_Destroy(obj, "input-timeshift-ram");
+}
+
 static void
 test_seeks(struct ctx *ctx)
 {
@@ -2248,6 +2353,10 @@ main(void)
     test_next_media(&ctx);
     test_seeks(&ctx);
     test_pause(&ctx);
+    /* Temporary files only, memory only, then a memory ring buffer */
+    test_timeshift(&ctx, 0, true, false);
+    test_timeshift(&ctx, 64, false, false);
+    test_timeshift(&ctx, 1, false, true);
     test_capabilities_pause(&ctx);
     test_capabilities_seek(&ctx);
     test_error(&ctx);